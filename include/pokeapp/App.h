@@ -3,9 +3,17 @@
 #include "pokeapp/World.h"
 #include "pokeapp/Pokeball.h"
 #include "pokeapp/Pokemon.h" 
+#include "pokeapp/SlotMap.h"
+#include "pokeapp/InputLog.h"
+#include "pokeapp/FrameStats.h"
+#include "pokeapp/Memory.h"
 #include <SDL.h>
 #include <glm/glm.hpp>
+#include <cstdint>
+#include <fstream>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 /*
@@ -20,16 +28,49 @@ class Shader;
 namespace pokepp { 
     class Model; 
     class PokemonController; 
+    class CollisionWorld;
+    class TrajectoryPredictor;
+    class Simulation;
+    struct PokeballStats;
+    struct ScenePropSet;
+    class DebugOverlay;
+    class GpuTimer;
+    class AutoSave;
+    class NetClient;
 }
 
+// Session options, set from the command line (see main.cpp)
+struct AppOptions {
+    std::string scenePath = "assets/scenes/default.scene";  // Population; a replay uses the log's
+    std::string recordPath;  // Record this session's input to a log
+    std::string replayPath;  // Replay a recorded log instead of reading live input
+    std::string timingPath;  // Write per-frame timings (and state hashes) as CSV
+    std::string tracePath;   // Profile the first frames into a Chrome trace
+    std::string memoryPath;  // Write a memory report as JSON at exit
+    std::string loadPath;    // Continue a saved session; its scene and seed replace the options'
+    std::string autosavePath; // Save in the background every AUTOSAVE_INTERVAL_SECONDS of play
+    std::string connectAddress; // Join a server (host:port) instead of simulating locally
+    bool headless = false;   // No window or rendering, replay only
+    bool allocCheck = false; // Fail with exit code 3 if a steady-state frame allocates from the heap
+    uint64_t seed = 0;       // World seed, 0 picks one from the clock. A replay uses the log's.
+};
+
 class App {
 public:
-    App();
+    explicit App(const AppOptions& options = {});
     ~App();
 
     bool init();
     void tick();
     bool running() const { return running_; }
+    bool replaying() const { return !options_.replayPath.empty(); }
+
+    // 0, or non-zero if a replay failed or ended in a different state than was recorded (2),
+    // or with --alloc-check a steady-state frame allocated (3)
+    int exitCode() const { return exitCode_; }
+
+    // Free-flying pokeballs by physics state, counted by the last physics step
+    const pokepp::PokeballStats& pokeballStats() const;
 
 private:
     // Initialization methods
@@ -51,12 +92,21 @@ private:
     
     // Main update methods
     void updateTiming();
-    void updatePhysics();
-    void updateCameraMovement();
+    int updatePhysics();
+    void stepSimulation();
+    void updateNetwork();
     void updateLighting();
     
     // Input handling methods
     void handleInput();
+    void applyInput(const pokepp::InputEvent& event);
+    void applyReplayInput();
+    void finishReplay();
+    void captureProfile(const std::string& path);
+    void dumpMemory(const std::string& path);
+    void saveGame(const std::string& path);
+    void toggleHud();
+    void handleKeyUp(SDL_Scancode scancode);
     void handleKeyDown(SDL_Keycode key);
     void handleMouseMotion(int xrel, int yrel);
     void handleMouseButtonDown(Uint8 button);
@@ -66,6 +116,16 @@ private:
     void updateCameraDirection();
     void handlePointLightKeys(SDL_Keycode key);
     
+    // Per-frame timing CSV
+    void writeTimingRow(double frameMs, double simMs, double renderMs, int ticksRun);
+
+    // Frame statistics for the HUD
+    void recordFrameStats(double cpuMs);
+    void saveSpike();
+
+    // Steady-state frames must not allocate from the heap (debug builds, --alloc-check)
+    void checkFrameAllocations();
+
     // Rendering methods
     void render();
     void setupMainShader(const glm::mat4& view, const glm::mat4& proj);
@@ -77,31 +137,21 @@ private:
     void drawPokeballs(const glm::mat4& view, const glm::mat4& proj);
     void drawLightGizmo(const glm::mat4& view, const glm::mat4& proj);
     void drawInventoryUI(); 
+    void drawHud();
     
     // Projectile system
     void spawnPokeball();
     void spawnPokeball(float speed);
-    void updatePokeballs(float dt);
     
     // Lighting helpers
     void uploadPointLightUniforms() const;
     
-    // Props struct
-    struct Prop {
-        std::shared_ptr<pokepp::Model> model;
-        glm::vec3 pos{ 0 };
-        glm::vec3 scale{ 1.0f };
-        glm::vec3 aabbMinLocal{ -0.5f };
-        glm::vec3 aabbMaxLocal{ 0.5f };
-    };
-    
-    void spawnRockAt(float x, float z, float scaleXZ = 1.0f, float scaleY = 1.0f);
-    void scatterRocks(int count);
-    void spawnTreeAt(float x, float z, float scaleXZ = 1.0f, float scaleY = 1.0f);
-    void scatterTrees(int count);
-    void spawnPokemonAt(float x, float z, float speed, float radius);
-    void scatterPokemon(int count);
+    void addProps(const pokepp::ScenePropSet& set, uint32_t setIndex);
+    std::shared_ptr<pokepp::Model> loadModel(const std::string& path);
     
+    AppOptions options_;
+    int exitCode_ = 0;
+
     // SDL/OpenGL
     SDL_Window* window_ = nullptr;
     SDL_GLContext glcontext_ = nullptr;
@@ -123,21 +173,24 @@ private:
     int gridVertexCount_ = 0;
     GLuint trajVAO_ = 0, trajVBO_ = 0;
     int trajMaxPoints_ = 0;
+    std::unique_ptr<pokepp::TrajectoryPredictor> trajectory_;
+    uint32_t trajUploadedRevision_ = 0;  // Predictor revision currently in trajVBO_
     int trajCount_ = 0;
     GLuint uiQuadVAO_ = 0, uiQuadVBO_ = 0;
+    GLuint uiSlotVAO_ = 0, uiSlotVBO_ = 0;      // Inventory slot background (unit square)
+    GLuint uiBorderVAO_ = 0, uiBorderVBO_ = 0;  // Inventory slot border (unit square outline)
+    pokepp::TrackedMemory gridMemory_, trajMemory_, uiQuadMemory_, uiSlotMemory_;
     
     // Pokeball
     std::unique_ptr<pokepp::Model> pokeballModel_;
-    std::vector<pokepp::Pokeball> balls_;
 	std::unique_ptr<Texture> pokeballTexture_;
 
-    // World and props
-    std::unique_ptr<pokepp::World> world_;
-    std::vector<Prop> props_;
-    std::shared_ptr<pokepp::Model> rockModel_;
-    std::shared_ptr<pokepp::Model> treeModel_;
-    std::shared_ptr<pokepp::Model> pokemonModel_;
-    std::unique_ptr<pokepp::PokemonController> pokemonController_;
+    // Gameplay state (world, Pokemon, pokeballs, player physics), free of rendering
+    std::unique_ptr<pokepp::Simulation> sim_;
+
+    // Models of props and species by path, loaded once. Empty when headless. Entities
+    // in the simulation point into these.
+    std::unordered_map<std::string, std::shared_ptr<pokepp::Model>> models_;
     
     // Uniform locations (main shader)
     GLint uTintLoc_ = -1;
@@ -178,10 +231,54 @@ private:
     GLint gProjLoc_ = -1;
     GLint gColorLoc_ = -1;
     
-    // Timing
-    uint32_t lastTicks_ = 0;
+    // Timing. The simulation advances in fixed PHYSICS_TIMESTEP ticks; dt_ is the frame time.
+    uint64_t lastCounter_ = 0;  // SDL performance counter at the start of the last frame
     float dt_ = 0.0f;
     float t_ = 0.0f;
+    float simAccumulator_ = 0.0f;
+    uint32_t simTick_ = 0;  // Index of the next simulation tick
+    std::unique_ptr<pokepp::AutoSave> autosave_;
+    uint32_t lastAutosaveTick_ = 0;
+
+    // Network play: the server simulates, sim_ only mirrors its snapshots for drawing.
+    // Jumps and throws are sent as wrapping counts.
+    std::unique_ptr<pokepp::NetClient> net_;
+    uint8_t netJumps_ = 0;
+    uint8_t netThrows_ = 0;
+    uint8_t netThrowSpeed_ = 0;
+    uint64_t frame_ = 0;
+
+    // Debug HUD: frame times, render counters and spike traces
+    std::unique_ptr<pokepp::DebugOverlay> overlay_;
+    std::unique_ptr<pokepp::GpuTimer> gpuTimer_;
+    pokepp::FrameStats frameStats_;
+    pokepp::RenderStats lastRenderStats_;  // Counters of the last rendered frame, without the HUD
+    double swapMs_ = 0.0;                  // Time blocked in the buffer swap, not counted as CPU work
+    bool showHud_ = false;
+    bool spikePending_ = false;            // The last frame was a spike: save its zones
+    int spikeCount_ = 0;
+    int spikeDumps_ = 0;
+
+    // Heap allocations, bytes and simulation allocation epoch at the start of the last frame,
+    // and whether the frame did one-off work that may allocate (dumps, captures, HUD toggles)
+    uint64_t heapAllocations_ = 0;
+    uint64_t heapBytes_ = 0;
+    uint64_t heapEpoch_ = 0;
+    bool frameMayAllocate_ = true;
+    uint64_t frameAllocations_ = 0;  // Of the last finished frame
+    uint64_t frameAllocBytes_ = 0;
+    uint64_t checkedFrames_ = 0;     // Frames past the warm-up, those of them that were steady
+    uint64_t steadyFrames_ = 0;      // (and so checked), and those that allocated
+    uint64_t allocatingFrames_ = 0;
+
+    // Held keys by scancode, driven by (recorded) key events so a replay sees the same state
+    bool keysHeld_[SDL_NUM_SCANCODES] = {};
+
+    // Input recording and replay
+    pokepp::InputRecorder recorder_;
+    pokepp::InputLog replayLog_;
+    size_t replayCursor_ = 0;  // Next event of replayLog_ to apply
+    std::ofstream timingFile_;
     
     // Camera
     glm::vec3 camPos_{ 0.0f, 2.0f, -5.0f };
@@ -190,13 +287,6 @@ private:
     float yaw_ = -90.0f;
     float pitch_ = 0.0f;
     float mouseSens_ = 0.1f;
-    float moveSpeed_ = 5.0f;
-    
-    // Player physics
-    float verticalVelocity_ = 0.0f;
-    bool isGrounded_ = true;
-    float playerEyeHeight_ = 1.7f;
-    float playerRadius_ = 0.4f;
     
     // Lighting
     glm::vec3 pointPos_{ 1.5f, 1.0f, 1.0f };
@@ -213,12 +303,5 @@ private:
     float maxChargeSeconds_ = 2.0f;
     float minThrowSpeed_ = 5.0f;
     float maxThrowSpeed_ = 20.0f;
-    
-    // Physics
-    float gravity_ = 9.8f;
-    float bounceRestitution_ = 0.6f;
 
-    // Pokemon species and models
-    std::vector<pokepp::PokemonSpecies> pokemonSpecies_;
-    std::vector<std::shared_ptr<pokepp::Model>> speciesModels_; 
 };
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "pokeapp/Constants.h"
+#include "pokeapp/SaveGame.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	AutoSave header file, defines a service that saves the simulation in the background.
+
+	save() runs on the main thread between ticks and only copies the state into a snapshot
+	(SaveGame::Snapshot, a profiler zone of its own). It does not allocate once the first
+	save is taken: the writer grows the snapshot ahead of the state. Encoding, the delta against the last
+	full save and the file write run on a writer thread of its own: on the shared pool they
+	would hold a worker for the whole write and stall the frame's parallelFor chunks queued
+	behind it. Files are written to a temporary name and renamed, so `path` always holds a
+	complete save.
+
+	Every fullEvery-th save (and any whose delta would be large) is a full save to `path`;
+	the others go to `path`.delta as a delta against it, which SaveGame::Load applies. A
+	save requested while the previous one is still being written is skipped.
+*/
+
+namespace pokepp {
+
+	struct AutoSaveStats {
+		size_t fullSaves = 0;
+		size_t deltaSaves = 0;
+		size_t skipped = 0;         // Requested while the previous save was being written
+		size_t failures = 0;        // Files that could not be written
+		size_t lastBytes = 0;       // Size of the last file written
+		bool lastDelta = false;     // The last file written was a delta
+		double lastSnapshotMs = 0.0;  // Main thread cost of the last save
+		double maxSnapshotMs = 0.0;
+		double lastWriteMs = 0.0;     // Writer thread: encode, delta and write
+	};
+
+	class AutoSave {
+	public:
+		AutoSave(std::string path, std::string scene, int fullEvery = constants::AUTOSAVE_FULL_EVERY);
+		~AutoSave();  // Waits for a save being written, then stops the writer
+
+		AutoSave(const AutoSave&) = delete;
+		AutoSave& operator=(const AutoSave&) = delete;
+
+		// Main thread, between ticks: snapshot the simulation and write it in the background.
+		// False if skipped because the previous save is still being written.
+		bool save(const Simulation& sim);
+
+		bool busy() const;
+		void wait() const;
+		AutoSaveStats stats() const;
+
+	private:
+		void writerLoop();
+		void write();  // On the writer thread
+
+		std::string path_;
+		std::string deltaPath_;
+		std::string scene_;
+		int fullEvery_;
+
+		// Filled by save() and read by write(); never both at once
+		SaveSnapshot snapshot_;
+
+		// Writer thread only
+		std::vector<uint64_t> base_;     // Last full save, encoded
+		std::vector<uint64_t> encoded_;
+		std::vector<uint64_t> delta_;
+		int sinceFull_ = 0;
+
+		mutable std::mutex mutex_;
+		mutable std::condition_variable idle_;
+		std::condition_variable pending_;  // Wakes the writer for a snapshot or to stop
+		bool busy_ = false;                // A snapshot is waiting or being written
+		bool stopping_ = false;
+		AutoSaveStats stats_;
+
+		std::thread writer_;  // Last, so it starts after the members it uses
+	};
+
+} // namespace pokepp
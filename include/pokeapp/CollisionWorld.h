@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/*
+	CollisionWorld header file, defines the static collision geometry of the level.
+	Props (rocks, trees) register their world-space bounding boxes here, so that systems
+	such as navigation and projectile physics can query them without knowing about
+	models or rendering.
+
+	Queries go through a uniform grid over the XZ plane that lists every box in each cell
+	it covers, so they only test the boxes near the query. The grid is rebuilt by the first
+	query after the geometry changed.
+*/
+
+namespace pokepp {
+
+	class World;
+
+	// Axis-aligned bounding box in world space
+	struct AABB {
+		glm::vec3 min{ 0.0f };
+		glm::vec3 max{ 0.0f };
+	};
+
+	class CollisionWorld {
+	public:
+		// Register a static box. Returns its index.
+		size_t addBox(const glm::vec3& min, const glm::vec3& max);
+		void clear();
+
+		const std::vector<AABB>& boxes() const { return boxes_; }
+		size_t memoryBytes() const;
+
+		// True if a circle in the XZ plane overlaps any box (ignores height)
+		bool overlapsCircleXZ(const glm::vec3& center, float radius) const;
+
+		// Sweep a sphere from `from` to `to` and find the first box it touches. On a hit, toi is
+		// the fraction of the segment travelled before contact (0-1) and normal points away from
+		// the box. A sphere that starts out touching a box only hits it when moving inward.
+		bool sweepSphere(const glm::vec3& from, const glm::vec3& to, float radius,
+		                 float& toi, glm::vec3& normal) const;
+
+		// Segment test, same as a sweep with a zero radius
+		bool raycast(const glm::vec3& from, const glm::vec3& to, float& toi, glm::vec3& normal) const {
+			return sweepSphere(from, to, 0.0f, toi, normal);
+		}
+
+		// Bumped whenever the geometry changes, so dependent caches can tell they are stale
+		uint32_t version() const { return version_; }
+
+		// Ball contacts, shared by the pokeball physics and the throw preview so both take the
+		// same path. SweepBall finds the first contact of a ball moving from -> to against the
+		// props (if any) and the terrain, or the flat plane at groundY when there is no
+		// terrain; it returns false if the path is clear.
+		static bool SweepBall(const World* world, const CollisionWorld* collision, const glm::vec3& from,
+		                      const glm::vec3& to, float radius, float groundY, float& toi, glm::vec3& normal);
+
+		// Bounce response: reflect with restitution, then damp the tangential part for friction.
+		// A ball already moving away from the surface keeps its velocity.
+		static glm::vec3 BounceBall(const glm::vec3& velocity, const glm::vec3& normal, float restitution, float friction);
+
+	private:
+		void ensureGrid() const;
+		void buildGrid() const;
+
+		// Calls visit(index) for the boxes in the cells overlapping an XZ rectangle; a box
+		// covering several of them is visited once per cell. Stops when visit returns true.
+		template <typename Visit>
+		bool visitBoxes(const glm::vec2& lo, const glm::vec2& hi, Visit&& visit) const;
+
+		std::vector<AABB> boxes_;
+		uint32_t version_ = 0;
+
+		// Broadphase grid, built lazily from const queries (the mutex keeps concurrent
+		// readers from building it twice)
+		mutable std::mutex gridMutex_;
+		mutable std::atomic<uint32_t> gridVersion_{ ~0u };  // version_ the grid was built for
+		mutable glm::vec2 gridOrigin_{ 0.0f };
+		mutable float gridCellSize_ = 1.0f;
+		mutable int gridWidth_ = 0;
+		mutable int gridHeight_ = 0;
+		mutable std::vector<uint32_t> cellStart_;  // cell -> first index into cellBoxes_
+		mutable std::vector<uint32_t> cellBoxes_;  // box indices by cell, ascending within a cell
+	};
+
+} // namespace pokepp
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/*
+	Components header file, defines the components shared by several kinds of entity in the
+	Simulation's Registry (see Ecs.h).
+
+	Entity kinds and their components:
+		prop      Transform, Renderable, Prop
+		Pokemon   Pokemon (which keeps its own position and species)
+		pokeball  Transform, Pokeball, plus Sleeping while at rest
+*/
+
+namespace pokepp {
+
+	class Model;
+
+	struct Transform {
+		glm::vec3 position{ 0.0f };
+		glm::vec3 scale{ 1.0f };
+	};
+
+	// What to draw for an entity. The model may be null (headless runs).
+	struct Renderable {
+		Model* model = nullptr;
+		glm::vec3 color{ 1.0f };
+	};
+
+	// Static scenery with a collision box (in local space, scaled with the prop)
+	struct Prop {
+		glm::vec3 boxMin{ 0.0f };
+		glm::vec3 boxMax{ 0.0f };
+		uint32_t set = 0;  // Index of the scene prop set it was scattered from
+	};
+
+	// Tag for pokeballs at rest. Physics and capture queries skip them.
+	struct Sleeping {};
+
+} // namespace pokepp
@@ -32,7 +32,10 @@ namespace pokepp {
         constexpr float BOUNCE_RESTITUTION = 0.6f;
         constexpr float BOUNCE_FRICTION = 0.95f;
         constexpr float GROUND_Y = -0.5f;
-        constexpr float PHYSICS_TIMESTEP = 1.0f / 120.0f;
+        constexpr float BALL_SLEEP_SPEED = 0.2f;       // Below this speed (m/s) a grounded ball may sleep
+        constexpr int BALL_SLEEP_STEPS = 30;           // Physics steps it must stay that slow first
+        constexpr float BALL_GROUND_NORMAL_Y = 0.7f;   // Contacts this flat count as ground
+        constexpr float PHYSICS_TIMESTEP = 1.0f / 60.0f;  // Ball physics; collisions are swept, so 30-60 Hz is enough
 
         // Grid
         constexpr int GRID_SIZE = 20;
@@ -46,6 +49,7 @@ namespace pokepp {
         constexpr float PROJECTILE_LIFETIME = 15.0f;
         constexpr float PROJECTILE_SPAWN_DISTANCE = 1.0f;
         constexpr float PROJECTILE_UPWARD_VELOCITY = 2.0f;
+        constexpr int POKEBALL_POOL_CAPACITY = 512;   // Balls in the world before the overflow policy applies
 
         // Lighting
         constexpr float DEFAULT_SHININESS = 32.0f;
@@ -67,5 +71,71 @@ namespace pokepp {
         // Pokeball animations
         constexpr float SHAKE_DURATION = 0.6f;
         constexpr int MAX_SHAKES = 3;
+
+        // Pokemon simulation level-of-detail (distances from the player, in meters)
+        constexpr float SIM_LOD_NEAR_RADIUS = 40.0f;  // Inside: tick every frame
+        constexpr float SIM_LOD_FAR_RADIUS = 90.0f;   // Outside: sleep until back in range
+        constexpr int SIM_LOD_MID_INTERVAL = 4;       // Mid tier ticks once every N frames
+
+        // Navigation
+        constexpr float NAV_CELL_SIZE = 1.0f;
+        constexpr float NAV_AGENT_RADIUS = 0.5f;
+        constexpr float NAV_MAX_SLOPE_DEGREES = 35.0f;
+        constexpr float FLEE_TRIGGER_RADIUS = 8.0f;   // Wild Pokemon closer than this run from the player
+        constexpr float FLEE_FIELD_RANGE = 30.0f;     // Extent of the flee field around the player
+        constexpr float FLEE_SPEED_MULTIPLIER = 1.75f;
+        constexpr float HERD_FIELD_RANGE = 80.0f;     // Extent of each species' field around its herd target
+        constexpr float HERD_GATHER_RADIUS = 10.0f;   // Wild Pokemon further than this walk back to their herd
+        constexpr float HERD_ROAM_RADIUS = 25.0f;     // How far a herd target strays from its species' home
+        constexpr int HERD_RETARGET_FRAMES = 1800;    // Frames between herd target moves
+
+        // Crowd steering between Pokemon
+        constexpr float CROWD_NEIGHBOUR_RADIUS = 2.5f;
+
+        // Profiling
+        constexpr int PROFILER_CAPTURE_FRAMES = 120;  // Frames per trace capture (F9 or --trace)
+
+        // Debug HUD (F3)
+        constexpr int HUD_FRAME_WINDOW = 240;         // Frames in the statistics and graph
+        constexpr float HUD_SPIKE_MS = 25.0f;         // CPU time of a frame that counts as a spike
+        constexpr int HUD_SPIKE_DUMP_LIMIT = 5;       // Spike traces saved per session
+        constexpr float HUD_GRAPH_MAX_MS = 33.3f;     // Top of the frame time graph
+
+        // Memory budgets per category in MiB, checked by memory reports (F10 or --memory)
+        constexpr int MEMORY_BUDGET_GPU_MESHES_MIB = 256;
+        constexpr int MEMORY_BUDGET_GPU_TEXTURES_MIB = 384;
+        constexpr int MEMORY_BUDGET_GPU_BUFFERS_MIB = 16;
+        constexpr int MEMORY_BUDGET_CPU_MESHES_MIB = 256;
+        constexpr int MEMORY_BUDGET_CPU_TERRAIN_MIB = 64;
+        constexpr int MEMORY_BUDGET_CPU_ENTITIES_MIB = 256;
+        constexpr int MEMORY_BUDGET_CPU_NAVIGATION_MIB = 128;
+        constexpr int MEMORY_BUDGET_CPU_COLLISION_MIB = 16;
+
+        // Per-frame allocations
+        constexpr int FRAME_ARENA_KIB = 256;          // Initial size of the frame arena, grows to the peak frame
+        constexpr int CAPTURE_SESSION_RESERVE = 64;   // Concurrent captures held before the capture list grows
+        constexpr int HEAP_CHECK_WARMUP_FRAMES = 300; // Debug builds assert no heap allocations per frame after this
+        constexpr int HEAP_CHECK_REPORTS = 3;         // Allocating steady-state frames reported in full, later ones only counted
+        constexpr int HEAP_CHECK_MIN_STEADY = 60;     // --alloc-check fails if fewer frames than this were steady
+        constexpr int ALLOC_STACK_CAPTURES = 8;       // Stacks recorded per steady-state frame (POKEPP_ALLOC_TRACKING)
+        constexpr int ALLOC_STACK_DEPTH = 24;
+
+        // Autosave (--autosave)
+        constexpr float AUTOSAVE_INTERVAL_SECONDS = 30.0f;  // Simulated time between autosaves
+        constexpr int AUTOSAVE_FULL_EVERY = 10;       // Every n-th autosave is a full save, the others deltas against it
+        constexpr float AUTOSAVE_MAX_DELTA_RATIO = 0.75f; // Larger deltas (relative to the save) are written as full saves
+
+        // Networking (pokepp_server, --connect)
+        constexpr int NET_DEFAULT_PORT = 27960;
+        constexpr int NET_SNAPSHOT_INTERVAL = 3;      // Server ticks per snapshot (20 Hz at 60 Hz ticks)
+        constexpr int NET_SNAPSHOT_HISTORY = 32;      // Snapshots kept per client as delta baselines
+        constexpr float NET_INTEREST_RADIUS = 60.0f;  // Entities farther from a client's player are not sent to it
+        constexpr int NET_MAX_SNAPSHOT_ENTITIES = 1024; // Nearest entities sent per snapshot
+        constexpr int NET_FRAGMENT_BYTES = 1100;      // Snapshot payload per datagram, under a typical MTU
+        constexpr float NET_POSITION_SCALE = 256.0f;  // Positions are sent in 1/256 m
+        constexpr float NET_INTERPOLATION_DELAY = 0.1f; // Clients draw this far (s) behind the newest snapshot
+        constexpr float NET_CLIENT_TIMEOUT = 5.0f;    // Seconds of silence before the server drops a client
+        constexpr float NET_CONNECT_TIMEOUT = 5.0f;   // Seconds a client waits for the server to accept it
+        constexpr int NET_MAX_CLIENTS = 250;
     }
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "pokeapp/Constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+	Crowd header file, defines the CrowdSystem used to keep wandering Pokemon from walking
+	through each other.
+
+	Agents are stored as structure-of-arrays (one float array per field) so the steering math
+	runs over contiguous data. Each step bins the agents into a spatial hash grid, gathers up
+	to MAX_NEIGHBOURS neighbours per agent, and computes classic boids steering (separation,
+	alignment, cohesion) plus a positional push that resolves any remaining overlap. Agents
+	are processed in parallel chunks on the shared ThreadPool.
+*/
+
+namespace pokepp {
+
+	class ThreadPool;
+
+	struct CrowdConfig {
+		float neighbourRadius = constants::CROWD_NEIGHBOUR_RADIUS;  // Agents further apart ignore each other
+		float separationWeight = 3.0f;
+		float alignmentWeight = 0.3f;
+		float cohesionWeight = 0.15f;
+		float maxSteer = 6.0f;          // Clamp on the steering acceleration (m/s^2)
+	};
+
+	class CrowdSystem {
+	public:
+		static constexpr int MAX_NEIGHBOURS = 8;
+
+		// Input, filled by the caller before step()
+		void resize(size_t count);
+		size_t size() const { return posX.size(); }
+
+		std::vector<float> posX, posZ;
+		std::vector<float> velX, velZ;
+		std::vector<float> radius;
+
+		// Output of step(): steering velocity change and overlap push per agent
+		std::vector<float> steerX, steerZ;
+		std::vector<float> pushX, pushZ;
+
+		void step(const CrowdConfig& config, ThreadPool* pool = nullptr);
+
+		size_t neighbourPairs() const { return neighbourPairs_; }
+
+		// Bytes held by the agent arrays and the neighbour grid
+		size_t memoryBytes() const;
+
+	private:
+		void buildGrid(float cellSize);
+		void solveRange(const CrowdConfig& config, size_t begin, size_t end);
+
+		inline uint32_t cellKey(int ci, int cj) const {
+			// Spatial hash of a cell coordinate into [0, tableSize)
+			uint32_t h = static_cast<uint32_t>(ci) * 73856093u ^ static_cast<uint32_t>(cj) * 19349663u;
+			return h & tableMask_;
+		}
+
+		float cellSize_ = 1.0f;
+		uint32_t tableMask_ = 0;
+		std::vector<uint32_t> agentCell_;   // hash bucket per agent
+		std::vector<uint32_t> cellStart_;   // bucket -> first index into sorted_
+		std::vector<uint32_t> sorted_;      // agent indices sorted by bucket
+		std::vector<uint32_t> cursor_;      // scatter position per bucket while building
+		std::vector<uint32_t> pairCounts_;  // neighbours found per agent (for stats)
+		size_t neighbourPairs_ = 0;
+	};
+
+} // namespace pokepp
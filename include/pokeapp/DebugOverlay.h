@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/vec2.hpp>
+#include "pokeapp/Memory.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+	DebugOverlay header file, defines batched 2D drawing for the debug HUD, and a GPU timer.
+
+	The overlay collects rectangles, lines and text for a frame into one vertex array and
+	draws all of it with a single upload and a single draw call in flush(), so showing the
+	HUD barely changes the numbers it shows. Text uses a built-in 5x7 pixel font (printable
+	ASCII) from a small texture; solid shapes sample a filled cell of the same texture, so
+	everything shares one shader and one texture. Coordinates are pixels from the top left.
+
+	GpuTimer measures GPU time between begin() and end() with timer queries. Results are
+	read a few frames later, never waiting for the GPU.
+*/
+
+class Shader;
+
+namespace pokepp {
+
+	// Pack a color as RGBA8
+	constexpr uint32_t rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+		return uint32_t(r) | (uint32_t(g) << 8) | (uint32_t(b) << 16) | (uint32_t(a) << 24);
+	}
+
+	class DebugOverlay {
+	public:
+		static constexpr int GLYPH_W = 6;  // Font cell in texels, including spacing
+		static constexpr int GLYPH_H = 8;
+
+		DebugOverlay();
+		~DebugOverlay();
+
+		DebugOverlay(const DebugOverlay&) = delete;
+		DebugOverlay& operator=(const DebugOverlay&) = delete;
+
+		// Create the shader, font texture and buffers. False if the shader failed to load.
+		bool init();
+
+		// Start a batch for a viewport of the given size
+		void begin(int width, int height);
+
+		void rect(float x, float y, float w, float h, uint32_t color);
+		void line(glm::vec2 a, glm::vec2 b, uint32_t color, float width = 1.0f);
+
+		// Draw text at a whole-number scale of the font; returns the x after the last glyph
+		float text(float x, float y, const char* s, uint32_t color, int scale = 2);
+
+		// Draw the batch (one upload, one draw call) and clear it
+		void flush();
+
+	private:
+		struct Vertex {
+			glm::vec2 pos;
+			glm::vec2 uv;
+			uint32_t color;
+		};
+
+		void quad(float x0, float y0, float x1, float y1, glm::vec2 uv0, glm::vec2 uv1, uint32_t color);
+
+		std::unique_ptr<Shader> shader_;
+		GLuint vao_ = 0, vbo_ = 0, font_ = 0;
+		size_t bufferVertices_ = 0;  // Capacity of vbo_
+		int width_ = 0, height_ = 0;
+		std::vector<Vertex> vertices_;
+		TrackedMemory bufferMemory_, fontMemory_;
+	};
+
+	class GpuTimer {
+	public:
+		~GpuTimer();
+
+		void begin();
+		void end();
+
+		// Milliseconds of the latest finished measurement, negative until there is one
+		float lastMs() const { return lastMs_; }
+
+	private:
+		static constexpr int LATENCY = 4;  // Queries in flight
+
+		GLuint queries_[LATENCY] = {};
+		bool pending_[LATENCY] = {};
+		int slot_ = 0;
+		bool running_ = false;
+		float lastMs_ = -1.0f;
+	};
+
+} // namespace pokepp
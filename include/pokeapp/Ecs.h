@@ -0,0 +1,317 @@
+#pragma once
+
+#include "pokeapp/SlotMap.h"
+#include "pokeapp/ThreadPool.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+	Ecs header file, defines an archetype based entity-component store (the Registry).
+
+	Every distinct set of component types is an archetype. An archetype stores its entities
+	in fixed-size chunks (CHUNK_BYTES), one contiguous column per component type, so a query
+	walks packed arrays of exactly the components it asks for instead of whole objects.
+	Chunks stay full except the last: removing an entity moves the archetype's last entity
+	into the hole. Adding or removing a component moves the entity to another archetype.
+	A chunk that empties is freed, unless reserve() asked the archetype to keep room for a
+	number of entities: then it is kept as a spare and reused by the next create, so an
+	archetype whose population churns within its reservation never touches the heap.
+
+	Entities are generational Handles (see SlotMap.h), so a handle to a destroyed entity is
+	detected as stale. Queries visit archetypes in creation order and rows in storage order,
+	so iteration is deterministic.
+
+	Structural changes (create, destroy, add, remove) must not happen inside a query;
+	collect the entities and apply the changes afterwards. Components may be any movable
+	type with an alignment of at most 64 bytes. A Registry supports up to MAX_COMPONENTS
+	component types.
+*/
+
+namespace pokepp {
+
+	using Entity = Handle;
+
+	using ComponentMask = uint64_t;
+	constexpr uint32_t MAX_COMPONENTS = 64;
+
+	// Type-erased operations on a component type
+	struct ComponentInfo {
+		size_t size = 0;
+		size_t align = 0;
+		void (*relocate)(void* dst, void* src) = nullptr;  // Move src into raw dst, then destroy src
+		void (*destroy)(void* p) = nullptr;
+	};
+
+	namespace ecs_detail {
+		uint32_t registerComponent(const ComponentInfo& info);
+		const ComponentInfo& componentInfo(uint32_t id);
+
+		template <typename T>
+		ComponentInfo makeInfo() {
+			static_assert(alignof(T) <= 64, "component alignment above a cache line is not supported");
+			ComponentInfo info;
+			info.size = sizeof(T);
+			info.align = alignof(T);
+			info.relocate = [](void* dst, void* src) {
+				T* s = static_cast<T*>(src);
+				new (dst) T(std::move(*s));
+				s->~T();
+			};
+			info.destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+			return info;
+		}
+	}
+
+	// Process-wide ID of a component type, assigned on first use. T and const T share it.
+	template <typename T>
+	uint32_t componentId() {
+		if constexpr (!std::is_same_v<T, std::remove_cv_t<T>>) {
+			return componentId<std::remove_cv_t<T>>();
+		} else {
+			static const uint32_t id = ecs_detail::registerComponent(ecs_detail::makeInfo<T>());
+			return id;
+		}
+	}
+
+	template <typename... Ts>
+	ComponentMask componentMask() {
+		return (ComponentMask{ 0 } | ... | (ComponentMask{ 1 } << componentId<Ts>()));
+	}
+
+	// Query filter: skip entities that have any of these components
+	template <typename... Ts>
+	struct Without {};
+
+	class Registry {
+	public:
+		static constexpr size_t CHUNK_BYTES = 16 * 1024;
+
+		Registry() = default;
+		~Registry();
+
+		Registry(const Registry&) = delete;
+		Registry& operator=(const Registry&) = delete;
+
+		// Create an entity with the given components (at most one of each type)
+		template <typename... Ts>
+		Entity create(Ts&&... components);
+
+		// Returns false if the entity was already destroyed
+		bool destroy(Entity e);
+		bool alive(Entity e) const;
+
+		// Component of an entity, nullptr if the entity is stale or lacks it
+		template <typename T> T* get(Entity e);
+		template <typename T> const T* get(Entity e) const;
+		template <typename T> bool has(Entity e) const { return get<T>(e) != nullptr; }
+
+		// Add (or overwrite) a component, moving the entity to its new archetype. nullptr
+		// (and nothing added) if the entity is stale.
+		template <typename T> T* add(Entity e, T value = {});
+
+		// Remove a component, moving the entity to its new archetype. False if it had none.
+		template <typename T> bool remove(Entity e);
+
+		// Call fn(Entity, Ts&...) or fn(Ts&...) for every entity with all of Ts
+		template <typename... Ts, typename Fn>
+		void each(Fn&& fn) { eachImpl<Ts...>(0, fn); }
+
+		// Same, skipping entities that have any of Xs
+		template <typename... Ts, typename... Xs, typename Fn>
+		void each(Without<Xs...>, Fn&& fn) { eachImpl<Ts...>(componentMask<Xs...>(), fn); }
+
+		// Read-only queries: fn gets const components
+		template <typename... Ts, typename Fn>
+		void each(Fn&& fn) const { const_cast<Registry*>(this)->eachImpl<const Ts...>(0, fn); }
+
+		template <typename... Ts, typename... Xs, typename Fn>
+		void each(Without<Xs...>, Fn&& fn) const { const_cast<Registry*>(this)->eachImpl<const Ts...>(componentMask<Xs...>(), fn); }
+
+		// Same as each(), split by chunk across the pool (the calling thread takes part).
+		// fn runs concurrently for different entities and must only touch its own components.
+		template <typename... Ts, typename Fn>
+		void parallelEach(ThreadPool& pool, Fn&& fn) { parallelEachImpl<Ts...>(pool, 0, fn); }
+
+		template <typename... Ts, typename... Xs, typename Fn>
+		void parallelEach(ThreadPool& pool, Without<Xs...>, Fn&& fn) { parallelEachImpl<Ts...>(pool, componentMask<Xs...>(), fn); }
+
+		// Number of entities with all of Ts (and none of Xs)
+		template <typename... Ts>
+		size_t count() const { return countMatching(componentMask<Ts...>(), 0); }
+
+		template <typename... Ts, typename... Xs>
+		size_t count(Without<Xs...>) const { return countMatching(componentMask<Ts...>(), componentMask<Xs...>()); }
+
+		size_t size() const { return liveCount_; }
+		size_t indexLimit() const { return records_.size(); }  // Above every Entity::index handed out
+		size_t archetypeCount() const { return archetypes_.size(); }
+
+		// Bytes held in chunks, and in bookkeeping (records, archetype tables, query scratch)
+		size_t chunkMemory() const;
+		size_t bookkeepingMemory() const;
+
+		// Keep room for n entities with exactly the components Ts: chunks (and spare chunks)
+		// for n rows and entity records for n more entities are allocated now and not freed
+		// while the population stays within n. Reserving less than before keeps the old room.
+		template <typename... Ts>
+		void reserve(size_t n) { reserveRows(archetypeFor(componentMask<Ts...>()), n); }
+
+		// Destroy every entity; outstanding handles become stale. Reserved room is kept.
+		void clear();
+
+		// Changes on every create, destroy, add and remove. Frames where it moved may open or
+		// free chunks; others leave the registry's memory alone.
+		uint64_t structureVersion() const { return structureVersion_; }
+
+	private:
+		struct Chunk {
+			std::byte* data = nullptr;
+			uint32_t count = 0;
+		};
+
+		struct Archetype {
+			ComponentMask mask = 0;
+			std::vector<uint32_t> components;           // Component IDs, ascending
+			std::vector<uint32_t> offsets;              // Column offset in a chunk, per component
+			std::vector<uint32_t> sizes;                // Component size, per component
+			std::array<int8_t, MAX_COMPONENTS> column;  // Component ID -> column, -1 if absent
+			uint32_t capacity = 0;                      // Entities per chunk
+			size_t chunkBytes = 0;                      // CHUNK_BYTES, or more for huge components
+			std::vector<Chunk> chunks;
+			std::vector<std::byte*> spare;              // Empty chunks kept for reuse
+			size_t reservedChunks = 0;                  // Chunks (in use or spare) kept by reserve()
+
+			Entity* entities(const Chunk& c) const { return reinterpret_cast<Entity*>(c.data); }
+			void* at(const Chunk& c, int col, uint32_t row) const {
+				return c.data + offsets[col] + row * sizes[col];
+			}
+		};
+
+		struct Record {
+			uint32_t generation = 0;
+			uint32_t archetype = 0;
+			uint32_t chunk = 0;
+			uint32_t row = 0;       // Next free slot while the entity is dead
+			bool live = false;
+		};
+
+		// Location of one matching chunk, for parallel queries
+		struct ChunkRef {
+			Archetype* archetype;
+			Chunk* chunk;
+		};
+
+		uint32_t archetypeFor(ComponentMask mask);
+		Entity allocateEntity();
+		void placeEntity(Entity e, uint32_t archetype);    // Reserve a row for e
+		void vacateRow(uint32_t archetype, uint32_t chunk, uint32_t row);  // Row already destroyed
+		void moveEntity(Entity e, ComponentMask newMask);  // Keeps shared components, drops the rest
+		void reserveRows(uint32_t archetype, size_t n);
+		void releaseChunk(Archetype& a, std::byte* data);  // Keep as a spare or free
+		void* componentPtr(Entity e, uint32_t id) const;
+		size_t countMatching(ComponentMask include, ComponentMask exclude) const;
+
+		template <typename T>
+		T* column(const Archetype& a, const Chunk& c) const {
+			return reinterpret_cast<T*>(c.data + a.offsets[a.column[componentId<T>()]]);
+		}
+
+		template <typename... Ts, typename Fn>
+		static void visitChunk(const Archetype& a, const Chunk& c, Fn& fn, Ts*... cols) {
+			const Entity* ents = a.entities(c);
+			for (uint32_t r = 0; r < c.count; ++r) {
+				if constexpr (std::is_invocable_v<Fn&, Entity, Ts&...>) fn(ents[r], cols[r]...);
+				else fn(cols[r]...);
+			}
+		}
+
+		template <typename... Ts, typename Fn>
+		void eachImpl(ComponentMask exclude, Fn& fn) {
+			const ComponentMask include = componentMask<Ts...>();
+			for (Archetype& a : archetypes_) {
+				if ((a.mask & include) != include || (a.mask & exclude)) continue;
+				for (Chunk& c : a.chunks) {
+					visitChunk<Ts...>(a, c, fn, column<std::remove_cv_t<Ts>>(a, c)...);
+				}
+			}
+		}
+
+		template <typename... Ts, typename Fn>
+		void parallelEachImpl(ThreadPool& pool, ComponentMask exclude, Fn& fn) {
+			const ComponentMask include = componentMask<Ts...>();
+			scratch_.clear();
+			for (Archetype& a : archetypes_) {
+				if ((a.mask & include) != include || (a.mask & exclude)) continue;
+				for (Chunk& c : a.chunks) scratch_.push_back({ &a, &c });
+			}
+			const std::vector<ChunkRef>& refs = scratch_;
+			pool.parallelFor(refs.size(), 1, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					const Archetype& a = *refs[i].archetype;
+					const Chunk& c = *refs[i].chunk;
+					visitChunk<Ts...>(a, c, fn, column<std::remove_cv_t<Ts>>(a, c)...);
+				}
+			});
+		}
+
+		std::vector<Archetype> archetypes_;
+		std::unordered_map<ComponentMask, uint32_t> archetypeByMask_;
+		std::vector<Record> records_;
+		uint32_t freeHead_ = Handle::INVALID_INDEX;
+		size_t liveCount_ = 0;
+		uint64_t structureVersion_ = 0;
+		std::vector<ChunkRef> scratch_;
+	};
+
+	template <typename... Ts>
+	Entity Registry::create(Ts&&... components) {
+		static_assert(sizeof...(Ts) > 0, "an entity needs at least one component");
+		const ComponentMask mask = componentMask<std::decay_t<Ts>...>();
+
+		Entity e = allocateEntity();
+		uint32_t archetype = archetypeFor(mask);
+		placeEntity(e, archetype);
+
+		const Record& rec = records_[e.index];
+		const Archetype& a = archetypes_[archetype];
+		const Chunk& c = a.chunks[rec.chunk];
+		(new (a.at(c, a.column[componentId<std::decay_t<Ts>>()], rec.row)) std::decay_t<Ts>(std::forward<Ts>(components)), ...);
+		return e;
+	}
+
+	template <typename T>
+	T* Registry::get(Entity e) {
+		return static_cast<T*>(componentPtr(e, componentId<T>()));
+	}
+
+	template <typename T>
+	const T* Registry::get(Entity e) const {
+		return static_cast<const T*>(componentPtr(e, componentId<T>()));
+	}
+
+	template <typename T>
+	T* Registry::add(Entity e, T value) {
+		if (!alive(e)) return nullptr;
+		if (T* existing = get<T>(e)) {
+			*existing = std::move(value);
+			return existing;
+		}
+		const uint32_t id = componentId<T>();
+		moveEntity(e, archetypes_[records_[e.index].archetype].mask | (ComponentMask{ 1 } << id));
+		return new (componentPtr(e, id)) T(std::move(value));
+	}
+
+	template <typename T>
+	bool Registry::remove(Entity e) {
+		if (!has<T>(e)) return false;
+		moveEntity(e, archetypes_[records_[e.index].archetype].mask & ~(ComponentMask{ 1 } << componentId<T>()));
+		return true;
+	}
+
+} // namespace pokepp
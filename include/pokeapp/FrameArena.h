@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/*
+	FrameArena header file, defines a bump allocator for data that only lives for one frame.
+
+	Allocations bump a pointer through one block and are never freed individually; reset()
+	at the start of the next frame releases everything at once. A frame that needs more
+	than the block holds gets extra blocks from the heap, and the next reset() replaces the
+	block with one large enough for that frame, so steady-state frames never touch the heap.
+
+	The arena is a std::pmr::memory_resource, so standard containers can use it through
+	the FrameVector alias below. Memory handed out must not outlive the frame: containers
+	built on it are locals of the code that fills and consumes them.
+
+	frameArena() is the calling thread's arena, reset by whatever ticks a Simulation on that
+	thread: App::tick, NetServer::tick (on its own thread in pokepp_netbots) and the tools
+	that tick one themselves. It is not synchronized; only that thread allocates from it,
+	though workers may read what it allocated during the frame.
+*/
+
+namespace pokepp {
+
+	class FrameArena : public std::pmr::memory_resource {
+	public:
+		explicit FrameArena(size_t bytes);
+		~FrameArena() override;
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		// Release everything allocated since the last reset
+		void reset();
+
+		size_t used() const { return used_; }          // Bytes handed out this frame
+		size_t capacity() const { return capacity_; }  // Size of the main block
+		size_t peak() const { return peak_; }          // Most bytes any frame used
+		size_t overflows() const { return overflows_; }  // Extra blocks taken from the heap, ever
+
+	private:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void*, size_t, size_t) override {}  // Released by reset()
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+		void releaseOverflow();
+
+		std::byte* block_ = nullptr;
+		size_t capacity_ = 0;
+		size_t offset_ = 0;     // Into block_, or into the newest overflow block
+		std::byte* overflow_ = nullptr;  // Newest overflow block; each starts with a link to the previous
+		size_t overflowSize_ = 0;
+		size_t used_ = 0;
+		size_t peak_ = 0;
+		size_t overflows_ = 0;
+	};
+
+	// Arena of the calling thread, reset once per frame (or tick) by its owner
+	FrameArena& frameArena();
+
+	template <typename T>
+	using FrameVector = std::pmr::vector<T>;
+
+	// An empty vector on the frame arena with room for `reserve` elements
+	template <typename T>
+	FrameVector<T> makeFrameVector(size_t reserve = 0) {
+		FrameVector<T> v(&frameArena());
+		v.reserve(reserve);
+		return v;
+	}
+
+} // namespace pokepp
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+	FrameStats header file, defines the per-frame statistics shown by the HUD.
+
+	RenderStats counts what the renderer submitted this frame (draw calls, triangles, models).
+	The counters are bumped where the draw calls happen (Mesh::draw, App) and reset by App at
+	the start of every frame. Rendering happens on the main thread only, so they are plain
+	integers.
+
+	FrameStats keeps a rolling window of frame times (CPU work, GPU time and the interval
+	between frames) and summarizes it as min/avg/p95/p99/max. Percentiles use the nearest
+	rank over the window.
+*/
+
+namespace pokepp {
+
+	struct RenderStats {
+		uint32_t drawCalls = 0;
+		uint64_t triangles = 0;
+		uint32_t models = 0;  // Model::draw calls: visible props, Pokemon, pokeballs, terrain
+	};
+
+	// Counters for the frame being rendered
+	RenderStats& renderStats();
+
+	struct FrameTimeSummary {
+		float min = 0.0f;
+		float avg = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+		size_t samples = 0;
+	};
+
+	class FrameStats {
+	public:
+		explicit FrameStats(size_t window);
+
+		// Add a frame. gpuMs is negative while no GPU timing is available.
+		void add(float cpuMs, float gpuMs, float intervalMs);
+
+		size_t size() const { return count_; }
+		size_t window() const { return cpu_.size(); }
+
+		// Samples by age, 0 is the oldest in the window
+		float cpuAt(size_t i) const { return cpu_[index(i)]; }
+		float gpuAt(size_t i) const { return gpu_[index(i)]; }
+
+		FrameTimeSummary cpu() const { return summarize(cpu_); }
+		FrameTimeSummary gpu() const { return summarize(gpu_); }
+		FrameTimeSummary interval() const { return summarize(interval_); }
+
+	private:
+		size_t index(size_t i) const { return (head_ + cpu_.size() - count_ + i) % cpu_.size(); }
+		FrameTimeSummary summarize(const std::vector<float>& samples) const;
+
+		std::vector<float> cpu_;
+		std::vector<float> gpu_;
+		std::vector<float> interval_;
+		size_t head_ = 0;   // Next slot to write
+		size_t count_ = 0;  // Samples in the window
+		mutable std::vector<float> sorted_;  // Scratch for percentiles
+	};
+
+} // namespace pokepp
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+	GlCounters header file, defines counting of the GL calls the renderer makes, per frame
+	and per render pass.
+
+	install() (after gladLoadGL) swaps glad's function pointers for the entry points below
+	with wrappers that count each call and forward it, so no call site changes. Binds of the
+	program, vertex array or 2D texture (per unit) that is already bound are also counted as
+	redundant: those are state changes that batching or sorting could remove.
+
+	The renderer marks its passes with beginPass("name") (a string literal); calls before the
+	first pass of a frame count toward "other". endFrame() publishes the frame's counts,
+	which the HUD reads through lastFrame() and lastFramePasses(). total() keeps counting
+	across frames, for tools that run without frames (pokepp_bench).
+
+	The wrappers are only built with POKEPP_GL_COUNTERS defined (the CMake option of the same
+	name, on by default). Otherwise install() returns false and nothing is counted.
+*/
+
+namespace pokepp {
+
+	enum class GlCall : uint8_t {
+		DrawElements,
+		DrawArrays,
+		UseProgram,
+		BindTexture,
+		BindVertexArray,
+		Uniform,             // Every glUniform* variant
+		BufferSubData,
+		GetUniformLocation,
+		IsEnabled,
+		Count
+	};
+
+	const char* glCallName(GlCall call);
+
+	struct GlCallCounts {
+		static constexpr size_t KINDS = static_cast<size_t>(GlCall::Count);
+
+		uint32_t calls[KINDS] = {};
+		uint32_t redundant[KINDS] = {};  // Only binds: UseProgram, BindTexture, BindVertexArray
+
+		uint32_t operator[](GlCall call) const { return calls[static_cast<size_t>(call)]; }
+		uint32_t redundantOf(GlCall call) const { return redundant[static_cast<size_t>(call)]; }
+		uint32_t total() const;
+		uint32_t draws() const { return (*this)[GlCall::DrawElements] + (*this)[GlCall::DrawArrays]; }
+
+		void add(const GlCallCounts& o);
+		GlCallCounts minus(const GlCallCounts& o) const;
+	};
+
+	struct GlPassCounts {
+		const char* name = nullptr;
+		GlCallCounts counts;
+	};
+
+	class GlCounters {
+	public:
+		// Wrap glad's function pointers. Call once, after gladLoadGL. False if counters are
+		// not built in or no GL functions are loaded.
+		static bool install();
+		static bool enabled();
+
+		// Calls from now on count toward the pass `name` (a string literal)
+		static void beginPass(const char* name);
+
+		// Publish the current frame's counts and start a new frame
+		static void endFrame();
+
+		// Counts of the last finished frame, in total and per pass (in order of first use)
+		static const GlCallCounts& lastFrame();
+		static const std::vector<GlPassCounts>& lastFramePasses();
+
+		// Counts since install()
+		static const GlCallCounts& total();
+	};
+
+} // namespace pokepp
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+/*
+	HeapCounter header file, counts global heap allocations made through operator new, on
+	every thread.
+
+	HeapCounter.cpp replaces the global operator new and delete: each allocation bumps two
+	relaxed atomic counters for the process and two for the calling thread, then goes to
+	malloc. Callers compare the counts before and after a region. Debug builds of the app
+	check that steady-state frames make no allocations on the main thread (App::tick), and
+	--alloc-check turns that into a failing exit code for the app, pokepp_simbench and
+	pokepp_bench. Worker threads (flow field solves, the autosave writer) may allocate.
+	malloc calls made directly (C libraries, drivers) are not seen.
+
+	Built with POKEPP_ALLOC_TRACKING (the CMake option of the same name, off by default) the
+	hook also:
+	  - gives every profiler zone in a trace the allocations and bytes made inside it, and
+	    lists the zones that allocate most;
+	  - records the call stacks of the next allocations after captureStacks(), so an
+	    allocation in a frame that should have none can be traced to its caller.
+
+	As with any object in a static library, the replacement is only linked into programs
+	that call HeapCounter.
+*/
+
+namespace pokepp {
+
+	class HeapCounter {
+	public:
+		static uint64_t allocations();
+		static uint64_t bytes();
+
+		// True when built with POKEPP_ALLOC_TRACKING
+		static bool tracking();
+
+		// Allocations and bytes of the calling thread
+		static uint64_t threadAllocations();
+		static uint64_t threadBytes();
+
+		// Forget the stacks recorded so far and record those of the calling thread's next
+		// `count` allocations (at most ALLOC_STACK_CAPTURES). No-op without tracking.
+		static void captureStacks(int count);
+		static void stopStackCapture();
+		static int capturedStacks();
+
+		// Print the recorded stacks, symbolized where the platform allows it
+		static void printStacks(std::FILE* out);
+	};
+
+} // namespace pokepp
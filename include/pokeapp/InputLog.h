@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+	InputLog header file, defines the binary input log used to record a play session and
+	replay it deterministically.
+
+	A log starts with the scene, the world seed, the fixed simulation timestep and the
+	initial window size. Then come the input events that affect the game (keys, mouse
+	motion and buttons, window resizes), each tagged with the simulation tick it is applied
+	before. The log ends with the number of ticks played and the final
+	Simulation::stateHash(), so a replay can check that it reached the same state.
+
+	Ticks are stored as varint deltas and payloads as zigzag varints, so most events take
+	3 to 5 bytes.
+*/
+
+namespace pokepp {
+
+	enum class InputEventType : uint8_t {
+		KeyDown, KeyUp, MouseMotion, MouseButtonDown, MouseButtonUp, Resize
+	};
+
+	struct InputEvent {
+		uint32_t tick = 0;
+		InputEventType type = InputEventType::KeyDown;
+		int32_t a = 0;  // Keycode, x motion, mouse button or width
+		int32_t b = 0;  // Scancode, y motion or height
+	};
+
+	struct InputLogHeader {
+		std::string scene;  // Scene file the session was populated from
+		uint64_t seed = 0;
+		float timestep = 1.0f / 60.0f;
+		int32_t width = 0;
+		int32_t height = 0;
+	};
+
+	// Writes a log while playing. Events are buffered and flushed in blocks; a log cut short
+	// (e.g. by a crash) still replays up to its last flushed event, it just can't be verified.
+	class InputRecorder {
+	public:
+		~InputRecorder();
+
+		bool open(const std::string& path, const InputLogHeader& header);
+		bool isOpen() const { return file_.is_open(); }
+
+		// Events must be recorded in tick order
+		void record(const InputEvent& event);
+
+		// Write the end marker and close the file
+		void finish(uint32_t ticks, uint64_t stateHash);
+
+		size_t eventCount() const { return eventCount_; }
+
+	private:
+		void flush();
+
+		std::ofstream file_;
+		std::vector<uint8_t> buffer_;
+		uint32_t lastTick_ = 0;
+		size_t eventCount_ = 0;
+	};
+
+	// A whole log read back for replay
+	class InputLog {
+	public:
+		bool load(const std::string& path);
+
+		const InputLogHeader& header() const { return header_; }
+		const std::vector<InputEvent>& events() const { return events_; }
+
+		// End marker: ticks played and the final state hash. Missing if the recording
+		// was cut short.
+		bool complete() const { return complete_; }
+		uint32_t tickCount() const { return tickCount_; }
+		uint64_t stateHash() const { return stateHash_; }
+
+	private:
+		InputLogHeader header_;
+		std::vector<InputEvent> events_;
+		bool complete_ = false;
+		uint32_t tickCount_ = 0;
+		uint64_t stateHash_ = 0;
+	};
+
+} // namespace pokepp
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+	Memory header file, defines accounting of GPU and CPU memory by category and asset.
+
+	Long-lived allocations register themselves with the MemoryRegistry through a
+	TrackedMemory member: GL buffers and textures where they are created, and CPU copies
+	that live as long as them. Containers that grow and shrink are not tracked live;
+	their owners add their capacity to a MemoryReport when one is taken (reportMemory()).
+
+	A MemoryReport merges entries with the same category and name (e.g. every mesh of one
+	model file), prints a table sorted by size, writes JSON, and checks each category
+	against its budget in Constants.h. GPU sizes are estimates from the formats and
+	dimensions requested; drivers may pad or compress.
+*/
+
+namespace pokepp {
+
+	enum class MemoryCategory : uint8_t {
+		GpuMeshes,      // Vertex and index buffers of meshes
+		GpuTextures,    // Textures, including mip chains
+		GpuBuffers,     // Other GL buffers (UI, grid, trajectory, overlay)
+		CpuMeshes,      // CPU copies of mesh vertices and indices
+		CpuTerrain,     // Heightfield
+		CpuEntities,    // Registry chunks, inventory, capture sessions
+		CpuNavigation,  // Navigation grid, flow fields, crowd arrays
+		CpuCollision,   // Collision boxes
+		Count
+	};
+
+	const char* memoryCategoryName(MemoryCategory category);
+	bool isGpuMemory(MemoryCategory category);
+	size_t memoryBudget(MemoryCategory category);  // Bytes
+
+	struct MemoryEntry {
+		MemoryCategory category = MemoryCategory::CpuEntities;
+		std::string name;
+		size_t bytes = 0;
+		size_t count = 0;  // Allocations merged into this entry
+	};
+
+	class MemoryReport {
+	public:
+		void add(MemoryCategory category, const std::string& name, size_t bytes);
+
+		// Capacity of a container, which is what it holds on to
+		template <typename T>
+		void addVector(MemoryCategory category, const std::string& name, const std::vector<T>& v) {
+			add(category, name, v.capacity() * sizeof(T));
+		}
+
+		const std::vector<MemoryEntry>& entries() const { return entries_; }
+		size_t total(MemoryCategory category) const;
+		size_t totalGpu() const;
+		size_t totalCpu() const;
+		bool withinBudgets() const;
+
+		// Sorted table with category totals and budgets
+		void print(std::FILE* out) const;
+		bool writeJson(const std::string& path) const;
+
+	private:
+		std::vector<const MemoryEntry*> sorted() const;  // Largest first
+
+		std::vector<MemoryEntry> entries_;
+	};
+
+	class MemoryRegistry {
+	public:
+		// Returns an ID for update() and untrack(), never 0
+		static uint32_t track(MemoryCategory category, const std::string& name, size_t bytes);
+		static void update(uint32_t id, size_t bytes);
+		static void untrack(uint32_t id);
+
+		// Add every live tracked allocation to a report
+		static void report(MemoryReport& out);
+	};
+
+	// A tracked allocation, untracked when destroyed. Movable, not copyable.
+	class TrackedMemory {
+	public:
+		TrackedMemory() = default;
+		TrackedMemory(MemoryCategory category, const std::string& name, size_t bytes)
+			: id_(MemoryRegistry::track(category, name, bytes)) {}
+		~TrackedMemory() { reset(); }
+
+		TrackedMemory(TrackedMemory&& o) noexcept : id_(o.id_) { o.id_ = 0; }
+		TrackedMemory& operator=(TrackedMemory&& o) noexcept {
+			if (this != &o) {
+				reset();
+				id_ = o.id_;
+				o.id_ = 0;
+			}
+			return *this;
+		}
+
+		TrackedMemory(const TrackedMemory&) = delete;
+		TrackedMemory& operator=(const TrackedMemory&) = delete;
+
+		void resize(size_t bytes) { if (id_) MemoryRegistry::update(id_, bytes); }
+		void reset() {
+			if (id_) MemoryRegistry::untrack(id_);
+			id_ = 0;
+		}
+
+	private:
+		uint32_t id_ = 0;
+	};
+
+} // namespace pokepp
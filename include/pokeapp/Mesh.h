@@ -1,7 +1,9 @@
 #pragma once
 
+#include <string>
 #include <vector>
 #include <glad/glad.h>
+#include "pokeapp/Memory.h"
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
@@ -23,7 +25,9 @@ namespace pokepp {
 
     class Mesh {
     public:
-        explicit Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices);
+        // name labels the mesh's memory in memory reports (usually the model file)
+        explicit Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices,
+                      const std::string& name = "mesh");
         ~Mesh();
 
 		// Disable copy operations (avoid OpenGL resource duplication issues)
@@ -45,6 +49,9 @@ namespace pokepp {
         
         std::vector<Vertex> vertices_;
         std::vector<unsigned> indices_;
+
+        TrackedMemory gpuMemory_;  // Vertex and index buffers
+        TrackedMemory cpuMemory_;  // vertices_ and indices_
     };
 
 } // namespace pokepp
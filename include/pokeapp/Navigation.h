@@ -0,0 +1,183 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/*
+	Navigation header file, defines the navigation grid and flow fields used to move
+	Pokemon around the terrain.
+
+	The NavGrid rasterizes the heightfield and the static props into walkable cells with a
+	traversal cost (steeper ground costs more, cliffs and props are blocked). A FlowField is
+	solved once per goal with Dijkstra over that grid and stores, for every cell, which
+	neighbour to step to. Any number of Pokemon can then follow the same field for the cost
+	of one cell lookup each.
+*/
+
+namespace pokepp {
+
+	class World;
+	class CollisionWorld;
+	class ThreadPool;
+
+	class NavGrid {
+	public:
+		static constexpr uint8_t BLOCKED = 0;
+
+		// Rasterize the world into cells of cellSize meters. Props are inflated by agentRadius
+		// so agents can be treated as points.
+		static std::shared_ptr<NavGrid> Build(const World& world, const CollisionWorld* collision,
+		                                      float cellSize, float agentRadius, float maxSlopeDegrees);
+
+		bool walkable(const glm::vec3& p) const;
+		bool cellOf(const glm::vec3& p, int& i, int& j) const;
+		glm::vec3 cellCenter(int i, int j) const;
+
+		// 0 = blocked, otherwise the relative cost of crossing the cell (1 = flat ground)
+		uint8_t cost(int i, int j) const { return costs_[idx(i, j)]; }
+
+		int width() const { return width_; }
+		int height() const { return height_; }
+		float cellSize() const { return cellSize_; }
+		size_t memoryBytes() const { return costs_.capacity(); }
+
+		inline int idx(int i, int j) const { return j * width_ + i; }
+
+	private:
+		std::vector<uint8_t> costs_;
+		int width_ = 0, height_ = 0;
+		float cellSize_ = 1.0f;
+		glm::vec2 origin_{ 0.0f }; // world (x,z) of the corner of cell (0,0)
+	};
+
+	enum class FlowMode {
+		Seek, // Move toward the goal
+		Flee  // Move away from the goal
+	};
+
+	class FlowField {
+	public:
+		// Working memory of a solve. Kept by the caller and reused, so a solve over a grid
+		// of the same size does not allocate.
+		struct SolveScratch {
+			std::vector<std::pair<float, int>> open;  // Min-heap of (distance, cell index)
+			std::vector<float> best;
+			std::vector<int> reached;
+		};
+
+		// Solve the field over grid around goal, reusing this field's storage. Cells further
+		// than maxDistance (in cost-weighted meters) are left unreached, which bounds the
+		// cost of a solve to the area of interest.
+		void solve(std::shared_ptr<const NavGrid> grid, const glm::vec3& goal, FlowMode mode,
+		           float maxDistance, SolveScratch& scratch);
+
+		// Unit direction in the XZ plane to follow from p, or zero if there is none
+		// (at the goal, out of range, or on a blocked cell)
+		glm::vec3 direction(const glm::vec3& p) const;
+
+		// Cost-weighted distance from the goal, or a negative value if unreached
+		float distanceAt(const glm::vec3& p) const;
+
+		FlowMode mode() const { return mode_; }
+		const glm::vec3& goal() const { return goal_; }
+		size_t memoryBytes() const { return distance_.capacity() * sizeof(float) + dir_.capacity(); }
+
+	private:
+		static constexpr uint8_t NO_DIRECTION = 8;
+
+		std::shared_ptr<const NavGrid> grid_;
+		std::vector<float> distance_;
+		std::vector<uint8_t> dir_; // neighbour index 0-7 per cell, NO_DIRECTION if none
+		glm::vec3 goal_{ 0.0f };
+		FlowMode mode_ = FlowMode::Seek;
+	};
+
+	// Keeps one flow field per goal up to date. Solves run on a worker, one at a time with
+	// the goals taking turns; agents keep following the previous field until the new one is
+	// swapped in by update(), so a moving goal never stalls the frame.
+	//
+	// Each goal double-buffers its field: a solve writes into the spare and update() swaps
+	// it with the current one. Together with the service's solve scratch, re-solving a goal
+	// does not allocate once both buffers exist, unless someone still holds the old field
+	// when the next solve starts.
+	class FlowFieldService {
+	public:
+		explicit FlowFieldService(ThreadPool& pool);
+		~FlowFieldService();  // Waits for a solve still running
+
+		FlowFieldService(const FlowFieldService&) = delete;
+		FlowFieldService& operator=(const FlowFieldService&) = delete;
+
+		void setGrid(std::shared_ptr<const NavGrid> grid);
+		const NavGrid* grid() const { return grid_.get(); }
+
+		int addGoal(FlowMode mode, float maxDistance);
+
+		// Move a goal. A new solve is scheduled only when the goal changes grid cell.
+		void setGoal(int goalId, const glm::vec3& pos);
+
+		// Main thread, once per frame: publish finished solves and start pending ones
+		void update();
+
+		// Solve inline in update() instead of on a worker, so a moved goal's field is used
+		// on the same frame. Needed for deterministic replays; off by default. Set it before
+		// the first update().
+		void setSynchronous(bool sync) { synchronous_ = sync; }
+
+		std::shared_ptr<const FlowField> field(int goalId) const;
+
+		size_t solvesStarted() const { return solvesStarted_; }
+		size_t solvesCompleted() const { return solvesCompleted_; }
+		bool solving() const { return job_.goalId >= 0; }  // A solve is running on a worker
+
+		// Bytes held by the grid and by both fields of each goal
+		size_t gridMemory() const { return grid_ ? grid_->memoryBytes() : 0; }
+		size_t fieldMemory() const;
+
+	private:
+		struct Goal {
+			FlowMode mode = FlowMode::Seek;
+			float maxDistance = 0.0f;
+			glm::vec3 pos{ 0.0f };
+			int cellI = -1, cellJ = -1;
+			bool dirty = false;   // goal moved since the last solve was scheduled
+			bool solved = false;  // current holds a solved field
+			std::shared_ptr<FlowField> current;
+			std::shared_ptr<FlowField> spare;  // Solved into, then swapped with current
+		};
+
+		// The solve on the worker. The main thread fills it before queueing the job and reads
+		// it back once done is set; the worker only touches it in between.
+		struct Job {
+			int goalId = -1;  // -1 when no solve is running
+			std::shared_ptr<const NavGrid> grid;
+			glm::vec3 pos{ 0.0f };
+			FlowMode mode = FlowMode::Seek;
+			float maxDistance = 0.0f;
+			FlowField* field = nullptr;  // The goal's spare
+			bool done = false;           // Under jobMutex_
+		};
+
+		void schedule(int goalId);
+		void publish(Goal& goal);
+		void runJob();  // On the worker
+
+		ThreadPool& pool_;
+		std::shared_ptr<const NavGrid> grid_;
+		std::vector<Goal> goals_;
+		int nextGoal_ = 0;  // First goal considered by the next update(), so goals take turns
+		Job job_;
+		FlowField::SolveScratch scratch_;  // Used by one solve at a time, inline or on the worker
+		std::mutex jobMutex_;
+		std::condition_variable jobDone_;
+		size_t solvesStarted_ = 0;
+		size_t solvesCompleted_ = 0;
+		bool synchronous_ = false;
+	};
+
+} // namespace pokepp
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "pokeapp/Constants.h"
+#include "pokeapp/NetProtocol.h"
+#include "pokeapp/UdpSocket.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+	NetClient header file, defines the client side of the network protocol (see
+	NetProtocol.h): the connection handshake, sending inputs, reassembling and decoding
+	snapshots, and interpolating between them.
+
+	Snapshots arrive NET_SNAPSHOT_INTERVAL ticks apart. The client shows the world
+	NET_INTERPOLATION_DELAY behind the newest one, blending positions and facing between the
+	two snapshots around that time, so a late or lost snapshot does not make entities jump.
+	The delay clock follows the server's ticks, slewing gently when it drifts and snapping
+	when it is far off. There is no prediction: the own player moves when the server says so.
+*/
+
+namespace pokepp {
+
+	struct NetClientStats {
+		uint64_t snapshots = 0;       // Decoded
+		uint64_t fullSnapshots = 0;   // Of those, without a baseline
+		uint64_t incomplete = 0;      // Dropped: a fragment missing (or superseded)
+		uint64_t undecodable = 0;     // Dropped: baseline unknown or payload malformed
+		uint64_t packetsReceived = 0;
+		uint64_t bytesReceived = 0;
+		uint64_t bytesSent = 0;
+		uint32_t serverTick = 0;       // Of the newest snapshot
+		uint32_t serverTickMicros = 0;  // Reported by the server with it
+		uint32_t serverNetMicros = 0;
+		uint16_t serverClients = 0;
+		size_t entities = 0;          // In the newest snapshot
+	};
+
+	class NetClient {
+	public:
+		NetClient() = default;
+		~NetClient();  // Tells the server it left
+
+		NetClient(const NetClient&) = delete;
+		NetClient& operator=(const NetClient&) = delete;
+
+		// Send Connect until the server accepts (blocking, up to `timeout` seconds). Prints the
+		// reason to stderr and returns false if it rejects or does not answer.
+		bool connect(const NetAddress& server, float timeout = constants::NET_CONNECT_TIMEOUT);
+		void disconnect();
+		bool connected() const { return connected_; }
+		const NetAccept& session() const { return accept_; }  // Client id, scene, seed, rates
+
+		// Per frame: read snapshots, advance the interpolation clock by dt, then send the input
+		// (its sequence and ack are filled in)
+		void update(float dt, NetInput input);
+
+		// True once two snapshots arrived, so there is something to interpolate
+		bool ready() const { return ready_; }
+
+		// Entities at the interpolation time, sorted by id. Valid until the next update.
+		const std::vector<NetEntity>& interpolated() const { return view_; }
+
+		// Mirror the interpolated entities into a simulation used only for drawing: Pokemon
+		// and pokeballs are created, moved and removed to match, and the player is moved to
+		// its own player's position. The simulation must not be ticked.
+		void applyTo(Simulation& sim);
+
+		const NetClientStats& stats() const { return stats_; }
+
+	private:
+		struct Mirror {
+			Entity entity;
+			uint32_t seen = 0;  // applyTo call that last saw it
+		};
+
+		struct Received {
+			uint32_t sequence = 0;
+			uint32_t tick = 0;
+			std::vector<NetEntity> entities;
+		};
+
+		void receive();
+		void handleSnapshot(const uint8_t* data, size_t size);
+		void decode();
+		const Received* findReceived(uint32_t sequence) const;
+		void interpolate();
+
+		UdpSocket socket_;
+		NetAddress server_;
+		bool connected_ = false;
+		NetAccept accept_;
+		uint32_t inputSequence_ = 0;
+
+		// Snapshot being reassembled
+		NetSnapshotHeader pending_;
+		std::vector<uint8_t> pendingPayload_;
+		std::vector<uint8_t> pendingHave_;  // Per fragment: received
+		size_t pendingLast_ = 0;            // Payload bytes in the last fragment
+		size_t pendingCount_ = 0;           // Fragments received
+
+		// Decoded snapshots by sequence % NET_SNAPSHOT_HISTORY, the newest and the clock
+		std::vector<Received> received_;
+		uint32_t newest_ = 0;
+		double renderTick_ = 0.0;
+		bool ready_ = false;
+
+		std::vector<NetEntity> view_;
+		std::unordered_map<uint32_t, Mirror> mirrored_;  // By net id
+		std::vector<uint32_t> stale_;
+		uint32_t applied_ = 0;
+
+		uint8_t packet_[NET_MAX_PACKET];
+		NetClientStats stats_;
+	};
+
+} // namespace pokepp
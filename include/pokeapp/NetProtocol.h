@@ -0,0 +1,144 @@
+#pragma once
+
+#include "pokeapp/Simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/*
+	NetProtocol header file, defines the packets the network server and its clients exchange
+	over UDP, and the snapshot encoding.
+
+	Every packet starts with the protocol id and a packet type. A client sends Connect until
+	the server answers Accept (its client id, the scene and seed to populate the world from,
+	and the tick rate), then one Input per frame: its held buttons, look direction, wrapping
+	counts of the jumps and throws it made (so a lost packet loses no action) and the newest
+	snapshot it received. The server answers with a Snapshot every NET_SNAPSHOT_INTERVAL
+	ticks.
+
+	A snapshot is the list of entities near the client's player (Pokemon, pokeballs and
+	players), quantized: positions to 1/NET_POSITION_SCALE m, facing to 1/256 turn and
+	four kind specific bytes. It is encoded as a delta against the newest snapshot the
+	client acknowledged (or against nothing): the ids that left, then for each entity that
+	is new or changed a mask of its changed fields and their new values, positions as zigzag
+	varint differences. Unchanged entities cost nothing. A payload larger than
+	NET_FRAGMENT_BYTES is split across datagrams; a snapshot missing a fragment is dropped.
+
+	All integers are little endian.
+*/
+
+namespace pokepp {
+
+	constexpr uint32_t NET_PROTOCOL_ID = 0x544E5050u;  // "PPNT"
+	constexpr uint16_t NET_PROTOCOL_VERSION = 1;
+	constexpr size_t NET_MAX_PACKET = 1400;  // Largest datagram sent
+
+	enum class NetPacket : uint8_t {
+		None = 0,  // Not a packet of this protocol
+		Connect,
+		Accept,
+		Reject,    // Server full or a different protocol version
+		Input,
+		Snapshot,
+		Disconnect,
+	};
+
+	enum class NetKind : uint8_t { Pokemon = 0, Pokeball = 1, Player = 2 };
+
+	// Bits of NetInput::buttons
+	constexpr uint8_t NET_BUTTON_FORWARD = 1;
+	constexpr uint8_t NET_BUTTON_BACK = 2;
+	constexpr uint8_t NET_BUTTON_LEFT = 4;
+	constexpr uint8_t NET_BUTTON_RIGHT = 8;
+	constexpr uint8_t NET_BUTTON_SPRINT = 16;
+
+	// One entity in a snapshot. aux holds, by kind:
+	//   Pokemon   species index, PokemonState, visible
+	//   Pokeball  flags (1 active, 2 locked), shake count, shake phase (1/255) and lock timer (1/50 s)
+	//   Player    client id (low and high byte)
+	struct NetEntity {
+		uint32_t id = 0;  // Kind in the low 2 bits
+		int32_t position[3] = {};
+		uint8_t yaw = 0;
+		uint8_t aux[4] = {};
+
+		NetKind kind() const { return static_cast<NetKind>(id & 3u); }
+		glm::vec3 worldPosition() const;
+		float yawRadians() const;
+		void setWorldPosition(const glm::vec3& p);
+		void setYaw(float radians);
+
+		bool operator==(const NetEntity& o) const;
+		bool operator!=(const NetEntity& o) const { return !(*this == o); }
+
+		static uint32_t MakeId(NetKind kind, uint32_t key) { return (key << 2) | static_cast<uint32_t>(kind); }
+	};
+
+	struct NetInput {
+		uint32_t sequence = 0;
+		uint32_t ack = 0;        // Newest snapshot the client decoded, 0 for none
+		uint8_t buttons = 0;     // NET_BUTTON_* bits
+		uint8_t jumps = 0;       // Wrapping counts of the jumps and throws made so far
+		uint8_t throws = 0;
+		uint8_t throwSpeed = 0;  // Of the last throw, in 1/8 m/s
+		glm::vec3 front{ 0.0f, 0.0f, -1.0f };
+
+		PlayerInput toPlayerInput() const;
+		void setMovement(const PlayerInput& input);  // Buttons and front
+	};
+
+	struct NetAccept {
+		uint16_t clientId = 0;
+		uint64_t seed = 0;
+		uint16_t tickRate = 60;          // Server ticks per second
+		uint8_t snapshotInterval = 1;    // Ticks per snapshot
+		std::string scene;
+	};
+
+	struct NetSnapshotHeader {
+		uint32_t sequence = 0;    // Counts from 1 per client
+		uint32_t baseline = 0;    // Snapshot the payload is a delta against, 0 for none
+		uint32_t tick = 0;        // Server tick it was taken after
+		uint32_t tickMicros = 0;  // Server: mean tick time (simulation and networking) over the
+		uint32_t netMicros = 0;   // previous snapshot interval, and its total networking time
+		uint16_t clients = 0;     // Connected clients
+		uint8_t fragment = 0;
+		uint8_t fragments = 1;
+	};
+
+	class NetProtocol {
+	public:
+		// Type of a received datagram, None if it is not one of ours
+		static NetPacket Type(const uint8_t* data, size_t size);
+
+		// Packets. Writers fill `out` (NET_MAX_PACKET bytes) and return the size; readers
+		// return false for a malformed packet.
+		static size_t WriteConnect(uint8_t* out);
+		static size_t WriteReject(uint8_t* out);
+		static size_t WriteDisconnect(uint8_t* out);
+		static bool ReadConnect(const uint8_t* data, size_t size, uint16_t& version);
+
+		static size_t WriteAccept(const NetAccept& accept, uint8_t* out);
+		static bool ReadAccept(const uint8_t* data, size_t size, NetAccept& out);
+
+		static size_t WriteInput(const NetInput& input, uint8_t* out);
+		static bool ReadInput(const uint8_t* data, size_t size, NetInput& out);
+
+		// One fragment of a snapshot payload
+		static size_t WriteSnapshot(const NetSnapshotHeader& header, const uint8_t* payload, size_t bytes, uint8_t* out);
+		static bool ReadSnapshot(const uint8_t* data, size_t size, NetSnapshotHeader& header,
+			const uint8_t*& payload, size_t& bytes);
+
+		// Snapshot payloads. Both lists are sorted by id; an empty baseline gives a full
+		// snapshot. Decode fails on a malformed payload.
+		static void EncodeEntities(std::span<const NetEntity> baseline, std::span<const NetEntity> entities,
+			std::vector<uint8_t>& out);
+		static bool DecodeEntities(std::span<const NetEntity> baseline, const uint8_t* data, size_t size,
+			std::vector<NetEntity>& out);
+	};
+
+} // namespace pokepp
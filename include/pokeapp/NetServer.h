@@ -0,0 +1,127 @@
+#pragma once
+
+#include "pokeapp/Constants.h"
+#include "pokeapp/NetProtocol.h"
+#include "pokeapp/UdpSocket.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+	NetServer header file, defines the authoritative game server: it owns a headless
+	Simulation, steps it at a fixed tick from its clients' inputs and sends each client
+	snapshots of the entities around its player (see NetProtocol.h).
+
+	Every client has its own player. The simulation has one, so each client's PlayerState
+	is swapped in for its movement, jumps and throws. Capturing and the inventory are not
+	networked.
+
+	Known limitation: Pokemon AI has a single focus. Fleeing and the LOD tiers (near Pokemon
+	simulated in detail, far ones coarsely) follow the first connected client's player
+	only; Pokemon ignore the other players and may run coarse ticks right next to them.
+
+	Each client keeps a history of the snapshots sent to it, as delta baselines: a snapshot
+	is encoded against the newest one the client acknowledged, or in full when that one is
+	no longer in the history.
+*/
+
+namespace pokepp {
+
+	struct NetServerStats {
+		size_t clients = 0;
+		uint32_t tick = 0;
+		double tickMs = 0.0;          // Last tick: simulation and networking
+		double netMs = 0.0;           // Of that, reading inputs and building and sending snapshots
+		size_t snapshotEntities = 0;  // Entities in the snapshots of the last snapshot tick
+		uint64_t snapshotsSent = 0;
+		uint64_t fullSnapshots = 0;   // Sent without a baseline
+		uint64_t packetsSent = 0;
+		uint64_t bytesSent = 0;
+		uint64_t bytesReceived = 0;
+		uint64_t accepted = 0;
+		uint64_t rejected = 0;
+		uint64_t dropped = 0;         // Disconnected or timed out
+		size_t arenaOverflows = 0;    // Frame arena blocks the ticking thread took from the heap, ever
+	};
+
+	class NetServer {
+	public:
+		// `scene` is sent to clients, which populate their world from it with the
+		// simulation's seed; the simulation must have been populated the same way.
+		NetServer(Simulation& sim, std::string scene, int maxClients = constants::NET_MAX_CLIENTS,
+			float tickSeconds = constants::PHYSICS_TIMESTEP);
+
+		NetServer(const NetServer&) = delete;
+		NetServer& operator=(const NetServer&) = delete;
+
+		// Listen on `port` (0 picks one), on the loopback interface or on all interfaces
+		bool start(uint16_t port, bool loopbackOnly = true);
+		uint16_t port() const { return socket_.port(); }
+
+		// One fixed tick: read inputs, step the simulation, then send snapshots if one is due
+		void tick();
+
+		size_t clientCount() const { return clients_.size(); }
+		const NetServerStats& stats() const { return stats_; }
+
+	private:
+		struct SentSnapshot {
+			uint32_t sequence = 0;
+			std::vector<NetEntity> entities;
+		};
+
+		struct Client {
+			NetAddress address;
+			uint16_t id = 0;
+			PlayerState player;
+			NetInput input;            // Newest received
+			uint8_t jumpsApplied = 0;  // Counters of the actions already made
+			uint8_t throwsApplied = 0;
+			uint32_t sequence = 0;     // Last snapshot sent
+			uint32_t acked = 0;        // Newest snapshot the client received
+			float silence = 0.0f;      // Seconds since its last packet
+			std::vector<SentSnapshot> history;  // By sequence % NET_SNAPSHOT_HISTORY
+		};
+
+		void receive();
+		void handlePacket(const NetAddress& from, const uint8_t* data, size_t size);
+		Client* findClient(const NetAddress& address);
+		void connectClient(const NetAddress& from, const uint8_t* data, size_t size);
+		void dropClients();
+		void simulate();
+		void gatherEntities();
+		void sendSnapshot(Client& client);
+		void send(const NetAddress& to, const uint8_t* data, size_t size);
+
+		Simulation& sim_;
+		std::string scene_;
+		int maxClients_;
+		float tickSeconds_;
+		UdpSocket socket_;
+
+		std::vector<std::unique_ptr<Client>> clients_;
+		uint16_t nextClientId_ = 1;
+		uint32_t tick_ = 0;
+
+		// Cost of the ticks since the last snapshot tick (it included), reported in snapshots
+		uint64_t windowTickMicros_ = 0;
+		uint64_t windowNetMicros_ = 0;
+		uint32_t windowTicks_ = 0;
+		uint32_t reportTickMicros_ = 0;
+		uint32_t reportNetMicros_ = 0;
+
+		// Snapshot scratch, reused across ticks
+		std::vector<NetEntity> world_;                   // Every entity this snapshot tick, by id
+		std::vector<glm::vec2> worldXZ_;                 // Their positions on the ground plane
+		std::vector<std::pair<float, uint32_t>> nearby_;  // Distance squared and index into world_
+		std::vector<uint8_t> payload_;
+		uint8_t packet_[NET_MAX_PACKET];
+
+		NetServerStats stats_;
+	};
+
+} // namespace pokepp
@@ -1,16 +1,17 @@
 #pragma once
 
+#include "pokeapp/SlotMap.h"
 #include <glm/glm.hpp>
 
 /*
 	Pokeball header file, defines a Pokeball struct for simulating Pokeball 
-	behavior in the game.
+	behavior in the game. A pokeball is an entity with a Transform (its position) and this
+	component; see Components.h.
 */
 
 namespace pokepp {
 
 	struct Pokeball {
-		glm::vec3 position{ 0.0f };
 		glm::vec3 velocity{ 0.0f };
 
 		float radius = 0.3f;
@@ -19,6 +20,11 @@ namespace pokepp {
 
 		float life = 10.0f;
 
+		// Rest detection. A ball that stays slow while touching the ground for a number of
+		// steps gets the Sleeping tag and is skipped by physics until woken. A Pokemon running
+		// into it still starts a capture, which wakes it.
+		int restSteps = 0;             // Consecutive slow, grounded steps
+
 		// Capture animation state
 		bool locked = false;           // For wiggle animation
 		float lockTimer = 0.0f;        // Animation time
@@ -28,7 +34,8 @@ namespace pokepp {
 
 		// NEW: Capture result
 		bool captureSuccess = false;   // Determined when capture starts
-		int targetPokemonId = -1;      // NEW: ID of the Pokmon this ball is attempting to capture
+		Handle captureSession;         // Session in PokemonController that resolves this capture
+		Handle targetPokemon;          // Handle of the Pokmon this ball is attempting to capture
 	};
 
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "pokeapp/Random.h"
 #include <glm/glm.hpp>
+#include <span>
 #include <vector>
 #include <string>
 
@@ -12,6 +14,7 @@
 namespace pokepp { // namespace for pokepp library
 	class Model;
 	class World;
+	class NavGrid;
 }
 class Shader; // global namespace
 
@@ -22,6 +25,11 @@ namespace pokepp {
 		Idle, Walking, Capturing, Captured, CaptureFailed  
 	};
 
+	// Simulation level-of-detail tier, chosen each frame from the distance to the player
+	enum class SimTier : unsigned char {
+		Near, Mid, Far
+	};
+
 	// Pokemon species data structure
 	struct PokemonSpecies {
 		std::string name;
@@ -34,9 +42,14 @@ namespace pokepp {
 	class Pokemon {
 	public:
 		Pokemon(const PokemonSpecies* species, const glm::vec3& startPos, 
-		        float moveSpeed = 2.0f, float collisionRadius = 0.5f, int id = 0);
+		        float moveSpeed = 2.0f, float collisionRadius = 0.5f, int id = 0, uint64_t seed = 0);
 		
-		void update(float dt, const World* world = nullptr, const std::vector<glm::vec3>& obstacles = {});
+		void update(float dt, const World* world = nullptr, std::span<const glm::vec3> obstacles = {},
+		            const NavGrid* nav = nullptr);
+		void steer(const glm::vec3& dir, float speedScale = 1.0f);
+		void applyCrowd(const glm::vec2& steer, const glm::vec2& push, float dt,
+		                const World* world = nullptr, const NavGrid* nav = nullptr);
+		void advanceAsleep(float dt, const World* world = nullptr);
 		void draw(Shader& shader) const;
 
 		const glm::vec3& getPosition() const { return position_; }
@@ -46,6 +59,8 @@ namespace pokepp {
 		void setState(PokemonState s) { state_ = s; }
 
 		float getRadius() const { return radius_; }
+		float getSpeed() const { return speed_; }
+		const glm::vec3& getVelocity() const { return velocity_; }
 
 		bool isCapturing() const { return state_ == PokemonState::Capturing; }
 		void startCapture();
@@ -59,16 +74,34 @@ namespace pokepp {
 		bool isVisible() const { return visible_; }
 		void setVisible(bool v) { visible_ = v; }
 
+		// Facing (radians about +Y), set from movement; network clients set it from snapshots
+		float getYRotation() const { return yRotation_; }
+		void setYRotation(float r) { yRotation_ = r; }
+
 		int getId() const { return id_; }
 		Model* getModel() const { return model_; }
+
+		// Inventory slot this Pokemon was sent out from, -1 for wild Pokemon
+		int getInventorySlot() const { return inventorySlot_; }
+		void setInventorySlot(int slot) { inventorySlot_ = slot; }
 		
 		const PokemonSpecies* getSpecies() const { return species_; }
 		const std::string& getSpeciesName() const { return species_ ? species_->name : "Unknown"; }
 
 		float getCatchRate() const { return species_ ? species_->catchRate : 0.5f; }
 
+		// Simulation LOD bookkeeping, managed by PokemonController
+		SimTier getSimTier() const { return simTier_; }
+		void setSimTier(SimTier t) { simTier_ = t; }
+		float getPendingDt() const { return pendingDt_; }
+		void setPendingDt(float dt) { pendingDt_ = dt; }
+		bool isWandering() const { return state_ == PokemonState::Idle || state_ == PokemonState::Walking; }
+
 	private:
+		friend class SaveGame;  // Saves and restores the private state
+
 		int id_ = 0;
+		int inventorySlot_ = -1;
 		void pickNewWanderDirection();
 		
 		const PokemonSpecies* species_;
@@ -88,5 +121,10 @@ namespace pokepp {
 		float captureDuration = 0.6f;
 
 		float yRotation_ = 0.0f;  // For facing direction (when wandering)
+
+		SimTier simTier_ = SimTier::Near;
+		float pendingDt_ = 0.0f;  // Time not yet simulated while in the mid or far tier
+
+		Random rng_;  // Wander randomness, its own stream of the simulation seed (by ID)
 	};
 }
\ No newline at end of file
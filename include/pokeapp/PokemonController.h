@@ -1,31 +1,120 @@
 #pragma once
 
 #include "pokeapp/Pokemon.h"
+#include "pokeapp/SlotMap.h"
+#include "pokeapp/Ecs.h"
+#include "pokeapp/Crowd.h"
+#include "pokeapp/Constants.h"
+#include "pokeapp/Random.h"
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <vector>
 #include <glm/glm.hpp>
 
 /*
 	PokemonController header file, defines a PokemonController class for controlling 
-	Pokemon spawning, updating, drawing, and inventory management.
+	Pokemon spawning, updating, drawing, and inventory management. Pokemon in the world are
+	entities with a Pokemon component in the Simulation's Registry; the inventory holds
+	compact InventoryEntry records, materialized as an entity while sent out.
 */
 
 // Forward declarations
 namespace pokepp {
 	class Model;
 	struct Pokeball;
+	struct Transform;
+	class FlowField;
+	class FlowFieldService;
+	class MemoryReport;
 }
 
 class Shader;
 
 namespace pokepp {
+
+	// Links a locked Pokeball to the Pokemon it is trying to capture. Created when the ball
+	// hits, resolved when the ball finishes shaking.
+	struct CaptureSession {
+		Entity ball;
+		Entity pokemon;
+		float roll = 0.0f;     // Random roll compared against the species catch rate
+		bool success = false;  // Outcome, decided up front so the ball animation can use it
+		float timer = 0.0f;    // Time since the ball locked on
+	};
+
+	// A caught Pokemon in the box: what it takes to rebuild it, not its live wander state.
+	// Sending it out creates a Pokemon entity from the entry; recalling writes the entity's
+	// stats back and destroys it.
+	struct InventoryEntry {
+		static constexpr uint16_t NO_SPECIES = 0xFFFF;
+
+		int32_t id = 0;                 // Pokemon ID, kept through capture and send-outs
+		uint16_t species = NO_SPECIES;  // Index into the species table
+		uint16_t reserved = 0;
+		float speed = 2.0f;             // Individual stats
+		float radius = 0.5f;
+	};
+
+	// Distance thresholds for simulation level-of-detail
+	struct SimLodConfig {
+		float nearRadius = constants::SIM_LOD_NEAR_RADIUS;
+		float farRadius = constants::SIM_LOD_FAR_RADIUS;
+		int midInterval = constants::SIM_LOD_MID_INTERVAL;
+	};
+
+	// Per-frame counters for each simulation tier
+	struct SimLodStats {
+		size_t nearCount = 0;
+		size_t midCount = 0;
+		size_t farCount = 0;
+		size_t updatesRun = 0;  // Full Pokemon::update calls this frame
+		size_t wakeUps = 0;     // Far -> mid/near transitions this frame
+	};
+
 	class PokemonController {
-	public:		
-		void spawnPokemon(const PokemonSpecies* species, const glm::vec3& pos, 
-		                  float speed = 2.0f, float radius = 0.5f, int id = 0);
+	public:
+		// Room for the captures of a busy scene, so starting one does not allocate mid-game
+		explicit PokemonController(Registry& registry) : registry_(registry) {
+			captures_.reserve(constants::CAPTURE_SESSION_RESERVE);
+		}
+
+		Entity spawnPokemon(const PokemonSpecies* species, const glm::vec3& pos, 
+		                    float speed = 2.0f, float radius = 0.5f, int id = 0);
 		
-		void updateAll(float dt, const World* world, const std::vector<glm::vec3>& obstacles);
+		void updateAll(float dt, const World* world, std::span<const glm::vec3> obstacles,
+		               const glm::vec3& focus);
 		void drawAll(Shader& shader) const;
-		void handlePokeballCapture(std::vector<Pokeball>& pokeballs);
+		void handlePokeballCapture(float dt);  // Pokeballs are read from the registry
+
+		// Navigation: the service's grid is used for walkability, the flee goal's field makes
+		// nearby wild Pokemon flee from the player, and herdGoals (one seek goal per species,
+		// by species index) lead Pokemon that strayed from their herd back to it
+		void setNavigation(FlowFieldService* service, int fleeGoal, std::span<const int> herdGoals);
+
+		// Simulation level-of-detail
+		void setLodConfig(const SimLodConfig& config) { lodConfig_ = config; }
+		const SimLodConfig& getLodConfig() const { return lodConfig_; }
+		const SimLodStats& getLodStats() const { return lodStats_; }
+
+		// Crowd steering between nearby wandering Pokemon
+		void setCrowdConfig(const CrowdConfig& config) { crowdConfig_ = config; }
+		const CrowdConfig& getCrowdConfig() const { return crowdConfig_; }
+		const CrowdSystem& getCrowd() const { return crowd_; }
+
+		// Species Pokemon are spawned with; inventory entries refer to them by index
+		void setSpecies(std::span<const PokemonSpecies> species) { species_ = species; }
+		const PokemonSpecies* speciesOf(const InventoryEntry& entry) const {
+			return entry.species < species_.size() ? &species_[entry.species] : nullptr;
+		}
+
+		// Seed for capture rolls and for the wander streams of Pokemon spawned afterwards
+		void setSeed(uint64_t seed) { seed_ = seed; rng_.reseed(seed); }
+		uint64_t getSeed() const { return seed_; }
+
+		// Capture sessions
+		bool resolveCapture(Handle session);
+		const SlotMap<CaptureSession>& getCaptures() const { return captures_; }
 
 		// Inventory management
 		void updateInventory();
@@ -33,18 +122,59 @@ namespace pokepp {
 		bool recallPokemon(size_t inventoryIndex);
 		bool isPokemonOut(size_t inventoryIndex) const;
 		bool hasAnyPokemonOut() const;
-		const std::vector<Pokemon>& getInventory() const { return inventory_; }
+		const std::vector<InventoryEntry>& getInventory() const { return inventory_; }
 		size_t getInventoryCount() const { return inventory_.size(); }
 
-		std::vector<Pokemon>& getPokemon() { return pokemon_; }
-		const std::vector<Pokemon>& getPokemon() const { return pokemon_; }
+		size_t getPokemonCount() const { return registry_.count<Pokemon>(); }
+		unsigned getFrame() const { return frame_; }  // updateAll calls so far
+
+		// Add the inventory, capture sessions, crowd and scratch buffers to a memory report
+		void reportMemory(MemoryReport& out) const;
+
+		// O(1) lookup of an active Pokemon, nullptr if it has since been removed
+		Pokemon* findPokemon(Entity e) { return registry_.get<Pokemon>(e); }
 
 	private:
-		bool isOwnedPokemon(const Pokemon& p) const;
+		friend class SaveGame;
+
+		bool isOwnedPokemon(const Pokemon& p) const { return p.getInventorySlot() >= 0; }
+		InventoryEntry makeEntry(const Pokemon& p) const;
+		size_t speciesIndex(const Pokemon& p) const;
+
+		// A sent-out Pokemon and the inventory slot it came from
+		struct OutPokemon {
+			uint32_t slot;
+			Entity entity;
+		};
+		const OutPokemon* findOut(size_t inventoryIndex) const;
+
+		// An unlocked pokeball, flying or asleep, gathered once per capture pass
+		struct BallCandidate {
+			Entity entity;
+			Transform* transform;
+			Pokeball* ball;
+			bool sleeping;
+		};
 		
-		std::vector<Pokemon> pokemon_;
-		std::vector<Pokemon> inventory_;
-		std::vector<size_t> outPokemonIndices_;  // Tracks which inventory slots are currently out
+		Registry& registry_;
+		SlotMap<CaptureSession> captures_;
+		std::vector<InventoryEntry> inventory_;
+		std::vector<OutPokemon> out_;  // Usually none or one, so lookups are a short scan
+		std::span<const PokemonSpecies> species_;
 		int nextPokemonId_ = 1;  // Auto incrementing ID for wild Pokmon
+
+		uint64_t seed_ = 0;
+		Random rng_;  // Capture rolls
+
+		FlowFieldService* nav_ = nullptr;
+		int fleeGoal_ = -1;
+		std::vector<int> herdGoals_;
+
+		SimLodConfig lodConfig_;
+		SimLodStats lodStats_;
+		unsigned frame_ = 0;  // Frames simulated, staggers the mid tier updates
+
+		CrowdSystem crowd_;
+		CrowdConfig crowdConfig_;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#ifdef POKEPP_ALLOC_TRACKING
+#include "pokeapp/HeapCounter.h"
+#endif
+
+/*
+	Profiler header file, defines a lightweight hierarchical CPU profiler.
+
+	Code is instrumented with scoped zones: PROFILE_ZONE("name") times the rest of the
+	enclosing block, PROFILE_FUNCTION() the enclosing function. Zone names must be string
+	literals (only the pointer is stored). Nested zones show up as a call hierarchy.
+
+	Nothing is recorded until a capture is requested. Profiler::capture(frames, path) starts
+	at the next Profiler::frame() (called once per frame by the main loop), records that many
+	frames and writes them as a Chrome trace JSON, which opens in chrome://tracing or
+	ui.perfetto.dev. While capturing, each thread appends to a fixed-size buffer of its own
+	(no locks, no allocation after its first event), with nanosecond timestamps. Outside a
+	capture a zone costs one relaxed atomic load.
+
+	With frame history on, zones are recorded every frame and only the latest frame is kept,
+	so a frame can be saved after it turned out to be slow (saveLastFrame).
+
+	Built with POKEPP_ALLOC_TRACKING, every zone also records the heap allocations and bytes
+	its thread made inside it. They are written as the event's args (inclusive, and "self"
+	without the zones nested in it), and the trace summary lists the zones that allocate most.
+
+	Zones compile to nothing unless POKEPP_PROFILER is defined (the CMake option of the same
+	name, on by default).
+*/
+
+namespace pokepp {
+
+	class Profiler {
+	public:
+		// Record the next `frames` frames and write them to `path`. False if a capture is
+		// already pending or running.
+		static bool capture(int frames, const std::string& path);
+
+		// True while zones are being recorded (a capture, or frame history)
+		static bool capturing() { return active_.load(std::memory_order_relaxed); }
+
+		// Frame boundary: starts a pending capture, and finishes one after its last frame
+		static void frame();
+
+		// Keep recording the latest frame, for saveLastFrame
+		static void setFrameHistory(bool enabled);
+
+		// Write the frame that just ended to `path`. Call before frame(). False if frame
+		// history is off or a capture is running.
+		static bool saveLastFrame(const std::string& path);
+
+		// Name shown for the calling thread in traces
+		static void setThreadName(const char* name);
+
+		// Nanoseconds on a monotonic clock
+		static uint64_t now();
+
+		// Add a finished zone to the calling thread's buffer (used by ProfileZone), with the
+		// heap allocations made inside it
+		static void record(const char* name, uint64_t start, uint64_t end, uint32_t allocations = 0, uint64_t bytes = 0);
+
+	private:
+		static std::atomic<bool> active_;
+	};
+
+	// RAII zone, see PROFILE_ZONE
+	class ProfileZone {
+	public:
+#ifdef POKEPP_ALLOC_TRACKING
+		explicit ProfileZone(const char* name)
+			: name_(name), start_(Profiler::capturing() ? Profiler::now() : 0) {
+			if (start_) {
+				allocations_ = HeapCounter::threadAllocations();
+				bytes_ = HeapCounter::threadBytes();
+			}
+		}
+
+		~ProfileZone() {
+			if (start_ && Profiler::capturing()) {
+				Profiler::record(name_, start_, Profiler::now(),
+					static_cast<uint32_t>(HeapCounter::threadAllocations() - allocations_), HeapCounter::threadBytes() - bytes_);
+			}
+		}
+#else
+		explicit ProfileZone(const char* name)
+			: name_(name), start_(Profiler::capturing() ? Profiler::now() : 0) {}
+
+		~ProfileZone() {
+			if (start_ && Profiler::capturing()) Profiler::record(name_, start_, Profiler::now());
+		}
+#endif
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		const char* name_;
+		uint64_t start_;
+#ifdef POKEPP_ALLOC_TRACKING
+		uint64_t allocations_ = 0;
+		uint64_t bytes_ = 0;
+#endif
+	};
+
+} // namespace pokepp
+
+#ifdef POKEPP_PROFILER
+#define POKEPP_PROFILE_CONCAT_(a, b) a##b
+#define POKEPP_PROFILE_CONCAT(a, b) POKEPP_PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ::pokepp::ProfileZone POKEPP_PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+	Random header file, defines a small seeded random number generator (PCG32).
+
+	Used for everything the simulation randomizes (spawning, wandering, capture rolls) in
+	place of std::rand, so a session started from the same seed plays out identically.
+	Each generator owns its state, and independent streams of the same seed (e.g. one per
+	Pokemon) never share numbers.
+*/
+
+namespace pokepp {
+
+	class Random {
+	public:
+		explicit Random(uint64_t seed = 0, uint64_t stream = 0) { reseed(seed, stream); }
+
+		void reseed(uint64_t seed, uint64_t stream = 0) {
+			state_ = 0;
+			inc_ = (stream << 1) | 1u;
+			next();
+			state_ += seed;
+			next();
+		}
+
+		// Uniform 32-bit value
+		uint32_t next() {
+			uint64_t old = state_;
+			state_ = old * 6364136223846793005ull + inc_;
+			uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+			uint32_t rot = static_cast<uint32_t>(old >> 59u);
+			return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31u));
+		}
+
+		// Uniform float in [0, 1)
+		float uniform() { return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f); }
+
+		// Uniform float in [lo, hi)
+		float range(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+
+		// Uniform integer in [0, n), n > 0
+		uint32_t index(uint32_t n) { return static_cast<uint32_t>((static_cast<uint64_t>(next()) * n) >> 32); }
+
+	private:
+		friend class SaveGame;
+
+		uint64_t state_ = 0;
+		uint64_t inc_ = 1;
+	};
+
+} // namespace pokepp
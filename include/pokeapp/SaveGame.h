@@ -0,0 +1,140 @@
+#pragma once
+
+#include "pokeapp/Simulation.h"
+#include "pokeapp/PokemonController.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+	SaveGame header file, defines the binary save format for a Simulation's state.
+
+	A save holds everything needed to continue a session: the scene it was populated from,
+	the seeds and random streams, the player, props, wild and sent-out Pokemon, pokeballs
+	(flying, asleep or shaking), capture sessions and the inventory. Loading one and
+	stepping on gives the same states as the session it was taken from (in deterministic
+	mode: a navigation solve still running on a worker is not saved). Derived state
+	(navigation, crowd grid, LOD counters) is rebuilt.
+
+	Layout, all integers and floats little endian:
+		header       "PPSV", format version, endian tag, block count, file size and a
+		             checksum of the block table
+		block table  per block: tag, row count, offset, size and checksum
+		blocks       8-byte aligned. META holds the scalar state; every other block is one
+		             entity kind stored as columns, each a packed array of one field for all
+		             rows, padded to 8 bytes. BORD (the balls' throw order, which decides
+		             the ones recycled when the pool is full) is optional; without it the
+		             balls with the least life left count as the oldest.
+
+	The columns can be read in place from a mapped file; Load reads the file with one call
+	and copies each column into the registry. Entity references (a ball's capture session
+	and target, sent-out Pokemon) are stored as row indices into their blocks. Unknown block
+	tags are skipped, so later versions can add blocks that older readers ignore.
+
+	Saving runs in two steps: Snapshot copies the state into plain arrays (cheap, on the
+	main thread between ticks) and Encode turns a snapshot into the file's bytes (on any
+	thread). A delta file ("PPSD") holds a save as its changed bytes XORed with a full save,
+	with unchanged words left out. Load applies `path`.delta when it was made
+	against the save at `path`.
+*/
+
+namespace pokepp {
+
+	class Model;
+
+	struct SaveInfo {
+		uint32_t version = 0;
+		std::string scene;  // Scene the session was populated from
+		uint64_t seed = 0;
+		size_t props = 0;
+		size_t pokemon = 0;    // In the world, wild or sent out
+		size_t pokeballs = 0;
+		size_t inventory = 0;
+	};
+
+	// Everything a save holds, copied out of a Simulation. Entity references are already
+	// rows. Reusing one keeps its capacity, so taking another snapshot does not allocate.
+	struct SaveSnapshot {
+		std::string scene;
+		uint64_t seed = 0;
+		Random rng;
+		float physicsAccumulator = 0.0f;
+		PlayerState player;
+		uint64_t controllerSeed = 0;
+		Random controllerRng;
+		int32_t nextPokemonId = 1;
+		uint32_t frame = 0;
+
+		std::vector<Transform> propTransforms;
+		std::vector<glm::vec3> propColors;
+		std::vector<Prop> props;
+
+		std::vector<Pokemon> pokemon;
+		std::vector<uint32_t> pokemonSpecies;  // Index into the species table
+
+		std::vector<Transform> ballTransforms;
+		std::vector<Pokeball> balls;
+		std::vector<uint8_t> ballSleeping;
+		std::vector<uint32_t> ballSessions;  // Capture row
+		std::vector<uint32_t> ballTargets;   // Pokemon row
+		std::vector<uint32_t> ballOrder;     // Ball rows by throw order, oldest first
+
+		std::vector<CaptureSession> captures;
+		std::vector<uint32_t> captureBalls;
+		std::vector<uint32_t> capturePokemon;
+
+		std::vector<InventoryEntry> inventory;
+		std::vector<uint32_t> outSlots;
+		std::vector<uint32_t> outRows;
+
+		std::vector<uint32_t> rowOf;  // Scratch: row of each entity index
+	};
+
+	class SaveGame {
+	public:
+		static constexpr uint32_t VERSION = 1;
+
+		// Serialize the simulation's state. `scene` is recorded for the loader to populate
+		// the world and species from.
+		static void Encode(const Simulation& sim, const std::string& scene, std::vector<uint64_t>& out);
+
+		// The same in two steps, see above
+		static void Snapshot(const Simulation& sim, const std::string& scene, SaveSnapshot& out);
+		static void Encode(const SaveSnapshot& snapshot, std::vector<uint64_t>& out);
+
+		// Give every array of a snapshot room for half as many rows again, so the next
+		// Snapshot of a growing state does not allocate. AutoSave calls it on its writer
+		// thread, keeping the allocations off the main thread.
+		static void ReserveSnapshot(SaveSnapshot& snapshot);
+
+		// Delta of an encoded save against a full one (returns its size in bytes), and back.
+		// ApplyDelta fails (printing why) if the delta was made against a different base.
+		static size_t EncodeDelta(std::span<const uint64_t> base, std::span<const uint64_t> save, std::vector<uint64_t>& out);
+		static bool ApplyDelta(std::span<const uint64_t> base, const void* delta, size_t size, std::vector<uint64_t>& out);
+
+		// Size of an encoded save, from its header
+		static size_t EncodedBytes(std::span<const uint64_t> save);
+
+		// Write encoded bytes to `path` through a temporary file, flushed to the disk and
+		// renamed over it in one step
+		static bool WriteFile(const std::string& path, std::span<const uint64_t> data, size_t bytes);
+
+		// Restore a save into a Simulation that has its world and species set (from the save's
+		// scene) and nothing spawned yet. propModels[i] is the model for props scattered from
+		// the scene's i-th prop set (missing or null: none). Call buildNavigation() afterwards.
+		// On failure the reason is printed to stderr and false is returned; the simulation may
+		// then hold part of the save.
+		static bool Decode(const void* data, size_t size, Simulation& sim, std::span<Model* const> propModels = {});
+
+		// The same through a file. Save writes a temporary file and renames it over `path`.
+		static bool Save(const Simulation& sim, const std::string& scene, const std::string& path);
+		static bool Load(const std::string& path, Simulation& sim, std::span<Model* const> propModels = {});
+
+		// Header and META block only, e.g. to find the scene before loading
+		static bool ReadInfo(const std::string& path, SaveInfo& out);
+	};
+
+} // namespace pokepp
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+/*
+	Scene header file, defines the data-driven description of a level: where the terrain
+	comes from, the species table, prop sets and spawn densities. Scenes live in
+	assets/scenes and are loaded by App and the tools, so populations can be changed (or
+	scaled up for stress tests) without recompiling.
+
+	Text form (.scene), one directive per line, `key=value` pairs in any order, `#` starts
+	a comment. Values cannot contain spaces; vectors are comma separated.
+
+		world    heightmap=<path> cell=<m> height=<m>
+		species  name=<name> model=<path> color=r,g,b scale=<display scale> catch=<rate>
+		props    kind=<name> model=<path> count=<n> | density=<per ha>  range=<m> margin=<m>
+		         flat=<min normal y> scale_xz=lo,hi scale_y=lo,hi box_min=x,y,z box_max=x,y,z
+		         color=r,g,b
+		pokemon  count=<n> | density=<per ha>  range=<m> margin=<m> flat=<min normal y>
+		         speed=lo,hi radius=lo,hi
+		balls    count=<n>   (pokeballs kept in flight by pokepp_simbench)
+
+	Keys left out keep the defaults below. A density is per hectare (100 m x 100 m) of the
+	square the group scatters in. The binary form (.pscene, written by pokepp_scenec) holds
+	the same data and loads without any text parsing; Scene::Load accepts either.
+*/
+
+namespace pokepp {
+
+	struct SceneWorld {
+		std::string heightmap = "assets/heightmaps/arena_heightmap.png";
+		float cellSize = 0.5f;
+		float heightScale = 5.0f;
+	};
+
+	struct SceneSpecies {
+		std::string name;
+		std::string model;  // Empty for none
+		glm::vec3 color{ 1.0f };
+		float displayScale = 1.0f;
+		float catchRate = 0.5f;
+	};
+
+	// A kind of prop scattered over flat ground. Each one blocks a box (in local space,
+	// scaled with the prop) in the CollisionWorld.
+	struct ScenePropSet {
+		std::string kind = "rock";
+		std::string model;
+		int count = 0;
+		float density = 0.0f;
+		float range = 100.0f;
+		float margin = 2.0f;
+		float minNormalY = 0.90f;
+		glm::vec2 scaleXZ{ 0.9f, 1.7f };
+		glm::vec2 scaleY{ 0.7f, 1.3f };
+		glm::vec3 boxMin{ -0.5f, 0.0f, -0.5f };
+		glm::vec3 boxMax{ 0.5f, 0.6f, 0.5f };
+		glm::vec3 color{ 0.6f };
+	};
+
+	// Wild Pokemon scattered over flat ground, of random species
+	struct ScenePokemonSpawn {
+		int count = 0;
+		float density = 0.0f;
+		float range = 100.0f;
+		float margin = 5.0f;
+		float minNormalY = 0.85f;
+		glm::vec2 speed{ 1.5f, 3.0f };
+		glm::vec2 radius{ 0.4f, 0.6f };
+	};
+
+	struct Scene {
+		SceneWorld world;
+		std::vector<SceneSpecies> species;
+		std::vector<ScenePropSet> props;
+		std::vector<ScenePokemonSpawn> pokemon;
+		int balls = 0;
+
+		// Load a scene in text or binary form (told apart by the file header). On failure the
+		// reason is printed to stderr and false is returned.
+		static bool Load(const std::string& path, Scene& out);
+
+		bool saveBinary(const std::string& path) const;
+	};
+
+	// Instances a group places: its count, or its density over the square it scatters in
+	int spawnCount(int count, float density, float range, float margin);
+
+} // namespace pokepp
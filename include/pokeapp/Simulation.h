@@ -0,0 +1,201 @@
+#pragma once
+
+#include "pokeapp/Components.h"
+#include "pokeapp/Ecs.h"
+#include "pokeapp/Pokeball.h"
+#include "pokeapp/Pokemon.h"
+#include "pokeapp/Random.h"
+#include "pokeapp/Scene.h"
+#include <glm/glm.hpp>
+#include <memory>
+#include <span>
+#include <vector>
+
+/*
+	Simulation header file, defines the Simulation class that owns all gameplay state:
+	the world and its collision geometry, Pokemon, pokeballs and the player.
+
+	It makes no rendering calls and needs no window or GL context, so it can be driven by
+	App for the game, or headless by tools and benchmarks. A World loaded without a mesh
+	and species without models are enough to run it.
+
+	Props, Pokemon and pokeballs are entities in one Registry (see Ecs.h and Components.h);
+	the renderer queries the same registry to draw them.
+*/
+
+namespace pokepp {
+
+	class Model;
+	class World;
+	class CollisionWorld;
+	class PokemonController;
+	class FlowFieldService;
+	class MemoryReport;
+
+	// Movement intent for one frame, read from the keyboard by App or scripted by tools
+	struct PlayerInput {
+		bool forward = false;
+		bool back = false;
+		bool left = false;
+		bool right = false;
+		bool sprint = false;
+		glm::vec3 front{ 0.0f, 0.0f, -1.0f };  // Look direction, movement is relative to it
+	};
+
+	struct PlayerState {
+		glm::vec3 position{ 0.0f, 2.0f, -5.0f };  // Eye position
+		float verticalVelocity = 0.0f;
+		bool grounded = true;
+		float eyeHeight = 1.7f;
+		float radius = 0.4f;
+		float moveSpeed = 5.0f;
+	};
+
+	// Free-flying pokeballs by physics state, counted by the last physics step
+	struct PokeballStats {
+		size_t active = 0;    // Integrated and collision-tested
+		size_t sleeping = 0;  // At rest, skipped until woken
+	};
+
+	// What throwPokeball does when the pool is full
+	enum class PokeballOverflow {
+		RecycleOldest,  // Remove the oldest ball (by throw order) that is not capturing, then throw
+		Reject,         // Drop the throw
+		Grow,           // Throw anyway; the registry opens chunks past the reservation
+	};
+
+	// Pokeball pool: the registry keeps chunks for `capacity` balls, so throwing and expiring
+	// balls within it never allocates
+	struct PokeballPool {
+		size_t capacity = 0;
+		PokeballOverflow policy = PokeballOverflow::RecycleOldest;
+		size_t highWater = 0;   // Most balls in the world at once
+		size_t overflows = 0;   // Throws made while full (recycled, rejected or grown)
+	};
+
+	class Simulation {
+	public:
+		Simulation();
+		~Simulation();
+
+		Simulation(const Simulation&) = delete;
+		Simulation& operator=(const Simulation&) = delete;
+
+		// Seed for everything the simulation randomizes. Set it before spawning anything.
+		void setSeed(uint64_t seed);
+		uint64_t seed() const { return seed_; }
+		Random& random() { return rng_; }
+
+		// Deterministic mode solves navigation fields inline instead of on workers, so the
+		// same seed and inputs always give the same state. Set it before buildNavigation().
+		void setDeterministic(bool on) { deterministic_ = on; }
+		bool deterministic() const { return deterministic_; }
+
+		// Hash of the gameplay state (player, Pokemon, inventory, pokeballs). Two runs with
+		// the same seed and inputs end with the same hash.
+		uint64_t stateHash() const;
+
+		// Add the CPU memory of the terrain, collision, navigation and entities to a report.
+		// GPU memory and meshes are tracked where they are created (MemoryRegistry).
+		void reportMemory(MemoryReport& out) const;
+
+		// World. Without a mesh the heightfield is only used for queries (headless).
+		bool loadWorld(const char* heightmapPath, float cellSize, float heightScale, bool withMesh = true);
+		World* world() { return world_.get(); }
+		const World* world() const { return world_.get(); }
+		CollisionWorld& collision() { return *collision_; }
+		const CollisionWorld& collision() const { return *collision_; }
+
+		// Species table. Set it before spawning: Pokemon keep pointers into it.
+		void setSpecies(std::vector<PokemonSpecies> species);
+		const std::vector<PokemonSpecies>& species() const { return species_; }
+
+		// Population
+		bool findFlatSpot(float range, float margin, float minNormalY, glm::vec2& out);
+		void spawnPokemonAt(float x, float z, float speed, float radius);
+
+		// Scatter a scene's prop set over flat ground as entities drawn with `model`, registering
+		// each prop's collision box. setIndex is the set's position in the scene (kept in Prop,
+		// so a save can find the model again). Returns the number placed.
+		size_t scatterProps(const ScenePropSet& set, Model* model = nullptr, uint32_t setIndex = 0);
+		void scatterPokemon(const ScenePokemonSpawn& spawn);
+		void buildNavigation();  // Call once the props are in the collision world and the species set
+
+		// Entities: props, Pokemon and pokeballs
+		Registry& entities() { return registry_; }
+		const Registry& entities() const { return registry_; }
+
+		// Pokeballs. throwPokeball returns false if the pool was full and the policy rejected it.
+		bool throwPokeball(const glm::vec3& origin, const glm::vec3& front, float speed);
+		size_t pokeballCount() const { return registry_.count<Pokeball>(); }
+		const PokeballStats& pokeballStats() const { return ballStats_; }
+		void setPokeballPool(size_t capacity, PokeballOverflow policy);
+		const PokeballPool& pokeballPool() const { return ballPool_; }
+		float gravity() const { return gravity_; }
+		float restitution() const { return bounceRestitution_; }
+
+		// Player
+		PlayerState& player() { return player_; }
+		const PlayerState& player() const { return player_; }
+		void jump();
+
+		PokemonController& pokemon() { return *pokemonController_; }
+		const PokemonController& pokemon() const { return *pokemonController_; }
+
+		// Advance the simulation by dt seconds: pokeball physics (in fixed steps), Pokemon,
+		// then the player. The three stages can also be called on their own, e.g. to time them.
+		void tick(float dt, const PlayerInput& input);
+		void stepPokeballs(float dt);
+		void updatePokemon(float dt);
+		void updatePlayer(float dt, const PlayerInput& input);
+
+		// Changes whenever the simulation did work that may allocate: entities created,
+		// destroyed or changing components. Flow field solves do not count; they allocate
+		// only on their worker, and reuse their buffers once each goal has solved.
+		uint64_t allocationEpoch() const;
+
+	private:
+		friend class SaveGame;
+
+		void updatePokeballs(float dt);
+
+		// Herds: a seek field per species toward a target that moves now and then
+		void updateHerds();
+		glm::vec3 herdTarget(size_t species, unsigned epoch) const;
+
+		// Throw order of the balls, for RecycleOldest
+		void recordThrow(Entity ball);
+		Entity takeOldestBall();
+		void compactBallOrder(size_t minSize);
+		void resetBallOrder(std::span<const Entity> order);
+
+		Registry registry_;  // Declared first: PokemonController holds on to it
+		std::unique_ptr<World> world_;
+		std::unique_ptr<CollisionWorld> collision_;
+		std::unique_ptr<PokemonController> pokemonController_;
+		std::unique_ptr<FlowFieldService> flowFields_;
+		int fleeGoal_ = -1;
+		std::vector<int> herdGoals_;  // Per species
+		unsigned herdEpoch_ = ~0u;    // Epoch the herd targets were set for, ~0 for none
+
+		std::vector<PokemonSpecies> species_;
+
+		uint64_t seed_ = 0;
+		Random rng_;  // Spawning
+		bool deterministic_ = false;
+
+		PokeballStats ballStats_;
+		PokeballPool ballPool_;
+		std::vector<Entity> ballOrder_;    // Ring of balls by throw order, oldest at the head. May
+		size_t ballOrderHead_ = 0;         // still hold removed ones, dropped lazily.
+		size_t ballOrderCount_ = 0;
+		uint32_t ballCollisionVersion_ = 0;  // CollisionWorld version the sleeping balls rest on
+		float physicsAccumulator_ = 0.0f;
+
+		PlayerState player_;
+
+		float gravity_ = 9.8f;
+		float bounceRestitution_ = 0.6f;
+	};
+
+} // namespace pokepp
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+	SlotMap header file, defines a generational slot map container and the Handle type
+	used to refer to its elements.
+
+	Elements live in a packed (dense) array, so iterating over them is as fast as iterating a
+	std::vector. A sparse array of slots maps each stable Handle to the element's current
+	position in the dense array. Removing an element swaps the last element into the hole,
+	so insert, erase and lookup are all O(1). Each slot carries a generation counter that is
+	bumped on erase, which means a Handle to a removed element is detected as stale rather
+	than silently pointing at whatever reused the slot.
+*/
+
+namespace pokepp {
+
+	// Stable reference to an element of a SlotMap
+	struct Handle {
+		static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+		uint32_t index = INVALID_INDEX;
+		uint32_t generation = 0;
+
+		bool valid() const { return index != INVALID_INDEX; }
+		bool operator==(const Handle& o) const { return index == o.index && generation == o.generation; }
+		bool operator!=(const Handle& o) const { return !(*this == o); }
+	};
+
+	template <typename T>
+	class SlotMap {
+	public:
+		using iterator = typename std::vector<T>::iterator;
+		using const_iterator = typename std::vector<T>::const_iterator;
+
+		// Construct an element in place and return its handle
+		template <typename... Args>
+		Handle emplace(Args&&... args) {
+			uint32_t slotIdx;
+			if (freeHead_ != Handle::INVALID_INDEX) {
+				// Reuse a free slot (its generation was already bumped on erase)
+				slotIdx = freeHead_;
+				freeHead_ = slots_[slotIdx].next;
+			} else {
+				slotIdx = static_cast<uint32_t>(slots_.size());
+				slots_.push_back({});
+			}
+
+			Slot& s = slots_[slotIdx];
+			s.next = static_cast<uint32_t>(dense_.size()); // occupied slots store their dense index
+			dense_.emplace_back(std::forward<Args>(args)...);
+			denseToSlot_.push_back(slotIdx);
+			return Handle{ slotIdx, s.generation };
+		}
+
+		Handle insert(T value) { return emplace(std::move(value)); }
+
+		// Remove the element referred to by h. Returns false if the handle is stale.
+		bool erase(Handle h) {
+			if (!contains(h)) return false;
+
+			uint32_t denseIdx = slots_[h.index].next;
+			uint32_t lastIdx = static_cast<uint32_t>(dense_.size() - 1);
+
+			// Swap the last element into the hole so the dense array stays packed
+			if (denseIdx != lastIdx) {
+				dense_[denseIdx] = std::move(dense_[lastIdx]);
+				denseToSlot_[denseIdx] = denseToSlot_[lastIdx];
+				slots_[denseToSlot_[denseIdx]].next = denseIdx;
+			}
+			dense_.pop_back();
+			denseToSlot_.pop_back();
+
+			// Invalidate outstanding handles and push the slot onto the free list
+			Slot& s = slots_[h.index];
+			s.generation++;
+			s.next = freeHead_;
+			freeHead_ = h.index;
+			return true;
+		}
+
+		bool contains(Handle h) const {
+			return h.index < slots_.size() && slots_[h.index].generation == h.generation
+				&& slots_[h.index].next < dense_.size() && denseToSlot_[slots_[h.index].next] == h.index;
+		}
+
+		// Lookup by handle, nullptr if the handle is stale
+		T* get(Handle h) { return contains(h) ? &dense_[slots_[h.index].next] : nullptr; }
+		const T* get(Handle h) const { return contains(h) ? &dense_[slots_[h.index].next] : nullptr; }
+
+		// Handle of the element currently stored at a dense position
+		Handle handleAt(size_t denseIdx) const {
+			uint32_t slotIdx = denseToSlot_[denseIdx];
+			return Handle{ slotIdx, slots_[slotIdx].generation };
+		}
+
+		void reserve(size_t n) {
+			dense_.reserve(n);
+			denseToSlot_.reserve(n);
+			slots_.reserve(n);
+		}
+
+		void clear() {
+			// Erase one by one so that every outstanding handle becomes stale
+			while (!dense_.empty()) erase(handleAt(dense_.size() - 1));
+		}
+
+		size_t size() const { return dense_.size(); }
+		size_t memoryBytes() const {
+			return dense_.capacity() * sizeof(T) + denseToSlot_.capacity() * sizeof(uint32_t) + slots_.capacity() * sizeof(Slot);
+		}
+		bool empty() const { return dense_.empty(); }
+
+		T& operator[](size_t denseIdx) { return dense_[denseIdx]; }
+		const T& operator[](size_t denseIdx) const { return dense_[denseIdx]; }
+
+		iterator begin() { return dense_.begin(); }
+		iterator end() { return dense_.end(); }
+		const_iterator begin() const { return dense_.begin(); }
+		const_iterator end() const { return dense_.end(); }
+
+		T* data() { return dense_.data(); }
+		const T* data() const { return dense_.data(); }
+
+	private:
+		struct Slot {
+			uint32_t generation = 0;
+			uint32_t next = Handle::INVALID_INDEX; // dense index when occupied, next free slot otherwise
+		};
+
+		std::vector<T> dense_;              // packed elements
+		std::vector<uint32_t> denseToSlot_; // dense index -> slot index
+		std::vector<Slot> slots_;           // slot index -> dense index + generation
+		uint32_t freeHead_ = Handle::INVALID_INDEX;
+	};
+
+} // namespace pokepp
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <memory>
+#include "pokeapp/Memory.h"
 
 /*
 	Texture header file, defines a Texture class for loading and managing textures in OpenGL.
@@ -23,4 +24,5 @@ public:
 private:
     unsigned int id_ = 0;
     std::string path_;
+    pokepp::TrackedMemory memory_;  // Texels of every mip level
 };
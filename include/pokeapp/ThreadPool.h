@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+	ThreadPool header file, defines a small fixed-size pool of worker threads.
+	Used to run background jobs (e.g. flow field solves) and to split data-parallel
+	loops across cores.
+
+	Long background jobs go to background(), a pool of its own: parallelFor() waits for
+	every chunk it queued, so a solve queued on (or running on) the shared pool would hold
+	the frame's chunks back behind it.
+
+	parallelFor() runs every frame, so it does not allocate: the loop body is passed by
+	reference, and the jobs it queues are small enough for std::function's inline storage.
+	The queue is a ring buffer that keeps its capacity.
+*/
+
+namespace pokepp {
+
+	class ThreadPool {
+	public:
+		// threadCount = 0 picks one worker per hardware thread (minus the main thread)
+		explicit ThreadPool(unsigned threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// Queue a job to run on a worker thread
+		void submit(std::function<void()> job);
+
+		// Run fn(begin, end) over [0, count) split into chunks of at least minChunk items.
+		// The calling thread takes part and the call returns once every chunk is done.
+		template <typename Fn>
+		void parallelFor(size_t count, size_t minChunk, Fn&& fn) {
+			using F = std::remove_reference_t<Fn>;
+			parallelForImpl(count, minChunk, const_cast<void*>(static_cast<const void*>(&fn)),
+				[](void* f, size_t begin, size_t end) { (*static_cast<F*>(f))(begin, end); });
+		}
+
+		// Block until the queue is empty and no job is running
+		void waitIdle();
+
+		unsigned threadCount() const { return static_cast<unsigned>(workers_.size()); }
+
+		// Shared pool for engine systems: the frame's data-parallel work
+		static ThreadPool& shared();
+
+		// One worker for long jobs that must not delay the frame (flow field solves)
+		static ThreadPool& background();
+
+	private:
+		using RangeFn = void (*)(void* fn, size_t begin, size_t end);
+
+		void parallelForImpl(size_t count, size_t minChunk, void* fn, RangeFn invoke);
+		void workerLoop();
+
+		std::vector<std::thread> workers_;
+		std::vector<std::function<void()>> jobs_;  // Ring buffer of jobCount_ jobs from jobHead_
+		size_t jobHead_ = 0;
+		size_t jobCount_ = 0;
+		std::mutex mutex_;
+		std::condition_variable jobAvailable_;
+		std::condition_variable idle_;
+		size_t running_ = 0;
+		bool stopping_ = false;
+	};
+
+} // namespace pokepp
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+/*
+	Trajectory header file, defines the TrajectoryPredictor used for the throw preview.
+
+	The flight path is evaluated from the closed-form parabola instead of being integrated
+	step by step, and contacts and bounces go through the same helpers the real pokeballs
+	use (CollisionWorld::SweepBall and BounceBall), so the preview matches the actual throw. The result is
+	cached and only recomputed when the throw or the world changes noticeably.
+*/
+
+namespace pokepp {
+
+	class World;
+	class CollisionWorld;
+
+	// Launch conditions and material of a throw
+	struct ThrowParams {
+		glm::vec3 origin{ 0.0f };
+		glm::vec3 velocity{ 0.0f };
+		float radius = 0.3f;
+		float gravity = 9.8f;
+		float restitution = 0.6f;
+		float friction = 0.95f;     // Tangential velocity kept on a bounce
+		float groundY = 0.0f;       // Flat ground used when there is no World
+	};
+
+	class TrajectoryPredictor {
+	public:
+		// maxPoints samples spaced sampleStep seconds apart
+		explicit TrajectoryPredictor(int maxPoints = 64, float sampleStep = 1.0f / 30.0f);
+
+		// Recompute the points if the throw moved by more than the tolerances, or if the world
+		// or its collision geometry changed. Returns true if the points were recomputed.
+		bool update(const ThrowParams& params, const World* world, const CollisionWorld* collision);
+
+		// Largest change in origin (meters) and launch velocity (m/s) that reuses the cache
+		void setTolerance(float positionEps, float velocityEps) { positionEps_ = positionEps; velocityEps_ = velocityEps; }
+
+		const std::vector<glm::vec3>& points() const { return points_; }
+
+		// Bumped every time the points are recomputed, so consumers can skip re-uploading
+		uint32_t revision() const { return revision_; }
+
+		void invalidate() { valid_ = false; }
+
+	private:
+		void solve(const ThrowParams& params, const World* world, const CollisionWorld* collision);
+
+		int maxPoints_;
+		float sampleStep_;
+		float positionEps_ = 0.01f;
+		float velocityEps_ = 0.01f;
+
+		// Inputs of the cached solution
+		bool valid_ = false;
+		ThrowParams cached_;
+		const World* world_ = nullptr;
+		const CollisionWorld* collision_ = nullptr;
+		uint32_t collisionVersion_ = 0;
+
+		std::vector<glm::vec3> points_;
+		uint32_t revision_ = 0;
+	};
+
+} // namespace pokepp
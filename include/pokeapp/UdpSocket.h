@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+	UdpSocket header file, defines a minimal non-blocking IPv4 UDP socket for the network
+	server and client (Winsock on Windows, BSD sockets elsewhere).
+
+	send and receive never block; wait() sleeps until a datagram arrives or a timeout passes.
+	Errors are reported by return values: send returns false, receive returns 0.
+*/
+
+namespace pokepp {
+
+	struct NetAddress {
+		uint32_t ip = 0;    // Host byte order
+		uint16_t port = 0;
+
+		bool operator==(const NetAddress& o) const { return ip == o.ip && port == o.port; }
+		bool operator!=(const NetAddress& o) const { return !(*this == o); }
+
+		std::string toString() const;
+
+		// "host:port" (a name or dotted IPv4 address) or "port" for the loopback address.
+		// Prints the reason to stderr and returns false if it does not resolve.
+		static bool Parse(const std::string& text, NetAddress& out);
+		static NetAddress Loopback(uint16_t port);
+	};
+
+	class UdpSocket {
+	public:
+		UdpSocket() = default;
+		~UdpSocket();
+
+		UdpSocket(const UdpSocket&) = delete;
+		UdpSocket& operator=(const UdpSocket&) = delete;
+
+		// Bind to `port` (0 picks a free one) on the loopback interface, or on all interfaces
+		bool open(uint16_t port = 0, bool loopbackOnly = true);
+		void close();
+		bool isOpen() const { return handle_ != INVALID; }
+		uint16_t port() const { return port_; }  // Bound port
+
+		bool send(const NetAddress& to, const void* data, size_t size);
+
+		// Copy the next waiting datagram into buf and return its size; 0 if none is waiting.
+		// Datagrams that do not fit (capacity bytes or more) are dropped.
+		size_t receive(NetAddress& from, void* buf, size_t capacity);
+
+		// Block until a datagram is waiting or `ms` milliseconds passed. True if one is waiting.
+		bool wait(int ms);
+
+	private:
+		static constexpr intptr_t INVALID = -1;
+
+		intptr_t handle_ = INVALID;  // SOCKET on Windows, a file descriptor elsewhere
+		uint16_t port_ = 0;
+	};
+
+} // namespace pokepp
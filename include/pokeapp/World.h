@@ -12,7 +12,7 @@ namespace pokepp {
 
 class World {
 public:
-	World();
+	explicit World(bool withMesh = true);
 	~World();
 
 	static std::unique_ptr<Mesh> makeGround(int n, float size);
@@ -22,9 +22,26 @@ public:
 	float heightAt(float x, float z) const;
 	glm::vec3 normalAt(float x, float z) const;
 
+	// Sweep a sphere from `from` to `to` against the terrain. On a hit, toi is the fraction of
+	// the segment travelled before contact (0-1) and normal is the terrain normal there.
+	bool sweepSphere(const glm::vec3& from, const glm::vec3& to, float radius,
+	                 float& toi, glm::vec3& normal) const;
+
+	// Segment test, same as a sweep with a zero radius
+	bool raycast(const glm::vec3& from, const glm::vec3& to, float& toi, glm::vec3& normal) const {
+		return sweepSphere(from, to, 0.0f, toi, normal);
+	}
+
+	// Half size of the terrain in meters along x and z (centered on the origin)
+	glm::vec2 halfExtents() const { return { halfWm_, halfZm_ }; }
+
+	// Bytes held by the heightfield
+	size_t heightsMemory() const { return heights_.capacity() * sizeof(float); }
+
 	void draw(const Shader& shader, const glm::mat4& view, const glm::mat4& proj) const;
 
-	static std::unique_ptr<World> FromHeightMap(const char* path, float cellSize, float heightScale);
+	// withMesh = false loads the heights only (no GL calls), for headless simulation
+	static std::unique_ptr<World> FromHeightMap(const char* path, float cellSize, float heightScale, bool withMesh = true);
 
 	// Textures
 	std::unique_ptr<Texture> grassTex_;
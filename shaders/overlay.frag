@@ -0,0 +1,12 @@
+#version 330 core
+
+in vec2 vUV;
+in vec4 vColor;
+
+uniform sampler2D uFont;  // Coverage in red; shapes sample a solid cell
+
+out vec4 FragColor;
+
+void main() {
+    FragColor = vec4(vColor.rgb, vColor.a * texture(uFont, vUV).r);
+}
@@ -5,6 +5,18 @@
 #include "pokeapp/Model.h"
 #include "pokeapp/PokemonController.h"
 #include "pokeapp/Pokeball.h"
+#include "pokeapp/CollisionWorld.h"
+#include "pokeapp/Trajectory.h"
+#include "pokeapp/Simulation.h"
+#include "pokeapp/Scene.h"
+#include "pokeapp/SaveGame.h"
+#include "pokeapp/AutoSave.h"
+#include "pokeapp/NetClient.h"
+#include "pokeapp/Profiler.h"
+#include "pokeapp/DebugOverlay.h"
+#include "pokeapp/GlCounters.h"
+#include "pokeapp/FrameArena.h"
+#include "pokeapp/HeapCounter.h"
 
 #include <glad/glad.h>
 #include <SDL.h>
@@ -12,9 +24,12 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cassert>
 #include <cstdio>
+#include <ctime>
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 
 /*
@@ -33,6 +48,22 @@ namespace {
 	constexpr glm::vec3 CAMERA_RESET_FRONT{ 0.0f, -0.3f, -1.0f };
 	constexpr glm::vec3 GRID_COLOR{ 0.25f, 0.25f, 0.25f };
 
+	// Live play drops frame time beyond this many ticks instead of falling further behind
+	constexpr int MAX_TICKS_PER_FRAME = 5;
+
+	using Clock = std::chrono::steady_clock;
+
+	double msSince(Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Count a draw call of the App's own geometry in the frame's RenderStats
+	void countDraw(GLenum mode, GLsizei count) {
+		pokepp::RenderStats& stats = pokepp::renderStats();
+		stats.drawCalls++;
+		if (mode == GL_TRIANGLES) stats.triangles += count / 3;
+	}
+
 	// Utility function to check for OpenGL errors
 	void checkGLError(const char* operation) {
 		GLenum error = glGetError();
@@ -42,85 +73,140 @@ namespace {
 	}
 }
 
-App::App() = default;
+App::App(const AppOptions& options)
+	: options_(options), frameStats_(HUD_FRAME_WINDOW) {}
 
 App::~App() {
 	cleanup();
 }
 
+const pokepp::PokeballStats& App::pokeballStats() const {
+	return sim_->pokeballStats();
+}
+
 // Initialize the application
 bool App::init() {
-	// Seed random number generator (for scattering rocks and Pokemon)
-	std::srand(static_cast<unsigned int>(std::time(nullptr)));
+	// Seed for scattering rocks and Pokemon and for everything else the simulation
+	// randomizes. A replay takes the scene, seed and window size it was recorded with.
+	uint64_t seed = options_.seed ? options_.seed : static_cast<uint64_t>(std::time(nullptr));
+	if (replaying()) {
+		if (!replayLog_.load(options_.replayPath)) {
+			std::cerr << "Failed to load replay " << options_.replayPath << std::endl;
+			return false;
+		}
+		options_.scenePath = replayLog_.header().scene;
+		seed = replayLog_.header().seed;
+		width_ = replayLog_.header().width;
+		height_ = replayLog_.header().height;
+	}
+
+	// A save names the scene its world and species come from
+	if (!options_.loadPath.empty()) {
+		pokepp::SaveInfo info;
+		if (!pokepp::SaveGame::ReadInfo(options_.loadPath, info)) return false;
+		options_.scenePath = info.scene;
+		seed = info.seed;
+	}
+
+	// A server sends the scene and seed its world was populated from
+	if (!options_.connectAddress.empty()) {
+		pokepp::NetAddress server;
+		net_ = std::make_unique<pokepp::NetClient>();
+		if (!pokepp::NetAddress::Parse(options_.connectAddress, server) || !net_->connect(server)) return false;
+		options_.scenePath = net_->session().scene;
+		seed = net_->session().seed;
+		std::cout << "Connected to " << server.toString() << " as client " << net_->session().clientId << std::endl;
+	}
+
+	// The scene declares the world, species, props and spawn densities
+	pokepp::Scene scene;
+	if (!pokepp::Scene::Load(options_.scenePath, scene)) return false;
 	
-	// Initialize key systems
-	if (!initSDL()) return false;
-	if (!initOpenGL()) return false;
-	if (!initShaders()) return false;
-	if (!initGeometry()) return false;
-	if (!initUniforms()) return false;
+	// Initialize key systems. Headless runs have no window or GL context.
+	if (!options_.headless) {
+		if (!initSDL()) return false;
+		if (!initOpenGL()) return false;
+		if (!initShaders()) return false;
+		if (!initGeometry()) return false;
+		if (!initUniforms()) return false;
+	}
 
 	running_ = true;
-	world_ = pokepp::World::FromHeightMap("assets/heightmaps/arena_heightmap.png", 0.5f, 5.0f); // Load heightmap world
-	pokemonController_ = std::make_unique<pokepp::PokemonController>(); // Create Pokemon controller
-
-	try {
-		// Load our 3D models 
-		rockModel_ = std::make_shared<pokepp::Model>("assets/models/rock.obj");
-		treeModel_ = std::make_shared<pokepp::Model>("assets/models/tree.obj");
-		auto pikachuModel = std::make_shared<pokepp::Model>("assets/models/pokemon/pikachu.obj");
-		auto charmanderModel = std::make_shared<pokepp::Model>("assets/models/pokemon/charmander.obj");
-		auto squirtleModel = std::make_shared<pokepp::Model>("assets/models/pokemon/squirtle.obj");
-		auto bulbasaurModel = std::make_shared<pokepp::Model>("assets/models/pokemon/001.obj");
-		
-		// Register Pokemon species with their properties
-		pokemonSpecies_.push_back({
-			.name = "Pikachu",
-			.model = pikachuModel.get(),
-			.displayColor = glm::vec3(1.0f, 0.9f, 0.2f),
-			.displayScale = 0.25f,
-			.catchRate = 0.7f 
+	sim_ = std::make_unique<pokepp::Simulation>(); // Gameplay state (world, Pokemon, pokeballs, player)
+	sim_->setSeed(seed);
+	sim_->setDeterministic(replaying() || !options_.recordPath.empty());
+	sim_->loadWorld(scene.world.heightmap.c_str(), scene.world.cellSize, scene.world.heightScale, !options_.headless); // Load heightmap world
+	sim_->player().position = camPos_;
+
+	// Register Pokemon species with their properties. Models are shared through the model
+	// cache; headless runs have none, and species work without.
+	std::vector<pokepp::PokemonSpecies> pokemonSpecies;
+	for (const pokepp::SceneSpecies& s : scene.species) {
+		pokemonSpecies.push_back({
+			.name = s.name,
+			.model = loadModel(s.model).get(),
+			.displayColor = s.color,
+			.displayScale = s.displayScale,
+			.catchRate = s.catchRate
 		});
-		
-		pokemonSpecies_.push_back({
-			.name = "Charmander",
-			.model = charmanderModel.get(),
-			.displayColor = glm::vec3(1.0f, 0.5f, 0.1f),
-			.displayScale = 0.7f,
-			.catchRate = 0.3f // make Charmander harder to catch :)
-		});
-		
-		pokemonSpecies_.push_back({
-			.name = "Squirtle",
-			.model = squirtleModel.get(),
-			.displayColor = glm::vec3(0.3f, 0.6f, 1.0f),
-			.displayScale = 0.85f,
-			.catchRate = 0.5f 
-		});
-		
-		pokemonSpecies_.push_back({
-			.name = "Bulbasaur",
-			.model = bulbasaurModel.get(),
-			.displayColor = glm::vec3(0.3f, 0.8f, 0.4f),
-			.displayScale = 100.00f,
-			.catchRate = 0.5f 
-		});
-		
-		// Store shared_ptrs to keep models alive
-		speciesModels_.push_back(pikachuModel);
-		speciesModels_.push_back(charmanderModel);
-		speciesModels_.push_back(squirtleModel);
-		speciesModels_.push_back(bulbasaurModel);
-		
-	} catch (const std::exception& e) {
-		std::cerr << "Failed to load models: " << e.what() << std::endl;
 	}
 
-	lastTicks_ = SDL_GetTicks(); // Initialize timing, used for delta-time calculations
+	lastCounter_ = SDL_GetPerformanceCounter(); // Initialize timing, used for delta-time calculations
 
-	// Populate the world with props and Pokemon
-	scatterRocks(50);
-	scatterPokemon(20);
+	// Pokemon keep pointers into the species table, so hand it over before spawning
+	sim_->setSpecies(std::move(pokemonSpecies));
+
+	// Populate the world with props and Pokemon, or restore them from a save. Connected
+	// to a server, only the props are placed (the same way as the server, from its seed);
+	// Pokemon and pokeballs come from its snapshots.
+	if (net_) {
+		for (size_t i = 0; i < scene.props.size(); ++i) {
+			addProps(scene.props[i], static_cast<uint32_t>(i));
+		}
+	} else if (!options_.loadPath.empty()) {
+		std::vector<pokepp::Model*> propModels;
+		for (const pokepp::ScenePropSet& set : scene.props) {
+			propModels.push_back(loadModel(set.model).get());
+		}
+		if (!pokepp::SaveGame::Load(options_.loadPath, *sim_, propModels)) return false;
+		camPos_ = sim_->player().position;
+	} else {
+		for (size_t i = 0; i < scene.props.size(); ++i) {
+			addProps(scene.props[i], static_cast<uint32_t>(i));
+		}
+		for (const pokepp::ScenePokemonSpawn& spawn : scene.pokemon) {
+			sim_->scatterPokemon(spawn);
+		}
+	}
+	if (!net_) sim_->buildNavigation();
+
+	if (!options_.autosavePath.empty()) {
+		autosave_ = std::make_unique<pokepp::AutoSave>(options_.autosavePath, options_.scenePath);
+	}
+
+	// Input log and timing output
+	if (!options_.recordPath.empty()) {
+		pokepp::InputLogHeader header;
+		header.scene = options_.scenePath;
+		header.seed = seed;
+		header.timestep = PHYSICS_TIMESTEP;
+		header.width = width_;
+		header.height = height_;
+		if (!recorder_.open(options_.recordPath, header)) {
+			std::cerr << "Failed to open input log " << options_.recordPath << ", not recording" << std::endl;
+		}
+	}
+	if (!options_.timingPath.empty()) {
+		timingFile_.open(options_.timingPath);
+		if (timingFile_.is_open()) {
+			timingFile_ << "frame,tick,ticks_run,frame_ms,sim_ms,render_ms,state_hash\n";
+		} else {
+			std::cerr << "Failed to open timing file " << options_.timingPath << std::endl;
+		}
+	}
+
+	pokepp::Profiler::setThreadName("main");
+	if (!options_.tracePath.empty()) captureProfile(options_.tracePath);
 
 	std::cout << "App initialized successfully!" << std::endl;
 	return true;
@@ -128,83 +214,412 @@ bool App::init() {
 
 // Main application tick/update, called once per frame. Calls various update methods.
 void App::tick() {
-	updateTiming();
-	updatePhysics();
-	handleInput();
-	updateCameraMovement();
-	updateLighting();
-	render();
+	checkFrameAllocations();
+	pokepp::frameArena().reset();
+
+	// Save the zones of a spike frame before the profiler moves on to the next frame
+	if (spikePending_) saveSpike();
+	if (pokepp::Profiler::capturing()) frameMayAllocate_ = true;  // The last frame writes the trace
+	pokepp::Profiler::frame();
+	pokepp::GlCounters::endFrame();
+	PROFILE_ZONE("App::tick");
+
+	auto frameStart = Clock::now();
+	{
+		PROFILE_ZONE("timing");
+		updateTiming();
+	}
+	{
+		PROFILE_ZONE("input");
+		handleInput();
+	}
+	if (!running_) return; // Quit: don't run ticks past the recorded end
+
+	auto simStart = Clock::now();
+	int ticksRun;
+	{
+		PROFILE_ZONE("physics");
+		ticksRun = updatePhysics();
+	}
+	double simMs = msSince(simStart);
+
+	{
+		PROFILE_ZONE("lighting");
+		updateLighting();
+	}
+
+	auto renderStart = Clock::now();
+	if (!options_.headless) render();
+	double renderMs = msSince(renderStart);
+
+	double frameMs = msSince(frameStart);
+	if (timingFile_.is_open()) writeTimingRow(frameMs, simMs, renderMs, ticksRun);
+	if (!options_.headless) recordFrameStats(frameMs - swapMs_);
+	frame_++;
 }
 
-// Update timing information (delta time, physics timestep)
+// Update timing information (frame delta time), from the high resolution counter since
+// millisecond ticks are too coarse for frame times
 void App::updateTiming() {
-	uint32_t now = SDL_GetTicks();
-	dt_ = (now - lastTicks_) / 1000.0f;
-	lastTicks_ = now;
+	uint64_t now = SDL_GetPerformanceCounter();
+	dt_ = static_cast<float>(static_cast<double>(now - lastCounter_) / static_cast<double>(SDL_GetPerformanceFrequency()));
+	lastCounter_ = now;
 	t_ += dt_;
+}
 
-	static float acc = 0.f;
-	const float h = PHYSICS_TIMESTEP;
-	acc += dt_;
-	while (acc >= h) {
-		updatePokeballs(h);
-		acc -= h;
+// Advance the simulation in fixed PHYSICS_TIMESTEP ticks and return how many ran. Live play
+// runs as many ticks as the frame time covers. A replay runs exactly one tick per frame,
+// after applying the input recorded for it, so it plays back as fast as frames allow.
+int App::updatePhysics() {
+	if (net_) {
+		updateNetwork();
+		return 0;
+	}
+	if (replaying()) {
+		bool done = replayLog_.complete()
+			? simTick_ >= replayLog_.tickCount()
+			: replayCursor_ >= replayLog_.events().size();
+		if (done) {
+			finishReplay();
+			return 0;
+		}
+		applyReplayInput();
+		stepSimulation();
+		return 1;
+	}
+
+	simAccumulator_ += dt_;
+	int ticks = 0;
+	while (simAccumulator_ >= PHYSICS_TIMESTEP && ticks < MAX_TICKS_PER_FRAME) {
+		stepSimulation();
+		simAccumulator_ -= PHYSICS_TIMESTEP;
+		ticks++;
 	}
+	if (simAccumulator_ >= PHYSICS_TIMESTEP) simAccumulator_ = 0.0f; // Too far behind, drop the rest
+	return ticks;
 }
 
-// Update physics for player and Pokemon
-void App::updatePhysics() {
+// Run one simulation tick: throw charge, pokeball physics, Pokemon, then the player. Only
+// input state is read here (held keys, camera direction), never the wall clock.
+void App::stepSimulation() {
+	const float h = PHYSICS_TIMESTEP;
+
+	if (isCharging_) {
+		charge_ = glm::clamp(charge_ + h / maxChargeSeconds_, 0.0f, 1.0f);
+	}
+
+	pokepp::PlayerInput input;
+	input.forward = keysHeld_[SDL_SCANCODE_W];
+	input.back = keysHeld_[SDL_SCANCODE_S];
+	input.left = keysHeld_[SDL_SCANCODE_A];
+	input.right = keysHeld_[SDL_SCANCODE_D];
+	input.sprint = keysHeld_[SDL_SCANCODE_LSHIFT];
+	input.front = camFront_;
+
+	sim_->tick(h, input);
+	camPos_ = sim_->player().position; // The camera follows the player's eye
+	simTick_++;
+
+	// Autosave at the tick boundary: only the snapshot runs here, the write is in the background
+	const uint32_t autosaveTicks = static_cast<uint32_t>(std::lround(AUTOSAVE_INTERVAL_SECONDS / h));
+	if (autosave_ && simTick_ - lastAutosaveTick_ >= autosaveTicks) {
+		lastAutosaveTick_ = simTick_;
+		autosave_->save(*sim_);
+	}
+}
 
-	// Build obstacle list from props
-	std::vector<glm::vec3> obstacles;
-	obstacles.reserve(props_.size());
-	for (const auto& prop : props_) {
-		obstacles.push_back(prop.pos);
+// Network play: send this frame's input to the server and show its latest snapshots,
+// interpolated. The simulation is not ticked. Entities appear and leave with the
+// snapshots, so these frames are not heap checked.
+void App::updateNetwork() {
+	if (isCharging_) {
+		charge_ = glm::clamp(charge_ + dt_ / maxChargeSeconds_, 0.0f, 1.0f);
 	}
 
-	// Update all Pokemon with world and obstacle info
-	if (pokemonController_) {
-		pokemonController_->updateAll(dt_, world_.get(), obstacles);
-		
-		// Move captured Pokemon to inventory automatically
-		pokemonController_->updateInventory();
+	pokepp::PlayerInput movement;
+	movement.forward = keysHeld_[SDL_SCANCODE_W];
+	movement.back = keysHeld_[SDL_SCANCODE_S];
+	movement.left = keysHeld_[SDL_SCANCODE_A];
+	movement.right = keysHeld_[SDL_SCANCODE_D];
+	movement.sprint = keysHeld_[SDL_SCANCODE_LSHIFT];
+	movement.front = camFront_;
+
+	pokepp::NetInput input;
+	input.setMovement(movement);
+	input.jumps = netJumps_;
+	input.throws = netThrows_;
+	input.throwSpeed = netThrowSpeed_;
+	net_->update(dt_, input);
+
+	if (net_->ready()) {
+		net_->applyTo(*sim_);
+		camPos_ = sim_->player().position;
 	}
+	frameMayAllocate_ = true;
 }
 
-// Handle user input events
+// Handle user input events. Game input is turned into InputEvents tagged with the next
+// simulation tick, recorded if a log is being written, and applied. During a replay live
+// input is ignored apart from quitting; the recorded events are applied by updatePhysics.
 void App::handleInput() {
+	if (options_.headless) return;
+
 	SDL_Event e;
 	while (SDL_PollEvent(&e)) {
+		pokepp::InputEvent event;
+		event.tick = simTick_;
+
 		switch (e.type) {
 		case SDL_QUIT:
 			running_ = false;
-			break;
+			continue;
 
 		case SDL_KEYDOWN:
-			handleKeyDown(e.key.keysym.sym);
+			// Profiler capture works in replays too and is never recorded
+			if (e.key.keysym.sym == SDLK_F9) {
+				captureProfile("pokepp_trace.json");
+				continue;
+			}
+			if (e.key.keysym.sym == SDLK_F3) {
+				toggleHud();
+				continue;
+			}
+			if (e.key.keysym.sym == SDLK_F10) {
+				dumpMemory("pokepp_memory.json");
+				continue;
+			}
+			if (e.key.keysym.sym == SDLK_F5 && !replaying() && !net_) {
+				saveGame("quicksave.ppsave");
+				continue;
+			}
+			[[fallthrough]];
+
+		case SDL_KEYUP:
+			event.type = (e.type == SDL_KEYDOWN) ? pokepp::InputEventType::KeyDown : pokepp::InputEventType::KeyUp;
+			event.a = e.key.keysym.sym;
+			event.b = e.key.keysym.scancode;
 			break;
 
 		case SDL_MOUSEMOTION:
-			handleMouseMotion(e.motion.xrel, e.motion.yrel);
+			event.type = pokepp::InputEventType::MouseMotion;
+			event.a = e.motion.xrel;
+			event.b = e.motion.yrel;
 			break;
 
 		case SDL_MOUSEBUTTONDOWN:
-			handleMouseButtonDown(e.button.button);
-			break;
-
 		case SDL_MOUSEBUTTONUP:
-			handleMouseButtonUp(e.button.button);
+			event.type = (e.type == SDL_MOUSEBUTTONDOWN) ? pokepp::InputEventType::MouseButtonDown : pokepp::InputEventType::MouseButtonUp;
+			event.a = e.button.button;
 			break;
 
 		case SDL_WINDOWEVENT:
-			if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-				handleWindowResize(e.window.data1, e.window.data2);
-			}
+			if (e.window.event != SDL_WINDOWEVENT_SIZE_CHANGED) continue;
+			event.type = pokepp::InputEventType::Resize;
+			event.a = e.window.data1;
+			event.b = e.window.data2;
 			break;
+
+		default:
+			continue;
+		}
+
+		if (replaying()) {
+			if (event.type == pokepp::InputEventType::KeyDown && event.a == SDLK_ESCAPE) running_ = false;
+			continue;
 		}
+
+		recorder_.record(event);
+		applyInput(event);
 	}
 }
 
+// Apply one input event, live or replayed
+void App::applyInput(const pokepp::InputEvent& event) {
+	switch (event.type) {
+	case pokepp::InputEventType::KeyDown:
+		if (event.b >= 0 && event.b < SDL_NUM_SCANCODES) keysHeld_[event.b] = true;
+		handleKeyDown(static_cast<SDL_Keycode>(event.a));
+		break;
+
+	case pokepp::InputEventType::KeyUp:
+		handleKeyUp(static_cast<SDL_Scancode>(event.b));
+		break;
+
+	case pokepp::InputEventType::MouseMotion:
+		handleMouseMotion(event.a, event.b);
+		break;
+
+	case pokepp::InputEventType::MouseButtonDown:
+		handleMouseButtonDown(static_cast<Uint8>(event.a));
+		break;
+
+	case pokepp::InputEventType::MouseButtonUp:
+		handleMouseButtonUp(static_cast<Uint8>(event.a));
+		break;
+
+	case pokepp::InputEventType::Resize:
+		handleWindowResize(event.a, event.b);
+		break;
+	}
+}
+
+// Apply the recorded events that go before the next tick
+void App::applyReplayInput() {
+	const auto& events = replayLog_.events();
+	while (replayCursor_ < events.size() && events[replayCursor_].tick <= simTick_) {
+		applyInput(events[replayCursor_++]);
+	}
+}
+
+// Stop the replay and check the final state against the one recorded. A mismatch means the
+// simulation did something different with the same seed and input.
+void App::finishReplay() {
+	running_ = false;
+
+	if (!replayLog_.complete()) {
+		std::cout << "Replay ended after " << simTick_ << " ticks (log has no end marker, state not verified)" << std::endl;
+		return;
+	}
+
+	uint64_t hash = sim_->stateHash();
+	bool match = (hash == replayLog_.stateHash());
+	std::printf("Replay finished: %u ticks, state hash %016llx, recorded %016llx: %s\n",
+		simTick_, static_cast<unsigned long long>(hash),
+		static_cast<unsigned long long>(replayLog_.stateHash()), match ? "match" : "MISMATCH");
+	if (!match) exitCode_ = 2;
+}
+
+// Profile the next PROFILER_CAPTURE_FRAMES frames into a Chrome trace
+void App::captureProfile(const std::string& path) {
+	frameMayAllocate_ = true;
+#ifdef POKEPP_PROFILER
+	if (pokepp::Profiler::capture(PROFILER_CAPTURE_FRAMES, path)) {
+		std::cout << "Profiling " << PROFILER_CAPTURE_FRAMES << " frames to " << path << std::endl;
+	}
+#else
+	std::cout << "Profiler not built in (configure with -DPOKEPP_PROFILER=ON)" << std::endl;
+#endif
+}
+
+// Print GPU and CPU memory by asset and subsystem, write it as JSON and check the budgets
+void App::dumpMemory(const std::string& path) {
+	frameMayAllocate_ = true;
+	pokepp::MemoryReport report;
+	pokepp::MemoryRegistry::report(report);
+	if (sim_) sim_->reportMemory(report);
+
+	report.print(stdout);
+	if (!report.writeJson(path)) {
+		std::cerr << "Failed to write memory report " << path << std::endl;
+	} else {
+		std::cout << "Memory report written to " << path << std::endl;
+	}
+	if (!report.withinBudgets()) std::cerr << "Warning: memory over budget" << std::endl;
+}
+
+// Save the session between ticks. Continue it with --load.
+void App::saveGame(const std::string& path) {
+	frameMayAllocate_ = true;
+	if (!sim_) return;
+	if (!pokepp::SaveGame::Save(*sim_, options_.scenePath, path)) {
+		std::cerr << "Failed to write save " << path << std::endl;
+	} else {
+		std::cout << "Game saved to " << path << std::endl;
+	}
+}
+
+// Show or hide the debug HUD. While it is shown the profiler keeps the latest frame, so
+// spike frames can be saved with their zones.
+void App::toggleHud() {
+	frameMayAllocate_ = true;
+	showHud_ = !showHud_;
+#ifdef POKEPP_PROFILER
+	pokepp::Profiler::setFrameHistory(showHud_);
+#endif
+}
+
+// Add a frame to the HUD statistics. With the HUD shown, a frame whose CPU work took longer
+// than HUD_SPIKE_MS is a spike and gets its zones saved at the start of the next frame.
+void App::recordFrameStats(double cpuMs) {
+	frameStats_.add(static_cast<float>(cpuMs), gpuTimer_->lastMs(), dt_ * 1000.0f);
+	if (showHud_ && cpuMs > HUD_SPIKE_MS) {
+		spikeCount_++;
+		spikePending_ = true;
+		std::printf("Spike: frame %llu took %.2f ms of CPU time\n", static_cast<unsigned long long>(frame_), cpuMs);
+	}
+}
+
+// Save the profiler zones of the spike frame that just ended
+void App::saveSpike() {
+	spikePending_ = false;
+	if (spikeDumps_ >= HUD_SPIKE_DUMP_LIMIT) return;
+	frameMayAllocate_ = true;
+
+	char path[64];
+	std::snprintf(path, sizeof(path), "pokepp_spike_%llu.json", static_cast<unsigned long long>(frame_ - 1));
+	if (pokepp::Profiler::saveLastFrame(path)) spikeDumps_++;
+}
+
+// Count the main thread's heap allocations in the frame that just ended (shown in the HUD).
+// Once warmed up, a frame that did no one-off work (entities created or destroyed, dumps and
+// captures) must not allocate from the global heap; flow field solves and autosaves are no
+// exception, only their worker threads may. Debug builds assert, and --alloc-check reports
+// it and fails the run with exit code 3 instead. Transient data belongs on the frame arena,
+// and buffers that persist keep their capacity. With POKEPP_ALLOC_TRACKING the first
+// allocations of each checked frame have their stacks recorded, and they are printed with
+// the report.
+void App::checkFrameAllocations() {
+	uint64_t allocations = pokepp::HeapCounter::threadAllocations();
+	uint64_t bytes = pokepp::HeapCounter::threadBytes();
+	uint64_t epoch = sim_ ? sim_->allocationEpoch() : 0;
+	frameAllocations_ = allocations - heapAllocations_;
+	frameAllocBytes_ = bytes - heapBytes_;
+
+#ifdef NDEBUG
+	const bool checking = options_.allocCheck;
+#else
+	const bool checking = true;
+#endif
+	const bool warm = frame_ > static_cast<uint64_t>(HEAP_CHECK_WARMUP_FRAMES);
+	bool steady = checking && warm && !frameMayAllocate_ && epoch == heapEpoch_;
+
+	if (checking && warm) checkedFrames_++;
+	if (steady) {
+		steadyFrames_++;
+		if (frameAllocations_ > 0 && ++allocatingFrames_ <= static_cast<uint64_t>(HEAP_CHECK_REPORTS)) {
+			std::fprintf(stderr, "Frame %llu made %llu heap allocations (%llu bytes) in steady state\n",
+				static_cast<unsigned long long>(frame_ - 1), static_cast<unsigned long long>(frameAllocations_),
+				static_cast<unsigned long long>(frameAllocBytes_));
+			pokepp::HeapCounter::printStacks(stderr);
+		}
+		if (frameAllocations_ > 0) {
+			if (options_.allocCheck) {
+				if (exitCode_ == 0) exitCode_ = 3;
+			} else {
+				assert(!"steady-state frame allocated from the heap");
+			}
+		}
+	}
+	if (checking && frame_ >= static_cast<uint64_t>(HEAP_CHECK_WARMUP_FRAMES)) {
+		pokepp::HeapCounter::captureStacks(ALLOC_STACK_CAPTURES);
+	}
+
+	heapAllocations_ = allocations;
+	heapBytes_ = bytes;
+	heapEpoch_ = epoch;
+	frameMayAllocate_ = false;
+}
+
+// One CSV row per frame. The state hash column lets two runs be diffed for the first frame
+// where they diverged.
+void App::writeTimingRow(double frameMs, double simMs, double renderMs, int ticksRun) {
+	char row[160];
+	std::snprintf(row, sizeof(row), "%llu,%u,%d,%.3f,%.3f,%.3f,%016llx\n",
+		static_cast<unsigned long long>(frame_), simTick_, ticksRun, frameMs, simMs, renderMs,
+		static_cast<unsigned long long>(sim_->stateHash()));
+	timingFile_ << row;
+}
+
 // Handle key down events, including movement, camera reset, 
 // flashlight toggle, and Pokemon management
 void App::handleKeyDown(SDL_Keycode key) {
@@ -222,26 +637,25 @@ void App::handleKeyDown(SDL_Keycode key) {
 		break;
 
 	case SDLK_SPACE:
-		if (isGrounded_) {
-			verticalVelocity_ = JUMP_VELOCITY;
-			isGrounded_ = false;
-		}
+		if (net_) netJumps_++;
+		else sim_->jump();
 		break;
 
 	// Number keys 1-9 to toggle Pokemon out/in
 	case SDLK_1: case SDLK_2: case SDLK_3: case SDLK_4: case SDLK_5:
 	case SDLK_6: case SDLK_7: case SDLK_8: case SDLK_9:
-		if (pokemonController_) {
+		{
+			pokepp::PokemonController& pokemon = sim_->pokemon();
 			size_t index = static_cast<size_t>(key - SDLK_1);
-			if (index < pokemonController_->getInventoryCount()) {
+			if (index < pokemon.getInventoryCount()) {
 				// Toggle: If out, recall. If in, send out.
-				if (pokemonController_->isPokemonOut(index)) {
-					pokemonController_->recallPokemon(index);
+				if (pokemon.isPokemonOut(index)) {
+					pokemon.recallPokemon(index);
 				} else {
 					// Send out Pokmon in front of player
 					glm::vec3 sendOutPos = camPos_ + camFront_ * 3.0f;
-					sendOutPos.y = world_ ? world_->heightAt(sendOutPos.x, sendOutPos.z) : 0.0f;
-					pokemonController_->sendOutPokemon(index, sendOutPos);
+					sendOutPos.y = sim_->world() ? sim_->world()->heightAt(sendOutPos.x, sendOutPos.z) : 0.0f;
+					pokemon.sendOutPokemon(index, sendOutPos);
 				}
 			} else {
 				std::cout << "No Pokemon in slot " << (index + 1) << std::endl;
@@ -255,9 +669,15 @@ void App::handleKeyDown(SDL_Keycode key) {
 	}
 }
 
+// Handle key up events, releasing held movement keys
+void App::handleKeyUp(SDL_Scancode scancode) {
+	if (scancode >= 0 && scancode < SDL_NUM_SCANCODES) keysHeld_[scancode] = false;
+}
+
 // Handle mouse motion for camera rotation. Updates yaw and pitch based on mouse movement
 // (Euler angles), then updates camera front vector.
 void App::handleMouseMotion(int xrel, int yrel) {
+	PROFILE_ZONE("camera");
 	float xoffset = static_cast<float>(xrel) * mouseSens_;
 	float yoffset = static_cast<float>(yrel) * mouseSens_;
 
@@ -291,12 +711,13 @@ void App::handleMouseButtonUp(Uint8 button) {
 void App::handleWindowResize(int width, int height) {
 	width_ = width;
 	height_ = height;
-	glViewport(0, 0, width_, height_);
+	if (!options_.headless) glViewport(0, 0, width_, height_);
 }
 
 // Reset camera to default position and orientation
 void App::resetCamera() {
 	camPos_ = glm::vec3(0.0f, CAMERA_RESET_HEIGHT, CAMERA_RESET_DISTANCE);
+	if (sim_) sim_->player().position = camPos_;
 	camFront_ = glm::normalize(CAMERA_RESET_FRONT);
 	pitch_ = glm::degrees(asinf(camFront_.y));
 	yaw_ = glm::degrees(atan2f(camFront_.z, camFront_.x));
@@ -309,122 +730,6 @@ void App::updateCameraDirection() {
 	camFront_ = glm::normalize(glm::vec3(cy * cp, sp, sy * cp));
 }
 
-// Update camera position based on input, collisions, and gravity
-void App::updateCameraMovement() {
-
-	// Helper lambda to push a point out of an AABB in the XZ plane. That is, it pushes the player
-	// out of obstacles. Uses AABB (Axis-Aligned Bounding Box) collision detection.
-	// Find the closest point on the obstacle to the player, and if the player is inside it then
-	// calculate which edge is nearest and push them to that edge. Prevents things like walking through rocks.
-	auto pushOutFromAABB_XZ = [&](glm::vec3& p, const glm::vec3& aabbWorldMin, const glm::vec3& aabbWorldMax) {
-		glm::vec2 pos2(p.x, p.z);
-		glm::vec2 bmin(aabbWorldMin.x - playerRadius_, aabbWorldMin.z - playerRadius_);
-		glm::vec2 bmax(aabbWorldMax.x + playerRadius_, aabbWorldMax.z + playerRadius_);
-		
-		glm::vec2 clampPt;
-		clampPt.x = glm::clamp(pos2.x, bmin.x, bmax.x);
-		clampPt.y = glm::clamp(pos2.y, bmin.y, bmax.y);
-		glm::vec2 delta = pos2 - clampPt;
-
-		if (delta.x == 0.0f && delta.y == 0.0f) {
-			float left = pos2.x - bmin.x;
-			float right = bmax.x - pos2.x;
-			float down = pos2.y - bmin.y;
-			float up = bmax.y - pos2.y;
-			float m = std::min(std::min(left, right), std::min(down, up));
-
-			if (m == left) p.x = bmin.x;
-			else if (m == right) p.x = bmax.x;
-			else if (m == down) p.z = bmin.y;
-			else p.z = bmax.y;
-		}
-	};
-
-	// Read WASD input and calculate intended movement vector.
-	const Uint8* ks = SDL_GetKeyboardState(nullptr);
-	float velocity = moveSpeed_ * dt_;
-
-	if (ks[SDL_SCANCODE_LSHIFT]) velocity *= SPRINT_MULTIPLIER;
-
-	glm::vec3 right = glm::normalize(glm::cross(camFront_, camUp_));
-	glm::vec3 fwd = glm::normalize(glm::vec3(camFront_.x, 0.0f, camFront_.z));
-
-	// Apply WASD movement. 
-	glm::vec3 next = camPos_;
-	if (ks[SDL_SCANCODE_W]) next += fwd * velocity;
-	if (ks[SDL_SCANCODE_S]) next -= fwd * velocity;
-	if (ks[SDL_SCANCODE_A]) next -= right * velocity;
-	if (ks[SDL_SCANCODE_D]) next += right * velocity;
-
-	// Check collisions with props, and call our lambda to push the player out of obstacles.
-	for (const auto& prop : props_) {
-		glm::vec3 wmin = prop.pos + prop.scale * prop.aabbMinLocal;
-		glm::vec3 wmax = prop.pos + prop.scale * prop.aabbMaxLocal;
-		glm::vec3 realMin = glm::min(wmin, wmax);
-		glm::vec3 realMax = glm::max(wmin, wmax);
-		pushOutFromAABB_XZ(next, realMin, realMax);
-	}
-
-	// Handle gravity and ground collision. Physics!
-	if (world_) {
-		// Apply gravity to vertical velocity
-		verticalVelocity_ -= GRAVITY * dt_;
-
-		// Update Y position based on vertical velocity
-		next.y = camPos_.y + verticalVelocity_ * dt_;
-
-		// Get terrain info at new position. Use dot product to find slope angle.
-		float groundY = world_->heightAt(next.x, next.z);
-		glm::vec3 normal = world_->normalAt(next.x, next.z);
-		float slopeAngle = glm::degrees(acosf(glm::clamp(glm::dot(normal, glm::vec3(0, 1, 0)), -1.0f, 1.0f)));
-
-		constexpr float MAX_CLIMBABLE_SLOPE = 45.0f;
-		constexpr float SLIDE_THRESHOLD = 35.0f;
-
-		// ONLY block horizontal movement if grounded AND slope too steep.
-		// This prevents things like walking up cliffs, instead making the player slide down. 
-		if (isGrounded_ && slopeAngle > MAX_CLIMBABLE_SLOPE) {
-			// Too steep - reject horizontal movement
-			next.x = camPos_.x;
-			next.z = camPos_.z;
-			groundY = world_? world_->heightAt(next.x, next.z) : 0.0f;
-		}
-
-		// Check ground collision
-		float targetY = groundY + playerEyeHeight_;
-		if (next.y <= targetY) {
-			next.y = targetY;
-			verticalVelocity_ = 0.0f;
-			isGrounded_ = true;
-
-			// Apply sliding on steep slopes (only when grounded)
-			if (slopeAngle > SLIDE_THRESHOLD) {
-				glm::vec3 gravity(0, -1, 0);
-				glm::vec3 slideDir = gravity - glm::dot(gravity, normal) * normal;
-				if (glm::length(slideDir) > 0.001f) {
-					slideDir = glm::normalize(slideDir);
-
-					float slideSpeed = (slopeAngle - SLIDE_THRESHOLD) * 0.1f;
-					next.x += slideDir.x * slideSpeed * dt_;
-					next.z += slideDir.z * slideSpeed * dt_;
-
-					// Recalculate ground height after sliding
-					groundY = world_->heightAt(next.x, next.z);
-					next.y = groundY + playerEyeHeight_;
-				}
-			}
-		}
-		else {
-			isGrounded_ = false;
-		}
-	}
-	else {
-		next.y = playerEyeHeight_;
-	}
-
-	camPos_ = next;
-}
-
 // Update lighting parameters based on flashlight state
 void App::updateLighting() {
 	if (flashlightOn_) {
@@ -442,6 +747,11 @@ void App::updateLighting() {
 
 // Heart of the application and graphics pipeline, handles all the drawing. 
 void App::render() {
+	PROFILE_ZONE("render");
+	pokepp::renderStats() = {};
+	pokepp::GlCounters::beginPass("terrain");
+	gpuTimer_->begin();
+
 	// Clear screen to bright blue sky
 	glClearColor(0.68f, 0.85f, 0.90f, 1.0f); 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -467,57 +777,86 @@ void App::render() {
 	}
 
 	// Draw 3D world
-	if (world_) {
-		world_->draw(*shader_, view, proj);
+	if (sim_->world()) {
+		PROFILE_ZONE("render: terrain");
+		sim_->world()->draw(*shader_, view, proj);
 	}
 
 	// Draw pokeballs, grid, and trajectory preview
-	drawPokeballs(view, proj);
-	drawGrid(view, proj);
-	drawTrajectory(view, proj);
+	{
+		PROFILE_ZONE("render: pokeballs");
+		pokepp::GlCounters::beginPass("balls");
+		drawPokeballs(view, proj);
+	}
+	{
+		PROFILE_ZONE("render: grid and trajectory");
+		pokepp::GlCounters::beginPass("grid");
+		drawGrid(view, proj);
+		drawTrajectory(view, proj);
+	}
 
 	// Draw props
-	if (!props_.empty()) {
+	{
+		PROFILE_ZONE("render: props");
+		pokepp::GlCounters::beginPass("props");
 		shader_->use();
 		shader_->setInt("uHasRock", -1);
 		shader_->setMat4("uView", glm::value_ptr(view));
 		shader_->setMat4("uProj", glm::value_ptr(proj));
 
-		for (const auto& prop : props_) {
+		const pokepp::Registry& entities = sim_->entities();
+		entities.each<pokepp::Transform, pokepp::Renderable, pokepp::Prop>(
+			[&](const pokepp::Transform& t, const pokepp::Renderable& r, const pokepp::Prop&) {
+			if (!r.model) return;
+
 			glm::mat4 model(1.0f); // Model matrix, transform from model to world space
-			model = glm::translate(model, prop.pos);
-			model = glm::scale(model, prop.scale);
+			model = glm::translate(model, t.position);
+			model = glm::scale(model, t.scale);
 			glm::mat3 normalMat = glm::mat3(glm::transpose(glm::inverse(model)));
 
 			shader_->setMat4("uModel", glm::value_ptr(model));
 			shader_->setMat3("uNormalMat", glm::value_ptr(normalMat));	
 
 			if (uKdLoc_ != -1) {
-				if (prop.model == treeModel_) {
-					glUniform3f(uKdLoc_, 0.2f, 0.6f, 0.2f);
-				} else {
-					glUniform3f(uKdLoc_, 0.6f, 0.6f, 0.6f);
-				}
+				glUniform3f(uKdLoc_, r.color.r, r.color.g, r.color.b);
 			}
 
 			shader_->setInt("uUseTexture", 0);
-			prop.model->draw(*shader_);
-		}
+			r.model->draw(*shader_);
+		});
 	}
 
 	// Draw Pokemon
-	if (pokemonController_) {
+	{
+		PROFILE_ZONE("render: pokemon");
+		pokepp::GlCounters::beginPass("pokemon");
 		shader_->use();
     
 		//  Reset uHasRock so shader knows this is NOT terrain
 		shader_->setInt("uHasRock", -1);
-		pokemonController_->drawAll(*shader_);
+		sim_->pokemon().drawAll(*shader_);
 	}
 
 	// Draw 2D UI overlay (AFTER all 3D rendering)
-	drawInventoryUI();
+	{
+		PROFILE_ZONE("render: inventory UI");
+		pokepp::GlCounters::beginPass("ui");
+		drawInventoryUI();
+	}
+	gpuTimer_->end();
+
+	// The HUD goes last and is left out of the counters and GPU time it shows
+	lastRenderStats_ = pokepp::renderStats();
+	if (showHud_) {
+		PROFILE_ZONE("render: HUD");
+		pokepp::GlCounters::beginPass("hud");
+		drawHud();
+	}
 
+	PROFILE_ZONE("render: swap");
+	auto swapStart = Clock::now();
 	SDL_GL_SwapWindow(window_);
+	swapMs_ = msSince(swapStart);
 }
 
 // Setup main shader uniforms for view, projection, tint effect, and lighting.
@@ -570,6 +909,7 @@ void App::drawGrid(const glm::mat4& view, const glm::mat4& proj) {
 
 	glBindVertexArray(gridVAO_);
 	glDrawArrays(GL_LINES, 0, gridVertexCount_);
+	countDraw(GL_LINES, gridVertexCount_);
 	glBindVertexArray(0);
 }
 
@@ -578,7 +918,6 @@ void App::drawGrid(const glm::mat4& view, const glm::mat4& proj) {
 void App::drawTrajectory(const glm::mat4& view, const glm::mat4& proj) {
 	if (!isCharging_) return;
 
-	charge_ = glm::clamp(charge_ + dt_ / maxChargeSeconds_, 0.0f, 1.0f);
 	float previewSpeed = glm::mix(minThrowSpeed_, maxThrowSpeed_, charge_);
 	drawTrajectory(view, proj, previewSpeed);
 }
@@ -587,41 +926,38 @@ void App::drawTrajectory(const glm::mat4& view, const glm::mat4& proj) {
 // Physics!
 void App::drawTrajectory(const glm::mat4& view, const glm::mat4& proj, float previewSpeed) {
 
-	// Store the predicted trajectory points
-	std::vector<glm::vec3> pts;
-	pts.reserve(trajMaxPoints_);
-
-	// Calculate the initial conditions for the trajectory simulation
-	glm::vec3 p0 = camPos_ + camFront_ * PROJECTILE_SPAWN_DISTANCE;
-	glm::vec3 v0 = glm::normalize(camFront_) * previewSpeed + glm::vec3(0.0f, PROJECTILE_UPWARD_VELOCITY, 0.0f);
-
-	// Physics simulation loop. Integrate projectile motion with gravity and simple bounce.
-	const float dt = 1.0f / TRAJECTORY_SIMULATION_FPS;
-	glm::vec3 p = p0, v = v0;
-
-	for (int i = 0; i < trajMaxPoints_; ++i) {
-		pts.push_back(p); // save point
-
-		// Euler integration (update physics)
-		v.y -= gravity_ * dt; // apply gravity to Y velocity
-		p += v * dt; // update position based on velocity
-
-		// simple bounce preview (one reflection)
-		if (p.y <= GROUND_Y) {
-			p.y = GROUND_Y;
-			v.y = -v.y * glm::clamp(bounceRestitution_, 0.0f, 1.0f);
-			v.x *= BOUNCE_FRICTION;
-			v.z *= BOUNCE_FRICTION;
+	// Launch conditions, identical to spawnPokeball
+	pokepp::ThrowParams params;
+	params.origin = camPos_ + camFront_ * PROJECTILE_SPAWN_DISTANCE;
+	params.velocity = glm::normalize(camFront_) * previewSpeed + glm::vec3(0.0f, PROJECTILE_UPWARD_VELOCITY, 0.0f);
+	params.radius = PROJECTILE_RADIUS;
+	params.gravity = sim_->gravity();
+	params.restitution = glm::clamp(sim_->restitution(), 0.0f, 1.0f);
+	params.friction = BOUNCE_FRICTION;
+	params.groundY = GROUND_Y;
+
+	// The predictor keeps its points until the throw or the world changes noticeably, and
+	// the buffer is only rewritten when it produced new ones
+	trajectory_->update(params, sim_->world(), &sim_->collision());
+	if (trajectory_->revision() != trajUploadedRevision_) {
+		const auto& pts = trajectory_->points();
+		trajCount_ = static_cast<int>(std::min<size_t>(pts.size(), trajMaxPoints_));
+
+		glBindBuffer(GL_ARRAY_BUFFER, trajVBO_);
+		void* dst = glMapBufferRange(GL_ARRAY_BUFFER, 0, trajCount_ * sizeof(glm::vec3),
+		                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (dst) {
+			std::copy_n(pts.data(), trajCount_, static_cast<glm::vec3*>(dst));
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			trajUploadedRevision_ = trajectory_->revision();
+		} else {
+			trajCount_ = 0;
 		}
 	}
+
 	GLint psLoc = glGetUniformLocation(unlit_->getProgram(), "uPtSize");
 	if (psLoc >= 0) glUniform1f(psLoc, TRAJECTORY_PREVIEW_POINT_SIZE);
 
-	// Upload and draw with unlit shader (since we just want solid color points - no lighting)
-	glBindBuffer(GL_ARRAY_BUFFER, trajVBO_);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, pts.size() * sizeof(glm::vec3), pts.data());
-	trajCount_ = static_cast<int>(pts.size());
-
 	unlit_->use();
 	unlit_->setMat4("uView", glm::value_ptr(view));
 	unlit_->setMat4("uProj", glm::value_ptr(proj));
@@ -644,6 +980,7 @@ void App::drawTrajectory(const glm::mat4& view, const glm::mat4& proj, float pre
 	glBindVertexArray(trajVAO_);
 	glPointSize(TRAJECTORY_POINT_SIZE);
 	glDrawArrays(GL_POINTS, 0, trajCount_);
+	countDraw(GL_POINTS, trajCount_);
 	glBindVertexArray(0);
 
 	// restore main shader if needed
@@ -658,172 +995,18 @@ void App::spawnPokeball() {
 // Spawn a pokeball at the camera position, moving in the camera front direction with given speed.
 // Overloaded with speed parameter. 
 void App::spawnPokeball(float speed) {
-	glm::vec3 spawnPos = camPos_ + camFront_ * PROJECTILE_SPAWN_DISTANCE;
-	glm::vec3 spawnVel = glm::normalize(camFront_) * speed + glm::vec3(0.0f, PROJECTILE_UPWARD_VELOCITY, 0.0f); 
-	// --> Horizontal component + verticalcomponent! Projectile motion!
-
-	// Create and initialize the pokeball
-	pokepp::Pokeball ball;
-	ball.position = spawnPos;
-	ball.velocity = spawnVel;
-	ball.radius = PROJECTILE_RADIUS;
-	ball.life = PROJECTILE_LIFETIME;
-	
-	balls_.push_back(ball);
-}
-
-// Update all active pokeballs, applying physics, collisions, and capture logic. This is, in a sense, the 
-// physics and game logic engine for all active pokeballs. Handles projectile motion, collisions, captures,
-// and cleanup. 
-void App::updatePokeballs(float dt) {
-	float step = glm::min(dt, 1.0f / 60.0f); // limit time step (60FPS)
-
-	constexpr float SHAKE_DURATION = 0.6f;
-	constexpr int MAX_SHAKES = 3;
-
-	// Helper lambda function, used for Pokeball collision detection with rocks. 
-	auto closestPointOnAABB = [](const glm::vec3& p, const glm::vec3& aabbMin, const glm::vec3& aabbMax) {
-		glm::vec3 cp;
-		cp.x = glm::clamp(p.x, aabbMin.x, aabbMax.x);
-		cp.y = glm::clamp(p.y, aabbMin.y, aabbMax.y);
-		cp.z = glm::clamp(p.z, aabbMin.z, aabbMax.z);
-		return cp;
-	};
-
-	// Main update loop, iterates through all the pokeballs
-	for (auto& b : balls_) {
-
-		// If locked, do horizontal shake animation!
-		if (b.locked) {
-			b.lockTimer += dt;
-			
-			// Initialize base position on first frame of lock
-			if (b.lockTimer <= dt) {
-				b.captureBasePos = b.position;
-			}
-			
-			b.shakePhase += dt / SHAKE_DURATION;
-
-			if (b.shakePhase >= 1.0f) {
-				b.shakePhase = 0.0f;
-				b.shakeCount++;
-				
-				// After 3rd shake, finalize capture result
-				if (b.shakeCount >= MAX_SHAKES) {
-					if (pokemonController_) {
-						// Find the Pokemon being captured at this ball's position
-						auto& activePokemon = pokemonController_->getPokemon();
-						for (auto& p : activePokemon) {
-							if (p.isCapturing() && glm::length(p.getPosition() - b.captureBasePos) < 1.0f) {
-								if (b.captureSuccess) p.markCaptured();
-								else p.markCaptureFailed(); 
-								break;
-							}
-						}
-					}
-				}
-			}
-
-			// Only shake during first 3 shakes
-			if (b.shakeCount < MAX_SHAKES) {
-				float t = b.shakePhase;
-				float shakeOffset = 0.12f * std::sin(t * 6.28318f);
-				
-				b.position.x = b.captureBasePos.x + shakeOffset;
-				b.position.y = b.captureBasePos.y;
-				b.position.z = b.captureBasePos.z;
-			}
-			continue;
-		}
-
-		if (!b.active) continue; // Skip inactive balls
-
-		// Here, the ball is active - it is flying through the air!
-
-		// Apply gravity (simple Euler integration)
-		b.velocity.y -= gravity_ * step;
-		b.position += b.velocity * step;
-
-		// Check collision with props (AABB)
-		for (const auto& prop : props_) {
-			glm::vec3 aabbMin = prop.pos + prop.scale * prop.aabbMinLocal;
-			glm::vec3 aabbMax = prop.pos + prop.scale * prop.aabbMaxLocal;
-			glm::vec3 closestPt = closestPointOnAABB(b.position, aabbMin, aabbMax);
-			glm::vec3 delta = b.position - closestPt;
-			float distSq = glm::dot(delta, delta);
-			float radiusSq = b.radius * b.radius;
-
-			if (distSq < radiusSq) { // collision!
-
-				// Find collision normal. 
-				float dist = glm::sqrt(distSq);
-				glm::vec3 collisionNormal = (dist > 0.0001f) ? (delta / dist) : glm::vec3(0.0f, 1.0f, 0.0f);
-
-				float penetration = b.radius - dist; // get penetration depth
-				b.position += collisionNormal * penetration; // push ball out of collision
-				
-				// Bounce physics
-				if (glm::dot(b.velocity, collisionNormal) < 0.0f) {
-					glm::vec3 reflection = glm::reflect(b.velocity, collisionNormal);
-					b.velocity = reflection * bounceRestitution_;
-
-					// Split velocity into normal and tangent components for friction
-					glm::vec3 normalVel = collisionNormal * glm::dot(b.velocity, collisionNormal);
-					glm::vec3 tangentVel = b.velocity - normalVel;
-					tangentVel *= BOUNCE_FRICTION;
-					b.velocity = normalVel + tangentVel;
-				}
-			}
-		}
-
-		// Terrain collision
-		float terrainHeight = GROUND_Y;
-		glm::vec3 terrainNormal = glm::vec3(0.0f, 1.0f, 0.0f);
-
-		if (world_) {
-			terrainHeight = world_->heightAt(b.position.x, b.position.z);
-			terrainNormal = world_->normalAt(b.position.x, b.position.z);
-		}
-
-		// Terrain collision response
-		glm::vec3 terrainPoint(b.position.x, terrainHeight, b.position.z);
-		glm::vec3 toBall = b.position - terrainPoint;
-		float distToTerrain = glm::dot(toBall, terrainNormal);
-
-		if (distToTerrain < b.radius) { // Ball is penetrating terrain. Same logic with props.
-			float penetration = b.radius - distToTerrain;
-			b.position += terrainNormal * penetration;
-
-			if (glm::dot(b.velocity, terrainNormal) < 0.0f) {
-				glm::vec3 reflection = glm::reflect(b.velocity, terrainNormal);
-				b.velocity = reflection * bounceRestitution_;
-				glm::vec3 normalVel = terrainNormal * glm::dot(b.velocity, terrainNormal);
-				glm::vec3 tangentVel = b.velocity - normalVel;
-				tangentVel *= BOUNCE_FRICTION;
-				b.velocity = normalVel + tangentVel;
-			}
-		}
-
-		b.life -= step;
-	}
-
-	// Capture logic
-	if (pokemonController_) {
-		pokemonController_->handlePokeballCapture(balls_);
+	if (net_) {
+		netThrows_++;
+		netThrowSpeed_ = static_cast<uint8_t>(std::lround(glm::clamp(speed, 0.0f, 31.0f) * 8.0f));
+		return;
 	}
-
-	// Remove expired pokeballs
-	balls_.erase(std::remove_if(balls_.begin(), balls_.end(),
-	[](const pokepp::Pokeball& p) { 
-		return p.life <= 0.0f || (p.locked && p.lockTimer > 2.8f);
-	}),
-	balls_.end());
+	sim_->throwPokeball(camPos_ + camFront_ * PROJECTILE_SPAWN_DISTANCE, camFront_, speed);
 }
 
 // Draw all active pokeballs in the scene. This includes pokeballs in midair, pokeballs in the middle of a
 // capture animation, etc. 
 void App::drawPokeballs(const glm::mat4& view, const glm::mat4& proj) {
-    if (balls_.empty() || !pokeballModel_) {
+    if (sim_->pokeballCount() == 0 || !pokeballModel_) {
         return;
     }
 
@@ -831,13 +1014,12 @@ void App::drawPokeballs(const glm::mat4& view, const glm::mat4& proj) {
     shader_->setInt("uHasRock", -1); 
 
 	// Main render loop, going through each ball in the world. 
-    for (size_t i = 0; i < balls_.size(); ++i) {
-        const auto& b = balls_[i];
-        
-        if (!b.active && !b.locked) continue;
+    const pokepp::Registry& entities = sim_->entities();
+    entities.each<pokepp::Transform, pokepp::Pokeball>([&](const pokepp::Transform& t, const pokepp::Pokeball& b) {
+        if (!b.active && !b.locked) return;
 
         glm::mat4 M(1.0f); // Model matrix
-        M = glm::translate(M, b.position); // add translation
+        M = glm::translate(M, t.position); // add translation
 
 		// Shake animation
         if (b.locked && b.shakeCount < 3) {
@@ -866,96 +1048,31 @@ void App::drawPokeballs(const glm::mat4& view, const glm::mat4& proj) {
 
 		// Draw model. 
         pokeballModel_->draw(*shader_);
-    }
+    });
 }
 
-// Spawns a rock at the specified coordinates. It queries the world height at that 
-// position to place it on the terrain.
-void App::spawnRockAt(float x, float z, float scaleXZ, float scaleY) {
-	if (!world_ || !rockModel_) return;
-
-	float y = world_->heightAt(x, z);
+// Load a model, or share the one already loaded from the same path. Headless runs and
+// empty paths get none; a model that fails to load is reported and left out.
+std::shared_ptr<pokepp::Model> App::loadModel(const std::string& path) {
+	if (options_.headless || path.empty()) return nullptr;
 
-	Prop p;
-	p.model = rockModel_;
-	p.pos = { x, y, z };
-	p.scale = { scaleXZ, scaleY, scaleXZ };
-	p.aabbMinLocal = { -0.5f, 0.0f, -0.5f }; // in LOCAL space. 
-	p.aabbMaxLocal = { 0.5f, 0.6f, 0.5f };
-
-	props_.emplace_back(std::move(p));
-}
+	auto it = models_.find(path);
+	if (it != models_.end()) return it->second;
 
-// Scatter multiple rocks randomly across the terrain, ensuring they are placed
-// on relatively flat ground.
-void App::scatterRocks(int count) {
-	if (!world_) return;
-	auto random = []() { return float(rand()) / float(RAND_MAX); };
-
-	float maxRange = 100.0f;
-
-	for (int i = 0; i < count; i++) {
-		float x = glm::mix(-maxRange + 2.0f, maxRange - 2.0f, random());
-		float z = glm::mix(-maxRange + 2.0f, maxRange - 2.0f, random());
-
-		glm::vec3 n = world_->normalAt(x, z);
-		if (glm::dot(n, glm::vec3(0, 1, 0)) < 0.90f) { // slope too steep
-			i--;
-			continue;
-		}
-
-		float sXZ = 0.9f + 0.8f * random();
-		float sY = 0.7f + 0.6f * random();
-		spawnRockAt(x, z, sXZ, sY);
+	std::shared_ptr<pokepp::Model> model;
+	try {
+		model = std::make_shared<pokepp::Model>(path);
+	} catch (const std::exception& e) {
+		std::cerr << "Failed to load model " << path << ": " << e.what() << std::endl;
 	}
+	models_.emplace(path, model);
+	return model;
 }
 
-// Spawn a Pokemon at the specified coordinates. It queries the world height at that
-// position to place it on the terrain. 
-void App::spawnPokemonAt(float x, float z, float speed, float radius) {
-	if (!world_ || pokemonSpecies_.empty() || !pokemonController_) return;
-
-	float y = world_->heightAt(x, z);
-
-	// Pick a random species
-	auto random = []() { return float(rand()) / float(RAND_MAX); };
-	int speciesIdx = static_cast<int>(random() * pokemonSpecies_.size());
-	const pokepp::PokemonSpecies* species = &pokemonSpecies_[speciesIdx];
-
-	// Use new species-based API
-	pokemonController_->spawnPokemon(species, glm::vec3(x, y, z), speed, radius);
-}
-
-// Scatter multiple Pokemon randomly across the terrain, ensuring they are placed
-// on relatively flat ground.
-void App::scatterPokemon(int count) {
-	if (!world_ || pokemonSpecies_.empty() || !pokemonController_) return;
-
-	auto random = []() { return float(rand()) / float(RAND_MAX); };
-	float maxRange = 100.0f;
-
-	for (int i = 0; i < count; i++) {
-		float x = glm::mix(-maxRange + 5.0f, maxRange - 5.0f, random());
-		float z = glm::mix(-maxRange + 5.0f, maxRange - 5.0f, random());
-
-		glm::vec3 normal = world_->normalAt(x, z);
-		float slope = glm::dot(normal, glm::vec3(0, 1, 0));
-
-		if (slope < 0.85f) { // slope too steep
-			i--;
-			continue;
-		}
-
-		float speed = 1.5f + 1.5f * random();
-		float radius = 0.4f + 0.2f * random();
-
-		// Pick random species
-		int speciesIdx = static_cast<int>(random() * pokemonSpecies_.size());
-		const pokepp::PokemonSpecies* species = &pokemonSpecies_[speciesIdx];
-
-		float y = world_->heightAt(x, z);
-		pokemonController_->spawnPokemon(species, glm::vec3(x, y, z), speed, radius);
-	}
+// Scatter a scene prop set over flat ground. The simulation places them as entities and
+// blocks their collision boxes; the model stays alive in the model cache.
+void App::addProps(const pokepp::ScenePropSet& set, uint32_t setIndex) {
+	sim_->scatterProps(set, loadModel(set.model).get(), setIndex);
 }
 
 // Initialize SDL, create window and OpenGL context
@@ -1015,6 +1132,9 @@ bool App::initOpenGL() {
 	glFrontFace(GL_CCW);
 	glEnable(GL_PROGRAM_POINT_SIZE);
 
+	// Count GL calls per frame and pass for the HUD (only when built with POKEPP_GL_COUNTERS)
+	pokepp::GlCounters::install();
+
 	checkGLError("OpenGL initialization");
 	return true;
 }
@@ -1055,6 +1175,11 @@ bool App::initGeometry() {
 	buildTrajectoryBuffer(64);
 	buildUIQuad();  // NEW: Build UI quad for inventory
 
+	// Debug HUD
+	overlay_ = std::make_unique<pokepp::DebugOverlay>();
+	if (!overlay_->init()) return false;
+	gpuTimer_ = std::make_unique<pokepp::GpuTimer>();
+
 	std::cout << "Geometry initialized successfully" << std::endl;
 	return true;
 }
@@ -1134,6 +1259,29 @@ void App::setDefaultUniforms() {
 
 // Cleanup OpenGL resources and SDL, free memory
 void App::cleanup() {
+	// Close the input log with the final tick and state hash, so replays can verify it
+	if (recorder_.isOpen() && sim_) {
+		recorder_.finish(simTick_, sim_->stateHash());
+		std::cout << "Recorded " << recorder_.eventCount() << " input events over " << simTick_
+			<< " ticks to " << options_.recordPath << std::endl;
+	}
+
+	autosave_.reset();  // Finishes a save being written
+	net_.reset();       // Tells the server this client left
+
+	// Report memory while everything is still loaded
+	if (!options_.memoryPath.empty()) dumpMemory(options_.memoryPath);
+	if (options_.allocCheck) {
+		std::printf("Heap check: %llu of %llu frames steady, %llu allocated\n",
+			static_cast<unsigned long long>(steadyFrames_), static_cast<unsigned long long>(checkedFrames_),
+			static_cast<unsigned long long>(allocatingFrames_));
+		// A run with (almost) no steady frames checked nothing
+		if (steadyFrames_ < static_cast<uint64_t>(HEAP_CHECK_MIN_STEADY)) {
+			std::fprintf(stderr, "Heap check: too few steady frames (at least %d needed)\n", HEAP_CHECK_MIN_STEADY);
+			if (exitCode_ == 0) exitCode_ = 3;
+		}
+	}
+
 	// Clean up OpenGL resources
 	if (vbo_) { glDeleteBuffers(1, &vbo_); vbo_ = 0; }
 	if (vao_) { glDeleteVertexArrays(1, &vao_); vao_ = 0; }
@@ -1145,6 +1293,16 @@ void App::cleanup() {
 	if (trajVBO_) { glDeleteBuffers(1, &trajVBO_); trajVBO_ = 0; }
 	if (uiQuadVAO_) { glDeleteVertexArrays(1, &uiQuadVAO_); uiQuadVAO_ = 0; }
 	if (uiQuadVBO_) { glDeleteBuffers(1, &uiQuadVBO_); uiQuadVBO_ = 0; }
+	if (uiSlotVAO_) { glDeleteVertexArrays(1, &uiSlotVAO_); uiSlotVAO_ = 0; }
+	if (uiSlotVBO_) { glDeleteBuffers(1, &uiSlotVBO_); uiSlotVBO_ = 0; }
+	if (uiBorderVAO_) { glDeleteVertexArrays(1, &uiBorderVAO_); uiBorderVAO_ = 0; }
+	if (uiBorderVBO_) { glDeleteBuffers(1, &uiBorderVBO_); uiBorderVBO_ = 0; }
+	gridMemory_.reset();
+	trajMemory_.reset();
+	uiQuadMemory_.reset();
+	uiSlotMemory_.reset();
+	overlay_.reset();
+	gpuTimer_.reset();
 
 	// Clean up SDL
 	if (glcontext_) { SDL_GL_DeleteContext(glcontext_); glcontext_ = nullptr; }
@@ -1196,6 +1354,7 @@ void App::buildGrid(int half, float spacing) {
 	glBindVertexArray(gridVAO_);
 	glBindBuffer(GL_ARRAY_BUFFER, gridVBO_);
 	glBufferData(GL_ARRAY_BUFFER, lines.size() * sizeof(glm::vec3), lines.data(), GL_STATIC_DRAW);
+	gridMemory_ = pokepp::TrackedMemory(pokepp::MemoryCategory::GpuBuffers, "grid", lines.size() * sizeof(glm::vec3));
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -1206,18 +1365,21 @@ void App::buildGrid(int half, float spacing) {
 // That is, preallocate GPU buffers to hold trajectory points to avoid reallocating every frame.
 void App::buildTrajectoryBuffer(int maxPoints) {
 	trajMaxPoints_ = maxPoints;
+	trajectory_ = std::make_unique<pokepp::TrajectoryPredictor>(maxPoints, 1.0f / TRAJECTORY_SIMULATION_FPS);
 	glGenVertexArrays(1, &trajVAO_);
 	glGenBuffers(1, &trajVBO_);
 
 	glBindVertexArray(trajVAO_);
 	glBindBuffer(GL_ARRAY_BUFFER, trajVBO_);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * trajMaxPoints_, nullptr, GL_DYNAMIC_DRAW);
+	trajMemory_ = pokepp::TrackedMemory(pokepp::MemoryCategory::GpuBuffers, "trajectory", sizeof(glm::vec3) * trajMaxPoints_);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
 	glBindVertexArray(0);
 }
 
-// Build the quad for rendering the inventory UI.
+// Build the quad for rendering the inventory UI, and the square and outline its slots are
+// drawn with.
 void App::buildUIQuad() {
     float quadVertices[] = {
         -1.0f,  1.0f,    0.0f, 1.0f,
@@ -1235,6 +1397,7 @@ void App::buildUIQuad() {
     glBindVertexArray(uiQuadVAO_);
     glBindBuffer(GL_ARRAY_BUFFER, uiQuadVBO_);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    uiQuadMemory_ = pokepp::TrackedMemory(pokepp::MemoryCategory::GpuBuffers, "ui quad", sizeof(quadVertices));
     
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
@@ -1243,12 +1406,40 @@ void App::buildUIQuad() {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
     
     glBindVertexArray(0);
+
+    float unitSquare[] = {
+        0.0f, 0.0f,  1.0f, 0.0f,  1.0f, 1.0f,
+        0.0f, 0.0f,  1.0f, 1.0f,  0.0f, 1.0f
+    };
+
+    float borderLine[] = {
+        0.0f, 0.0f,  1.0f, 0.0f,  1.0f, 1.0f,  0.0f, 1.0f,  0.0f, 0.0f
+    };
+
+    glGenVertexArrays(1, &uiSlotVAO_);
+    glGenBuffers(1, &uiSlotVBO_);
+    glBindVertexArray(uiSlotVAO_);
+    glBindBuffer(GL_ARRAY_BUFFER, uiSlotVBO_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(unitSquare), unitSquare, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    glGenVertexArrays(1, &uiBorderVAO_);
+    glGenBuffers(1, &uiBorderVBO_);
+    glBindVertexArray(uiBorderVAO_);
+    glBindBuffer(GL_ARRAY_BUFFER, uiBorderVBO_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(borderLine), borderLine, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glBindVertexArray(0);
+    uiSlotMemory_ = pokepp::TrackedMemory(pokepp::MemoryCategory::GpuBuffers, "ui slots", sizeof(unitSquare) + sizeof(borderLine));
 }
 
 // Draw the inventory UI in the top-left corner of the screen. Includes the spinning 
 // Pokemon model. 
 void App::drawInventoryUI() {
-    if (!pokemonController_ || pokemonController_->getInventoryCount() == 0) {
+    const pokepp::PokemonController& pokemon = sim_->pokemon();
+    if (pokemon.getInventoryCount() == 0) {
         return;
     }
 
@@ -1270,7 +1461,7 @@ void App::drawInventoryUI() {
     unlit_->setMat4("uProj", glm::value_ptr(orthoProj));
     unlit_->setMat4("uView", glm::value_ptr(glm::mat4(1.0f)));
 
-    const auto& inventory = pokemonController_->getInventory();
+    const auto& inventory = pokemon.getInventory();
     size_t count = std::min(inventory.size(), size_t(6));
 
     const float slotSize = 70.0f;
@@ -1279,40 +1470,10 @@ void App::drawInventoryUI() {
 
     GLint colorLoc = glGetUniformLocation(unlit_->getProgram(), "uColor");
 
-    // Create VAO/VBO for background and border
-    float unitSquare[] = {
-        0.0f, 0.0f,  1.0f, 0.0f,  1.0f, 1.0f,
-        0.0f, 0.0f,  1.0f, 1.0f,  0.0f, 1.0f
-    };
-
-    float borderLine[] = {
-        0.0f, 0.0f,  1.0f, 0.0f,  1.0f, 1.0f,  0.0f, 1.0f,  0.0f, 0.0f
-    };
-
-    GLuint bgVAO, bgVBO;
-    glGenVertexArrays(1, &bgVAO);
-    glGenBuffers(1, &bgVBO);
-    glBindVertexArray(bgVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, bgVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(unitSquare), unitSquare, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glBindVertexArray(0);
-
-    GLuint borderVAO, borderVBO;
-    glGenVertexArrays(1, &borderVAO);
-    glGenBuffers(1, &borderVBO);
-    glBindVertexArray(borderVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, borderVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(borderLine), borderLine, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glBindVertexArray(0);
-
 	// === Draw each inventory slot ===
     for (size_t i = 0; i < count; ++i) {
         float yPos = startY - i * (slotSize + slotSpacing);
-        bool isOut = pokemonController_->isPokemonOut(i);
+        bool isOut = pokemon.isPokemonOut(i);
         
         glm::vec3 slotColor = isOut 
             ? glm::vec3(0.2f, 1.0f, 0.3f)
@@ -1324,8 +1485,9 @@ void App::drawInventoryUI() {
         model = glm::scale(model, glm::vec3(slotSize, slotSize, 1.0f));
         unlit_->setMat4("uModel", glm::value_ptr(model));
         if (colorLoc >= 0) glUniform3f(colorLoc, slotColor.r, slotColor.g, slotColor.b);
-        glBindVertexArray(bgVAO);
+        glBindVertexArray(uiSlotVAO_);
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        countDraw(GL_TRIANGLES, 6);
         glBindVertexArray(0);
 
         // Border
@@ -1342,17 +1504,12 @@ void App::drawInventoryUI() {
         if (colorLoc >= 0) glUniform3f(colorLoc, borderColor.r, borderColor.g, borderColor.b);
         
         glLineWidth(3.0f);
-        glBindVertexArray(borderVAO);
+        glBindVertexArray(uiBorderVAO_);
         glDrawArrays(GL_LINE_STRIP, 0, 5);
+        countDraw(GL_LINE_STRIP, 5);
         glBindVertexArray(0);
     }
 
-    // Clean up 2D geometry
-    glDeleteVertexArrays(1, &bgVAO);
-    glDeleteBuffers(1, &bgVBO);
-    glDeleteVertexArrays(1, &borderVAO);
-    glDeleteBuffers(1, &borderVBO);
-
 	// === Draw 3D pokemon models within each slot ===
 	glEnable(GL_DEPTH_TEST);
 	glClear(GL_DEPTH_BUFFER_BIT);
@@ -1362,9 +1519,8 @@ void App::drawInventoryUI() {
 	shader_->setInt("uHasRock", -1);
 
 	for (size_t i = 0; i < count; ++i) {
-		const auto& pokemon = inventory[i];
-		pokepp::Model* model = pokemon.getModel();
-		const pokepp::PokemonSpecies* species = pokemon.getSpecies();
+		const pokepp::PokemonSpecies* species = pokemon.speciesOf(inventory[i]);
+		pokepp::Model* model = species ? species->model : nullptr;
 		if (!model) continue;
 
 		float yPos = startY - i * (slotSize + slotSpacing);
@@ -1429,3 +1585,124 @@ void App::drawInventoryUI() {
 
     shader_->use();
 }
+
+// Draw the debug HUD in the top-right corner: frame time statistics, a graph of the last
+// HUD_FRAME_WINDOW frames, and what the last frame rendered (with its GL calls per pass, when
+// they are counted). Everything goes through the
+// overlay batch, which is one draw call.
+void App::drawHud() {
+	constexpr int SCALE = 2;
+	constexpr float LINE = pokepp::DebugOverlay::GLYPH_H * SCALE + 4.0f;
+	constexpr float PAD = 8.0f;
+	constexpr float PANEL_W = 41 * pokepp::DebugOverlay::GLYPH_W * SCALE + 2 * PAD;
+	constexpr float GRAPH_H = 80.0f;
+	constexpr uint32_t TEXT = pokepp::rgba(235, 235, 235);
+	constexpr uint32_t DIM = pokepp::rgba(150, 150, 150);
+
+	pokepp::DebugOverlay& o = *overlay_;
+	o.begin(width_, height_);
+
+	// GL counter rows: totals, binds, other calls, then the passes two to a row under a header
+	const std::vector<pokepp::GlPassCounts>& passes = pokepp::GlCounters::lastFramePasses();
+	const int glRows = pokepp::GlCounters::enabled() ? 4 + static_cast<int>((passes.size() + 1) / 2) : 0;
+
+	const float x = std::max(0.0f, width_ - PANEL_W - PAD);
+	float y = PAD;
+	const float panelH = (8 + glRows) * LINE + GRAPH_H + 3 * PAD;
+	o.rect(x, y, PANEL_W, panelH, pokepp::rgba(0, 0, 0, 170));
+	y += PAD;
+
+	char buf[96];
+	auto row = [&](const char* label, const pokepp::FrameTimeSummary& s, float now) {
+		if (s.samples == 0) {
+			std::snprintf(buf, sizeof(buf), "%-5s   n/a", label);
+		} else {
+			std::snprintf(buf, sizeof(buf), "%-5s%6.2f%6.2f%6.2f%6.2f%6.2f%6.2f", label, now, s.min, s.avg, s.p95, s.p99, s.max);
+		}
+		o.text(x + PAD, y, buf, TEXT, SCALE);
+		y += LINE;
+	};
+
+	const size_t n = frameStats_.size();
+	const pokepp::FrameTimeSummary interval = frameStats_.interval();
+	o.text(x + PAD, y, "ms     now   min   avg   p95   p99   max", DIM, SCALE);
+	y += LINE;
+	row("CPU", frameStats_.cpu(), n ? frameStats_.cpuAt(n - 1) : 0.0f);
+	row("GPU", frameStats_.gpu(), gpuTimer_->lastMs());
+	row("frame", interval, dt_ * 1000.0f);
+
+	// Graph: CPU time per frame as bars, GPU time as a line, with the 60 fps and spike marks
+	const float gx = x + PAD, gy = y + PAD * 0.5f, gw = PANEL_W - 2 * PAD;
+	const size_t window = frameStats_.window();
+	const float barW = gw / window;
+	auto graphY = [&](float ms) { return gy + GRAPH_H - std::min(ms, HUD_GRAPH_MAX_MS) / HUD_GRAPH_MAX_MS * GRAPH_H; };
+
+	o.rect(gx, gy, gw, GRAPH_H, pokepp::rgba(255, 255, 255, 25));
+	for (size_t i = 0; i < n; ++i) {
+		float ms = frameStats_.cpuAt(i);
+		uint32_t color = ms > HUD_SPIKE_MS ? pokepp::rgba(240, 70, 60)
+			: ms > 1000.0f / 60.0f ? pokepp::rgba(240, 200, 60) : pokepp::rgba(90, 210, 90);
+		float top = graphY(ms);
+		o.rect(gx + (window - n + i) * barW, top, std::max(barW - 0.5f, 1.0f), gy + GRAPH_H - top, color);
+	}
+	for (size_t i = 1; i < n; ++i) {
+		float a = frameStats_.gpuAt(i - 1), b = frameStats_.gpuAt(i);
+		if (a < 0.0f || b < 0.0f) continue;
+		float xa = gx + (window - n + i - 0.5f) * barW;
+		o.line({ xa, graphY(a) }, { xa + barW, graphY(b) }, pokepp::rgba(80, 200, 255), 1.5f);
+	}
+	o.line({ gx, graphY(1000.0f / 60.0f) }, { gx + gw, graphY(1000.0f / 60.0f) }, pokepp::rgba(255, 255, 255, 90));
+	o.line({ gx, graphY(HUD_SPIKE_MS) }, { gx + gw, graphY(HUD_SPIKE_MS) }, pokepp::rgba(240, 70, 60, 120));
+	y = gy + GRAPH_H + PAD;
+
+	// Counters of the last frame, without the HUD itself
+	const pokepp::RenderStats& r = lastRenderStats_;
+	std::snprintf(buf, sizeof(buf), "draws %-6u tris %-9llu models %u", r.drawCalls,
+		static_cast<unsigned long long>(r.triangles), r.models);
+	o.text(x + PAD, y, buf, TEXT, SCALE);
+	y += LINE;
+	std::snprintf(buf, sizeof(buf), "pokemon %-6zu balls %zu/%-4zu fps %.0f", sim_->pokemon().getPokemonCount(),
+		sim_->pokeballCount(), sim_->pokeballPool().capacity, interval.avg > 0.0f ? 1000.0f / interval.avg : 0.0f);
+	o.text(x + PAD, y, buf, TEXT, SCALE);
+	y += LINE;
+	std::snprintf(buf, sizeof(buf), "spikes >%.0f ms: %d (%d saved)", HUD_SPIKE_MS, spikeCount_, spikeDumps_);
+	o.text(x + PAD, y, buf, spikeCount_ ? pokepp::rgba(240, 120, 100) : DIM, SCALE);
+	y += LINE;
+	std::snprintf(buf, sizeof(buf), "heap allocs %-6llu %.1f KiB", static_cast<unsigned long long>(frameAllocations_),
+		frameAllocBytes_ / 1024.0);
+	o.text(x + PAD, y, buf, frameAllocations_ ? pokepp::rgba(240, 200, 60) : DIM, SCALE);
+	y += LINE;
+
+	// GL calls of the last frame (HUD included), binds as calls (redundant ones)
+	if (glRows > 0) {
+		using pokepp::GlCall;
+		const pokepp::GlCallCounts& gl = pokepp::GlCounters::lastFrame();
+		std::snprintf(buf, sizeof(buf), "gl calls %-6u draws %-5u uniforms %u", gl.total(), gl.draws(), gl[GlCall::Uniform]);
+		o.text(x + PAD, y, buf, TEXT, SCALE);
+		y += LINE;
+		std::snprintf(buf, sizeof(buf), "prog %u (%u) vao %u (%u) tex %u (%u)",
+			gl[GlCall::UseProgram], gl.redundantOf(GlCall::UseProgram),
+			gl[GlCall::BindVertexArray], gl.redundantOf(GlCall::BindVertexArray),
+			gl[GlCall::BindTexture], gl.redundantOf(GlCall::BindTexture));
+		o.text(x + PAD, y, buf, TEXT, SCALE);
+		y += LINE;
+		std::snprintf(buf, sizeof(buf), "getloc %-5u subdata %-4u isenabled %u", gl[GlCall::GetUniformLocation],
+			gl[GlCall::BufferSubData], gl[GlCall::IsEnabled]);
+		o.text(x + PAD, y, buf, TEXT, SCALE);
+		y += LINE;
+		o.text(x + PAD, y, "pass     calls draw  pass     calls draw", DIM, SCALE);
+		y += LINE;
+		for (size_t i = 0; i < passes.size(); i += 2) {
+			const pokepp::GlPassCounts& a = passes[i];
+			int len = std::snprintf(buf, sizeof(buf), "%-8s%6u%5u", a.name, a.counts.total(), a.counts.draws());
+			if (i + 1 < passes.size()) {
+				const pokepp::GlPassCounts& b = passes[i + 1];
+				std::snprintf(buf + len, sizeof(buf) - len, "  %-8s%6u%5u", b.name, b.counts.total(), b.counts.draws());
+			}
+			o.text(x + PAD, y, buf, TEXT, SCALE);
+			y += LINE;
+		}
+	}
+
+	o.flush();
+}
@@ -0,0 +1,135 @@
+#include "pokeapp/AutoSave.h"
+#include "pokeapp/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+/*
+	Implementation of the AutoSave class. save() sets busy_ and wakes the writer thread,
+	which clears it (and wakes waiters) under the mutex once the file is written. The
+	destructor waits for that, then stops and joins the writer.
+*/
+
+namespace pokepp {
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double msSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+AutoSave::AutoSave(std::string path, std::string scene, int fullEvery)
+    : path_(std::move(path)), deltaPath_(path_ + ".delta"), scene_(std::move(scene)),
+      fullEvery_(std::max(1, fullEvery)), writer_([this] { writerLoop(); }) {}
+
+AutoSave::~AutoSave() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    pending_.notify_one();
+    if (writer_.joinable()) writer_.join();
+}
+
+bool AutoSave::save(const Simulation& sim) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (busy_) {
+            stats_.skipped++;
+            return false;
+        }
+    }
+
+    auto start = Clock::now();
+    SaveGame::Snapshot(sim, scene_, snapshot_);
+    double snapshotMs = msSince(start);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        busy_ = true;
+        stats_.lastSnapshotMs = snapshotMs;
+        stats_.maxSnapshotMs = std::max(stats_.maxSnapshotMs, snapshotMs);
+    }
+    pending_.notify_one();
+    return true;
+}
+
+void AutoSave::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        pending_.wait(lock, [this] { return busy_ || stopping_; });
+        if (!busy_) return;
+        lock.unlock();
+        write();
+        lock.lock();
+    }
+}
+
+void AutoSave::write() {
+    PROFILE_ZONE("AutoSave::write");
+    auto start = Clock::now();
+    SaveGame::Encode(snapshot_, encoded_);
+    SaveGame::ReserveSnapshot(snapshot_);  // Grows here rather than in the next save()
+
+    // A delta against the last full save, unless a full one is due or the delta is no smaller
+    bool full = base_.empty() || sinceFull_ + 1 >= fullEvery_;
+    size_t deltaBytes = 0;
+    if (!full) {
+        deltaBytes = SaveGame::EncodeDelta(base_, encoded_, delta_);
+        full = deltaBytes > SaveGame::EncodedBytes(encoded_) * constants::AUTOSAVE_MAX_DELTA_RATIO;
+    }
+
+    bool ok;
+    size_t bytes;
+    if (full) {
+        // Drop the old delta only once the new save is in place. Until then the old save and
+        // its delta stay complete; after a crash in between, Load ignores the delta, which
+        // was made against a different save.
+        bytes = SaveGame::EncodedBytes(encoded_);
+        ok = SaveGame::WriteFile(path_, encoded_, bytes);
+        if (ok) {
+            std::remove(deltaPath_.c_str());
+            base_.swap(encoded_);
+            sinceFull_ = 0;
+        }
+    } else {
+        bytes = deltaBytes;
+        ok = SaveGame::WriteFile(deltaPath_, delta_, bytes);
+        if (ok) sinceFull_++;
+    }
+    if (!ok) std::cerr << "Failed to write autosave " << (full ? path_ : deltaPath_) << std::endl;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ok) stats_.failures++;
+    else if (full) stats_.fullSaves++;
+    else stats_.deltaSaves++;
+    if (ok) {
+        stats_.lastBytes = bytes;
+        stats_.lastDelta = !full;
+    }
+    stats_.lastWriteMs = msSince(start);
+    busy_ = false;
+    idle_.notify_all();
+}
+
+bool AutoSave::busy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return busy_;
+}
+
+void AutoSave::wait() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return !busy_; });
+}
+
+AutoSaveStats AutoSave::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace pokepp
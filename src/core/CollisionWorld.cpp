@@ -0,0 +1,256 @@
+#include "pokeapp/CollisionWorld.h"
+#include "pokeapp/World.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+/*
+	Implementation of the CollisionWorld class. Stores the static boxes of all props
+	and answers overlap queries against them, through the broadphase grid.
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr float CONTACT_EPS = 1e-4f;
+    constexpr int MAX_ADVANCE_STEPS = 16;
+    constexpr float GRID_CELL_SIZE = 4.0f;   // Meters; a few props per cell
+    constexpr float MAX_GRID_CELLS = 262144.0f;  // Larger levels get larger cells
+
+    // Normal of the box face closest to a point inside the box
+    glm::vec3 nearestFaceNormal(const glm::vec3& p, const AABB& b) {
+        glm::vec3 normal(0.0f, 1.0f, 0.0f);
+        float best = b.max.y - p.y;
+        for (int k = 0; k < 3; ++k) {
+            float toMin = p[k] - b.min[k];
+            float toMax = b.max[k] - p[k];
+            if (toMin < best) { best = toMin; normal = glm::vec3(0.0f); normal[k] = -1.0f; }
+            if (toMax < best) { best = toMax; normal = glm::vec3(0.0f); normal[k] = 1.0f; }
+        }
+        return normal;
+    }
+
+    // Swept sphere vs a single box. The segment is first clipped against the box grown by the
+    // radius (slab test). That grown box contains the true rounded shape, so on a face the entry
+    // point is exact; near edges and corners the sphere is then advanced along the segment by its
+    // distance to the box until it touches, which converges because the box is convex.
+    bool sweepSphereBox(const glm::vec3& from, const glm::vec3& d, float radius, const AABB& b,
+                        float& toi, glm::vec3& normal) {
+        // Already touching: report contact only when moving further in
+        glm::vec3 q = glm::clamp(from, b.min, b.max);
+        glm::vec3 delta = from - q;
+        float distSq = glm::dot(delta, delta);
+        if (distSq <= radius * radius) {
+            normal = (distSq > 1e-12f) ? delta / std::sqrt(distSq) : nearestFaceNormal(from, b);
+            toi = 0.0f;
+            return glm::dot(d, normal) < 0.0f;
+        }
+
+        float tEnter = 0.0f, tExit = 1.0f;
+        for (int k = 0; k < 3; ++k) {
+            float lo = b.min[k] - radius, hi = b.max[k] + radius;
+            if (std::abs(d[k]) < 1e-8f) {
+                if (from[k] < lo || from[k] > hi) return false;
+                continue;
+            }
+            float t1 = (lo - from[k]) / d[k];
+            float t2 = (hi - from[k]) / d[k];
+            if (t1 > t2) std::swap(t1, t2);
+            tEnter = std::max(tEnter, t1);
+            tExit = std::min(tExit, t2);
+            if (tEnter > tExit) return false;
+        }
+
+        float len = glm::length(d);
+        float t = tEnter;
+        for (int i = 0; i < MAX_ADVANCE_STEPS; ++i) {
+            glm::vec3 p = from + d * t;
+            glm::vec3 c = glm::clamp(p, b.min, b.max);
+            float dist = glm::length(p - c);
+            if (dist <= radius + CONTACT_EPS) {
+                toi = t;
+                normal = (dist > 1e-6f) ? (p - c) / dist : nearestFaceNormal(p, b);
+                return true;
+            }
+            t += (dist - radius) / len;
+            if (t > tExit) return false;
+        }
+        return false;
+    }
+}
+
+size_t CollisionWorld::addBox(const glm::vec3& min, const glm::vec3& max) {
+    // Accept boxes given with any corner order (negative scales flip them)
+    boxes_.push_back({ glm::min(min, max), glm::max(min, max) });
+    version_++;
+    return boxes_.size() - 1;
+}
+
+void CollisionWorld::clear() {
+    boxes_.clear();
+    version_++;
+}
+
+size_t CollisionWorld::memoryBytes() const {
+    return boxes_.capacity() * sizeof(AABB) + (cellStart_.capacity() + cellBoxes_.capacity()) * sizeof(uint32_t);
+}
+
+void CollisionWorld::ensureGrid() const {
+    if (gridVersion_.load(std::memory_order_acquire) == version_) return;
+    std::lock_guard<std::mutex> lock(gridMutex_);
+    if (gridVersion_.load(std::memory_order_relaxed) == version_) return;
+    buildGrid();
+    gridVersion_.store(version_, std::memory_order_release);
+}
+
+// Bin the boxes into the cells they cover with a counting sort: count entries per cell,
+// prefix-sum the counts into start offsets, then scatter the box indices in order.
+void CollisionWorld::buildGrid() const {
+    gridWidth_ = gridHeight_ = 0;
+    cellStart_.clear();
+    cellBoxes_.clear();
+    if (boxes_.empty()) return;
+
+    glm::vec2 lo(std::numeric_limits<float>::max());
+    glm::vec2 hi(std::numeric_limits<float>::lowest());
+    for (const auto& b : boxes_) {
+        lo = glm::min(lo, glm::vec2(b.min.x, b.min.z));
+        hi = glm::max(hi, glm::vec2(b.max.x, b.max.z));
+    }
+    glm::vec2 extent = hi - lo;
+    gridCellSize_ = GRID_CELL_SIZE;
+    float cells = (extent.x / gridCellSize_ + 1.0f) * (extent.y / gridCellSize_ + 1.0f);
+    if (cells > MAX_GRID_CELLS) gridCellSize_ *= std::sqrt(cells / MAX_GRID_CELLS);
+    gridOrigin_ = lo;
+    gridWidth_ = int(extent.x / gridCellSize_) + 1;
+    gridHeight_ = int(extent.y / gridCellSize_) + 1;
+
+    auto cellsOf = [this](const AABB& b, int& i0, int& j0, int& i1, int& j1) {
+        i0 = std::clamp(int((b.min.x - gridOrigin_.x) / gridCellSize_), 0, gridWidth_ - 1);
+        j0 = std::clamp(int((b.min.z - gridOrigin_.y) / gridCellSize_), 0, gridHeight_ - 1);
+        i1 = std::clamp(int((b.max.x - gridOrigin_.x) / gridCellSize_), 0, gridWidth_ - 1);
+        j1 = std::clamp(int((b.max.z - gridOrigin_.y) / gridCellSize_), 0, gridHeight_ - 1);
+    };
+
+    cellStart_.assign(size_t(gridWidth_) * gridHeight_ + 1, 0);
+    for (const auto& b : boxes_) {
+        int i0, j0, i1, j1;
+        cellsOf(b, i0, j0, i1, j1);
+        for (int j = j0; j <= j1; ++j) {
+            for (int i = i0; i <= i1; ++i) cellStart_[size_t(j) * gridWidth_ + i + 1]++;
+        }
+    }
+    std::partial_sum(cellStart_.begin(), cellStart_.end(), cellStart_.begin());
+
+    std::vector<uint32_t> cursor(cellStart_.begin(), cellStart_.end() - 1);
+    cellBoxes_.resize(cellStart_.back());
+    for (size_t k = 0; k < boxes_.size(); ++k) {
+        int i0, j0, i1, j1;
+        cellsOf(boxes_[k], i0, j0, i1, j1);
+        for (int j = j0; j <= j1; ++j) {
+            for (int i = i0; i <= i1; ++i) cellBoxes_[cursor[size_t(j) * gridWidth_ + i]++] = static_cast<uint32_t>(k);
+        }
+    }
+}
+
+template <typename Visit>
+bool CollisionWorld::visitBoxes(const glm::vec2& lo, const glm::vec2& hi, Visit&& visit) const {
+    ensureGrid();
+    if (gridWidth_ == 0) return false;
+
+    // Boxes lie inside the grid, so a rectangle outside of it touches none
+    glm::vec2 a = (lo - gridOrigin_) / gridCellSize_;
+    glm::vec2 b = (hi - gridOrigin_) / gridCellSize_;
+    if (b.x < 0.0f || b.y < 0.0f || a.x >= float(gridWidth_) || a.y >= float(gridHeight_)) return false;
+    int i0 = std::max(0, int(a.x)), j0 = std::max(0, int(a.y));
+    int i1 = std::min(gridWidth_ - 1, int(b.x)), j1 = std::min(gridHeight_ - 1, int(b.y));
+
+    for (int j = j0; j <= j1; ++j) {
+        for (int i = i0; i <= i1; ++i) {
+            size_t cell = size_t(j) * gridWidth_ + i;
+            for (uint32_t k = cellStart_[cell]; k < cellStart_[cell + 1]; ++k) {
+                if (visit(cellBoxes_[k])) return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool CollisionWorld::sweepSphere(const glm::vec3& from, const glm::vec3& to, float radius,
+                                 float& toi, glm::vec3& normal) const {
+    const glm::vec3 d = to - from;
+    const glm::vec3 lo = glm::min(from, to) - glm::vec3(radius);
+    const glm::vec3 hi = glm::max(from, to) + glm::vec3(radius);
+    bool hit = false;
+    uint32_t hitBox = 0;
+    toi = 1.0f;
+    visitBoxes(glm::vec2(lo.x, lo.z), glm::vec2(hi.x, hi.z), [&](uint32_t k) {
+        const AABB& b = boxes_[k];
+        if (b.max.y < lo.y || b.min.y > hi.y) return false;
+
+        // Ties go to the lowest index, the order the boxes were added in
+        float t;
+        glm::vec3 n;
+        if (sweepSphereBox(from, d, radius, b, t, n) && (t < toi || (hit && t == toi && k < hitBox))) {
+            toi = t;
+            normal = n;
+            hit = true;
+            hitBox = k;
+        }
+        return false;
+    });
+    return hit;
+}
+
+bool CollisionWorld::SweepBall(const World* world, const CollisionWorld* collision, const glm::vec3& from,
+                               const glm::vec3& to, float radius, float groundY, float& toi, glm::vec3& normal) {
+    bool hit = false;
+    toi = 1.0f;
+
+    float t;
+    glm::vec3 n;
+    if (collision && collision->sweepSphere(from, to, radius, t, n) && t < toi) {
+        toi = t; normal = n; hit = true;
+    }
+
+    if (world) {
+        if (world->sweepSphere(from, to, radius, t, n) && t < toi) {
+            toi = t; normal = n; hit = true;
+        }
+    } else {
+        float d0 = from.y - groundY - radius;
+        float d1 = to.y - groundY - radius;
+        if (d1 < 0.0f && d1 < d0) {
+            t = (d0 <= 0.0f) ? 0.0f : d0 / (d0 - d1);
+            if (t < toi) { toi = t; normal = glm::vec3(0.0f, 1.0f, 0.0f); hit = true; }
+        }
+    }
+    return hit;
+}
+
+glm::vec3 CollisionWorld::BounceBall(const glm::vec3& velocity, const glm::vec3& normal, float restitution, float friction) {
+    if (glm::dot(velocity, normal) >= 0.0f) return velocity;
+    glm::vec3 v = glm::reflect(velocity, normal) * restitution;
+    glm::vec3 normalVel = normal * glm::dot(v, normal);
+    glm::vec3 tangentVel = v - normalVel;
+    tangentVel *= friction;
+    return normalVel + tangentVel;
+}
+
+// Circle vs box overlap in the XZ plane, via the closest point on the box
+bool CollisionWorld::overlapsCircleXZ(const glm::vec3& center, float radius) const {
+    const float r2 = radius * radius;
+    const glm::vec2 c(center.x, center.z);
+    return visitBoxes(c - glm::vec2(radius), c + glm::vec2(radius), [&](uint32_t k) {
+        const AABB& b = boxes_[k];
+        float cx = std::clamp(center.x, b.min.x, b.max.x);
+        float cz = std::clamp(center.z, b.min.z, b.max.z);
+        float dx = center.x - cx;
+        float dz = center.z - cz;
+        return dx * dx + dz * dz <= r2;
+    });
+}
+
+} // namespace pokepp
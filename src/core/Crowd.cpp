@@ -0,0 +1,191 @@
+#include "pokeapp/Crowd.h"
+#include "pokeapp/ThreadPool.h"
+#include "pokeapp/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+/*
+	Implementation of the CrowdSystem. See Crowd.h for an overview.
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr size_t AGENTS_PER_CHUNK = 256;
+    constexpr float MIN_DIST_SQ = 1e-4f;
+}
+
+void CrowdSystem::resize(size_t count) {
+    posX.resize(count);
+    posZ.resize(count);
+    velX.resize(count);
+    velZ.resize(count);
+    radius.resize(count);
+    steerX.resize(count);
+    steerZ.resize(count);
+    pushX.resize(count);
+    pushZ.resize(count);
+    agentCell_.resize(count);
+    sorted_.resize(count);
+    pairCounts_.resize(count);
+}
+
+size_t CrowdSystem::memoryBytes() const {
+    size_t floats = posX.capacity() + posZ.capacity() + velX.capacity() + velZ.capacity() + radius.capacity()
+                  + steerX.capacity() + steerZ.capacity() + pushX.capacity() + pushZ.capacity();
+    size_t indices = agentCell_.capacity() + cellStart_.capacity() + sorted_.capacity() + cursor_.capacity()
+                   + pairCounts_.capacity();
+    return floats * sizeof(float) + indices * sizeof(uint32_t);
+}
+
+// Bin agents into a hash grid with a counting sort: count agents per bucket, prefix-sum the
+// counts into start offsets, then scatter agent indices into sorted_.
+void CrowdSystem::buildGrid(float cellSize) {
+    const size_t n = size();
+    cellSize_ = cellSize;
+
+    uint32_t tableSize = 64;
+    while (tableSize < 2 * n) tableSize <<= 1;
+    tableMask_ = tableSize - 1;
+
+    cellStart_.assign(tableSize + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        int ci = int(std::floor(posX[i] / cellSize_));
+        int cj = int(std::floor(posZ[i] / cellSize_));
+        agentCell_[i] = cellKey(ci, cj);
+        cellStart_[agentCell_[i] + 1]++;
+    }
+    std::partial_sum(cellStart_.begin(), cellStart_.end(), cellStart_.begin());
+
+    // Scatter with a per-bucket write cursor
+    cursor_.assign(cellStart_.begin(), cellStart_.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        sorted_[cursor_[agentCell_[i]]++] = static_cast<uint32_t>(i);
+    }
+}
+
+void CrowdSystem::step(const CrowdConfig& config, ThreadPool* pool) {
+    PROFILE_ZONE("CrowdSystem::step");
+    const size_t n = size();
+    neighbourPairs_ = 0;
+    if (n == 0) return;
+
+    // Cells as large as the query radius, so the 3x3 block around an agent covers it
+    buildGrid(std::max(config.neighbourRadius, 0.1f));
+
+    if (pool) {
+        pool->parallelFor(n, AGENTS_PER_CHUNK, [&](size_t begin, size_t end) { solveRange(config, begin, end); });
+    } else {
+        solveRange(config, 0, n);
+    }
+
+    for (size_t i = 0; i < n; ++i) neighbourPairs_ += pairCounts_[i];
+}
+
+void CrowdSystem::solveRange(const CrowdConfig& config, size_t begin, size_t end) {
+    const float queryRadiusSq = config.neighbourRadius * config.neighbourRadius;
+
+    for (size_t i = begin; i < end; ++i) {
+        const float px = posX[i], pz = posZ[i];
+        const int ci = int(std::floor(px / cellSize_));
+        const int cj = int(std::floor(pz / cellSize_));
+
+        // Gather up to MAX_NEIGHBOURS nearest neighbours into fixed-size SoA scratch arrays.
+        // Unused lanes keep a zero weight so the math below can always run the full width.
+        float nDx[MAX_NEIGHBOURS] = {}, nDz[MAX_NEIGHBOURS] = {};
+        float nVx[MAX_NEIGHBOURS] = {}, nVz[MAX_NEIGHBOURS] = {};
+        float nR[MAX_NEIGHBOURS] = {}, nD2[MAX_NEIGHBOURS] = {};
+        float nW[MAX_NEIGHBOURS] = {};
+        int count = 0;
+
+        uint32_t visited[9];
+        int visitedCount = 0;
+        for (int dj = -1; dj <= 1; ++dj) {
+            for (int di = -1; di <= 1; ++di) {
+                uint32_t bucket = cellKey(ci + di, cj + dj);
+
+                // Two cells can hash to the same bucket; only scan each bucket once
+                bool seen = false;
+                for (int v = 0; v < visitedCount; ++v) seen |= (visited[v] == bucket);
+                if (seen) continue;
+                visited[visitedCount++] = bucket;
+
+                for (uint32_t k = cellStart_[bucket]; k < cellStart_[bucket + 1]; ++k) {
+                    uint32_t j = sorted_[k];
+                    if (j == i) continue;
+
+                    float dx = posX[j] - px, dz = posZ[j] - pz;
+                    float d2 = dx * dx + dz * dz;
+                    if (d2 >= queryRadiusSq) continue;
+
+                    int slot = count;
+                    if (count == MAX_NEIGHBOURS) {
+                        // Full: replace the furthest neighbour if this one is closer
+                        slot = 0;
+                        for (int s = 1; s < MAX_NEIGHBOURS; ++s) if (nD2[s] > nD2[slot]) slot = s;
+                        if (d2 >= nD2[slot]) continue;
+                    } else {
+                        count++;
+                    }
+                    nDx[slot] = dx; nDz[slot] = dz; nD2[slot] = d2;
+                    nVx[slot] = velX[j]; nVz[slot] = velZ[j];
+                    nR[slot] = radius[j]; nW[slot] = 1.0f;
+                }
+            }
+        }
+        pairCounts_[i] = static_cast<uint32_t>(count);
+
+        // Steering terms over the fixed-width neighbour arrays
+        float sepX = 0.0f, sepZ = 0.0f;
+        float alignX = 0.0f, alignZ = 0.0f;
+        float cohX = 0.0f, cohZ = 0.0f;
+        float pushAccX = 0.0f, pushAccZ = 0.0f;
+        const float ri = radius[i];
+        for (int s = 0; s < MAX_NEIGHBOURS; ++s) {
+            float d2 = std::max(nD2[s], MIN_DIST_SQ);
+            float invD = 1.0f / std::sqrt(d2);
+            float w = nW[s];
+
+            // Separation: away from neighbours, stronger the closer they are
+            sepX -= w * nDx[s] / d2;
+            sepZ -= w * nDz[s] / d2;
+
+            alignX += w * nVx[s];
+            alignZ += w * nVz[s];
+            cohX += w * nDx[s];
+            cohZ += w * nDz[s];
+
+            // Overlap: each agent takes half of the penetration
+            float pen = std::max(0.0f, ri + nR[s] - d2 * invD) * w;
+            pushAccX -= 0.5f * pen * nDx[s] * invD;
+            pushAccZ -= 0.5f * pen * nDz[s] * invD;
+        }
+
+        float sx = 0.0f, sz = 0.0f;
+        if (count > 0) {
+            float inv = 1.0f / count;
+            sx = config.separationWeight * sepX
+                + config.alignmentWeight * (alignX * inv - velX[i])
+                + config.cohesionWeight * (cohX * inv);
+            sz = config.separationWeight * sepZ
+                + config.alignmentWeight * (alignZ * inv - velZ[i])
+                + config.cohesionWeight * (cohZ * inv);
+
+            float len2 = sx * sx + sz * sz;
+            if (len2 > config.maxSteer * config.maxSteer) {
+                float scale = config.maxSteer / std::sqrt(len2);
+                sx *= scale;
+                sz *= scale;
+            }
+        }
+
+        steerX[i] = sx;
+        steerZ[i] = sz;
+        pushX[i] = pushAccX;
+        pushZ[i] = pushAccZ;
+    }
+}
+
+} // namespace pokepp
@@ -0,0 +1,256 @@
+#include "pokeapp/DebugOverlay.h"
+#include "pokeapp/Shader.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cmath>
+#include <iostream>
+
+/*
+	Implementation of DebugOverlay and GpuTimer, see DebugOverlay.h.
+
+	The font texture is a 16x6 grid of GLYPH_W x GLYPH_H cells holding characters 32-126,
+	with cell 127 filled solid for shapes. Glyphs are 5x7, stored as 5 column bytes with the
+	top row in bit 0.
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr int FONT_COLUMNS = 16;
+    constexpr int FONT_ROWS = 6;
+    constexpr int FONT_W = FONT_COLUMNS * DebugOverlay::GLYPH_W;
+    constexpr int FONT_H = FONT_ROWS * DebugOverlay::GLYPH_H;
+    constexpr int SOLID_GLYPH = 127;
+    constexpr size_t INITIAL_VERTICES = 16 * 1024;
+
+    constexpr uint8_t FONT_5X7[95][5] = {
+        { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, // space ! "
+        { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, // # $ %
+        { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 }, { 0x00, 0x1C, 0x22, 0x41, 0x00 }, // & ' (
+        { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 }, // ) * +
+        { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, // , - .
+        { 0x20, 0x10, 0x08, 0x04, 0x02 }, { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, // / 0 1
+        { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 }, { 0x18, 0x14, 0x12, 0x7F, 0x10 }, // 2 3 4
+        { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 }, // 5 6 7
+        { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, // 8 9 :
+        { 0x00, 0x56, 0x36, 0x00, 0x00 }, { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, // ; < =
+        { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 }, { 0x32, 0x49, 0x79, 0x41, 0x3E }, // > ? @
+        { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 }, // A B C
+        { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 }, // D E F
+        { 0x3E, 0x41, 0x49, 0x49, 0x7A }, { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, // G H I
+        { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 }, { 0x7F, 0x40, 0x40, 0x40, 0x40 }, // J K L
+        { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E }, // M N O
+        { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, // P Q R
+        { 0x46, 0x49, 0x49, 0x49, 0x31 }, { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, // S T U
+        { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F }, { 0x63, 0x14, 0x08, 0x14, 0x63 }, // V W X
+        { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 }, // Y Z [
+        { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, // \ ] ^
+        { 0x40, 0x40, 0x40, 0x40, 0x40 }, { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, // _ ` a
+        { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 }, { 0x38, 0x44, 0x44, 0x48, 0x7F }, // b c d
+        { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E }, // e f g
+        { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 }, // h i j
+        { 0x7F, 0x10, 0x28, 0x44, 0x00 }, { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, // k l m
+        { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, { 0x7C, 0x14, 0x14, 0x14, 0x08 }, // n o p
+        { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 }, // q r s
+        { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C }, // t u v
+        { 0x3C, 0x40, 0x30, 0x40, 0x3C }, { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, // w x y
+        { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, { 0x00, 0x00, 0x7F, 0x00, 0x00 }, // z { |
+        { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 },                                   // } ~
+    };
+
+    // Texture coordinates of a character's cell
+    void glyphUV(int c, glm::vec2& uv0, glm::vec2& uv1) {
+        int cell = c - 32;
+        int cx = cell % FONT_COLUMNS, cy = cell / FONT_COLUMNS;
+        uv0 = { float(cx * DebugOverlay::GLYPH_W) / FONT_W, float(cy * DebugOverlay::GLYPH_H) / FONT_H };
+        uv1 = { float((cx + 1) * DebugOverlay::GLYPH_W) / FONT_W, float((cy + 1) * DebugOverlay::GLYPH_H) / FONT_H };
+    }
+
+    // Center of the solid cell, so every pixel of a shape samples a filled texel
+    glm::vec2 solidUV() {
+        glm::vec2 uv0, uv1;
+        glyphUV(SOLID_GLYPH, uv0, uv1);
+        return (uv0 + uv1) * 0.5f;
+    }
+}
+
+DebugOverlay::DebugOverlay() = default;
+
+DebugOverlay::~DebugOverlay() {
+    if (vbo_) glDeleteBuffers(1, &vbo_);
+    if (vao_) glDeleteVertexArrays(1, &vao_);
+    if (font_) glDeleteTextures(1, &font_);
+}
+
+bool DebugOverlay::init() {
+    shader_ = std::make_unique<Shader>();
+    if (!shader_->loadFromFiles("shaders/overlay.vert", "shaders/overlay.frag")) {
+        std::cerr << "Failed to load overlay shaders" << std::endl;
+        return false;
+    }
+    shader_->use();
+    shader_->setInt("uFont", 0);
+
+    // Rasterize the font into a single channel texture, rows top to bottom
+    std::vector<uint8_t> pixels(FONT_W * FONT_H, 0);
+    for (int c = 32; c <= SOLID_GLYPH; ++c) {
+        int cell = c - 32;
+        int x0 = (cell % FONT_COLUMNS) * GLYPH_W, y0 = (cell / FONT_COLUMNS) * GLYPH_H;
+        for (int x = 0; x < GLYPH_W; ++x) {
+            for (int y = 0; y < GLYPH_H; ++y) {
+                bool on = (c == SOLID_GLYPH) || (x < 5 && y < 7 && (FONT_5X7[cell][x] >> y) & 1);
+                pixels[(y0 + y) * FONT_W + x0 + x] = on ? 255 : 0;
+            }
+        }
+    }
+
+    glGenTextures(1, &font_);
+    glBindTexture(GL_TEXTURE_2D, font_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, FONT_W, FONT_H, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    fontMemory_ = TrackedMemory(MemoryCategory::GpuTextures, "overlay font", pixels.size());
+
+    // Streamed vertex buffer: position, texture coordinate, packed color
+    bufferVertices_ = INITIAL_VERTICES;
+    vertices_.reserve(bufferVertices_);
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, bufferVertices_ * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+    bufferMemory_ = TrackedMemory(MemoryCategory::GpuBuffers, "overlay vertices", bufferVertices_ * sizeof(Vertex));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, uv));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+    glBindVertexArray(0);
+    return true;
+}
+
+void DebugOverlay::begin(int width, int height) {
+    width_ = width;
+    height_ = height;
+    vertices_.clear();
+}
+
+// Two triangles covering (x0, y0)-(x1, y1)
+void DebugOverlay::quad(float x0, float y0, float x1, float y1, glm::vec2 uv0, glm::vec2 uv1, uint32_t color) {
+    const Vertex a{ { x0, y0 }, { uv0.x, uv0.y }, color };
+    const Vertex b{ { x1, y0 }, { uv1.x, uv0.y }, color };
+    const Vertex c{ { x1, y1 }, { uv1.x, uv1.y }, color };
+    const Vertex d{ { x0, y1 }, { uv0.x, uv1.y }, color };
+    vertices_.insert(vertices_.end(), { a, b, c, a, c, d });
+}
+
+void DebugOverlay::rect(float x, float y, float w, float h, uint32_t color) {
+    const glm::vec2 uv = solidUV();
+    quad(x, y, x + w, y + h, uv, uv, color);
+}
+
+// A line is a thin quad along the segment
+void DebugOverlay::line(glm::vec2 a, glm::vec2 b, uint32_t color, float width) {
+    glm::vec2 d = b - a;
+    float len = glm::length(d);
+    if (len <= 0.0f) return;
+
+    const glm::vec2 n = glm::vec2(-d.y, d.x) * (0.5f * width / len);
+    const glm::vec2 uv = solidUV();
+    const Vertex v0{ a - n, uv, color }, v1{ b - n, uv, color }, v2{ b + n, uv, color }, v3{ a + n, uv, color };
+    vertices_.insert(vertices_.end(), { v0, v1, v2, v0, v2, v3 });
+}
+
+float DebugOverlay::text(float x, float y, const char* s, uint32_t color, int scale) {
+    const float w = float(GLYPH_W * scale), h = float(GLYPH_H * scale);
+    for (; *s; ++s) {
+        int c = static_cast<unsigned char>(*s);
+        if (c < 32 || c > 126) c = '?';
+        if (c != ' ') {
+            glm::vec2 uv0, uv1;
+            glyphUV(c, uv0, uv1);
+            quad(x, y, x + w, y + h, uv0, uv1, color);
+        }
+        x += w;
+    }
+    return x;
+}
+
+void DebugOverlay::flush() {
+    if (vertices_.empty()) return;
+
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    shader_->use();
+    glm::mat4 proj = glm::ortho(0.0f, float(width_), float(height_), 0.0f);
+    shader_->setMat4("uProj", glm::value_ptr(proj));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, font_);
+
+    // Orphan the buffer so the upload never waits for the previous frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    if (vertices_.size() > bufferVertices_) {
+        bufferVertices_ = vertices_.capacity();
+        bufferMemory_.resize(bufferVertices_ * sizeof(Vertex));
+    }
+    glBufferData(GL_ARRAY_BUFFER, bufferVertices_ * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices_.size() * sizeof(Vertex), vertices_.data());
+
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices_.size()));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    if (cullFace) glEnable(GL_CULL_FACE);
+    if (!blend) glDisable(GL_BLEND);
+    vertices_.clear();
+}
+
+GpuTimer::~GpuTimer() {
+    if (queries_[0]) glDeleteQueries(LATENCY, queries_);
+}
+
+// Start timing. The oldest query is read back first; if the GPU has not finished it yet,
+// this frame goes unmeasured rather than stalling.
+void GpuTimer::begin() {
+    if (!queries_[0]) glGenQueries(LATENCY, queries_);
+
+    GLuint q = queries_[slot_];
+    if (pending_[slot_]) {
+        GLint available = 0;
+        glGetQueryObjectiv(q, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(q, GL_QUERY_RESULT, &ns);
+        lastMs_ = static_cast<float>(ns / 1e6);
+        pending_[slot_] = false;
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, q);
+    running_ = true;
+}
+
+void GpuTimer::end() {
+    if (!running_) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    pending_[slot_] = true;
+    slot_ = (slot_ + 1) % LATENCY;
+    running_ = false;
+}
+
+} // namespace pokepp
@@ -0,0 +1,313 @@
+#include "pokeapp/Ecs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+/*
+	Implementation of the archetype Registry. See Ecs.h for an overview.
+
+	Chunk layout: the entity handles first, then one column per component in ascending
+	component ID order, each aligned for its type. The capacity is the largest entity count
+	whose columns fit in the chunk.
+*/
+
+namespace pokepp {
+
+namespace ecs_detail {
+    namespace {
+        // Fixed storage, so lookups never race with a registration on another thread
+        std::array<ComponentInfo, MAX_COMPONENTS> g_components;
+        std::atomic<uint32_t> g_componentCount{ 0 };
+        std::mutex g_registerMutex;
+    }
+
+    // Component masks are 64 bits wide, so one more type cannot be stored at all: fail
+    // loudly in every build rather than write past the table
+    uint32_t registerComponent(const ComponentInfo& info) {
+        std::lock_guard<std::mutex> lock(g_registerMutex);
+        uint32_t id = g_componentCount.load();
+        if (id >= MAX_COMPONENTS) {
+            std::fprintf(stderr, "Registry: too many component types (at most %u)\n", MAX_COMPONENTS);
+            std::abort();
+        }
+        g_components[id] = info;
+        g_componentCount.store(id + 1);
+        return id;
+    }
+
+    const ComponentInfo& componentInfo(uint32_t id) {
+        return g_components[id];
+    }
+}
+
+namespace {
+    constexpr size_t CHUNK_ALIGN = 64;
+
+    size_t alignUp(size_t v, size_t align) {
+        return (v + align - 1) & ~(align - 1);
+    }
+
+    std::byte* allocateChunk(size_t bytes) {
+        return static_cast<std::byte*>(::operator new(bytes, std::align_val_t{ CHUNK_ALIGN }));
+    }
+
+    void freeChunk(std::byte* data) {
+        ::operator delete(data, std::align_val_t{ CHUNK_ALIGN });
+    }
+}
+
+Registry::~Registry() {
+    clear();
+    for (Archetype& a : archetypes_) {
+        for (std::byte* data : a.spare) freeChunk(data);
+    }
+}
+
+// Find the archetype for a component set, creating it (and its chunk layout) on first use
+uint32_t Registry::archetypeFor(ComponentMask mask) {
+    auto it = archetypeByMask_.find(mask);
+    if (it != archetypeByMask_.end()) return it->second;
+
+    Archetype a;
+    a.mask = mask;
+    a.column.fill(-1);
+    size_t perEntity = sizeof(Entity);
+    for (uint32_t id = 0; id < MAX_COMPONENTS; ++id) {
+        if (!(mask & (ComponentMask{ 1 } << id))) continue;
+        a.column[id] = static_cast<int8_t>(a.components.size());
+        a.components.push_back(id);
+        a.sizes.push_back(static_cast<uint32_t>(ecs_detail::componentInfo(id).size));
+        perEntity += ecs_detail::componentInfo(id).size;
+    }
+    a.offsets.resize(a.components.size());
+
+    // Lay the columns out for a capacity, returning the bytes used
+    auto layout = [&](uint32_t capacity) {
+        size_t offset = sizeof(Entity) * capacity;
+        for (size_t c = 0; c < a.components.size(); ++c) {
+            offset = alignUp(offset, ecs_detail::componentInfo(a.components[c]).align);
+            a.offsets[c] = static_cast<uint32_t>(offset);
+            offset += a.sizes[c] * capacity;
+        }
+        return offset;
+    };
+
+    a.chunkBytes = CHUNK_BYTES;
+    a.capacity = static_cast<uint32_t>(std::max<size_t>(1, CHUNK_BYTES / perEntity));
+    while (a.capacity > 1 && layout(a.capacity) > CHUNK_BYTES) a.capacity--;
+    a.chunkBytes = alignUp(std::max(CHUNK_BYTES, layout(a.capacity)), CHUNK_ALIGN);
+
+    uint32_t index = static_cast<uint32_t>(archetypes_.size());
+    archetypes_.push_back(std::move(a));
+    archetypeByMask_.emplace(mask, index);
+    return index;
+}
+
+Entity Registry::allocateEntity() {
+    uint32_t index;
+    if (freeHead_ != Handle::INVALID_INDEX) {
+        index = freeHead_;
+        freeHead_ = records_[index].row;
+    } else {
+        index = static_cast<uint32_t>(records_.size());
+        records_.push_back({});
+    }
+
+    Record& rec = records_[index];
+    rec.live = true;
+    liveCount_++;
+    return Entity{ index, rec.generation };
+}
+
+// Reserve the next row of an archetype for e, opening a chunk if the last one is full
+void Registry::placeEntity(Entity e, uint32_t archetype) {
+    Archetype& a = archetypes_[archetype];
+    structureVersion_++;
+    if (a.chunks.empty() || a.chunks.back().count == a.capacity) {
+        std::byte* data;
+        if (!a.spare.empty()) {
+            data = a.spare.back();
+            a.spare.pop_back();
+        } else {
+            data = allocateChunk(a.chunkBytes);
+        }
+        a.chunks.push_back({ data, 0 });
+    }
+
+    Chunk& c = a.chunks.back();
+    uint32_t row = c.count++;
+    a.entities(c)[row] = e;
+
+    Record& rec = records_[e.index];
+    rec.archetype = archetype;
+    rec.chunk = static_cast<uint32_t>(a.chunks.size() - 1);
+    rec.row = row;
+}
+
+// Fill a row whose components are already destroyed or moved out with the archetype's last
+// row, keeping every chunk but the last full
+void Registry::vacateRow(uint32_t archetype, uint32_t chunk, uint32_t row) {
+    Archetype& a = archetypes_[archetype];
+    structureVersion_++;
+    Chunk& last = a.chunks.back();
+    uint32_t lastChunk = static_cast<uint32_t>(a.chunks.size() - 1);
+    uint32_t lastRow = last.count - 1;
+
+    if (chunk != lastChunk || row != lastRow) {
+        Chunk& c = a.chunks[chunk];
+        for (size_t col = 0; col < a.components.size(); ++col) {
+            const int column = static_cast<int>(col);
+            ecs_detail::componentInfo(a.components[col]).relocate(a.at(c, column, row), a.at(last, column, lastRow));
+        }
+
+        Entity moved = a.entities(last)[lastRow];
+        a.entities(c)[row] = moved;
+        records_[moved.index].chunk = chunk;
+        records_[moved.index].row = row;
+    }
+
+    if (--last.count == 0) {
+        releaseChunk(a, last.data);
+        a.chunks.pop_back();
+    }
+}
+
+void Registry::releaseChunk(Archetype& a, std::byte* data) {
+    // a.chunks still counts this chunk
+    if (a.chunks.size() + a.spare.size() <= a.reservedChunks) {
+        a.spare.push_back(data);
+    } else {
+        freeChunk(data);
+    }
+}
+
+// Open spare chunks until n rows fit, and size the tables that would otherwise grow as
+// the archetype fills up
+void Registry::reserveRows(uint32_t archetype, size_t n) {
+    Archetype& a = archetypes_[archetype];
+    size_t chunks = (n + a.capacity - 1) / a.capacity;
+    if (chunks <= a.reservedChunks) return;
+
+    a.reservedChunks = chunks;
+    a.chunks.reserve(chunks);
+    a.spare.reserve(chunks);
+    while (a.chunks.size() + a.spare.size() < chunks) a.spare.push_back(allocateChunk(a.chunkBytes));
+    records_.reserve(liveCount_ + n);
+}
+
+// Move an entity to the archetype for newMask. Components in both archetypes are relocated,
+// the ones dropped are destroyed, and new ones are left unconstructed for the caller.
+void Registry::moveEntity(Entity e, ComponentMask newMask) {
+    const Record old = records_[e.index];
+    uint32_t target = archetypeFor(newMask);  // May grow archetypes_: look them up afterwards
+    placeEntity(e, target);
+
+    Archetype& from = archetypes_[old.archetype];
+    Archetype& to = archetypes_[target];
+    const Chunk& src = from.chunks[old.chunk];
+    const Record& rec = records_[e.index];
+    const Chunk& dst = to.chunks[rec.chunk];
+
+    for (size_t col = 0; col < from.components.size(); ++col) {
+        const uint32_t id = from.components[col];
+        void* p = from.at(src, static_cast<int>(col), old.row);
+        if (to.column[id] >= 0) {
+            ecs_detail::componentInfo(id).relocate(to.at(dst, to.column[id], rec.row), p);
+        } else {
+            ecs_detail::componentInfo(id).destroy(p);
+        }
+    }
+
+    vacateRow(old.archetype, old.chunk, old.row);
+}
+
+bool Registry::destroy(Entity e) {
+    if (!alive(e)) return false;
+
+    Record& rec = records_[e.index];
+    Archetype& a = archetypes_[rec.archetype];
+    const Chunk& c = a.chunks[rec.chunk];
+    for (size_t col = 0; col < a.components.size(); ++col) {
+        ecs_detail::componentInfo(a.components[col]).destroy(a.at(c, static_cast<int>(col), rec.row));
+    }
+    vacateRow(rec.archetype, rec.chunk, rec.row);
+
+    // Invalidate outstanding handles and push the record onto the free list
+    rec.live = false;
+    rec.generation++;
+    rec.row = freeHead_;
+    freeHead_ = e.index;
+    liveCount_--;
+    return true;
+}
+
+bool Registry::alive(Entity e) const {
+    return e.index < records_.size() && records_[e.index].live && records_[e.index].generation == e.generation;
+}
+
+void* Registry::componentPtr(Entity e, uint32_t id) const {
+    if (!alive(e)) return nullptr;
+
+    const Record& rec = records_[e.index];
+    const Archetype& a = archetypes_[rec.archetype];
+    int col = a.column[id];
+    if (col < 0) return nullptr;
+    return a.at(a.chunks[rec.chunk], col, rec.row);
+}
+
+size_t Registry::countMatching(ComponentMask include, ComponentMask exclude) const {
+    size_t n = 0;
+    for (const Archetype& a : archetypes_) {
+        if ((a.mask & include) != include || (a.mask & exclude)) continue;
+        for (const Chunk& c : a.chunks) n += c.count;
+    }
+    return n;
+}
+
+size_t Registry::chunkMemory() const {
+    size_t n = 0;
+    for (const Archetype& a : archetypes_) n += (a.chunks.size() + a.spare.size()) * a.chunkBytes;
+    return n;
+}
+
+size_t Registry::bookkeepingMemory() const {
+    size_t n = records_.capacity() * sizeof(Record) + scratch_.capacity() * sizeof(ChunkRef)
+             + archetypes_.capacity() * sizeof(Archetype);
+    for (const Archetype& a : archetypes_) {
+        n += (a.components.capacity() + a.offsets.capacity() + a.sizes.capacity()) * sizeof(uint32_t)
+           + a.chunks.capacity() * sizeof(Chunk) + a.spare.capacity() * sizeof(std::byte*);
+    }
+    return n;
+}
+
+void Registry::clear() {
+    structureVersion_++;
+    for (Archetype& a : archetypes_) {
+        for (Chunk& c : a.chunks) {
+            for (size_t col = 0; col < a.components.size(); ++col) {
+                const ComponentInfo& info = ecs_detail::componentInfo(a.components[col]);
+                for (uint32_t row = 0; row < c.count; ++row) info.destroy(a.at(c, static_cast<int>(col), row));
+            }
+        }
+        // Reserved chunks become spares, the rest are freed
+        while (!a.chunks.empty()) {
+            releaseChunk(a, a.chunks.back().data);
+            a.chunks.pop_back();
+        }
+    }
+
+    for (uint32_t i = 0; i < records_.size(); ++i) {
+        Record& rec = records_[i];
+        if (!rec.live) continue;
+        rec.live = false;
+        rec.generation++;
+        rec.row = freeHead_;
+        freeHead_ = i;
+    }
+    liveCount_ = 0;
+}
+
+} // namespace pokepp
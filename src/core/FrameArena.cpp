@@ -0,0 +1,94 @@
+#include "pokeapp/FrameArena.h"
+#include "pokeapp/Constants.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+/*
+	Implementation of the FrameArena class, see FrameArena.h.
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr std::align_val_t BLOCK_ALIGN{ alignof(std::max_align_t) };
+
+    // Overflow blocks start with a pointer to the previous one
+    constexpr size_t LINK_BYTES = alignof(std::max_align_t);
+
+    std::byte* allocateBlock(size_t bytes) {
+        return static_cast<std::byte*>(::operator new(bytes, BLOCK_ALIGN));
+    }
+
+    void freeBlock(std::byte* block) {
+        ::operator delete(block, BLOCK_ALIGN);
+    }
+
+    size_t alignUp(size_t offset, const std::byte* base, size_t alignment) {
+        uintptr_t p = reinterpret_cast<uintptr_t>(base) + offset;
+        return offset + ((alignment - p % alignment) % alignment);
+    }
+}
+
+FrameArena::FrameArena(size_t bytes)
+    : block_(allocateBlock(std::max<size_t>(bytes, 1))), capacity_(std::max<size_t>(bytes, 1)) {}
+
+FrameArena::~FrameArena() {
+    releaseOverflow();
+    freeBlock(block_);
+}
+
+FrameArena& frameArena() {
+    thread_local FrameArena arena(size_t(constants::FRAME_ARENA_KIB) * 1024);
+    return arena;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    std::byte* base = overflow_ ? overflow_ : block_;
+    size_t size = overflow_ ? overflowSize_ : capacity_;
+
+    size_t start = alignUp(offset_, base, alignment);
+    if (start + bytes > size) {
+        // Out of room: chain a block big enough for this allocation or another main block's worth
+        size_t newSize = std::max(capacity_, LINK_BYTES + bytes + alignment);
+        std::byte* block = allocateBlock(newSize);
+        *reinterpret_cast<std::byte**>(block) = overflow_;
+        overflow_ = block;
+        overflowSize_ = newSize;
+        overflows_++;
+
+        base = block;
+        start = alignUp(LINK_BYTES, base, alignment);
+    }
+
+    offset_ = start + bytes;
+    used_ += bytes;
+    return base + start;
+}
+
+void FrameArena::releaseOverflow() {
+    while (overflow_) {
+        std::byte* previous = *reinterpret_cast<std::byte**>(overflow_);
+        freeBlock(overflow_);
+        overflow_ = previous;
+    }
+    overflowSize_ = 0;
+}
+
+// A frame that overflowed gets a main block sized for it (with room for alignment padding),
+// so the next frame like it fits in one block
+void FrameArena::reset() {
+    peak_ = std::max(peak_, used_);
+    if (overflow_) {
+        releaseOverflow();
+        size_t newCapacity = std::max(capacity_ * 2, peak_ + peak_ / 4);
+        freeBlock(block_);
+        block_ = allocateBlock(newCapacity);
+        capacity_ = newCapacity;
+    }
+    offset_ = 0;
+    used_ = 0;
+}
+
+} // namespace pokepp
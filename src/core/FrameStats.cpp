@@ -0,0 +1,60 @@
+#include "pokeapp/FrameStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+	Implementation of FrameStats, see FrameStats.h.
+*/
+
+namespace pokepp {
+
+RenderStats& renderStats() {
+    static RenderStats stats;
+    return stats;
+}
+
+FrameStats::FrameStats(size_t window)
+    : cpu_(std::max<size_t>(window, 1), 0.0f),
+      gpu_(cpu_.size(), -1.0f),
+      interval_(cpu_.size(), 0.0f) {
+    sorted_.reserve(cpu_.size());
+}
+
+void FrameStats::add(float cpuMs, float gpuMs, float intervalMs) {
+    cpu_[head_] = cpuMs;
+    gpu_[head_] = gpuMs;
+    interval_[head_] = intervalMs;
+    head_ = (head_ + 1) % cpu_.size();
+    count_ = std::min(count_ + 1, cpu_.size());
+}
+
+// Summarize the samples in the window, skipping negative (unknown) ones
+FrameTimeSummary FrameStats::summarize(const std::vector<float>& samples) const {
+    sorted_.clear();
+    for (size_t i = 0; i < count_; ++i) {
+        float v = samples[index(i)];
+        if (v >= 0.0f) sorted_.push_back(v);
+    }
+
+    FrameTimeSummary s;
+    s.samples = sorted_.size();
+    if (sorted_.empty()) return s;
+
+    std::sort(sorted_.begin(), sorted_.end());
+    auto rank = [&](float p) {
+        size_t r = static_cast<size_t>(std::ceil(p * sorted_.size()));
+        return sorted_[std::clamp<size_t>(r, 1, sorted_.size()) - 1];
+    };
+
+    double sum = 0.0;
+    for (float v : sorted_) sum += v;
+    s.min = sorted_.front();
+    s.max = sorted_.back();
+    s.avg = static_cast<float>(sum / sorted_.size());
+    s.p95 = rank(0.95f);
+    s.p99 = rank(0.99f);
+    return s;
+}
+
+} // namespace pokepp
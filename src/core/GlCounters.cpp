@@ -0,0 +1,263 @@
+#include "pokeapp/GlCounters.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+/*
+	Implementation of the GL call counters, see GlCounters.h. GL is only called from the
+	main thread, so the counts need no synchronization.
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr const char* NO_PASS = "other";
+    constexpr size_t NO_PASS_INDEX = static_cast<size_t>(-1);
+    constexpr GLuint UNKNOWN = ~0u;  // Binding not seen yet
+    constexpr int MAX_TEXTURE_UNITS = 32;
+
+    const char* const CALL_NAMES[] = {
+        "glDrawElements", "glDrawArrays", "glUseProgram", "glBindTexture", "glBindVertexArray",
+        "glUniform*", "glBufferSubData", "glGetUniformLocation", "glIsEnabled",
+    };
+    static_assert(std::size(CALL_NAMES) == GlCallCounts::KINDS);
+
+    struct State {
+        bool installed = false;
+        GlCallCounts total, lastTotal;
+        std::vector<GlPassCounts> frame, last;
+        size_t pass = NO_PASS_INDEX;  // Index into frame
+
+        // Bindings as last set through the wrappers
+        GLuint program = UNKNOWN, vertexArray = UNKNOWN;
+        int unit = 0;
+        GLuint textures[MAX_TEXTURE_UNITS];
+    };
+
+    State& state() {
+        static State s;
+        return s;
+    }
+
+    size_t passIndex(State& s, const char* name) {
+        for (size_t i = 0; i < s.frame.size(); ++i) {
+            if (s.frame[i].name == name || std::strcmp(s.frame[i].name, name) == 0) return i;
+        }
+        s.frame.push_back({ name, {} });
+        return s.frame.size() - 1;
+    }
+
+#ifdef POKEPP_GL_COUNTERS
+    void count(GlCall call, bool redundant = false) {
+        State& s = state();
+        if (s.pass == NO_PASS_INDEX) s.pass = passIndex(s, NO_PASS);
+        const size_t i = static_cast<size_t>(call);
+        GlCallCounts& pass = s.frame[s.pass].counts;
+        pass.calls[i]++;
+        s.total.calls[i]++;
+        if (redundant) {
+            pass.redundant[i]++;
+            s.total.redundant[i]++;
+        }
+    }
+
+    // The real entry points, and wrappers that count and forward
+    PFNGLDRAWELEMENTSPROC realDrawElements;
+    PFNGLDRAWARRAYSPROC realDrawArrays;
+    PFNGLUSEPROGRAMPROC realUseProgram;
+    PFNGLBINDTEXTUREPROC realBindTexture;
+    PFNGLACTIVETEXTUREPROC realActiveTexture;
+    PFNGLBINDVERTEXARRAYPROC realBindVertexArray;
+    PFNGLUNIFORM1FPROC realUniform1f;
+    PFNGLUNIFORM1IPROC realUniform1i;
+    PFNGLUNIFORM3FPROC realUniform3f;
+    PFNGLUNIFORM3FVPROC realUniform3fv;
+    PFNGLUNIFORMMATRIX3FVPROC realUniformMatrix3fv;
+    PFNGLUNIFORMMATRIX4FVPROC realUniformMatrix4fv;
+    PFNGLBUFFERSUBDATAPROC realBufferSubData;
+    PFNGLGETUNIFORMLOCATIONPROC realGetUniformLocation;
+    PFNGLISENABLEDPROC realIsEnabled;
+
+    void APIENTRY countDrawElements(GLenum mode, GLsizei n, GLenum type, const void* indices) {
+        count(GlCall::DrawElements);
+        realDrawElements(mode, n, type, indices);
+    }
+
+    void APIENTRY countDrawArrays(GLenum mode, GLint first, GLsizei n) {
+        count(GlCall::DrawArrays);
+        realDrawArrays(mode, first, n);
+    }
+
+    void APIENTRY countUseProgram(GLuint program) {
+        State& s = state();
+        count(GlCall::UseProgram, s.program == program);
+        s.program = program;
+        realUseProgram(program);
+    }
+
+    // Only 2D textures are tracked for redundancy, per unit
+    void APIENTRY countBindTexture(GLenum target, GLuint texture) {
+        State& s = state();
+        bool tracked = target == GL_TEXTURE_2D && s.unit < MAX_TEXTURE_UNITS;
+        count(GlCall::BindTexture, tracked && s.textures[s.unit] == texture);
+        if (tracked) s.textures[s.unit] = texture;
+        realBindTexture(target, texture);
+    }
+
+    // Not counted, only followed so texture binds can be matched to their unit
+    void APIENTRY trackActiveTexture(GLenum texture) {
+        state().unit = static_cast<int>(texture - GL_TEXTURE0);
+        realActiveTexture(texture);
+    }
+
+    void APIENTRY countBindVertexArray(GLuint array) {
+        State& s = state();
+        count(GlCall::BindVertexArray, s.vertexArray == array);
+        s.vertexArray = array;
+        realBindVertexArray(array);
+    }
+
+    void APIENTRY countUniform1f(GLint location, GLfloat v0) {
+        count(GlCall::Uniform);
+        realUniform1f(location, v0);
+    }
+
+    void APIENTRY countUniform1i(GLint location, GLint v0) {
+        count(GlCall::Uniform);
+        realUniform1i(location, v0);
+    }
+
+    void APIENTRY countUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+        count(GlCall::Uniform);
+        realUniform3f(location, v0, v1, v2);
+    }
+
+    void APIENTRY countUniform3fv(GLint location, GLsizei n, const GLfloat* value) {
+        count(GlCall::Uniform);
+        realUniform3fv(location, n, value);
+    }
+
+    void APIENTRY countUniformMatrix3fv(GLint location, GLsizei n, GLboolean transpose, const GLfloat* value) {
+        count(GlCall::Uniform);
+        realUniformMatrix3fv(location, n, transpose, value);
+    }
+
+    void APIENTRY countUniformMatrix4fv(GLint location, GLsizei n, GLboolean transpose, const GLfloat* value) {
+        count(GlCall::Uniform);
+        realUniformMatrix4fv(location, n, transpose, value);
+    }
+
+    void APIENTRY countBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+        count(GlCall::BufferSubData);
+        realBufferSubData(target, offset, size, data);
+    }
+
+    GLint APIENTRY countGetUniformLocation(GLuint program, const GLchar* name) {
+        count(GlCall::GetUniformLocation);
+        return realGetUniformLocation(program, name);
+    }
+
+    GLboolean APIENTRY countIsEnabled(GLenum cap) {
+        count(GlCall::IsEnabled);
+        return realIsEnabled(cap);
+    }
+
+    // Keep the loaded pointer in `real` and put the wrapper in its place
+    template <typename Proc>
+    void wrap(Proc& gladPointer, Proc& real, Proc wrapper) {
+        real = gladPointer;
+        gladPointer = wrapper;
+    }
+#endif
+}
+
+const char* glCallName(GlCall call) {
+    return CALL_NAMES[static_cast<size_t>(call)];
+}
+
+uint32_t GlCallCounts::total() const {
+    uint32_t n = 0;
+    for (uint32_t c : calls) n += c;
+    return n;
+}
+
+void GlCallCounts::add(const GlCallCounts& o) {
+    for (size_t i = 0; i < KINDS; ++i) {
+        calls[i] += o.calls[i];
+        redundant[i] += o.redundant[i];
+    }
+}
+
+GlCallCounts GlCallCounts::minus(const GlCallCounts& o) const {
+    GlCallCounts out;
+    for (size_t i = 0; i < KINDS; ++i) {
+        out.calls[i] = calls[i] - o.calls[i];
+        out.redundant[i] = redundant[i] - o.redundant[i];
+    }
+    return out;
+}
+
+bool GlCounters::install() {
+#ifdef POKEPP_GL_COUNTERS
+    State& s = state();
+    if (s.installed) return true;
+    if (!glad_glDrawElements || !glad_glUseProgram) return false;  // GL not loaded
+
+    std::fill(std::begin(s.textures), std::end(s.textures), UNKNOWN);
+    wrap(glad_glDrawElements, realDrawElements, &countDrawElements);
+    wrap(glad_glDrawArrays, realDrawArrays, &countDrawArrays);
+    wrap(glad_glUseProgram, realUseProgram, &countUseProgram);
+    wrap(glad_glBindTexture, realBindTexture, &countBindTexture);
+    wrap(glad_glActiveTexture, realActiveTexture, &trackActiveTexture);
+    wrap(glad_glBindVertexArray, realBindVertexArray, &countBindVertexArray);
+    wrap(glad_glUniform1f, realUniform1f, &countUniform1f);
+    wrap(glad_glUniform1i, realUniform1i, &countUniform1i);
+    wrap(glad_glUniform3f, realUniform3f, &countUniform3f);
+    wrap(glad_glUniform3fv, realUniform3fv, &countUniform3fv);
+    wrap(glad_glUniformMatrix3fv, realUniformMatrix3fv, &countUniformMatrix3fv);
+    wrap(glad_glUniformMatrix4fv, realUniformMatrix4fv, &countUniformMatrix4fv);
+    wrap(glad_glBufferSubData, realBufferSubData, &countBufferSubData);
+    wrap(glad_glGetUniformLocation, realGetUniformLocation, &countGetUniformLocation);
+    wrap(glad_glIsEnabled, realIsEnabled, &countIsEnabled);
+    s.installed = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool GlCounters::enabled() {
+    return state().installed;
+}
+
+void GlCounters::beginPass(const char* name) {
+    State& s = state();
+    if (s.installed) s.pass = passIndex(s, name);
+}
+
+// Swap the frame's passes into last, keeping both vectors' capacity
+void GlCounters::endFrame() {
+    State& s = state();
+    if (!s.installed) return;
+    s.last.swap(s.frame);
+    s.frame.clear();
+    s.pass = NO_PASS_INDEX;
+    s.lastTotal = {};
+    for (const GlPassCounts& p : s.last) s.lastTotal.add(p.counts);
+}
+
+const GlCallCounts& GlCounters::lastFrame() {
+    return state().lastTotal;
+}
+
+const std::vector<GlPassCounts>& GlCounters::lastFramePasses() {
+    return state().last;
+}
+
+const GlCallCounts& GlCounters::total() {
+    return state().total;
+}
+
+} // namespace pokepp
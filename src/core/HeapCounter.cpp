@@ -0,0 +1,206 @@
+#include "pokeapp/HeapCounter.h"
+#include "pokeapp/Constants.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef POKEPP_ALLOC_TRACKING
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif __has_include(<execinfo.h>)
+#include <execinfo.h>
+#include <unistd.h>
+#define POKEPP_HAVE_EXECINFO
+#endif
+#endif
+
+/*
+	Implementation of the heap counter: replacements for the global operator new and
+	delete, see HeapCounter.h. The array forms are left to the standard library, which
+	forwards them here.
+
+	Nothing here may allocate with operator new. Stacks go to a fixed table; a slot is
+	claimed with an atomic counter and marked complete once written, so printStacks()
+	only reads finished ones.
+*/
+
+namespace pokepp {
+
+namespace {
+    std::atomic<uint64_t> g_allocations{ 0 };
+    std::atomic<uint64_t> g_bytes{ 0 };
+    thread_local uint64_t t_allocations = 0;
+    thread_local uint64_t t_bytes = 0;
+
+#ifdef POKEPP_ALLOC_TRACKING
+    constexpr int MAX_STACKS = constants::ALLOC_STACK_CAPTURES;
+    constexpr int MAX_FRAMES = constants::ALLOC_STACK_DEPTH;
+
+    struct Stack {
+        void* frames[MAX_FRAMES];
+        int depth = 0;
+        size_t size = 0;
+        std::atomic<bool> complete{ false };
+    };
+
+    Stack g_stacks[MAX_STACKS];
+    std::atomic<int> g_stackNext{ 0 };   // Next slot to claim
+    std::atomic<int> g_stackLimit{ 0 };  // Slots to fill before capture stops
+
+    thread_local bool t_capturing = false;  // This thread called captureStacks()
+    thread_local bool t_inCapture = false;  // The unwinder may allocate on first use
+
+    int captureFrames(void** frames, int maxFrames) {
+#if defined(_WIN32)
+        return CaptureStackBackTrace(0, static_cast<DWORD>(maxFrames), frames, nullptr);
+#elif defined(POKEPP_HAVE_EXECINFO)
+        return backtrace(frames, maxFrames);
+#else
+        (void)frames;
+        (void)maxFrames;
+        return 0;
+#endif
+    }
+
+    void recordStack(size_t size) {
+        if (!t_capturing || t_inCapture || g_stackNext.load(std::memory_order_relaxed) >= g_stackLimit.load(std::memory_order_relaxed)) return;
+        int slot = g_stackNext.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= g_stackLimit.load(std::memory_order_relaxed)) return;
+
+        t_inCapture = true;
+        Stack& s = g_stacks[slot];
+        s.depth = captureFrames(s.frames, MAX_FRAMES);
+        s.size = size;
+        s.complete.store(true, std::memory_order_release);
+        t_inCapture = false;
+    }
+#endif
+
+    void count(size_t size) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_bytes.fetch_add(size, std::memory_order_relaxed);
+        t_allocations++;
+        t_bytes += size;
+#ifdef POKEPP_ALLOC_TRACKING
+        recordStack(size);
+#endif
+    }
+
+    void* allocate(size_t size) {
+        count(size);
+        return std::malloc(size ? size : 1);
+    }
+
+    void* allocateAligned(size_t size, std::align_val_t alignment) {
+        count(size);
+        size_t align = static_cast<size_t>(alignment);
+#ifdef _MSC_VER
+        return _aligned_malloc(size ? size : 1, align);
+#else
+        // aligned_alloc wants a size that is a multiple of the alignment
+        return std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align);
+#endif
+    }
+
+    void freeAligned(void* p) {
+#ifdef _MSC_VER
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+}
+
+uint64_t HeapCounter::allocations() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t HeapCounter::bytes() {
+    return g_bytes.load(std::memory_order_relaxed);
+}
+
+uint64_t HeapCounter::threadAllocations() { return t_allocations; }
+uint64_t HeapCounter::threadBytes() { return t_bytes; }
+
+#ifdef POKEPP_ALLOC_TRACKING
+bool HeapCounter::tracking() { return true; }
+
+void HeapCounter::captureStacks(int count) {
+    // Unwind once here, so loading the unwinder is not the first allocation recorded
+    void* warm[1];
+    t_inCapture = true;
+    captureFrames(warm, 1);
+    t_inCapture = false;
+
+    g_stackLimit.store(0, std::memory_order_relaxed);
+    for (Stack& s : g_stacks) s.complete.store(false, std::memory_order_relaxed);
+    g_stackNext.store(0, std::memory_order_relaxed);
+    g_stackLimit.store(count < MAX_STACKS ? count : MAX_STACKS, std::memory_order_relaxed);
+    t_capturing = true;
+}
+
+void HeapCounter::stopStackCapture() {
+    g_stackLimit.store(0, std::memory_order_relaxed);
+    t_capturing = false;
+}
+
+int HeapCounter::capturedStacks() {
+    int n = 0;
+    for (const Stack& s : g_stacks) {
+        if (s.complete.load(std::memory_order_acquire)) n++;
+    }
+    return n;
+}
+
+void HeapCounter::printStacks(std::FILE* out) {
+    for (int i = 0; i < MAX_STACKS; ++i) {
+        const Stack& s = g_stacks[i];
+        if (!s.complete.load(std::memory_order_acquire)) continue;
+
+        std::fprintf(out, "allocation %d: %zu bytes\n", i + 1, s.size);
+#ifdef POKEPP_HAVE_EXECINFO
+        std::fflush(out);
+        backtrace_symbols_fd(s.frames, s.depth, fileno(out));
+#else
+        for (int f = 0; f < s.depth; ++f) std::fprintf(out, "  %p\n", s.frames[f]);
+#endif
+    }
+    std::fflush(out);
+}
+#else
+bool HeapCounter::tracking() { return false; }
+void HeapCounter::captureStacks(int) {}
+void HeapCounter::stopStackCapture() {}
+int HeapCounter::capturedStacks() { return 0; }
+void HeapCounter::printStacks(std::FILE*) {}
+#endif
+
+} // namespace pokepp
+
+void* operator new(std::size_t size) {
+    if (void* p = pokepp::allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return pokepp::allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* p = pokepp::allocateAligned(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return pokepp::allocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { pokepp::freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { pokepp::freeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { pokepp::freeAligned(p); }
@@ -0,0 +1,189 @@
+#include "pokeapp/InputLog.h"
+
+#include <cstring>
+#include <iterator>
+
+/*
+	Implementation of the InputRecorder and InputLog. See InputLog.h for an overview.
+
+	Layout (all multi-byte values little endian):
+	    "PPIL", version byte, scene path (varint length and bytes), varint seed,
+	    float timestep, varint width, varint height
+	    per event: type byte, varint tick delta, zigzag varint payload (one or two values)
+	    end marker: END_MARKER byte, varint ticks, 8-byte state hash
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr char MAGIC[4] = { 'P', 'P', 'I', 'L' };
+    constexpr uint8_t VERSION = 2;
+    constexpr uint8_t END_MARKER = 0xFF;
+    constexpr size_t FLUSH_BYTES = 4096;
+
+    // Events with a second payload value
+    bool hasSecondValue(InputEventType type) {
+        return type != InputEventType::MouseButtonDown && type != InputEventType::MouseButtonUp;
+    }
+
+    void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    void putSigned(std::vector<uint8_t>& out, int32_t v) {
+        uint32_t zigzag = (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+        putVarint(out, zigzag);
+    }
+
+    void putFixed(std::vector<uint8_t>& out, uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        }
+    }
+
+    // Bounds-checked reader over the loaded file
+    struct Reader {
+        const uint8_t* p;
+        const uint8_t* end;
+        bool ok = true;
+
+        bool atEnd() const { return p >= end; }
+
+        uint8_t byte() {
+            if (p >= end) { ok = false; return 0; }
+            return *p++;
+        }
+
+        uint64_t varint() {
+            uint64_t v = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t b = byte();
+                v |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if (!(b & 0x80)) return v;
+            }
+            ok = false;
+            return 0;
+        }
+
+        int32_t signedVarint() {
+            uint32_t zigzag = static_cast<uint32_t>(varint());
+            return static_cast<int32_t>((zigzag >> 1) ^ (0u - (zigzag & 1)));
+        }
+
+        uint64_t fixed(int bytes) {
+            uint64_t v = 0;
+            for (int i = 0; i < bytes; ++i) v |= static_cast<uint64_t>(byte()) << (8 * i);
+            return v;
+        }
+    };
+}
+
+InputRecorder::~InputRecorder() {
+    if (file_.is_open()) {
+        flush();
+    }
+}
+
+bool InputRecorder::open(const std::string& path, const InputLogHeader& header) {
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) return false;
+
+    buffer_.clear();
+    buffer_.insert(buffer_.end(), std::begin(MAGIC), std::end(MAGIC));
+    buffer_.push_back(VERSION);
+    putVarint(buffer_, header.scene.size());
+    buffer_.insert(buffer_.end(), header.scene.begin(), header.scene.end());
+    putVarint(buffer_, header.seed);
+    uint32_t timestepBits;
+    std::memcpy(&timestepBits, &header.timestep, sizeof(timestepBits));
+    putFixed(buffer_, timestepBits, 4);
+    putVarint(buffer_, static_cast<uint32_t>(header.width));
+    putVarint(buffer_, static_cast<uint32_t>(header.height));
+
+    lastTick_ = 0;
+    eventCount_ = 0;
+    return true;
+}
+
+void InputRecorder::record(const InputEvent& event) {
+    if (!file_.is_open()) return;
+
+    buffer_.push_back(static_cast<uint8_t>(event.type));
+    putVarint(buffer_, event.tick - lastTick_);
+    putSigned(buffer_, event.a);
+    if (hasSecondValue(event.type)) putSigned(buffer_, event.b);
+
+    lastTick_ = event.tick;
+    eventCount_++;
+    if (buffer_.size() >= FLUSH_BYTES) flush();
+}
+
+void InputRecorder::finish(uint32_t ticks, uint64_t stateHash) {
+    if (!file_.is_open()) return;
+
+    buffer_.push_back(END_MARKER);
+    putVarint(buffer_, ticks);
+    putFixed(buffer_, stateHash, 8);
+    flush();
+    file_.close();
+}
+
+void InputRecorder::flush() {
+    file_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    file_.flush();
+    buffer_.clear();
+}
+
+bool InputLog::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    *this = InputLog();
+    Reader in{ data.data(), data.data() + data.size() };
+
+    char magic[4];
+    for (char& c : magic) c = static_cast<char>(in.byte());
+    if (!in.ok || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || in.byte() != VERSION) return false;
+
+    size_t sceneLength = static_cast<size_t>(in.varint());
+    if (!in.ok || sceneLength > static_cast<size_t>(in.end - in.p)) return false;
+    header_.scene.assign(reinterpret_cast<const char*>(in.p), sceneLength);
+    in.p += sceneLength;
+
+    header_.seed = in.varint();
+    uint32_t timestepBits = static_cast<uint32_t>(in.fixed(4));
+    std::memcpy(&header_.timestep, &timestepBits, sizeof(timestepBits));
+    header_.width = static_cast<int32_t>(in.varint());
+    header_.height = static_cast<int32_t>(in.varint());
+    if (!in.ok) return false;
+
+    uint32_t tick = 0;
+    while (!in.atEnd()) {
+        uint8_t type = in.byte();
+        if (type == END_MARKER) {
+            tickCount_ = static_cast<uint32_t>(in.varint());
+            stateHash_ = in.fixed(8);
+            complete_ = in.ok;
+            break;
+        }
+        if (type > static_cast<uint8_t>(InputEventType::Resize)) break;
+
+        InputEvent event;
+        event.type = static_cast<InputEventType>(type);
+        tick += static_cast<uint32_t>(in.varint());
+        event.tick = tick;
+        event.a = in.signedVarint();
+        if (hasSecondValue(event.type)) event.b = in.signedVarint();
+        if (!in.ok) break;  // Truncated mid-event: keep what came before
+
+        events_.push_back(event);
+    }
+    return true;
+}
+
+} // namespace pokepp
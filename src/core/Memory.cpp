@@ -0,0 +1,179 @@
+#include "pokeapp/Memory.h"
+#include "pokeapp/Constants.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+/*
+	Implementation of the memory registry and reports, see Memory.h.
+*/
+
+namespace pokepp {
+
+namespace {
+    struct CategoryInfo {
+        const char* name;
+        bool gpu;
+        size_t budgetMiB;
+    };
+
+    constexpr CategoryInfo CATEGORIES[] = {
+        { "gpu meshes",     true,  constants::MEMORY_BUDGET_GPU_MESHES_MIB },
+        { "gpu textures",   true,  constants::MEMORY_BUDGET_GPU_TEXTURES_MIB },
+        { "gpu buffers",    true,  constants::MEMORY_BUDGET_GPU_BUFFERS_MIB },
+        { "cpu meshes",     false, constants::MEMORY_BUDGET_CPU_MESHES_MIB },
+        { "cpu terrain",    false, constants::MEMORY_BUDGET_CPU_TERRAIN_MIB },
+        { "cpu entities",   false, constants::MEMORY_BUDGET_CPU_ENTITIES_MIB },
+        { "cpu navigation", false, constants::MEMORY_BUDGET_CPU_NAVIGATION_MIB },
+        { "cpu collision",  false, constants::MEMORY_BUDGET_CPU_COLLISION_MIB },
+    };
+    static_assert(std::size(CATEGORIES) == static_cast<size_t>(MemoryCategory::Count));
+
+    constexpr size_t MIB = 1024 * 1024;
+
+    std::mutex g_mutex;
+    std::unordered_map<uint32_t, MemoryEntry> g_tracked;
+    uint32_t g_nextId = 1;
+
+    const CategoryInfo& info(MemoryCategory category) {
+        return CATEGORIES[static_cast<size_t>(category)];
+    }
+
+    double mib(size_t bytes) {
+        return bytes / double(MIB);
+    }
+}
+
+const char* memoryCategoryName(MemoryCategory category) {
+    return info(category).name;
+}
+
+bool isGpuMemory(MemoryCategory category) {
+    return info(category).gpu;
+}
+
+size_t memoryBudget(MemoryCategory category) {
+    return info(category).budgetMiB * MIB;
+}
+
+uint32_t MemoryRegistry::track(MemoryCategory category, const std::string& name, size_t bytes) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    uint32_t id = g_nextId++;
+    g_tracked.emplace(id, MemoryEntry{ category, name, bytes, 1 });
+    return id;
+}
+
+void MemoryRegistry::update(uint32_t id, size_t bytes) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_tracked.find(id);
+    if (it != g_tracked.end()) it->second.bytes = bytes;
+}
+
+void MemoryRegistry::untrack(uint32_t id) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_tracked.erase(id);
+}
+
+void MemoryRegistry::report(MemoryReport& out) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (const auto& [id, entry] : g_tracked) out.add(entry.category, entry.name, entry.bytes);
+}
+
+// Add to the entry of the same category and name
+void MemoryReport::add(MemoryCategory category, const std::string& name, size_t bytes) {
+    auto it = std::find_if(entries_.begin(), entries_.end(), [&](const MemoryEntry& e) {
+        return e.category == category && e.name == name;
+    });
+    if (it == entries_.end()) {
+        entries_.push_back({ category, name, 0, 0 });
+        it = entries_.end() - 1;
+    }
+    it->bytes += bytes;
+    it->count++;
+}
+
+std::vector<const MemoryEntry*> MemoryReport::sorted() const {
+    std::vector<const MemoryEntry*> out;
+    for (const MemoryEntry& e : entries_) out.push_back(&e);
+    std::stable_sort(out.begin(), out.end(), [](const MemoryEntry* a, const MemoryEntry* b) {
+        return a->bytes > b->bytes;
+    });
+    return out;
+}
+
+size_t MemoryReport::total(MemoryCategory category) const {
+    size_t n = 0;
+    for (const MemoryEntry& e : entries_) {
+        if (e.category == category) n += e.bytes;
+    }
+    return n;
+}
+
+size_t MemoryReport::totalGpu() const {
+    size_t n = 0;
+    for (const MemoryEntry& e : entries_) {
+        if (isGpuMemory(e.category)) n += e.bytes;
+    }
+    return n;
+}
+
+size_t MemoryReport::totalCpu() const {
+    size_t n = 0;
+    for (const MemoryEntry& e : entries_) {
+        if (!isGpuMemory(e.category)) n += e.bytes;
+    }
+    return n;
+}
+
+bool MemoryReport::withinBudgets() const {
+    for (size_t c = 0; c < static_cast<size_t>(MemoryCategory::Count); ++c) {
+        MemoryCategory category = static_cast<MemoryCategory>(c);
+        if (total(category) > memoryBudget(category)) return false;
+    }
+    return true;
+}
+
+void MemoryReport::print(std::FILE* out) const {
+    std::fprintf(out, "%-16s %-48s %6s %12s\n", "category", "name", "count", "MiB");
+    for (const MemoryEntry* e : sorted()) {
+        std::fprintf(out, "%-16s %-48s %6zu %12.3f\n", memoryCategoryName(e->category), e->name.c_str(), e->count, mib(e->bytes));
+    }
+
+    std::fprintf(out, "\n%-16s %12s %12s\n", "category", "MiB", "budget MiB");
+    for (size_t c = 0; c < static_cast<size_t>(MemoryCategory::Count); ++c) {
+        MemoryCategory category = static_cast<MemoryCategory>(c);
+        size_t bytes = total(category);
+        std::fprintf(out, "%-16s %12.3f %12zu%s\n", memoryCategoryName(category), mib(bytes),
+            info(category).budgetMiB, bytes > memoryBudget(category) ? "  OVER BUDGET" : "");
+    }
+    std::fprintf(out, "total: %.3f MiB GPU, %.3f MiB CPU\n", mib(totalGpu()), mib(totalCpu()));
+}
+
+bool MemoryReport::writeJson(const std::string& path) const {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    std::fprintf(f, "{\n  \"gpuBytes\": %zu,\n  \"cpuBytes\": %zu,\n  \"categories\": [\n", totalGpu(), totalCpu());
+    for (size_t c = 0; c < static_cast<size_t>(MemoryCategory::Count); ++c) {
+        MemoryCategory category = static_cast<MemoryCategory>(c);
+        std::fprintf(f, "    {\"name\": \"%s\", \"gpu\": %s, \"bytes\": %zu, \"budgetBytes\": %zu}%s\n",
+            memoryCategoryName(category), isGpuMemory(category) ? "true" : "false", total(category),
+            memoryBudget(category), c + 1 < static_cast<size_t>(MemoryCategory::Count) ? "," : "");
+    }
+    std::fprintf(f, "  ],\n  \"entries\": [\n");
+    const std::vector<const MemoryEntry*> entries = sorted();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const MemoryEntry& e = *entries[i];
+        std::fprintf(f, "    {\"category\": \"%s\", \"name\": \"", memoryCategoryName(e.category));
+        for (char ch : e.name) {
+            if (ch == '"' || ch == '\\') std::fputc('\\', f);
+            std::fputc(ch, f);
+        }
+        std::fprintf(f, "\", \"count\": %zu, \"bytes\": %zu}%s\n", e.count, e.bytes, i + 1 < entries.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+} // namespace pokepp
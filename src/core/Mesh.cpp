@@ -1,4 +1,5 @@
 #include <pokeapp/Mesh.h>
+#include <pokeapp/FrameStats.h>
 
 /*
     Implementation of the Mesh class for managing 3D mesh data and rendering.
@@ -6,9 +7,14 @@
 
 using namespace pokepp;
 
-Mesh::Mesh(const std::vector<Vertex>& v, const std::vector<unsigned>& i)
+Mesh::Mesh(const std::vector<Vertex>& v, const std::vector<unsigned>& i, const std::string& name)
     : vertices_(v), indices_(i) {
     setup();
+
+    const size_t bytes = vertices_.size() * sizeof(Vertex) + indices_.size() * sizeof(unsigned);
+    gpuMemory_ = TrackedMemory(MemoryCategory::GpuMeshes, name, bytes);
+    cpuMemory_ = TrackedMemory(MemoryCategory::CpuMeshes, name,
+        vertices_.capacity() * sizeof(Vertex) + indices_.capacity() * sizeof(unsigned));
 }
 
 Mesh::~Mesh() {
@@ -28,6 +34,8 @@ Mesh& Mesh::operator=(Mesh&& o) noexcept { // Move assignment
     std::swap(EBO_, o.EBO_);
     vertices_ = std::move(o.vertices_);
     indices_ = std::move(o.indices_);
+    std::swap(gpuMemory_, o.gpuMemory_);
+    std::swap(cpuMemory_, o.cpuMemory_);
     return *this;
 }
 
@@ -65,4 +73,8 @@ void Mesh::draw() const {
     glBindVertexArray(VAO_);
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices_.size()), GL_UNSIGNED_INT, nullptr);
     glBindVertexArray(0);
+
+    RenderStats& stats = renderStats();
+    stats.drawCalls++;
+    stats.triangles += indices_.size() / 3;
 }
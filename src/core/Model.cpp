@@ -2,6 +2,8 @@
 #include <pokeapp/tiny_obj_loader.h>
 #include <pokeapp/Shader.h> 
 #include <pokeapp/Texture.h>
+#include <pokeapp/Profiler.h>
+#include <pokeapp/FrameStats.h>
 #include <stdexcept>
 #include <cstdio>
 #include <glm/vec3.hpp>
@@ -150,7 +152,7 @@ void Model::loadObj(const std::string& path) {
         int matId = -1;
         for (int mid : shape.mesh.material_ids) { if (mid >= 0) { matId = mid; break; } }
 
-        meshes_.emplace_back(vertices, indices);
+        meshes_.emplace_back(vertices, indices, path);
         meshMatIdx_.push_back(matId);
     }  
 }
@@ -162,7 +164,9 @@ void Model::draw(const Shader& shader) const {
 
 // Draw the model using the specified shader, with optional material override
 void Model::draw(const Shader& shader, bool overrideMaterial) const {
-    
+    PROFILE_ZONE("Model::draw");
+    renderStats().models++;
+
 	// Draw each mesh with its associated material
     for (size_t i = 0; i < meshes_.size(); ++i) {
         if (overrideMaterial) {
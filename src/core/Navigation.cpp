@@ -0,0 +1,323 @@
+#include "pokeapp/Navigation.h"
+#include "pokeapp/World.h"
+#include "pokeapp/CollisionWorld.h"
+#include "pokeapp/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+/*
+	Implementation of the navigation grid, flow field solver and the service that keeps
+	flow fields up to date on a worker thread.
+*/
+
+namespace pokepp {
+
+namespace {
+    // 8-connected neighbourhood. Orthogonal neighbours first, so diagonals can check them.
+    constexpr int NEIGHBOUR_DI[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    constexpr int NEIGHBOUR_DJ[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+    constexpr float NEIGHBOUR_DIST[8] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f };
+
+    // Slope costs are scaled into this range so a cost fits in a byte
+    constexpr float MAX_SLOPE_COST = 8.0f;
+}
+
+// Build the navigation grid. Each cell samples the terrain normal at its center: cells
+// steeper than maxSlopeDegrees are blocked, others cost more the steeper they are.
+// Prop boxes (inflated by agentRadius) are then stamped in as blocked.
+std::shared_ptr<NavGrid> NavGrid::Build(const World& world, const CollisionWorld* collision,
+                                        float cellSize, float agentRadius, float maxSlopeDegrees) {
+    auto grid = std::make_shared<NavGrid>();
+    glm::vec2 half = world.halfExtents();
+    if (half.x <= 0.0f || half.y <= 0.0f || cellSize <= 0.0f) return grid;
+
+    grid->cellSize_ = cellSize;
+    grid->width_ = std::max(1, int(std::floor(2.0f * half.x / cellSize)));
+    grid->height_ = std::max(1, int(std::floor(2.0f * half.y / cellSize)));
+    grid->origin_ = -half;
+    grid->costs_.assign(size_t(grid->width_) * grid->height_, BLOCKED);
+
+    // Terrain slope (normal.y is the cosine of the slope angle)
+    const float minNormalY = std::cos(glm::radians(maxSlopeDegrees));
+    for (int j = 0; j < grid->height_; ++j) {
+        for (int i = 0; i < grid->width_; ++i) {
+            glm::vec3 c = grid->cellCenter(i, j);
+            float ny = world.normalAt(c.x, c.z).y;
+            if (ny < minNormalY) continue;
+
+            float steepness = (1.0f - ny) / std::max(1.0f - minNormalY, 1e-4f); // [0,1]
+            grid->costs_[grid->idx(i, j)] = static_cast<uint8_t>(1.0f + steepness * (MAX_SLOPE_COST - 1.0f));
+        }
+    }
+
+    // Props
+    if (collision) {
+        for (const auto& box : collision->boxes()) {
+            int i0, j0, i1, j1;
+            glm::vec3 lo = box.min - glm::vec3(agentRadius);
+            glm::vec3 hi = box.max + glm::vec3(agentRadius);
+            i0 = std::max(0, int(std::floor((lo.x - grid->origin_.x) / cellSize)));
+            j0 = std::max(0, int(std::floor((lo.z - grid->origin_.y) / cellSize)));
+            i1 = std::min(grid->width_ - 1, int(std::floor((hi.x - grid->origin_.x) / cellSize)));
+            j1 = std::min(grid->height_ - 1, int(std::floor((hi.z - grid->origin_.y) / cellSize)));
+            for (int j = j0; j <= j1; ++j) {
+                for (int i = i0; i <= i1; ++i) {
+                    grid->costs_[grid->idx(i, j)] = BLOCKED;
+                }
+            }
+        }
+    }
+
+    return grid;
+}
+
+bool NavGrid::cellOf(const glm::vec3& p, int& i, int& j) const {
+    i = int(std::floor((p.x - origin_.x) / cellSize_));
+    j = int(std::floor((p.z - origin_.y) / cellSize_));
+    return i >= 0 && j >= 0 && i < width_ && j < height_;
+}
+
+glm::vec3 NavGrid::cellCenter(int i, int j) const {
+    return { origin_.x + (i + 0.5f) * cellSize_, 0.0f, origin_.y + (j + 0.5f) * cellSize_ };
+}
+
+// Points outside the grid count as blocked, which also keeps agents on the terrain
+bool NavGrid::walkable(const glm::vec3& p) const {
+    int i, j;
+    return cellOf(p, i, j) && costs_[idx(i, j)] != BLOCKED;
+}
+
+// Dijkstra from the goal cell over the 8-connected grid. Edge cost is the step length times
+// the mean cost of the two cells, which approximates the eikonal solution on this grid.
+// Diagonal steps are only allowed when both adjacent orthogonal cells are open, so paths
+// never cut across the corner of a blocked cell.
+void FlowField::solve(std::shared_ptr<const NavGrid> grid, const glm::vec3& goal, FlowMode mode,
+                      float maxDistance, SolveScratch& scratch) {
+    goal_ = goal;
+    mode_ = mode;
+    grid_ = std::move(grid);
+    distance_.clear();
+    dir_.clear();
+    if (!grid_ || grid_->width() == 0) return;
+
+    const NavGrid& g = *grid_;
+    const size_t cells = size_t(g.width()) * g.height();
+    distance_.assign(cells, -1.0f);
+    dir_.assign(cells, NO_DIRECTION);
+
+    int gi, gj;
+    if (!g.cellOf(goal, gi, gj)) return;
+
+    // The open list is a binary heap on a reused vector, popped in the same order as
+    // std::priority_queue would
+    using Entry = std::pair<float, int>; // (distance, cell index)
+    std::greater<Entry> later;
+    auto& open = scratch.open;
+    auto& best = scratch.best;
+    auto& reached = scratch.reached; // settled cells, so the second pass only visits the solved area
+    open.clear();
+    best.assign(cells, std::numeric_limits<float>::max());
+    reached.clear();
+
+    // Flee fields start from the goal even if the player stands on a blocked cell
+    best[g.idx(gi, gj)] = 0.0f;
+    open.push_back({ 0.0f, g.idx(gi, gj) });
+
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), later);
+        auto [d, c] = open.back();
+        open.pop_back();
+        if (d > best[c] || distance_[c] >= 0.0f) continue;
+        distance_[c] = d;
+        reached.push_back(c);
+
+        int ci = c % g.width(), cj = c / g.width();
+        float costC = std::max<float>(1.0f, g.cost(ci, cj));
+
+        for (int n = 0; n < 8; ++n) {
+            int ni = ci + NEIGHBOUR_DI[n], nj = cj + NEIGHBOUR_DJ[n];
+            if (ni < 0 || nj < 0 || ni >= g.width() || nj >= g.height()) continue;
+            uint8_t costN = g.cost(ni, nj);
+            if (costN == NavGrid::BLOCKED) continue;
+            if (n >= 4 && (g.cost(ni, cj) == NavGrid::BLOCKED || g.cost(ci, nj) == NavGrid::BLOCKED)) continue;
+
+            float nd = d + NEIGHBOUR_DIST[n] * g.cellSize() * 0.5f * (costC + costN);
+            if (nd > maxDistance) continue;
+
+            int nc = g.idx(ni, nj);
+            if (nd < best[nc]) {
+                best[nc] = nd;
+                open.push_back({ nd, nc });
+                std::push_heap(open.begin(), open.end(), later);
+            }
+        }
+    }
+
+    // Pick each cell's step: downhill toward the goal for Seek, uphill away from it for Flee.
+    // For Flee, unreached open neighbours count as "beyond maxDistance", i.e. safest.
+    for (int c : reached) {
+        int i = c % g.width(), j = c / g.width();
+        float bestScore = distance_[c];
+        uint8_t bestDir = NO_DIRECTION;
+
+        for (int n = 0; n < 8; ++n) {
+            int ni = i + NEIGHBOUR_DI[n], nj = j + NEIGHBOUR_DJ[n];
+            if (ni < 0 || nj < 0 || ni >= g.width() || nj >= g.height()) continue;
+            if (g.cost(ni, nj) == NavGrid::BLOCKED) continue;
+            if (n >= 4 && (g.cost(ni, j) == NavGrid::BLOCKED || g.cost(i, nj) == NavGrid::BLOCKED)) continue;
+
+            float nd = distance_[g.idx(ni, nj)];
+            if (mode == FlowMode::Seek) {
+                if (nd >= 0.0f && nd < bestScore) { bestScore = nd; bestDir = uint8_t(n); }
+            } else {
+                if (nd < 0.0f) nd = maxDistance;
+                if (nd > bestScore) { bestScore = nd; bestDir = uint8_t(n); }
+            }
+        }
+        dir_[c] = bestDir;
+    }
+}
+
+glm::vec3 FlowField::direction(const glm::vec3& p) const {
+    int i, j;
+    if (!grid_ || !grid_->cellOf(p, i, j)) return glm::vec3(0.0f);
+
+    uint8_t d = dir_[grid_->idx(i, j)];
+    if (d == NO_DIRECTION) return glm::vec3(0.0f);
+    return glm::vec3(NEIGHBOUR_DI[d], 0.0f, NEIGHBOUR_DJ[d]) / NEIGHBOUR_DIST[d];
+}
+
+float FlowField::distanceAt(const glm::vec3& p) const {
+    int i, j;
+    if (!grid_ || !grid_->cellOf(p, i, j)) return -1.0f;
+    return distance_[grid_->idx(i, j)];
+}
+
+FlowFieldService::FlowFieldService(ThreadPool& pool)
+    : pool_(pool) {}
+
+FlowFieldService::~FlowFieldService() {
+    if (job_.goalId < 0) return;
+    std::unique_lock<std::mutex> lock(jobMutex_);
+    jobDone_.wait(lock, [this] { return job_.done; });
+}
+
+// Swapping the grid invalidates every field, so all goals are re-solved
+void FlowFieldService::setGrid(std::shared_ptr<const NavGrid> grid) {
+    grid_ = std::move(grid);
+    for (auto& goal : goals_) {
+        goal.dirty = true;
+    }
+}
+
+// Both fields are made up front, so a goal solved long after start-up does not allocate
+int FlowFieldService::addGoal(FlowMode mode, float maxDistance) {
+    Goal goal;
+    goal.mode = mode;
+    goal.maxDistance = maxDistance;
+    goal.current = std::make_shared<FlowField>();
+    goal.spare = std::make_shared<FlowField>();
+    goals_.push_back(goal);
+    return static_cast<int>(goals_.size() - 1);
+}
+
+void FlowFieldService::setGoal(int goalId, const glm::vec3& pos) {
+    Goal& goal = goals_[goalId];
+    goal.pos = pos;
+    if (!grid_) return;
+
+    int i, j;
+    grid_->cellOf(pos, i, j);
+    if (i != goal.cellI || j != goal.cellJ) {
+        goal.cellI = i;
+        goal.cellJ = j;
+        goal.dirty = true;
+    }
+}
+
+void FlowFieldService::update() {
+    // Publish the finished solve
+    if (job_.goalId >= 0) {
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(jobMutex_);
+            done = job_.done;
+        }
+        if (done) {
+            publish(goals_[job_.goalId]);
+            job_.goalId = -1;
+            job_.grid.reset();
+        }
+    }
+
+    // Start a solve for a goal that moved, from the one after the last goal solved so a goal
+    // that keeps moving (the player's) cannot starve the others. A goal is re-solved from its
+    // latest position once its previous solve lands. Synchronous mode solves every goal now.
+    const int count = static_cast<int>(goals_.size());
+    for (int n = 0; n < count && job_.goalId < 0; ++n) {
+        int id = (nextGoal_ + n) % count;
+        if (goals_[id].dirty) {
+            schedule(id);
+            nextGoal_ = (id + 1) % count;
+        }
+    }
+}
+
+// The spare is reused unless a caller still holds it from before the last swap
+void FlowFieldService::schedule(int goalId) {
+    Goal& goal = goals_[goalId];
+    if (!grid_) return;
+
+    goal.dirty = false;
+    solvesStarted_++;
+    if (goal.spare.use_count() > 1) goal.spare = std::make_shared<FlowField>();
+
+    if (synchronous_) {
+        goal.spare->solve(grid_, goal.pos, goal.mode, goal.maxDistance, scratch_);
+        publish(goal);
+        return;
+    }
+
+    job_.goalId = goalId;
+    job_.grid = grid_;
+    job_.pos = goal.pos;
+    job_.mode = goal.mode;
+    job_.maxDistance = goal.maxDistance;
+    job_.field = goal.spare.get();
+    job_.done = false;
+
+    // Captures only the service, which std::function stores without allocating. The
+    // destructor waits for the job, so the service outlives it.
+    pool_.submit([this] { runJob(); });
+}
+
+void FlowFieldService::runJob() {
+    job_.field->solve(job_.grid, job_.pos, job_.mode, job_.maxDistance, scratch_);
+    std::lock_guard<std::mutex> lock(jobMutex_);
+    job_.done = true;
+    jobDone_.notify_all();
+}
+
+void FlowFieldService::publish(Goal& goal) {
+    goal.current.swap(goal.spare);
+    goal.solved = true;
+    solvesCompleted_++;
+}
+
+std::shared_ptr<const FlowField> FlowFieldService::field(int goalId) const {
+    if (goalId < 0 || goalId >= static_cast<int>(goals_.size()) || !goals_[goalId].solved) return nullptr;
+    return goals_[goalId].current;
+}
+
+size_t FlowFieldService::fieldMemory() const {
+    size_t n = 0;
+    for (const Goal& g : goals_) {
+        n += g.current->memoryBytes() + g.spare->memoryBytes();
+    }
+    return n;
+}
+
+} // namespace pokepp
@@ -0,0 +1,275 @@
+#include "pokeapp/NetClient.h"
+#include "pokeapp/PokemonController.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+/*
+	Implementation of the NetClient class. Snapshots are decoded into a ring indexed by
+	sequence, which doubles as the set of delta baselines the server may refer to and as
+	the interpolation buffer.
+*/
+
+namespace pokepp {
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    bool newer(uint32_t a, uint32_t b) {
+        return static_cast<int32_t>(a - b) > 0;
+    }
+
+    constexpr float CONNECT_RESEND_SECONDS = 0.25f;
+    constexpr double CLOCK_SNAP_SECONDS = 0.25;  // Drift beyond this resets the clock
+    constexpr double CLOCK_SLEW_RATE = 2.0;      // Fraction of the drift corrected per second
+}
+
+NetClient::~NetClient() {
+    disconnect();
+}
+
+bool NetClient::connect(const NetAddress& server, float timeout) {
+    disconnect();
+    bool loopback = (server.ip >> 24) == 127;
+    if (!socket_.open(0, loopback)) return false;
+    server_ = server;
+
+    auto start = Clock::now();
+    auto lastSend = start - std::chrono::hours(1);
+    while (std::chrono::duration<float>(Clock::now() - start).count() < timeout) {
+        if (std::chrono::duration<float>(Clock::now() - lastSend).count() >= CONNECT_RESEND_SECONDS) {
+            socket_.send(server_, packet_, NetProtocol::WriteConnect(packet_));
+            lastSend = Clock::now();
+        }
+        if (!socket_.wait(50)) continue;
+
+        NetAddress from;
+        while (size_t size = socket_.receive(from, packet_, sizeof(packet_))) {
+            if (from != server_) continue;
+            NetPacket type = NetProtocol::Type(packet_, size);
+            if (type == NetPacket::Reject) {
+                std::cerr << "Server " << server_.toString() << " rejected the connection (full or a different version)" << std::endl;
+                socket_.close();
+                return false;
+            }
+            if (type == NetPacket::Accept && NetProtocol::ReadAccept(packet_, size, accept_)) {
+                connected_ = true;
+                received_.assign(constants::NET_SNAPSHOT_HISTORY, {});
+                return true;
+            }
+        }
+    }
+    std::cerr << "No answer from server " << server_.toString() << std::endl;
+    socket_.close();
+    return false;
+}
+
+void NetClient::disconnect() {
+    if (connected_) socket_.send(server_, packet_, NetProtocol::WriteDisconnect(packet_));
+    socket_.close();
+    connected_ = false;
+    ready_ = false;
+    newest_ = 0;
+    pending_ = {};
+    pendingCount_ = 0;
+    received_.clear();
+    view_.clear();
+}
+
+void NetClient::update(float dt, NetInput input) {
+    if (!connected_) return;
+    receive();
+
+    // Follow the server's ticks, NET_INTERPOLATION_DELAY behind the newest snapshot
+    if (newest_ != 0) {
+        const double rate = accept_.tickRate;
+        double target = findReceived(newest_)->tick - constants::NET_INTERPOLATION_DELAY * rate;
+        renderTick_ += dt * rate;
+        double drift = target - renderTick_;
+        if (std::abs(drift) > CLOCK_SNAP_SECONDS * rate) renderTick_ = target;
+        else renderTick_ += drift * std::min(1.0, CLOCK_SLEW_RATE * dt);
+        interpolate();
+    }
+
+    input.sequence = ++inputSequence_;
+    input.ack = newest_;
+    size_t size = NetProtocol::WriteInput(input, packet_);
+    if (socket_.send(server_, packet_, size)) stats_.bytesSent += size;
+}
+
+void NetClient::receive() {
+    NetAddress from;
+    while (size_t size = socket_.receive(from, packet_, sizeof(packet_))) {
+        if (from != server_) continue;
+        stats_.packetsReceived++;
+        stats_.bytesReceived += size;
+        if (NetProtocol::Type(packet_, size) == NetPacket::Snapshot) handleSnapshot(packet_, size);
+    }
+}
+
+// Collect a fragment; the snapshot is decoded once all of its fragments are in
+void NetClient::handleSnapshot(const uint8_t* data, size_t size) {
+    NetSnapshotHeader header;
+    const uint8_t* payload = nullptr;
+    size_t bytes = 0;
+    if (!NetProtocol::ReadSnapshot(data, size, header, payload, bytes)) return;
+    if (newest_ != 0 && !newer(header.sequence, newest_)) return;  // Late
+
+    const size_t fragmentBytes = constants::NET_FRAGMENT_BYTES;
+    if (header.sequence != pending_.sequence) {
+        if (pending_.sequence != 0 && !newer(header.sequence, pending_.sequence)) return;
+        if (pendingCount_ > 0) stats_.incomplete++;
+        pending_ = header;
+        pendingPayload_.resize(header.fragments * fragmentBytes);
+        pendingHave_.assign(header.fragments, 0);
+        pendingCount_ = 0;
+    }
+    bool last = header.fragment + 1 == header.fragments;
+    if (header.fragments != pending_.fragments || bytes > fragmentBytes || (!last && bytes != fragmentBytes)) return;
+    if (pendingHave_[header.fragment]) return;
+
+    std::copy_n(payload, bytes, pendingPayload_.begin() + header.fragment * fragmentBytes);
+    pendingHave_[header.fragment] = 1;
+    if (last) pendingLast_ = bytes;
+    if (++pendingCount_ == pending_.fragments) {
+        decode();
+        pendingCount_ = 0;
+    }
+}
+
+void NetClient::decode() {
+    const NetSnapshotHeader& header = pending_;
+    Received& slot = received_[header.sequence % received_.size()];
+
+    static const std::vector<NetEntity> none;
+    const std::vector<NetEntity>* baseline = &none;
+    if (header.baseline != 0) {
+        const Received* base = findReceived(header.baseline);
+        if (!base || base == &slot) {
+            stats_.undecodable++;
+            return;
+        }
+        baseline = &base->entities;
+    }
+
+    size_t size = (header.fragments - 1) * static_cast<size_t>(constants::NET_FRAGMENT_BYTES) + pendingLast_;
+    if (!NetProtocol::DecodeEntities(*baseline, pendingPayload_.data(), size, slot.entities)) {
+        slot.sequence = 0;
+        stats_.undecodable++;
+        return;
+    }
+    slot.sequence = header.sequence;
+    slot.tick = header.tick;
+
+    if (newest_ == 0) renderTick_ = header.tick - constants::NET_INTERPOLATION_DELAY * accept_.tickRate;
+    newest_ = header.sequence;
+    ready_ = ready_ || stats_.snapshots > 0;
+    stats_.snapshots++;
+    if (header.baseline == 0) stats_.fullSnapshots++;
+    stats_.serverTick = header.tick;
+    stats_.serverTickMicros = header.tickMicros;
+    stats_.serverNetMicros = header.netMicros;
+    stats_.serverClients = header.clients;
+    stats_.entities = slot.entities.size();
+}
+
+const NetClient::Received* NetClient::findReceived(uint32_t sequence) const {
+    const Received& slot = received_[sequence % received_.size()];
+    return slot.sequence == sequence && sequence != 0 ? &slot : nullptr;
+}
+
+// Blend the two snapshots around the render time into view_
+void NetClient::interpolate() {
+    const Received* from = nullptr;
+    const Received* to = nullptr;
+    for (const Received& r : received_) {
+        if (r.sequence == 0) continue;
+        if (r.tick <= renderTick_) {
+            if (!from || r.tick > from->tick) from = &r;
+        } else if (!to || r.tick < to->tick) {
+            to = &r;
+        }
+    }
+
+    view_.clear();
+    if (!from || !to) {
+        const Received* only = from ? from : to;
+        if (only) view_.assign(only->entities.begin(), only->entities.end());
+        return;
+    }
+
+    // Entities in the later snapshot, moved back toward where they were in the earlier one.
+    // Entities only in the earlier snapshot have left.
+    double t = (renderTick_ - from->tick) / static_cast<double>(to->tick - from->tick);
+    auto a = from->entities.begin();
+    for (const NetEntity& b : to->entities) {
+        while (a != from->entities.end() && a->id < b.id) ++a;
+        NetEntity e = b;
+        if (a != from->entities.end() && a->id == b.id) {
+            for (int i = 0; i < 3; ++i) {
+                e.position[i] = static_cast<int32_t>(std::lround(a->position[i] + (static_cast<double>(b.position[i]) - a->position[i]) * t));
+            }
+            int turn = static_cast<int8_t>(static_cast<uint8_t>(b.yaw - a->yaw));  // Shortest way round
+            e.yaw = static_cast<uint8_t>(a->yaw + static_cast<int>(std::lround(turn * t)));
+            if (t < 0.5) std::copy_n(a->aux, 4, e.aux);
+        }
+        view_.push_back(e);
+    }
+}
+
+void NetClient::applyTo(Simulation& sim) {
+    Registry& registry = sim.entities();
+    const std::vector<PokemonSpecies>& species = sim.species();
+    applied_++;
+
+    for (const NetEntity& e : view_) {
+        glm::vec3 position = e.worldPosition();
+        NetKind kind = e.kind();
+        if (kind == NetKind::Player) {
+            if ((e.aux[0] | (e.aux[1] << 8)) == accept_.clientId) sim.player().position = position;
+            continue;
+        }
+        if (kind != NetKind::Pokemon && kind != NetKind::Pokeball) continue;
+        if (kind == NetKind::Pokemon && e.aux[0] >= species.size()) continue;
+
+        Mirror& mirror = mirrored_[e.id];
+        mirror.seen = applied_;
+        if (kind == NetKind::Pokemon) {
+            Pokemon* p = registry.get<Pokemon>(mirror.entity);
+            if (!p) {
+                mirror.entity = sim.pokemon().spawnPokemon(&species[e.aux[0]], position);
+                p = registry.get<Pokemon>(mirror.entity);
+            }
+            p->setPosition(position);
+            p->setYRotation(e.yawRadians());
+            p->setState(static_cast<PokemonState>(e.aux[1]));
+            p->setVisible(e.aux[2] != 0);
+        } else {
+            Pokeball* b = registry.get<Pokeball>(mirror.entity);
+            if (!b) {
+                mirror.entity = registry.create(Transform{ position }, Pokeball{});
+                b = registry.get<Pokeball>(mirror.entity);
+            }
+            registry.get<Transform>(mirror.entity)->position = position;
+            b->active = e.aux[0] & 1;
+            b->locked = e.aux[0] & 2;
+            b->shakeCount = e.aux[1];
+            b->shakePhase = e.aux[2] / 255.0f;
+            b->lockTimer = e.aux[3] / 50.0f;
+        }
+    }
+
+    // Remove what the server no longer sends
+    stale_.clear();
+    for (const auto& [id, mirror] : mirrored_) {
+        if (mirror.seen != applied_) stale_.push_back(id);
+    }
+    for (uint32_t id : stale_) {
+        registry.destroy(mirrored_[id].entity);
+        mirrored_.erase(id);
+    }
+}
+
+} // namespace pokepp
@@ -0,0 +1,393 @@
+#include "pokeapp/NetProtocol.h"
+#include "pokeapp/Constants.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+	Implementation of the NetProtocol class: byte-wise little endian packet writing and
+	reading, and the snapshot delta encoding described in NetProtocol.h.
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr float TWO_PI = 6.28318530718f;
+
+    // Field bits of a changed entity
+    constexpr uint8_t FIELD_X = 1;
+    constexpr uint8_t FIELD_Y = 2;
+    constexpr uint8_t FIELD_Z = 4;
+    constexpr uint8_t FIELD_YAW = 8;
+    constexpr uint8_t FIELD_AUX = 16;  // Shifted by the aux byte's index
+
+    constexpr size_t HEADER_BYTES = 5;  // Protocol id and packet type
+
+    class ByteWriter {
+    public:
+        explicit ByteWriter(uint8_t* out) : out_(out) {}
+
+        void u8(uint8_t v) { out_[size_++] = v; }
+        void u16(uint16_t v) { u8(static_cast<uint8_t>(v)); u8(static_cast<uint8_t>(v >> 8)); }
+        void u32(uint32_t v) { u16(static_cast<uint16_t>(v)); u16(static_cast<uint16_t>(v >> 16)); }
+        void u64(uint64_t v) { u32(static_cast<uint32_t>(v)); u32(static_cast<uint32_t>(v >> 32)); }
+        void bytes(const void* data, size_t n) {
+            std::copy_n(static_cast<const uint8_t*>(data), n, out_ + size_);
+            size_ += n;
+        }
+        void header(NetPacket type) { u32(NET_PROTOCOL_ID); u8(static_cast<uint8_t>(type)); }
+
+        size_t size() const { return size_; }
+
+    private:
+        uint8_t* out_;
+        size_t size_ = 0;
+    };
+
+    // Reads fail softly: past the end every read gives 0 and ok() turns false
+    class ByteReader {
+    public:
+        ByteReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+        uint8_t u8() {
+            if (pos_ >= size_) { ok_ = false; return 0; }
+            return data_[pos_++];
+        }
+        uint16_t u16() { uint16_t lo = u8(); return static_cast<uint16_t>(lo | (u8() << 8)); }
+        uint32_t u32() { uint32_t lo = u16(); return lo | (static_cast<uint32_t>(u16()) << 16); }
+        uint64_t u64() { uint64_t lo = u32(); return lo | (static_cast<uint64_t>(u32()) << 32); }
+        const uint8_t* bytes(size_t n) {
+            if (n > size_ - std::min(pos_, size_)) { ok_ = false; return nullptr; }
+            const uint8_t* p = data_ + pos_;
+            pos_ += n;
+            return p;
+        }
+        uint32_t varint() {
+            uint32_t v = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                uint8_t b = u8();
+                v |= static_cast<uint32_t>(b & 0x7F) << shift;
+                if (!(b & 0x80)) return v;
+            }
+            ok_ = false;
+            return 0;
+        }
+
+        bool ok() const { return ok_; }
+        bool atEnd() const { return pos_ == size_; }
+        size_t remaining() const { return size_ - pos_; }
+
+    private:
+        const uint8_t* data_;
+        size_t size_;
+        size_t pos_ = 0;
+        bool ok_ = true;
+    };
+
+    // Growing output for snapshot payloads; keeps the vector's capacity between snapshots
+    void putVarint(std::vector<uint8_t>& out, uint32_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    uint32_t zigzag(int32_t v) { return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31); }
+    int32_t unzigzag(uint32_t v) { return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1); }
+
+    int16_t quantizeUnit(float v) { return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f)); }
+
+    // A changed (or new) entity: its id gap, field mask and the fields that differ from `base`
+    void putChange(std::vector<uint8_t>& out, uint32_t gap, const NetEntity& base, const NetEntity& e) {
+        uint8_t mask = 0;
+        for (int i = 0; i < 3; ++i) {
+            if (e.position[i] != base.position[i]) mask |= FIELD_X << i;
+        }
+        if (e.yaw != base.yaw) mask |= FIELD_YAW;
+        for (int i = 0; i < 4; ++i) {
+            if (e.aux[i] != base.aux[i]) mask |= FIELD_AUX << i;
+        }
+
+        putVarint(out, gap);
+        out.push_back(mask);
+        for (int i = 0; i < 3; ++i) {
+            if (mask & (FIELD_X << i)) putVarint(out, zigzag(static_cast<int32_t>(static_cast<uint32_t>(e.position[i]) - static_cast<uint32_t>(base.position[i]))));
+        }
+        if (mask & FIELD_YAW) out.push_back(e.yaw);
+        for (int i = 0; i < 4; ++i) {
+            if (mask & (FIELD_AUX << i)) out.push_back(e.aux[i]);
+        }
+    }
+
+    void readChange(ByteReader& in, uint8_t mask, NetEntity& e) {
+        for (int i = 0; i < 3; ++i) {
+            if (mask & (FIELD_X << i)) e.position[i] = static_cast<int32_t>(static_cast<uint32_t>(e.position[i]) + static_cast<uint32_t>(unzigzag(in.varint())));
+        }
+        if (mask & FIELD_YAW) e.yaw = in.u8();
+        for (int i = 0; i < 4; ++i) {
+            if (mask & (FIELD_AUX << i)) e.aux[i] = in.u8();
+        }
+    }
+}
+
+glm::vec3 NetEntity::worldPosition() const {
+    const float inv = 1.0f / constants::NET_POSITION_SCALE;
+    return glm::vec3(position[0] * inv, position[1] * inv, position[2] * inv);
+}
+
+float NetEntity::yawRadians() const {
+    return yaw * (TWO_PI / 256.0f);
+}
+
+void NetEntity::setWorldPosition(const glm::vec3& p) {
+    for (int i = 0; i < 3; ++i) {
+        float q = std::clamp(p[i] * constants::NET_POSITION_SCALE, -2.0e9f, 2.0e9f);
+        position[i] = static_cast<int32_t>(std::lround(q));
+    }
+}
+
+void NetEntity::setYaw(float radians) {
+    yaw = static_cast<uint8_t>(std::lround(radians * (256.0f / TWO_PI)) & 0xFF);
+}
+
+bool NetEntity::operator==(const NetEntity& o) const {
+    return id == o.id && std::equal(position, position + 3, o.position) && yaw == o.yaw
+        && std::equal(aux, aux + 4, o.aux);
+}
+
+PlayerInput NetInput::toPlayerInput() const {
+    PlayerInput input;
+    input.forward = buttons & NET_BUTTON_FORWARD;
+    input.back = buttons & NET_BUTTON_BACK;
+    input.left = buttons & NET_BUTTON_LEFT;
+    input.right = buttons & NET_BUTTON_RIGHT;
+    input.sprint = buttons & NET_BUTTON_SPRINT;
+    float length = glm::length(front);
+    if (length > 1e-3f) input.front = front / length;
+    return input;
+}
+
+void NetInput::setMovement(const PlayerInput& input) {
+    buttons = (input.forward ? NET_BUTTON_FORWARD : 0) | (input.back ? NET_BUTTON_BACK : 0)
+        | (input.left ? NET_BUTTON_LEFT : 0) | (input.right ? NET_BUTTON_RIGHT : 0)
+        | (input.sprint ? NET_BUTTON_SPRINT : 0);
+    front = input.front;
+}
+
+NetPacket NetProtocol::Type(const uint8_t* data, size_t size) {
+    ByteReader in(data, size);
+    if (in.u32() != NET_PROTOCOL_ID) return NetPacket::None;
+    uint8_t type = in.u8();
+    if (!in.ok() || type < static_cast<uint8_t>(NetPacket::Connect) || type > static_cast<uint8_t>(NetPacket::Disconnect)) {
+        return NetPacket::None;
+    }
+    return static_cast<NetPacket>(type);
+}
+
+size_t NetProtocol::WriteConnect(uint8_t* out) {
+    ByteWriter w(out);
+    w.header(NetPacket::Connect);
+    w.u16(NET_PROTOCOL_VERSION);
+    return w.size();
+}
+
+bool NetProtocol::ReadConnect(const uint8_t* data, size_t size, uint16_t& version) {
+    ByteReader in(data + HEADER_BYTES, size - HEADER_BYTES);
+    version = in.u16();
+    return in.ok();
+}
+
+size_t NetProtocol::WriteReject(uint8_t* out) {
+    ByteWriter w(out);
+    w.header(NetPacket::Reject);
+    return w.size();
+}
+
+size_t NetProtocol::WriteDisconnect(uint8_t* out) {
+    ByteWriter w(out);
+    w.header(NetPacket::Disconnect);
+    return w.size();
+}
+
+size_t NetProtocol::WriteAccept(const NetAccept& accept, uint8_t* out) {
+    ByteWriter w(out);
+    w.header(NetPacket::Accept);
+    w.u16(accept.clientId);
+    w.u64(accept.seed);
+    w.u16(accept.tickRate);
+    w.u8(accept.snapshotInterval);
+    size_t length = std::min<size_t>(accept.scene.size(), NET_MAX_PACKET - 32);
+    w.u16(static_cast<uint16_t>(length));
+    w.bytes(accept.scene.data(), length);
+    return w.size();
+}
+
+bool NetProtocol::ReadAccept(const uint8_t* data, size_t size, NetAccept& out) {
+    ByteReader in(data + HEADER_BYTES, size - HEADER_BYTES);
+    out.clientId = in.u16();
+    out.seed = in.u64();
+    out.tickRate = in.u16();
+    out.snapshotInterval = in.u8();
+    uint16_t length = in.u16();
+    const uint8_t* scene = in.bytes(length);
+    if (!in.ok() || out.tickRate == 0 || out.snapshotInterval == 0) return false;
+    out.scene.assign(reinterpret_cast<const char*>(scene), length);
+    return true;
+}
+
+size_t NetProtocol::WriteInput(const NetInput& input, uint8_t* out) {
+    ByteWriter w(out);
+    w.header(NetPacket::Input);
+    w.u32(input.sequence);
+    w.u32(input.ack);
+    w.u8(input.buttons);
+    w.u8(input.jumps);
+    w.u8(input.throws);
+    w.u8(input.throwSpeed);
+    for (int i = 0; i < 3; ++i) w.u16(static_cast<uint16_t>(quantizeUnit(input.front[i])));
+    return w.size();
+}
+
+bool NetProtocol::ReadInput(const uint8_t* data, size_t size, NetInput& out) {
+    ByteReader in(data + HEADER_BYTES, size - HEADER_BYTES);
+    out.sequence = in.u32();
+    out.ack = in.u32();
+    out.buttons = in.u8();
+    out.jumps = in.u8();
+    out.throws = in.u8();
+    out.throwSpeed = in.u8();
+    for (int i = 0; i < 3; ++i) out.front[i] = static_cast<int16_t>(in.u16()) / 32767.0f;
+    return in.ok();
+}
+
+size_t NetProtocol::WriteSnapshot(const NetSnapshotHeader& header, const uint8_t* payload, size_t bytes, uint8_t* out) {
+    ByteWriter w(out);
+    w.header(NetPacket::Snapshot);
+    w.u32(header.sequence);
+    w.u32(header.baseline);
+    w.u32(header.tick);
+    w.u32(header.tickMicros);
+    w.u32(header.netMicros);
+    w.u16(header.clients);
+    w.u8(header.fragment);
+    w.u8(header.fragments);
+    w.u16(static_cast<uint16_t>(bytes));
+    w.bytes(payload, bytes);
+    return w.size();
+}
+
+bool NetProtocol::ReadSnapshot(const uint8_t* data, size_t size, NetSnapshotHeader& header,
+                               const uint8_t*& payload, size_t& bytes) {
+    ByteReader in(data + HEADER_BYTES, size - HEADER_BYTES);
+    header.sequence = in.u32();
+    header.baseline = in.u32();
+    header.tick = in.u32();
+    header.tickMicros = in.u32();
+    header.netMicros = in.u32();
+    header.clients = in.u16();
+    header.fragment = in.u8();
+    header.fragments = in.u8();
+    bytes = in.u16();
+    payload = in.bytes(bytes);
+    return in.ok() && header.sequence != 0 && header.fragment < header.fragments;
+}
+
+void NetProtocol::EncodeEntities(std::span<const NetEntity> baseline, std::span<const NetEntity> entities,
+                                 std::vector<uint8_t>& out) {
+    out.clear();
+
+    // Removed: in the baseline but not in the snapshot
+    size_t removed = 0;
+    {
+        size_t j = 0;
+        for (const NetEntity& b : baseline) {
+            while (j < entities.size() && entities[j].id < b.id) ++j;
+            if (j == entities.size() || entities[j].id != b.id) ++removed;
+        }
+    }
+    putVarint(out, static_cast<uint32_t>(removed));
+    uint32_t prev = 0;
+    size_t j = 0;
+    for (const NetEntity& b : baseline) {
+        while (j < entities.size() && entities[j].id < b.id) ++j;
+        if (j == entities.size() || entities[j].id != b.id) {
+            putVarint(out, b.id - prev);
+            prev = b.id;
+        }
+    }
+
+    // Changed or new, counted once the list is written (its count goes in front)
+    size_t countAt = out.size();
+    putVarint(out, 0);
+    size_t countBytes = out.size() - countAt;
+    size_t changed = 0;
+    prev = 0;
+    const NetEntity empty;
+    size_t k = 0;
+    for (const NetEntity& e : entities) {
+        while (k < baseline.size() && baseline[k].id < e.id) ++k;
+        bool known = k < baseline.size() && baseline[k].id == e.id;
+        if (known && baseline[k] == e) continue;
+        putChange(out, e.id - prev, known ? baseline[k] : empty, e);
+        prev = e.id;
+        ++changed;
+    }
+
+    // Patch the count: rewrite the varint, shifting the list if it grew past one byte
+    uint8_t count[5];
+    size_t n = 0;
+    for (uint32_t v = static_cast<uint32_t>(changed); ; v >>= 7) {
+        count[n++] = static_cast<uint8_t>(v >= 0x80 ? (v | 0x80) : v);
+        if (v < 0x80) break;
+    }
+    if (n != countBytes) out.insert(out.begin() + countAt, n - countBytes, 0);
+    std::copy_n(count, n, out.begin() + countAt);
+}
+
+bool NetProtocol::DecodeEntities(std::span<const NetEntity> baseline, const uint8_t* data, size_t size,
+                                 std::vector<NetEntity>& out) {
+    out.clear();
+    ByteReader removedIn(data, size);
+    uint32_t removedCount = removedIn.varint();
+    if (!removedIn.ok() || removedCount > baseline.size()) return false;
+
+    // Skip the removed ids to find the changes; both lists are then merged with the baseline
+    ByteReader in = removedIn;
+    for (uint32_t i = 0; i < removedCount; ++i) in.varint();
+    uint32_t changedCount = in.varint();
+    if (!in.ok() || changedCount > in.remaining()) return false;
+
+    uint32_t removedLeft = removedCount;
+    uint32_t nextRemoved = removedLeft ? removedIn.varint() : 0;
+    uint32_t changedLeft = changedCount;
+    uint32_t nextChanged = changedLeft ? in.varint() : 0;
+    size_t b = 0;
+
+    while (b < baseline.size() || changedLeft > 0) {
+        if (!in.ok() || !removedIn.ok()) return false;
+        uint32_t baseId = b < baseline.size() ? baseline[b].id : UINT32_MAX;
+        bool changeNext = changedLeft > 0 && (b == baseline.size() || nextChanged <= baseId);
+
+        if (changeNext) {
+            NetEntity e;
+            if (b < baseline.size() && nextChanged == baseId) e = baseline[b++];
+            e.id = nextChanged;
+            readChange(in, in.u8(), e);
+            if (!out.empty() && out.back().id >= e.id) return false;
+            out.push_back(e);
+            if (--changedLeft > 0) nextChanged += in.varint();
+            continue;
+        }
+
+        if (removedLeft > 0 && nextRemoved == baseId) {
+            ++b;
+            if (--removedLeft > 0) nextRemoved += removedIn.varint();
+            continue;
+        }
+        out.push_back(baseline[b++]);
+    }
+    return in.ok() && removedIn.ok() && in.atEnd() && removedLeft == 0;
+}
+
+} // namespace pokepp
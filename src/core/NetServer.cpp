@@ -0,0 +1,300 @@
+#include "pokeapp/NetServer.h"
+#include "pokeapp/FrameArena.h"
+#include "pokeapp/PokemonController.h"
+#include "pokeapp/World.h"
+#include "pokeapp/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+/*
+	Implementation of the NetServer class. A tick reads every waiting datagram, steps the
+	simulation, and on snapshot ticks gathers all entities once and then picks, encodes and
+	sends each client's share.
+*/
+
+namespace pokepp {
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    uint32_t microsSince(Clock::time_point start) {
+        return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    }
+
+    // Sequence a is newer than b, allowing for wraparound
+    bool newer(uint32_t a, uint32_t b) {
+        return static_cast<int32_t>(a - b) > 0;
+    }
+
+    constexpr int MAX_ACTIONS_PER_TICK = 4;  // Jumps or throws applied from one input
+}
+
+NetServer::NetServer(Simulation& sim, std::string scene, int maxClients, float tickSeconds)
+    : sim_(sim), scene_(std::move(scene)), maxClients_(std::max(1, maxClients)), tickSeconds_(tickSeconds) {}
+
+bool NetServer::start(uint16_t port, bool loopbackOnly) {
+    return socket_.open(port, loopbackOnly);
+}
+
+void NetServer::tick() {
+    PROFILE_ZONE("NetServer::tick");
+    auto start = Clock::now();
+    frameArena().reset();  // The simulation's per-tick scratch
+
+    receive();
+    dropClients();
+    uint32_t netMicros = microsSince(start);
+
+    simulate();
+    tick_++;
+
+    bool snapshotTick = tick_ % constants::NET_SNAPSHOT_INTERVAL == 0;
+    if (snapshotTick && windowTicks_ > 0) {
+        reportTickMicros_ = static_cast<uint32_t>(windowTickMicros_ / windowTicks_);
+        reportNetMicros_ = static_cast<uint32_t>(std::min<uint64_t>(windowNetMicros_, UINT32_MAX));
+        windowTickMicros_ = windowNetMicros_ = 0;
+        windowTicks_ = 0;
+    }
+    if (snapshotTick && !clients_.empty()) {
+        auto snapshotStart = Clock::now();
+        gatherEntities();
+        stats_.snapshotEntities = 0;
+        for (auto& client : clients_) sendSnapshot(*client);
+        netMicros += microsSince(snapshotStart);
+    }
+
+    uint32_t tickMicros = microsSince(start);
+    windowTickMicros_ += tickMicros;
+    windowNetMicros_ += netMicros;
+    windowTicks_++;
+    stats_.clients = clients_.size();
+    stats_.tick = tick_;
+    stats_.tickMs = tickMicros / 1000.0;
+    stats_.netMs = netMicros / 1000.0;
+    stats_.arenaOverflows = frameArena().overflows();
+}
+
+void NetServer::receive() {
+    NetAddress from;
+    while (size_t size = socket_.receive(from, packet_, sizeof(packet_))) {
+        stats_.bytesReceived += size;
+        handlePacket(from, packet_, size);
+    }
+}
+
+void NetServer::handlePacket(const NetAddress& from, const uint8_t* data, size_t size) {
+    NetPacket type = NetProtocol::Type(data, size);
+    if (type == NetPacket::Connect) {
+        connectClient(from, data, size);
+        return;
+    }
+
+    Client* client = findClient(from);
+    if (!client) return;
+    client->silence = 0.0f;
+
+    if (type == NetPacket::Input) {
+        NetInput input;
+        if (!NetProtocol::ReadInput(data, size, input) || !newer(input.sequence, client->input.sequence)) return;
+        client->input = input;
+        if (newer(input.ack, client->acked) && !newer(input.ack, client->sequence)) client->acked = input.ack;
+    } else if (type == NetPacket::Disconnect) {
+        client->silence = constants::NET_CLIENT_TIMEOUT + 1.0f;  // Removed by dropClients
+    }
+}
+
+NetServer::Client* NetServer::findClient(const NetAddress& address) {
+    for (auto& client : clients_) {
+        if (client->address == address) return client.get();
+    }
+    return nullptr;
+}
+
+// Accept a new client, or answer again one whose Accept was lost
+void NetServer::connectClient(const NetAddress& from, const uint8_t* data, size_t size) {
+    uint16_t version = 0;
+    Client* client = findClient(from);
+    bool ok = NetProtocol::ReadConnect(data, size, version) && version == NET_PROTOCOL_VERSION;
+    if (!ok || (!client && clients_.size() >= static_cast<size_t>(maxClients_))) {
+        stats_.rejected++;
+        send(from, packet_, NetProtocol::WriteReject(packet_));
+        return;
+    }
+
+    if (!client) {
+        auto added = std::make_unique<Client>();
+        added->address = from;
+        added->id = nextClientId_++;
+        if (nextClientId_ == 0) nextClientId_ = 1;
+        added->history.resize(constants::NET_SNAPSHOT_HISTORY);
+
+        // Players start around the world's centre, a step apart
+        float angle = added->id * 2.39996f;
+        glm::vec3 start(std::cos(angle) * 2.0f, 0.0f, std::sin(angle) * 2.0f);
+        start.y = sim_.world()->heightAt(start.x, start.z) + added->player.eyeHeight;
+        added->player.position = start;
+
+        client = added.get();
+        clients_.push_back(std::move(added));
+        stats_.accepted++;
+    }
+
+    NetAccept accept;
+    accept.clientId = client->id;
+    accept.seed = sim_.seed();
+    accept.tickRate = static_cast<uint16_t>(std::lround(1.0f / tickSeconds_));
+    accept.snapshotInterval = static_cast<uint8_t>(constants::NET_SNAPSHOT_INTERVAL);
+    accept.scene = scene_;
+    send(from, packet_, NetProtocol::WriteAccept(accept, packet_));
+}
+
+void NetServer::dropClients() {
+    size_t before = clients_.size();
+    for (auto& client : clients_) client->silence += tickSeconds_;
+    clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [](const std::unique_ptr<Client>& c) {
+        return c->silence > constants::NET_CLIENT_TIMEOUT;
+    }), clients_.end());
+    stats_.dropped += before - clients_.size();
+}
+
+// Step the simulation as Simulation::tick does, with every client's player in turn
+void NetServer::simulate() {
+    const float dt = tickSeconds_;
+    sim_.stepPokeballs(dt);
+    if (!clients_.empty()) sim_.player() = clients_.front()->player;  // The AI's focus, see NetServer.h
+    sim_.updatePokemon(dt);
+
+    for (auto& client : clients_) {
+        const NetInput& input = client->input;
+        PlayerInput movement = input.toPlayerInput();
+        sim_.player() = client->player;
+
+        if (static_cast<uint8_t>(input.jumps - client->jumpsApplied) > 0) sim_.jump();
+        client->jumpsApplied = input.jumps;
+        sim_.updatePlayer(dt, movement);
+
+        int throws = std::min<int>(static_cast<uint8_t>(input.throws - client->throwsApplied), MAX_ACTIONS_PER_TICK);
+        client->throwsApplied = input.throws;
+        for (int i = 0; i < throws; ++i) {
+            sim_.throwPokeball(sim_.player().position + movement.front * constants::PROJECTILE_SPAWN_DISTANCE,
+                movement.front, input.throwSpeed / 8.0f);
+        }
+        client->player = sim_.player();
+    }
+    if (!clients_.empty()) sim_.player() = clients_.front()->player;
+}
+
+// Quantize every Pokemon, pokeball and player once per snapshot tick
+void NetServer::gatherEntities() {
+    world_.clear();
+    const Registry& entities = sim_.entities();
+    const PokemonSpecies* species = sim_.species().data();
+
+    entities.each<Pokemon>([&](const Pokemon& p) {
+        NetEntity e;
+        e.id = NetEntity::MakeId(NetKind::Pokemon, static_cast<uint32_t>(p.getId()));
+        e.setWorldPosition(p.getPosition());
+        e.setYaw(p.getYRotation());
+        e.aux[0] = static_cast<uint8_t>(p.getSpecies() ? p.getSpecies() - species : 0);
+        e.aux[1] = static_cast<uint8_t>(p.getState());
+        e.aux[2] = p.isVisible() ? 1 : 0;
+        world_.push_back(e);
+    });
+
+    entities.each<Transform, Pokeball>([&](Entity handle, const Transform& t, const Pokeball& b) {
+        NetEntity e;
+        e.id = NetEntity::MakeId(NetKind::Pokeball, ((handle.generation & 0x3FFu) << 20) | (handle.index & 0xFFFFFu));
+        e.setWorldPosition(t.position);
+        e.aux[0] = (b.active ? 1 : 0) | (b.locked ? 2 : 0);
+        e.aux[1] = static_cast<uint8_t>(std::clamp(b.shakeCount, 0, 255));
+        e.aux[2] = static_cast<uint8_t>(std::lround(std::clamp(b.shakePhase, 0.0f, 1.0f) * 255.0f));
+        e.aux[3] = static_cast<uint8_t>(std::lround(std::clamp(b.lockTimer * 50.0f, 0.0f, 255.0f)));
+        world_.push_back(e);
+    });
+
+    for (const auto& client : clients_) {
+        NetEntity e;
+        e.id = NetEntity::MakeId(NetKind::Player, client->id);
+        e.setWorldPosition(client->player.position);
+        glm::vec3 front = client->input.front;
+        e.setYaw(std::atan2(front.x, front.z));
+        e.aux[0] = static_cast<uint8_t>(client->id);
+        e.aux[1] = static_cast<uint8_t>(client->id >> 8);
+        world_.push_back(e);
+    }
+
+    // Sorted by id once, so each client's pick only needs its indices in order
+    std::sort(world_.begin(), world_.end(), [](const NetEntity& a, const NetEntity& b) { return a.id < b.id; });
+    worldXZ_.clear();
+    for (const NetEntity& e : world_) {
+        glm::vec3 p = e.worldPosition();
+        worldXZ_.emplace_back(p.x, p.z);
+    }
+}
+
+// Pick the entities nearest the client's player, encode them against its acknowledged
+// snapshot and send the payload in fragments
+void NetServer::sendSnapshot(Client& client) {
+    const float radius2 = constants::NET_INTEREST_RADIUS * constants::NET_INTEREST_RADIUS;
+    const glm::vec2 eye(client.player.position.x, client.player.position.z);
+
+    nearby_.clear();
+    for (uint32_t i = 0; i < world_.size(); ++i) {
+        glm::vec2 d = worldXZ_[i] - eye;
+        float dist2 = d.x * d.x + d.y * d.y;
+        if (world_[i].kind() == NetKind::Player) dist2 = 0.0f;  // Players are always sent
+        if (dist2 <= radius2) nearby_.emplace_back(dist2, i);
+    }
+    const size_t limit = constants::NET_MAX_SNAPSHOT_ENTITIES;
+    if (nearby_.size() > limit) {
+        std::nth_element(nearby_.begin(), nearby_.begin() + limit, nearby_.end());
+        nearby_.resize(limit);
+        std::sort(nearby_.begin(), nearby_.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+    }
+
+    SentSnapshot& slot = client.history[(client.sequence + 1) % client.history.size()];
+    slot.entities.clear();
+    for (const auto& [dist2, index] : nearby_) slot.entities.push_back(world_[index]);
+
+    // Delta against the acknowledged snapshot while it is still in the history (the slot
+    // just overwritten is the oldest, so it is never the baseline)
+    const SentSnapshot* baseline = nullptr;
+    if (client.acked != 0) {
+        const SentSnapshot& acked = client.history[client.acked % client.history.size()];
+        if (acked.sequence == client.acked && &acked != &slot) baseline = &acked;
+    }
+    static const std::vector<NetEntity> none;
+    NetProtocol::EncodeEntities(baseline ? baseline->entities : none, slot.entities, payload_);
+    slot.sequence = ++client.sequence;
+
+    NetSnapshotHeader header;
+    header.sequence = slot.sequence;
+    header.baseline = baseline ? baseline->sequence : 0;
+    header.tick = tick_;
+    header.tickMicros = reportTickMicros_;
+    header.netMicros = reportNetMicros_;
+    header.clients = static_cast<uint16_t>(std::min<size_t>(clients_.size(), UINT16_MAX));
+    const size_t fragmentBytes = constants::NET_FRAGMENT_BYTES;
+    header.fragments = static_cast<uint8_t>(std::clamp<size_t>((payload_.size() + fragmentBytes - 1) / fragmentBytes, 1, 255));
+    for (uint8_t f = 0; f < header.fragments; ++f) {
+        header.fragment = f;
+        size_t offset = f * fragmentBytes;
+        size_t bytes = std::min(fragmentBytes, payload_.size() - std::min(offset, payload_.size()));
+        send(client.address, packet_, NetProtocol::WriteSnapshot(header, payload_.data() + offset, bytes, packet_));
+    }
+
+    stats_.snapshotsSent++;
+    if (!baseline) stats_.fullSnapshots++;
+    stats_.snapshotEntities += slot.entities.size();
+}
+
+void NetServer::send(const NetAddress& to, const uint8_t* data, size_t size) {
+    if (socket_.send(to, data, size)) {
+        stats_.packetsSent++;
+        stats_.bytesSent += size;
+    }
+}
+
+} // namespace pokepp
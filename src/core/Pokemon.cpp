@@ -2,11 +2,12 @@
 #include "pokeapp/Model.h"
 #include "pokeapp/Shader.h"
 #include "pokeapp/World.h"
+#include "pokeapp/Navigation.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <cstdlib>
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 
 /*
@@ -15,33 +16,70 @@
 */
 
 namespace pokepp {
-	static float randomFloat() {
-		return static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-	}
-
 	Pokemon::Pokemon(const PokemonSpecies* species, const glm::vec3& startPos, 
-	                 float moveSpeed, float collisionRadius, int id)
+	                 float moveSpeed, float collisionRadius, int id, uint64_t seed)
 		: species_{ species }
 		, model_{ species ? species->model : nullptr }
 		, position_{ startPos }
 		, speed_{ moveSpeed }
 		, radius_{ collisionRadius }
-		, id_{ id } {
+		, id_{ id }
+		, rng_{ seed, static_cast<uint64_t>(id) } {
 		pickNewWanderDirection();
 	}
 
 	// Pick a new random direction for wandering
 	void Pokemon::pickNewWanderDirection() {
-		float angle = randomFloat() * 6.2831853f; // Angle in radians
+		float angle = rng_.uniform() * 6.2831853f; // Angle in radians
 		wanderDir_ = glm::normalize(glm::vec3{ std::cos(angle), 0.0f, std::sin(angle) });
 		velocity_ = wanderDir_ * speed_;
 
-		timeUntilDirectionChange_ = 1.0f + 2.0f * randomFloat();
+		timeUntilDirectionChange_ = 1.0f + 2.0f * rng_.uniform();
 		state_ = PokemonState::Walking;
 	}
 
+	// Override the wander direction (e.g. from a flow field). The current leg is kept
+	// short so the Pokemon goes back to wandering soon after the steering stops.
+	void Pokemon::steer(const glm::vec3& dir, float speedScale) {
+		if (!isWandering()) return;
+
+		wanderDir_ = dir;
+		velocity_ = dir * speed_ * speedScale;
+		timeUntilDirectionChange_ = std::max(timeUntilDirectionChange_, 0.5f);
+		state_ = PokemonState::Walking;
+	}
+
+	// Apply crowd steering (an XZ acceleration) and an overlap push from the CrowdSystem.
+	// Speed is capped at the current speed or the base speed, whichever is higher, so
+	// steering can turn a fleeing Pokemon but never speed it up.
+	void Pokemon::applyCrowd(const glm::vec2& steer, const glm::vec2& push, float dt,
+	                         const World* world, const NavGrid* nav) {
+		if (!isWandering()) return;
+
+		float maxSpeed = std::max(speed_, glm::length(velocity_));
+		velocity_ += glm::vec3(steer.x, 0.0f, steer.y) * dt;
+		float len = glm::length(velocity_);
+		if (len > maxSpeed) {
+			velocity_ *= maxSpeed / len;
+			len = maxSpeed;
+		}
+		if (len > 0.001f) {
+			wanderDir_ = velocity_ / len;
+			state_ = PokemonState::Walking;
+		}
+
+		// Never push a Pokemon into a prop or off the terrain
+		glm::vec3 pushed = position_ + glm::vec3(push.x, 0.0f, push.y);
+		if (push != glm::vec2(0.0f) && (!nav || nav->walkable(pushed))) {
+			position_ = pushed;
+			if (world) {
+				position_.y = world->heightAt(position_.x, position_.z);
+			}
+		}
+	}
+
 	// Update Pokemon state and position based on elapsed time and world state
-	void Pokemon::update(float dt, const World* world, const std::vector<glm::vec3>& obstacles) {
+	void Pokemon::update(float dt, const World* world, std::span<const glm::vec3> obstacles, const NavGrid* nav) {
 		
 		// Skip all movement if fully captured
 		if (state_ == PokemonState::Captured) {
@@ -67,9 +105,16 @@ namespace pokepp {
 		glm::vec3 oldPos = position_;
 		glm::vec3 nextPos = position_ + velocity_ * dt;
 
-		// Check for collisions with obstacles
+		// Check for collisions with obstacles. The navigation grid already has props (inflated
+		// by the agent radius) and steep slopes baked in, so a single cell lookup replaces the
+		// obstacle scan when it is available.
 		bool collided = false;
-		for (const auto& obstacle : obstacles) {
+		if (nav) {
+			// Only block if we are on open ground now, so a Pokemon that starts out on a blocked
+			// cell can still walk off it
+			collided = !nav->walkable(nextPos) && nav->walkable(position_);
+		}
+		else for (const auto& obstacle : obstacles) {
 			glm::vec2 toObstacle(obstacle.x - nextPos.x, obstacle.z - nextPos.z);
 			float dist = glm::length(toObstacle);
 			if (dist < radius_ + 0.7f) { // obstacle radius estimate
@@ -103,6 +148,37 @@ namespace pokepp {
 		}
 	}
 
+	// Advance a sleeping (far tier) Pokemon by dt seconds in one step, without the per-frame
+	// obstacle scan. The current wander leg is finished exactly; the rest of the time is
+	// covered by a random walk of legs averaging 2s, whose expected displacement grows
+	// with the square root of the number of legs.
+	void Pokemon::advanceAsleep(float dt, const World* world) {
+		if (!isWandering() || dt <= 0.0f) return;
+
+		float leg = std::min(dt, timeUntilDirectionChange_);
+		position_ += velocity_ * leg;
+		timeUntilDirectionChange_ -= leg;
+
+		float rest = dt - leg;
+		if (rest > 0.0f) {
+			constexpr float MEAN_LEG_SECONDS = 2.0f;
+			float legs = rest / MEAN_LEG_SECONDS;
+			float angle = rng_.uniform() * 6.2831853f;
+			float dist = speed_ * MEAN_LEG_SECONDS * std::sqrt(legs);
+			position_ += glm::vec3{ std::cos(angle), 0.0f, std::sin(angle) } * dist;
+			pickNewWanderDirection();
+		}
+
+		// Follow terrain height
+		if (world) {
+			position_.y = world->heightAt(position_.x, position_.z);
+		}
+
+		if (glm::length(velocity_) > 0.001f) {
+			yRotation_ = std::atan2(velocity_.x, velocity_.z);
+		}
+	}
+
 	// Render the Pokemon using the provided shader
 	void Pokemon::draw(Shader& shader) const {
 		if (!visible_ || !model_) return;
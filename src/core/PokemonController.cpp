@@ -1,14 +1,19 @@
 #include "pokeapp/PokemonController.h"
 #include "pokeapp/Pokemon.h"
 #include "pokeapp/Pokeball.h"
+#include "pokeapp/Components.h"
 #include "pokeapp/Model.h"
 #include "pokeapp/Shader.h"
+#include "pokeapp/Navigation.h"
+#include "pokeapp/FrameArena.h"
+#include "pokeapp/ThreadPool.h"
+#include "pokeapp/Profiler.h"
+#include "pokeapp/Memory.h"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/norm.hpp>
 #include <iostream>
 #include <algorithm>
-#include <cstdlib>
 
 /*
 	Implementation of PokemonController class. This class manages all active Pokemon
@@ -25,59 +30,213 @@ namespace pokepp {
 		return dist2 <= (rsum * rsum);
 	}
 
-	static float randomFloat() {
-		return static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-	}
-
 	// Spawn a new wild Pokemon in the world
-	void PokemonController::spawnPokemon(const PokemonSpecies* species, const glm::vec3& pos, 
-                                      float speed, float radius, int id) {
+	Entity PokemonController::spawnPokemon(const PokemonSpecies* species, const glm::vec3& pos, 
+                                        float speed, float radius, int id) {
 		int actualId = (id == 0) ? nextPokemonId_++ : id;
-		pokemon_.emplace_back(species, pos, speed, radius, actualId);
+		return registry_.create(Pokemon(species, pos, speed, radius, actualId, seed_));
+	}
+
+	void PokemonController::setNavigation(FlowFieldService* service, int fleeGoal, std::span<const int> herdGoals) {
+		nav_ = service;
+		fleeGoal_ = fleeGoal;
+		herdGoals_.assign(herdGoals.begin(), herdGoals.end());
 	}
 
-	// Update all active Pokemon (wandering, capturing, etc.)
-	void PokemonController::updateAll(float dt, const World* world, const std::vector<glm::vec3>& obstacles) {
-		for (auto& p : pokemon_) {
-			p.update(dt, world, obstacles);
+	// Update all active Pokemon (wandering, capturing, etc.) using simulation LOD tiers
+	// based on distance from the focus point (the player):
+	//   Near - full update every frame.
+	//   Mid  - full update every midInterval frames with the accumulated dt. Pokemon are
+	//          staggered by ID so an even share of them ticks on each frame.
+	//   Far  - asleep; time accumulates and is applied analytically on wake-up.
+	// Pokemon that are not wandering (capturing, owned, etc.) always run at full rate.
+	// Awake wandering Pokemon are also steered around each other by the CrowdSystem before
+	// they move. The per-tier updates only touch their own Pokemon, so they run in parallel
+	// chunks on the shared ThreadPool.
+	void PokemonController::updateAll(float dt, const World* world, std::span<const glm::vec3> obstacles,
+	                                  const glm::vec3& focus) {
+		PROFILE_ZONE("PokemonController::updateAll");
+		frame_++;
+		lodStats_ = {};
+
+		const float nearSq = lodConfig_.nearRadius * lodConfig_.nearRadius;
+		const float farSq = lodConfig_.farRadius * lodConfig_.farRadius;
+		const unsigned interval = static_cast<unsigned>(std::max(1, lodConfig_.midInterval));
+
+		// Grab the navigation data once; every Pokemon then costs one cell lookup
+		const NavGrid* grid = nav_ ? nav_->grid() : nullptr;
+		std::shared_ptr<const FlowField> flee = nav_ ? nav_->field(fleeGoal_) : nullptr;
+		const float fleeSq = constants::FLEE_TRIGGER_RADIUS * constants::FLEE_TRIGGER_RADIUS;
+		// Raw pointers, so no field is held past the frame: the service reuses a goal's old
+		// field for its next solve only when nobody else still holds it
+		FrameVector<const FlowField*> herdFields = makeFrameVector<const FlowField*>(herdGoals_.size());
+		for (int goal : herdGoals_) {
+			herdFields.push_back(nav_ ? nav_->field(goal).get() : nullptr);
+		}
+
+		// Tier assignment, flee and herd steering. Also counts the tiers, picks the mid tier
+		// Pokemon that update this frame, and gathers the crowd: every awake wandering Pokemon.
+		// Sleeping ones are left out, since nobody sees them overlap and their position jumps
+		// on wake-up anyway.
+		FrameVector<Pokemon*> crowdMembers(&frameArena());  // Pokemon of each crowd agent
+		{
+			PROFILE_ZONE("Pokemon LOD, flee and herd");
+			registry_.each<Pokemon>([&](Pokemon& p) {
+				glm::vec2 d(p.getPosition().x - focus.x, p.getPosition().z - focus.z);
+				float distSq = glm::dot(d, d);
+
+				SimTier tier = SimTier::Near;
+				if (p.isWandering() && !isOwnedPokemon(p)) {
+					if (distSq >= farSq) tier = SimTier::Far;
+					else if (distSq >= nearSq) tier = SimTier::Mid;
+				}
+
+				// Waking up - catch up on the time spent asleep in one analytic step
+				if (p.getSimTier() == SimTier::Far && tier != SimTier::Far) {
+					p.advanceAsleep(p.getPendingDt(), world);
+					p.setPendingDt(0.0f);
+					lodStats_.wakeUps++;
+				}
+				p.setSimTier(tier);
+
+				// Wild Pokemon that get too close to the player run away along the flee field
+				bool fled = false;
+				if (flee && tier != SimTier::Far && distSq < fleeSq && p.isWandering() && !isOwnedPokemon(p)) {
+					glm::vec3 dir = flee->direction(p.getPosition());
+					if (dir != glm::vec3(0.0f)) {
+						p.steer(dir, constants::FLEE_SPEED_MULTIPLIER);
+						fled = true;
+					}
+				}
+
+				// Walking wild Pokemon that strayed from their species' herd head back along its
+				// field; near the herd target (or out of the field's reach) they wander freely
+				if (!fled && tier != SimTier::Far && p.getState() == PokemonState::Walking && !isOwnedPokemon(p)) {
+					size_t s = speciesIndex(p);
+					const FlowField* herd = s < herdFields.size() ? herdFields[s] : nullptr;
+					if (herd && herd->distanceAt(p.getPosition()) > constants::HERD_GATHER_RADIUS) {
+						glm::vec3 dir = herd->direction(p.getPosition());
+						if (dir != glm::vec3(0.0f)) p.steer(dir);
+					}
+				}
+
+				switch (tier) {
+				case SimTier::Near:
+					lodStats_.nearCount++;
+					lodStats_.updatesRun++;
+					break;
+				case SimTier::Mid:
+					lodStats_.midCount++;
+					if ((static_cast<unsigned>(p.getId()) + frame_) % interval == 0) lodStats_.updatesRun++;
+					break;
+				case SimTier::Far:
+					lodStats_.farCount++;
+					break;
+				}
+
+				if (tier != SimTier::Far && p.isWandering() && p.isVisible()) {
+					crowdMembers.push_back(&p);
+				}
+			});
+		}
+
+		// Crowd steering
+		crowd_.resize(crowdMembers.size());
+		for (size_t a = 0; a < crowdMembers.size(); ++a) {
+			const Pokemon& p = *crowdMembers[a];
+			crowd_.posX[a] = p.getPosition().x;
+			crowd_.posZ[a] = p.getPosition().z;
+			crowd_.velX[a] = p.getVelocity().x;
+			crowd_.velZ[a] = p.getVelocity().z;
+			crowd_.radius[a] = p.getRadius();
+		}
+		crowd_.step(crowdConfig_, &ThreadPool::shared());
+
+		for (size_t a = 0; a < crowdMembers.size(); ++a) {
+			crowdMembers[a]->applyCrowd({ crowd_.steerX[a], crowd_.steerZ[a] },
+			                                      { crowd_.pushX[a], crowd_.pushZ[a] }, dt, world, grid);
+		}
+
+		// Per-tier simulation
+		{
+			PROFILE_ZONE("Pokemon tier updates");
+			const unsigned frame = frame_;
+			registry_.parallelEach<Pokemon>(ThreadPool::shared(), [&](Pokemon& p) {
+				SimTier tier = p.getSimTier();
+				float pending = p.getPendingDt() + dt;
+				bool run = tier == SimTier::Near
+					|| (tier == SimTier::Mid && (static_cast<unsigned>(p.getId()) + frame) % interval == 0);
+				if (run) {
+					p.setPendingDt(0.0f);
+					p.update(pending, world, obstacles, grid);
+				} else {
+					p.setPendingDt(pending);
+				}
+			});
 		}
 	}
 
 	// Draw all active Pokemon
 	void PokemonController::drawAll(Shader& shader) const {
-		for (const auto& p : pokemon_) {
+		PROFILE_ZONE("PokemonController::drawAll");
+		registry_.each<Pokemon>([&](const Pokemon& p) {
 			p.draw(shader);
-		}
+		});
 	}
 
 	// Handle collisions between Pokeballs and Pokemon for capture attempts
-	void PokemonController::handlePokeballCapture(std::vector<Pokeball>& pokeballs) {
-		for (auto& p : pokemon_) {
-			
+	void PokemonController::handlePokeballCapture(float dt) {
+		PROFILE_ZONE("PokemonController::handlePokeballCapture");
+
+		// Advance open capture sessions. If the ball disappeared before it could resolve
+		// the capture, the Pokemon breaks free instead of being stuck mid-capture.
+		for (size_t i = captures_.size(); i-- > 0; ) {
+			CaptureSession& session = captures_[i];
+			session.timer += dt;
+			if (!registry_.alive(session.ball)) {
+				session.success = false;
+				resolveCapture(captures_.handleAt(i));
+			}
+		}
+
+		// Gather the balls that can still capture: not locked (already attempted a capture).
+		// Balls asleep on the ground count too, a Pokemon can walk into one.
+		FrameVector<BallCandidate> ballCandidates(&frameArena());
+		registry_.each<Transform, Pokeball>(Without<Sleeping>{}, [&](Entity e, Transform& t, Pokeball& ball) {
+			if (!ball.locked) ballCandidates.push_back({ e, &t, &ball, false });
+		});
+		registry_.each<Transform, Pokeball, Sleeping>([&](Entity e, Transform& t, Pokeball& ball, Sleeping&) {
+			if (!ball.locked) ballCandidates.push_back({ e, &t, &ball, true });
+		});
+		if (ballCandidates.empty()) return;
+
+		registry_.each<Pokemon>([&](Entity handle, Pokemon& p) {
 			// Skip if already captured or currently capturing
-			if (p.isCaptured() || p.isCapturing()) continue;
+			if (p.isCaptured() || p.isCapturing()) return;
 			
 			// Skip if capture failed (still in failed state, hasn't fully reset yet)
 			// (bug fix)
-			if (p.captureFailed()) continue;
+			if (p.captureFailed()) return;
 
 			// Skip if this is one of our own Pokemon (can't recapture them!)
 			if (isOwnedPokemon(p)) {
-				continue;
+				return;
 			}
 
-			// Check collision with each active Pokeball
-			for (auto& ball : pokeballs) {
+			// Check collision with each candidate Pokeball
+			for (BallCandidate& candidate : ballCandidates) {
+				Pokeball& ball = *candidate.ball;
+				glm::vec3& ballPos = candidate.transform->position;
 
-				// Skip if this ball is already locked (already attempted a capture)
+				// Skip if this ball locked onto another Pokemon earlier in this pass
 				if (ball.locked) continue;
 				
 				// Skip if this ball already tried to capture this specific Pokemon
 				// (prevents multiple collisions on same ball)
-				if (ball.targetPokemonId == p.getId()) continue;
+				if (ball.targetPokemon == handle) continue;
 				
 				// On collision, start capture process
-				if (collide(ball.position, ball.radius, p.getPosition(), p.getRadius())) {					
+				if (collide(ballPos, ball.radius, p.getPosition(), p.getRadius())) {					
 					p.startCapture();
 					p.setVisible(false);
 
@@ -85,42 +244,74 @@ namespace pokepp {
 					ball.locked = true;
 					ball.lockTimer = 0.0f;
 					ball.velocity = glm::vec3(0.0f);
-					ball.targetPokemonId = p.getId();  // Remember which Pokemon this ball tried to capture, to avoid re-collisions
+					ball.targetPokemon = handle;  // Remember which Pokemon this ball tried to capture, to avoid re-collisions
 
 					// SNAP animation - ball snaps to Pokemon position
-					ball.position = p.getPosition() + glm::vec3(0.0f, p.getRadius(), 0.0f);
+					ballPos = p.getPosition() + glm::vec3(0.0f, p.getRadius(), 0.0f);
 
 					// Calculate capture success based on catch rate
 					float catchRate = p.getCatchRate();
-					float roll = randomFloat();
+					float roll = rng_.uniform();
 					bool captureSuccess = (roll <= catchRate);
 					
-					// Store the result via the ball for later processing
+					// Open a capture session linking this ball and Pokemon, so the result can be
+					// applied directly when the ball finishes shaking
+					CaptureSession session;
+					session.ball = candidate.entity;
+					session.pokemon = handle;
+					session.roll = roll;
+					session.success = captureSuccess;
+					ball.captureSession = captures_.insert(session);
 					ball.captureSuccess = captureSuccess;
 
 					break;
 				}
 			}
+		});
+
+		// Wake the sleeping balls that started a capture, so the physics step runs their
+		// shake. Flags are read first: removing the tag moves balls and their components.
+		for (BallCandidate& candidate : ballCandidates) {
+			candidate.sleeping = candidate.sleeping && candidate.ball->locked;
+		}
+		for (const BallCandidate& candidate : ballCandidates) {
+			if (candidate.sleeping) registry_.remove<Sleeping>(candidate.entity);
 		}
 	}
 
+	// Apply the outcome of a capture session to its Pokemon and close the session
+	bool PokemonController::resolveCapture(Handle sessionHandle) {
+		CaptureSession* session = captures_.get(sessionHandle);
+		if (!session) {
+			return false;
+		}
+
+		// The Pokemon may have been removed in the meantime (e.g. recalled)
+		if (Pokemon* p = registry_.get<Pokemon>(session->pokemon); p && p->isCapturing()) {
+			if (session->success) p->markCaptured();
+			else p->markCaptureFailed();
+		}
+
+		captures_.erase(sessionHandle);
+		return true;
+	}
+
 	// Update inventory by moving captured Pokemon from active list to inventory
 	void PokemonController::updateInventory() {
-
-		// Move SUCCESSFULLY captured Pokmon from active list to inventory
-		auto it = pokemon_.begin();
-		while (it != pokemon_.end()) {
-			if (it->isCaptured() && !it->isVisible()) {
-				// Only move to inventory if it's NOT one of our sent-out Pokmon
-				if (!isOwnedPokemon(*it)) {
-					inventory_.push_back(std::move(*it));
-					it = pokemon_.erase(it);
-				} else {
-					++it;
-				}
-			} else {
-				++it;
+		PROFILE_ZONE("PokemonController::updateInventory");
+
+		// Move SUCCESSFULLY captured Pokmon from active list to inventory. The entities are
+		// destroyed after the query, since that changes the registry's layout.
+		FrameVector<Entity> removed(&frameArena());
+		registry_.each<Pokemon>([&](Entity e, Pokemon& p) {
+			// Only move to inventory if it's NOT one of our sent-out Pokmon
+			if (p.isCaptured() && !p.isVisible() && !isOwnedPokemon(p)) {
+				inventory_.push_back(makeEntry(p));
+				removed.push_back(e);
 			}
+		});
+		for (Entity e : removed) {
+			registry_.destroy(e);
 		}
 	}
 
@@ -140,19 +331,14 @@ namespace pokepp {
 			return false;
 		}
 
-		// Create a copy of the Pokemon (keep original in inventory)
-		Pokemon sentOut = inventory_[inventoryIndex];
-		
-		// Reset state and position for the active copy
-		sentOut.setPosition(position);
+		// Materialize the entry as a live Pokemon (the entry stays in the inventory)
+		const InventoryEntry& entry = inventory_[inventoryIndex];
+		Pokemon sentOut(speciesOf(entry), position, entry.speed, entry.radius, entry.id, seed_);
 		sentOut.setState(PokemonState::Idle);
-		sentOut.setVisible(true);
+		sentOut.setInventorySlot(static_cast<int>(inventoryIndex));
 
-		// Add to active Pokemon list
-		pokemon_.push_back(std::move(sentOut));
-		
-		// Track that this inventory slot is now out
-		outPokemonIndices_.push_back(inventoryIndex);
+		// Add to active Pokemon list, and track that this inventory slot is now out
+		out_.push_back({ static_cast<uint32_t>(inventoryIndex), registry_.create(std::move(sentOut)) });
 
 		return true;
 	}
@@ -164,59 +350,68 @@ namespace pokepp {
 		}
 
 		// Find if this Pokmon is currently out
-		auto outIt = std::find(outPokemonIndices_.begin(), outPokemonIndices_.end(), inventoryIndex);
-		if (outIt == outPokemonIndices_.end()) {
+		const OutPokemon* out = findOut(inventoryIndex);
+		if (!out) {
 			return false;
 		}
 
-		// Find and remove the sent-out Pokmon by matching ID
-		int targetId = inventory_[inventoryIndex].getId();
-		bool found = false;
-
-		// Search from the END backwards (sent-out Pokmon are added to the end)
-		for (auto it = pokemon_.rbegin(); it != pokemon_.rend(); ++it) {
-			if (it->getId() == targetId && isOwnedPokemon(*it)) {
-				// Found it! Remove it using base() iterator
-				pokemon_.erase(std::next(it).base());
-				found = true;
-				break;
-			}
+		// Write its stats back, then remove the sent-out Pokmon directly through its handle
+		if (const Pokemon* p = registry_.get<Pokemon>(out->entity)) {
+			inventory_[inventoryIndex] = makeEntry(*p);
 		}
-
-		if (!found) {
+		if (!registry_.destroy(out->entity)) {
 			return false;
 		}
 
-		// Remove from tracking list
-		outPokemonIndices_.erase(outIt);
+		// Clear the tracking handle
+		out_.erase(out_.begin() + (out - out_.data()));
 
 		return true;
 	}
 
 	// Check if a specific inventory Pokemon is currently out in the world
 	bool PokemonController::isPokemonOut(size_t inventoryIndex) const {
-		return std::find(outPokemonIndices_.begin(), outPokemonIndices_.end(), inventoryIndex) 
-		       != outPokemonIndices_.end();
+		return findOut(inventoryIndex) != nullptr;
 	}
 
 	// Check if any Pokemon are currently out in the world
 	bool PokemonController::hasAnyPokemonOut() const {
-		return !outPokemonIndices_.empty();
+		return !out_.empty();
 	}
 
-	// Check if a given Pokemon is one of our owned (sent-out) Pokemon
-	bool PokemonController::isOwnedPokemon(const Pokemon& p) const {
-		if (outPokemonIndices_.empty()) {
-			return false;
+	const PokemonController::OutPokemon* PokemonController::findOut(size_t inventoryIndex) const {
+		for (const OutPokemon& out : out_) {
+			if (out.slot == inventoryIndex) return &out;
 		}
+		return nullptr;
+	}
 
-		// Check if this Pokmon's ID matches any of our inventory Pokmon
-		for (size_t outIdx : outPokemonIndices_) {
-			if (outIdx < inventory_.size() && p.getId() == inventory_[outIdx].getId()) {
-				return true;
-			}
+	// Index of a Pokemon's species in the table, or the table size for species outside it
+	size_t PokemonController::speciesIndex(const Pokemon& p) const {
+		const PokemonSpecies* species = p.getSpecies();
+		if (species && species >= species_.data() && species < species_.data() + species_.size()) {
+			return static_cast<size_t>(species - species_.data());
 		}
+		return species_.size();
+	}
+
+	// The record a Pokemon leaves in the inventory. Pokemon of species outside the table
+	// (none in practice) come back without a species.
+	InventoryEntry PokemonController::makeEntry(const Pokemon& p) const {
+		InventoryEntry entry;
+		entry.id = p.getId();
+		size_t species = speciesIndex(p);
+		if (species < species_.size()) entry.species = static_cast<uint16_t>(species);
+		entry.speed = p.getSpeed();
+		entry.radius = p.getRadius();
+		return entry;
+	}
 
-		return false;
+	// Report the containers this controller owns; the Pokemon themselves live in the registry
+	void PokemonController::reportMemory(MemoryReport& out) const {
+		out.addVector(MemoryCategory::CpuEntities, "inventory", inventory_);
+		out.addVector(MemoryCategory::CpuEntities, "inventory", out_);
+		out.add(MemoryCategory::CpuEntities, "capture sessions", captures_.memoryBytes());
+		out.add(MemoryCategory::CpuNavigation, "crowd", crowd_.memoryBytes());
 	}
 }
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "pokeapp/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+	Implementation of the Profiler. See Profiler.h for an overview.
+
+	Each thread that records during a capture gets a ThreadBuffer. Only the owning thread
+	writes to it; it publishes an event by bumping `count` with release ordering, so the
+	thread writing the trace sees complete events only. Every capture has a new epoch, and a
+	buffer from an older epoch is reset by its owner on its next event, so buffers never need
+	to be cleared from another thread. Buffers are kept for the life of the process.
+*/
+
+namespace pokepp {
+
+std::atomic<bool> Profiler::active_{ false };
+
+namespace {
+    constexpr uint32_t EVENTS_PER_THREAD = 1u << 16;
+
+    struct ZoneEvent {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+        uint32_t allocations;  // Heap allocations inside the zone (POKEPP_ALLOC_TRACKING)
+        uint64_t bytes;
+    };
+
+    struct ThreadBuffer {
+        std::unique_ptr<ZoneEvent[]> events{ new ZoneEvent[EVENTS_PER_THREAD] };
+        std::atomic<uint32_t> count{ 0 };
+        std::atomic<uint32_t> epoch{ 0 };
+        std::atomic<uint32_t> dropped{ 0 };  // Events past the end of the buffer
+        uint32_t threadId = 0;
+        std::string name;
+    };
+
+    std::mutex g_buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+    std::atomic<uint32_t> g_epoch{ 0 };
+
+    thread_local ThreadBuffer* t_buffer = nullptr;
+    thread_local const char* t_threadName = nullptr;
+
+    // Capture state, only touched by the thread calling capture() and frame()
+    struct CaptureState {
+        bool pending = false;
+        bool recording = false;  // A capture is running
+        bool history = false;    // Recording the latest frame for saveLastFrame
+        bool historyFrame = false;  // The current frame is being recorded as history
+        int frames = 0;
+        int framesLeft = 0;
+        uint64_t start = 0;      // Start of the capture, or of the latest frame
+        std::string path;
+    };
+    CaptureState g_capture;
+
+    ThreadBuffer* threadBuffer() {
+        if (!t_buffer) {
+            auto buffer = std::make_unique<ThreadBuffer>();
+            std::lock_guard<std::mutex> lock(g_buffersMutex);
+            buffer->threadId = static_cast<uint32_t>(g_buffers.size() + 1);
+            buffer->name = t_threadName ? t_threadName : "thread " + std::to_string(buffer->threadId);
+            t_buffer = buffer.get();
+            g_buffers.push_back(std::move(buffer));
+        }
+        return t_buffer;
+    }
+
+    // Escape a zone name for a JSON string (names are literals, but may come from __func__)
+    void writeJsonString(std::FILE* f, const char* s) {
+        std::fputc('"', f);
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') std::fputc('\\', f);
+            std::fputc(*s, f);
+        }
+        std::fputc('"', f);
+    }
+
+    // Allocations of each event without those of the events nested in it. Zones of one thread
+    // nest properly, so sorted by start (outer first on ties) each event's parent is the
+    // innermost open one.
+    void selfAllocations(const ZoneEvent* events, uint32_t count, std::vector<int64_t>& allocations,
+                         std::vector<int64_t>& bytes) {
+        std::vector<uint32_t> order(count);
+        for (uint32_t i = 0; i < count; ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return events[a].start != events[b].start ? events[a].start < events[b].start : events[a].end > events[b].end;
+        });
+
+        allocations.resize(count);
+        bytes.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            allocations[i] = events[i].allocations;
+            bytes[i] = static_cast<int64_t>(events[i].bytes);
+        }
+
+        std::vector<uint32_t> open;
+        for (uint32_t i : order) {
+            while (!open.empty() && events[open.back()].end <= events[i].start) open.pop_back();
+            if (!open.empty()) {
+                allocations[open.back()] -= events[i].allocations;
+                bytes[open.back()] -= static_cast<int64_t>(events[i].bytes);
+            }
+            open.push_back(i);
+        }
+    }
+
+    // Write the events of an epoch since `start` as a Chrome trace, and print a summary of
+    // the zones taking the most time (and allocating most, when allocations are tracked)
+    bool writeTrace(uint32_t epoch, uint64_t start, int frames, const std::string& path, size_t summaryRows) {
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) {
+            std::fprintf(stderr, "Profiler: failed to open %s\n", path.c_str());
+            return false;
+        }
+
+        struct ZoneTotal {
+            uint64_t ns = 0;
+            uint32_t calls = 0;
+            int64_t selfAllocations = 0;
+            int64_t selfBytes = 0;
+        };
+        std::unordered_map<std::string, ZoneTotal> totals;
+        size_t eventCount = 0;
+        uint32_t dropped = 0;
+        std::vector<int64_t> selfAllocs, selfBytes;
+
+        std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        bool first = true;
+        std::lock_guard<std::mutex> lock(g_buffersMutex);
+        for (const auto& buffer : g_buffers) {
+            if (buffer->epoch.load(std::memory_order_acquire) != epoch) continue;
+
+            std::fprintf(f, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":",
+                first ? "" : ",\n", buffer->threadId);
+            writeJsonString(f, buffer->name.c_str());
+            std::fprintf(f, "}}");
+            first = false;
+
+            uint32_t count = buffer->count.load(std::memory_order_acquire);
+            selfAllocations(buffer->events.get(), count, selfAllocs, selfBytes);
+            for (uint32_t i = 0; i < count; ++i) {
+                const ZoneEvent& e = buffer->events[i];
+                if (e.start < start) continue;
+
+                // Microseconds with nanosecond precision
+                std::fprintf(f, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+                    buffer->threadId, (e.start - start) / 1000.0, (e.end - e.start) / 1000.0);
+                writeJsonString(f, e.name);
+                if (e.allocations > 0) {
+                    std::fprintf(f, ",\"args\":{\"allocs\":%u,\"bytes\":%llu,\"selfAllocs\":%lld,\"selfBytes\":%lld}",
+                        e.allocations, static_cast<unsigned long long>(e.bytes),
+                        static_cast<long long>(selfAllocs[i]), static_cast<long long>(selfBytes[i]));
+                }
+                std::fputc('}', f);
+
+                ZoneTotal& total = totals[e.name];
+                total.ns += e.end - e.start;
+                total.calls++;
+                total.selfAllocations += selfAllocs[i];
+                total.selfBytes += selfBytes[i];
+                eventCount++;
+            }
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        std::fprintf(f, "\n]}\n");
+        std::fclose(f);
+
+        std::printf("Profiler: wrote %zu zones over %d frames to %s", eventCount, frames, path.c_str());
+        if (dropped) std::printf(" (%u dropped, buffers full)", dropped);
+        std::printf("\n");
+
+        // Zones by inclusive time per frame
+        std::vector<std::pair<std::string, ZoneTotal>> sorted(totals.begin(), totals.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.ns > b.second.ns; });
+        const double perFrame = std::max(1, frames);
+        std::printf("  %-36s %10s %10s\n", "zone", "ms/frame", "calls/frame");
+        for (size_t i = 0; i < sorted.size() && i < summaryRows; ++i) {
+            std::printf("  %-36s %10.3f %10.1f\n", sorted[i].first.c_str(),
+                sorted[i].second.ns / 1e6 / perFrame, sorted[i].second.calls / perFrame);
+        }
+
+        // Allocation hotspots: zones by the allocations made directly in them
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+            return a.second.selfAllocations > b.second.selfAllocations;
+        });
+        if (!sorted.empty() && sorted[0].second.selfAllocations > 0) {
+            std::printf("  %-36s %12s %10s\n", "zone (self)", "allocs/frame", "KiB/frame");
+            for (size_t i = 0; i < sorted.size() && i < summaryRows && sorted[i].second.selfAllocations > 0; ++i) {
+                std::printf("  %-36s %12.1f %10.2f\n", sorted[i].first.c_str(),
+                    sorted[i].second.selfAllocations / perFrame, sorted[i].second.selfBytes / 1024.0 / perFrame);
+            }
+        }
+        return true;
+    }
+}
+
+bool Profiler::capture(int frames, const std::string& path) {
+    if (g_capture.pending || g_capture.recording || frames <= 0) return false;
+
+    g_capture.pending = true;
+    g_capture.frames = frames;
+    g_capture.path = path;
+    return true;
+}
+
+void Profiler::frame() {
+    CaptureState& c = g_capture;
+    if (c.recording && --c.framesLeft <= 0) {
+        c.recording = false;
+        writeTrace(g_epoch.load(), c.start, c.frames, c.path, 12);
+    }
+
+    // A new capture, or the next frame of history, starts a new epoch. Buffers of the old
+    // one are reset by their threads on their next zone.
+    bool startCapture = c.pending;
+    if (startCapture) {
+        c.pending = false;
+        c.recording = true;
+        c.framesLeft = c.frames;
+    }
+    c.historyFrame = c.history && !c.recording;
+    if (startCapture || c.historyFrame) {
+        c.start = now();
+        g_epoch.fetch_add(1);
+    }
+    active_.store(c.recording || c.history, std::memory_order_relaxed);
+}
+
+void Profiler::setFrameHistory(bool enabled) {
+    // Recording starts with the next frame
+    g_capture.history = enabled;
+    if (!enabled) {
+        g_capture.historyFrame = false;
+        if (!g_capture.recording) active_.store(false, std::memory_order_relaxed);
+    }
+}
+
+bool Profiler::saveLastFrame(const std::string& path) {
+    if (!g_capture.historyFrame) return false;
+    return writeTrace(g_epoch.load(), g_capture.start, 1, path, 5);
+}
+
+void Profiler::setThreadName(const char* name) {
+    t_threadName = name;
+}
+
+uint64_t Profiler::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end, uint32_t allocations, uint64_t bytes) {
+    ThreadBuffer* buffer = threadBuffer();
+
+    uint32_t epoch = g_epoch.load(std::memory_order_relaxed);
+    if (buffer->epoch.load(std::memory_order_relaxed) != epoch) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->epoch.store(epoch, std::memory_order_release);
+    }
+
+    uint32_t n = buffer->count.load(std::memory_order_relaxed);
+    if (n >= EVENTS_PER_THREAD) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[n] = { name, start, end, allocations, bytes };
+    buffer->count.store(n + 1, std::memory_order_release);
+}
+
+} // namespace pokepp
@@ -0,0 +1,1051 @@
+#include "pokeapp/SaveGame.h"
+#include "pokeapp/Simulation.h"
+#include "pokeapp/PokemonController.h"
+#include "pokeapp/CollisionWorld.h"
+#include "pokeapp/Components.h"
+#include "pokeapp/Profiler.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#include <filesystem>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <type_traits>
+
+/*
+	Implementation of the save format, see SaveGame.h.
+
+	Header (32 bytes): magic, version u32, endian tag u32 (0x01020304), block count u32,
+	file size u64, table checksum u64. Table entry (32 bytes): tag u32, rows u32, offset u64,
+	size u64, checksum u64. Checksums are FNV-1a over the little endian 64-bit words of the
+	bytes (blocks are padded to whole words); a changed word always changes the result.
+
+	Columns are written and read one field at a time through storeLanes(), a memcpy on
+	little endian hosts and a byte swap per scalar elsewhere.
+
+	Delta header (40 bytes): magic, version u32, size of the save u64, table checksum of the
+	base save u64 (identifies it), payload size u64, payload checksum u64. The payload is a
+	list of runs: the count of unchanged words and of changed words (LEB128 varints), then per
+	changed word a byte with a bit for each byte that differs from the base and those bytes
+	XORed with the base. Moving floats mostly keep their sign and exponent bytes.
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr char MAGIC[4] = { 'P', 'P', 'S', 'V' };
+    constexpr uint32_t ENDIAN_TAG = 0x01020304u;
+    constexpr size_t HEADER_BYTES = 32;
+    constexpr size_t TABLE_ENTRY_BYTES = 32;
+    constexpr uint32_t MAX_BLOCKS = 256;
+    constexpr uint32_t NONE = 0xFFFFFFFFu;  // Entity reference to nothing
+    constexpr char DELTA_MAGIC[4] = { 'P', 'P', 'S', 'D' };
+    constexpr size_t DELTA_HEADER_BYTES = 40;
+
+    constexpr uint32_t fourcc(const char (&s)[5]) {
+        return uint32_t(uint8_t(s[0])) | uint32_t(uint8_t(s[1])) << 8 | uint32_t(uint8_t(s[2])) << 16 | uint32_t(uint8_t(s[3])) << 24;
+    }
+
+    constexpr uint32_t TAG_META = fourcc("META");
+    constexpr uint32_t TAG_PROPS = fourcc("PROP");
+    constexpr uint32_t TAG_POKEMON = fourcc("PKMN");
+    constexpr uint32_t TAG_BALLS = fourcc("BALL");
+    constexpr uint32_t TAG_CAPTURES = fourcc("CAPT");
+    constexpr uint32_t TAG_INVENTORY = fourcc("INVE");
+    constexpr uint32_t TAG_OUT = fourcc("OUTP");
+    constexpr uint32_t TAG_BALL_ORDER = fourcc("BORD");
+    constexpr uint32_t BLOCK_COUNT = 8;     // Written
+    constexpr uint32_t REQUIRED_BLOCKS = 7; // Needed to load, BORD is optional
+
+    // Rows a snapshot array keeps room for, at least
+    constexpr size_t MIN_SNAPSHOT_ROWS = 64;
+
+    template <typename T>
+    void reserveHeadroom(std::vector<T>& v) {
+        size_t rows = std::max(v.size() + v.size() / 2, MIN_SNAPSHOT_ROWS);
+        if (v.capacity() < rows) v.reserve(rows);
+    }
+
+    // Pokeball flag bits
+    constexpr uint8_t BALL_ACTIVE = 1, BALL_GROUNDED = 2, BALL_LOCKED = 4, BALL_SUCCESS = 8, BALL_SLEEPING = 16;
+
+    // Scalar size of a field: byte order is swapped per scalar
+    template <typename T>
+    constexpr size_t laneBytes() {
+        if constexpr (std::is_same_v<T, glm::vec3>) return sizeof(float);
+        else return sizeof(T);
+    }
+
+    // Copy bytes between host order and little endian
+    void storeLanes(void* dst, const void* src, size_t bytes, size_t lane) {
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(dst, src, bytes);
+        } else {
+            auto* d = static_cast<unsigned char*>(dst);
+            auto* s = static_cast<const unsigned char*>(src);
+            for (size_t i = 0; i < bytes; i += lane) {
+                for (size_t b = 0; b < lane; ++b) d[i + b] = s[i + lane - 1 - b];
+            }
+        }
+    }
+
+    uint64_t checksum(const unsigned char* p, size_t bytes) {
+        uint64_t h = 14695981039346656037ull;
+        for (size_t i = 0; i < bytes; i += 8) {
+            uint64_t w;
+            storeLanes(&w, p + i, sizeof(w), sizeof(w));
+            h = (h ^ w) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    // File size and table checksum from an encoded save's header
+    uint64_t encodedBytes(const uint64_t* save) {
+        uint64_t bytes;
+        storeLanes(&bytes, reinterpret_cast<const unsigned char*>(save) + 16, 8, 8);
+        return bytes;
+    }
+    uint64_t baseTagOf(const uint64_t* save) {
+        uint64_t tag;
+        storeLanes(&tag, reinterpret_cast<const unsigned char*>(save) + 24, 8, 8);
+        return tag;
+    }
+
+    struct BlockEntry {
+        uint32_t tag = 0;
+        uint32_t rows = 0;
+        uint64_t offset = 0;
+        uint64_t bytes = 0;
+        uint64_t checksum = 0;
+    };
+
+    class Writer {
+    public:
+        explicit Writer(std::vector<uint64_t>& out) : out_(out) { out_.clear(); }
+
+        size_t size() const { return size_; }
+        unsigned char* at(size_t offset) { return reinterpret_cast<unsigned char*>(out_.data()) + offset; }
+
+        // Append n zero bytes, returning their offset
+        size_t grow(size_t n) {
+            size_t offset = size_;
+            size_ += n;
+            out_.resize((size_ + 7) / 8, 0);
+            return offset;
+        }
+        void align() { grow((8 - size_ % 8) % 8); }
+
+        template <typename T>
+        void put(const T& v) {
+            size_t offset = grow(sizeof(T));
+            storeLanes(at(offset), &v, sizeof(T), laneBytes<T>());
+        }
+        void put(const std::string& s) {
+            put(static_cast<uint32_t>(s.size()));
+            size_t offset = grow(s.size());
+            std::memcpy(at(offset), s.data(), s.size());
+        }
+
+        // One column: get(row) for every row, then padding to a whole word
+        template <typename T, typename Get>
+        void column(size_t rows, Get&& get) {
+            unsigned char* p = at(grow(rows * sizeof(T)));
+            for (size_t i = 0; i < rows; ++i) {
+                const T v = get(i);
+                storeLanes(p + i * sizeof(T), &v, sizeof(T), laneBytes<T>());
+            }
+            align();
+        }
+
+        // The same in two steps, for blocks with many columns: reserve each column (its
+        // offset is returned), then fill the rows in one pass with store(), so every source
+        // row is read once instead of once per column
+        template <typename T>
+        size_t reserveColumn(size_t rows) {
+            size_t offset = grow(rows * sizeof(T));
+            align();
+            return offset;
+        }
+        template <typename T>
+        void store(size_t column, size_t row, const T& v) {
+            storeLanes(at(column + row * sizeof(T)), &v, sizeof(T), laneBytes<T>());
+        }
+
+        void beginBlock(uint32_t tag, size_t rows) {
+            blocks_.push_back({ tag, static_cast<uint32_t>(rows), size_ });
+        }
+        void endBlock() {
+            align();
+            BlockEntry& b = blocks_.back();
+            b.bytes = size_ - b.offset;
+            b.checksum = checksum(at(b.offset), b.bytes);
+        }
+
+        // Fill in the header and block table reserved at the start
+        void finish() {
+            for (size_t i = 0; i < blocks_.size(); ++i) {
+                const BlockEntry& b = blocks_[i];
+                unsigned char* e = at(HEADER_BYTES + i * TABLE_ENTRY_BYTES);
+                storeLanes(e, &b.tag, 4, 4);
+                storeLanes(e + 4, &b.rows, 4, 4);
+                storeLanes(e + 8, &b.offset, 8, 8);
+                storeLanes(e + 16, &b.bytes, 8, 8);
+                storeLanes(e + 24, &b.checksum, 8, 8);
+            }
+
+            const uint32_t version = SaveGame::VERSION, count = static_cast<uint32_t>(blocks_.size());
+            const uint64_t fileBytes = size_;
+            const uint64_t tableChecksum = checksum(at(HEADER_BYTES), blocks_.size() * TABLE_ENTRY_BYTES);
+            unsigned char* h = at(0);
+            std::memcpy(h, MAGIC, sizeof(MAGIC));
+            storeLanes(h + 4, &version, 4, 4);
+            storeLanes(h + 8, &ENDIAN_TAG, 4, 4);
+            storeLanes(h + 12, &count, 4, 4);
+            storeLanes(h + 16, &fileBytes, 8, 8);
+            storeLanes(h + 24, &tableChecksum, 8, 8);
+        }
+
+    private:
+        std::vector<uint64_t>& out_;
+        size_t size_ = 0;
+        std::vector<BlockEntry> blocks_;
+    };
+
+    class Reader {
+    public:
+        Reader(const unsigned char* p, size_t bytes) : base_(p), p_(p), end_(p + bytes) {}
+
+        template <typename T>
+        void get(T& v) {
+            if (static_cast<size_t>(end_ - p_) < sizeof(T)) { ok_ = false; v = T(); return; }
+            storeLanes(&v, p_, sizeof(T), laneBytes<T>());
+            p_ += sizeof(T);
+        }
+        void get(std::string& s) {
+            uint32_t len = 0;
+            get(len);
+            if (static_cast<size_t>(end_ - p_) < len) { ok_ = false; return; }
+            s.assign(reinterpret_cast<const char*>(p_), len);
+            p_ += len;
+        }
+
+        // One column written by Writer::column: set(row, value) for every row
+        template <typename T, typename Set>
+        void column(size_t rows, Set&& set) {
+            const unsigned char* p = column<T>(rows);
+            if (!p) return;
+            for (size_t i = 0; i < rows; ++i) set(i, load<T>(p, i));
+        }
+
+        // The same in two steps: the start of the column (null if the block is too short),
+        // then load() for each row
+        template <typename T>
+        const unsigned char* column(size_t rows) {
+            if (!ok_ || static_cast<size_t>(end_ - p_) / sizeof(T) < rows) { ok_ = false; return nullptr; }
+            const unsigned char* p = p_;
+            p_ += rows * sizeof(T);
+            p_ += std::min<size_t>((8 - (p_ - base_) % 8) % 8, end_ - p_);
+            return p;
+        }
+        template <typename T>
+        static T load(const unsigned char* column, size_t row) {
+            T v;
+            storeLanes(&v, column + row * sizeof(T), sizeof(T), laneBytes<T>());
+            return v;
+        }
+
+        bool ok() const { return ok_; }
+
+    private:
+        const unsigned char* base_;
+        const unsigned char* p_;
+        const unsigned char* end_;
+        bool ok_ = true;
+    };
+
+    // Validated header and block table of a save in memory
+    struct Parsed {
+        std::vector<BlockEntry> blocks;
+
+        const BlockEntry* find(uint32_t tag) const {
+            for (const BlockEntry& b : blocks) {
+                if (b.tag == tag) return &b;
+            }
+            return nullptr;
+        }
+    };
+
+    bool fail(const char* reason) {
+        std::cerr << "Invalid save: " << reason << std::endl;
+        return false;
+    }
+
+    bool parse(const unsigned char* data, size_t size, Parsed& out) {
+        if (size < HEADER_BYTES || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) return fail("not a save file");
+
+        uint32_t version = 0, endian = 0, count = 0;
+        uint64_t fileBytes = 0, tableChecksum = 0;
+        storeLanes(&version, data + 4, 4, 4);
+        storeLanes(&endian, data + 8, 4, 4);
+        storeLanes(&count, data + 12, 4, 4);
+        storeLanes(&fileBytes, data + 16, 8, 8);
+        storeLanes(&tableChecksum, data + 24, 8, 8);
+
+        if (version != SaveGame::VERSION) {
+            std::cerr << "Invalid save: unsupported version " << version << std::endl;
+            return false;
+        }
+        if (endian != ENDIAN_TAG) return fail("bad endian tag");
+        if (fileBytes != size) return fail("truncated file");
+        if (count > MAX_BLOCKS || HEADER_BYTES + size_t(count) * TABLE_ENTRY_BYTES > size) return fail("bad block table");
+        if (checksum(data + HEADER_BYTES, size_t(count) * TABLE_ENTRY_BYTES) != tableChecksum) return fail("block table checksum mismatch");
+
+        out.blocks.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            BlockEntry& b = out.blocks[i];
+            const unsigned char* e = data + HEADER_BYTES + i * TABLE_ENTRY_BYTES;
+            storeLanes(&b.tag, e, 4, 4);
+            storeLanes(&b.rows, e + 4, 4, 4);
+            storeLanes(&b.offset, e + 8, 8, 8);
+            storeLanes(&b.bytes, e + 16, 8, 8);
+            storeLanes(&b.checksum, e + 24, 8, 8);
+            if (b.offset % 8 || b.bytes % 8 || b.offset > size || b.bytes > size - b.offset) return fail("block out of bounds");
+            if (checksum(data + b.offset, b.bytes) != b.checksum) {
+                char tag[5] = {};
+                std::memcpy(tag, e, 4);
+                std::cerr << "Invalid save: checksum mismatch in block " << tag << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Flush a written file's data through to the disk
+    bool syncFile(std::FILE* file) {
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    // Rename `from` over `to` in one step: `to` is replaced atomically if it exists
+    bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        return MoveFileExW(std::filesystem::path(from).c_str(), std::filesystem::path(to).c_str(),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+
+    bool readFile(const std::string& path, std::vector<uint64_t>& buffer, size_t& size) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open save " << path << std::endl;
+            return false;
+        }
+        size = static_cast<size_t>(file.tellg());
+        buffer.resize((size + 7) / 8);
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(size));
+        if (!file) {
+            std::cerr << "Failed to read save " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+void SaveGame::Snapshot(const Simulation& sim, const std::string& scene, SaveSnapshot& out) {
+    PROFILE_ZONE("SaveGame::Snapshot");
+    const Registry& reg = sim.registry_;
+    const PokemonController& pc = *sim.pokemonController_;
+
+    out.scene = scene;
+    out.seed = sim.seed_;
+    out.rng = sim.rng_;
+    out.physicsAccumulator = sim.physicsAccumulator_;
+    out.player = sim.player_;
+    out.controllerSeed = pc.seed_;
+    out.controllerRng = pc.rng_;
+    out.nextPokemonId = static_cast<int32_t>(pc.nextPokemonId_);
+    out.frame = static_cast<uint32_t>(pc.frame_);
+
+    // Rows of each block in registry order, reserved up front
+    const size_t props = reg.count<Transform, Renderable, Prop>();
+    out.propTransforms.clear();
+    out.propColors.clear();
+    out.props.clear();
+    out.propTransforms.reserve(props);
+    out.propColors.reserve(props);
+    out.props.reserve(props);
+    reg.each<Transform, Renderable, Prop>([&](const Transform& t, const Renderable& r, const Prop& p) {
+        out.propTransforms.push_back(t);
+        out.propColors.push_back(r.color);
+        out.props.push_back(p);
+    });
+
+    std::vector<uint32_t>& rowOf = out.rowOf;
+    rowOf.assign(reg.indexLimit(), NONE);
+    const std::vector<PokemonSpecies>& table = sim.species_;
+    const size_t pokemon = reg.count<Pokemon>();
+    out.pokemon.clear();
+    out.pokemonSpecies.clear();
+    out.pokemon.reserve(pokemon);
+    out.pokemonSpecies.reserve(pokemon);
+    reg.each<Pokemon>([&](Entity e, const Pokemon& p) {
+        rowOf[e.index] = static_cast<uint32_t>(out.pokemon.size());
+        out.pokemon.push_back(p);
+        const PokemonSpecies* s = p.species_;
+        out.pokemonSpecies.push_back(s && s >= table.data() && s < table.data() + table.size() ? static_cast<uint32_t>(s - table.data()) : NONE);
+    });
+
+    const size_t ballRows = reg.count<Transform, Pokeball>();
+    out.ballTransforms.clear();
+    out.balls.clear();
+    out.ballSleeping.clear();
+    out.ballTransforms.reserve(ballRows);
+    out.balls.reserve(ballRows);
+    out.ballSleeping.reserve(ballRows);
+    reg.each<Transform, Pokeball>([&](Entity e, const Transform& t, const Pokeball& b) {
+        rowOf[e.index] = static_cast<uint32_t>(out.balls.size());
+        out.ballTransforms.push_back(t);
+        out.balls.push_back(b);
+        out.ballSleeping.push_back(reg.has<Sleeping>(e));
+    });
+
+    // Entity references as rows
+    auto row = [&](Entity e) { return reg.alive(e) ? rowOf[e.index] : NONE; };
+    const size_t balls = out.balls.size();
+    out.ballSessions.resize(balls);
+    out.ballTargets.resize(balls);
+    for (size_t i = 0; i < balls; ++i) {
+        const CaptureSession* s = pc.captures_.get(out.balls[i].captureSession);
+        out.ballSessions[i] = s ? static_cast<uint32_t>(s - pc.captures_.data()) : NONE;
+        out.ballTargets[i] = row(out.balls[i].targetPokemon);
+    }
+    out.ballOrder.clear();
+    for (size_t i = 0; i < sim.ballOrderCount_; ++i) {
+        Entity e = sim.ballOrder_[(sim.ballOrderHead_ + i) % sim.ballOrder_.size()];
+        if (reg.alive(e)) out.ballOrder.push_back(rowOf[e.index]);
+    }
+
+    const size_t captures = pc.captures_.size();
+    out.captures.assign(pc.captures_.data(), pc.captures_.data() + captures);
+    out.captureBalls.resize(captures);
+    out.capturePokemon.resize(captures);
+    for (size_t i = 0; i < captures; ++i) {
+        out.captureBalls[i] = row(out.captures[i].ball);
+        out.capturePokemon[i] = row(out.captures[i].pokemon);
+    }
+
+    out.inventory.assign(pc.inventory_.begin(), pc.inventory_.end());
+    out.outSlots.resize(pc.out_.size());
+    out.outRows.resize(pc.out_.size());
+    for (size_t i = 0; i < pc.out_.size(); ++i) {
+        out.outSlots[i] = pc.out_[i].slot;
+        out.outRows[i] = row(pc.out_[i].entity);
+    }
+}
+
+void SaveGame::ReserveSnapshot(SaveSnapshot& s) {
+    reserveHeadroom(s.propTransforms);
+    reserveHeadroom(s.propColors);
+    reserveHeadroom(s.props);
+    reserveHeadroom(s.pokemon);
+    reserveHeadroom(s.pokemonSpecies);
+    reserveHeadroom(s.ballTransforms);
+    reserveHeadroom(s.balls);
+    reserveHeadroom(s.ballSleeping);
+    reserveHeadroom(s.ballSessions);
+    reserveHeadroom(s.ballTargets);
+    reserveHeadroom(s.ballOrder);
+    reserveHeadroom(s.captures);
+    reserveHeadroom(s.captureBalls);
+    reserveHeadroom(s.capturePokemon);
+    reserveHeadroom(s.inventory);
+    reserveHeadroom(s.outSlots);
+    reserveHeadroom(s.outRows);
+    reserveHeadroom(s.rowOf);
+}
+
+void SaveGame::Encode(const SaveSnapshot& s, std::vector<uint64_t>& out) {
+    PROFILE_ZONE("SaveGame::Encode");
+    Writer w(out);
+    out.reserve((HEADER_BYTES + BLOCK_COUNT * TABLE_ENTRY_BYTES + 1024
+        + s.props.size() * 64 + s.pokemon.size() * 96 + s.balls.size() * 96 + s.inventory.size() * 16) / 8);
+    w.grow(HEADER_BYTES + BLOCK_COUNT * TABLE_ENTRY_BYTES);
+
+    w.beginBlock(TAG_META, 1);
+    w.put(s.scene);
+    w.put(s.seed);
+    w.put(s.rng.state_);
+    w.put(s.rng.inc_);
+    w.put(s.physicsAccumulator);
+    w.put(s.player.position);
+    w.put(s.player.verticalVelocity);
+    w.put(static_cast<uint8_t>(s.player.grounded));
+    w.put(s.player.eyeHeight);
+    w.put(s.player.radius);
+    w.put(s.player.moveSpeed);
+    w.put(s.controllerSeed);
+    w.put(s.controllerRng.state_);
+    w.put(s.controllerRng.inc_);
+    w.put(s.nextPokemonId);
+    w.put(s.frame);
+    w.endBlock();
+
+    size_t n = s.props.size();
+    w.beginBlock(TAG_PROPS, n);
+    w.column<glm::vec3>(n, [&](size_t i) { return s.propTransforms[i].position; });
+    w.column<glm::vec3>(n, [&](size_t i) { return s.propTransforms[i].scale; });
+    w.column<glm::vec3>(n, [&](size_t i) { return s.propColors[i]; });
+    w.column<glm::vec3>(n, [&](size_t i) { return s.props[i].boxMin; });
+    w.column<glm::vec3>(n, [&](size_t i) { return s.props[i].boxMax; });
+    w.column<uint32_t>(n, [&](size_t i) { return s.props[i].set; });
+    w.endBlock();
+
+    // Pokemon, the bulk of a save: one pass over the rows
+    const std::vector<Pokemon>& pokemon = s.pokemon;
+    n = pokemon.size();
+    w.beginBlock(TAG_POKEMON, n);
+    {
+        const size_t id = w.reserveColumn<int32_t>(n);
+        const size_t slot = w.reserveColumn<int32_t>(n);
+        const size_t species = w.reserveColumn<uint32_t>(n);
+        const size_t position = w.reserveColumn<glm::vec3>(n);
+        const size_t velocity = w.reserveColumn<glm::vec3>(n);
+        const size_t wanderDir = w.reserveColumn<glm::vec3>(n);
+        const size_t speed = w.reserveColumn<float>(n);
+        const size_t radius = w.reserveColumn<float>(n);
+        const size_t directionTime = w.reserveColumn<float>(n);
+        const size_t captureTimer = w.reserveColumn<float>(n);
+        const size_t captureDuration = w.reserveColumn<float>(n);
+        const size_t yRotation = w.reserveColumn<float>(n);
+        const size_t pendingDt = w.reserveColumn<float>(n);
+        const size_t state = w.reserveColumn<uint8_t>(n);
+        const size_t simTier = w.reserveColumn<uint8_t>(n);
+        const size_t visible = w.reserveColumn<uint8_t>(n);
+        const size_t rngState = w.reserveColumn<uint64_t>(n);
+        const size_t rngInc = w.reserveColumn<uint64_t>(n);
+        for (size_t i = 0; i < n; ++i) {
+            const Pokemon& p = pokemon[i];
+            w.store(id, i, static_cast<int32_t>(p.id_));
+            w.store(slot, i, static_cast<int32_t>(p.inventorySlot_));
+            w.store(species, i, s.pokemonSpecies[i]);
+            w.store(position, i, p.position_);
+            w.store(velocity, i, p.velocity_);
+            w.store(wanderDir, i, p.wanderDir_);
+            w.store(speed, i, p.speed_);
+            w.store(radius, i, p.radius_);
+            w.store(directionTime, i, p.timeUntilDirectionChange_);
+            w.store(captureTimer, i, p.captureTimer_);
+            w.store(captureDuration, i, p.captureDuration);
+            w.store(yRotation, i, p.yRotation_);
+            w.store(pendingDt, i, p.pendingDt_);
+            w.store(state, i, static_cast<uint8_t>(p.state_));
+            w.store(simTier, i, static_cast<uint8_t>(p.simTier_));
+            w.store(visible, i, static_cast<uint8_t>(p.visible_));
+            w.store(rngState, i, p.rng_.state_);
+            w.store(rngInc, i, p.rng_.inc_);
+        }
+    }
+    w.endBlock();
+
+    const std::vector<Pokeball>& balls = s.balls;
+    n = balls.size();
+    w.beginBlock(TAG_BALLS, n);
+    w.column<glm::vec3>(n, [&](size_t i) { return s.ballTransforms[i].position; });
+    w.column<glm::vec3>(n, [&](size_t i) { return s.ballTransforms[i].scale; });
+    w.column<glm::vec3>(n, [&](size_t i) { return balls[i].velocity; });
+    w.column<glm::vec3>(n, [&](size_t i) { return balls[i].captureBasePos; });
+    w.column<float>(n, [&](size_t i) { return balls[i].radius; });
+    w.column<float>(n, [&](size_t i) { return balls[i].life; });
+    w.column<float>(n, [&](size_t i) { return balls[i].lockTimer; });
+    w.column<float>(n, [&](size_t i) { return balls[i].shakePhase; });
+    w.column<int32_t>(n, [&](size_t i) { return static_cast<int32_t>(balls[i].restSteps); });
+    w.column<int32_t>(n, [&](size_t i) { return static_cast<int32_t>(balls[i].shakeCount); });
+    w.column<uint32_t>(n, [&](size_t i) { return s.ballSessions[i]; });
+    w.column<uint32_t>(n, [&](size_t i) { return s.ballTargets[i]; });
+    w.column<uint8_t>(n, [&](size_t i) {
+        const Pokeball& b = balls[i];
+        return static_cast<uint8_t>((b.active ? BALL_ACTIVE : 0) | (b.grounded ? BALL_GROUNDED : 0) | (b.locked ? BALL_LOCKED : 0)
+            | (b.captureSuccess ? BALL_SUCCESS : 0) | (s.ballSleeping[i] ? BALL_SLEEPING : 0));
+    });
+    w.endBlock();
+
+    n = s.captures.size();
+    w.beginBlock(TAG_CAPTURES, n);
+    w.column<uint32_t>(n, [&](size_t i) { return s.captureBalls[i]; });
+    w.column<uint32_t>(n, [&](size_t i) { return s.capturePokemon[i]; });
+    w.column<float>(n, [&](size_t i) { return s.captures[i].roll; });
+    w.column<float>(n, [&](size_t i) { return s.captures[i].timer; });
+    w.column<uint8_t>(n, [&](size_t i) { return static_cast<uint8_t>(s.captures[i].success); });
+    w.endBlock();
+
+    n = s.inventory.size();
+    w.beginBlock(TAG_INVENTORY, n);
+    w.column<int32_t>(n, [&](size_t i) { return s.inventory[i].id; });
+    w.column<uint16_t>(n, [&](size_t i) { return s.inventory[i].species; });
+    w.column<float>(n, [&](size_t i) { return s.inventory[i].speed; });
+    w.column<float>(n, [&](size_t i) { return s.inventory[i].radius; });
+    w.endBlock();
+
+    n = s.outSlots.size();
+    w.beginBlock(TAG_OUT, n);
+    w.column<uint32_t>(n, [&](size_t i) { return s.outSlots[i]; });
+    w.column<uint32_t>(n, [&](size_t i) { return s.outRows[i]; });
+    w.endBlock();
+
+    n = s.ballOrder.size();
+    w.beginBlock(TAG_BALL_ORDER, n);
+    w.column<uint32_t>(n, [&](size_t i) { return s.ballOrder[i]; });
+    w.endBlock();
+
+    w.finish();
+}
+
+void SaveGame::Encode(const Simulation& sim, const std::string& scene, std::vector<uint64_t>& out) {
+    SaveSnapshot snapshot;
+    Snapshot(sim, scene, snapshot);
+    Encode(snapshot, out);
+}
+
+size_t SaveGame::EncodeDelta(std::span<const uint64_t> base, std::span<const uint64_t> save, std::vector<uint64_t>& out) {
+    PROFILE_ZONE("SaveGame::EncodeDelta");
+    const size_t words = save.size();
+    size_t size = DELTA_HEADER_BYTES;
+    out.resize((size + words + 16) / 8 + 1);
+    auto* bytes = reinterpret_cast<unsigned char*>(out.data());
+    auto reserve = [&](size_t n) {
+        if (size + n > out.size() * 8) {
+            out.resize((size + n) / 8 + out.size());
+            bytes = reinterpret_cast<unsigned char*>(out.data());
+        }
+    };
+    auto varint = [&](uint64_t v) {
+        reserve(10);
+        do {
+            bytes[size++] = static_cast<unsigned char>((v & 0x7F) | (v >= 0x80 ? 0x80 : 0));
+            v >>= 7;
+        } while (v);
+    };
+
+    // Runs of unchanged words, then changed words as a mask of their changed bytes and those
+    // bytes XORed with the base
+    auto baseWord = [&](size_t i) { return i < base.size() ? base[i] : uint64_t(0); };
+    size_t i = 0;
+    while (i < words) {
+        size_t zeros = 0;
+        while (i + zeros < words && save[i + zeros] == baseWord(i + zeros)) ++zeros;
+        size_t literals = 0;
+        while (i + zeros + literals < words && save[i + zeros + literals] != baseWord(i + zeros + literals)) ++literals;
+        varint(zeros);
+        varint(literals);
+        i += zeros;
+        reserve(literals * 9);
+        for (size_t end = i + literals; i < end; ++i) {
+            const uint64_t x = save[i] ^ baseWord(i);
+            unsigned char word[8];
+            std::memcpy(word, &x, 8);
+            unsigned char& mask = bytes[size++];
+            mask = 0;
+            for (int b = 0; b < 8; ++b) {
+                if (word[b]) {
+                    mask |= static_cast<unsigned char>(1u << b);
+                    bytes[size++] = word[b];
+                }
+            }
+        }
+    }
+
+    const size_t payloadBytes = size - DELTA_HEADER_BYTES;
+    out.resize((size + 7) / 8);
+    bytes = reinterpret_cast<unsigned char*>(out.data());
+    std::memset(bytes + size, 0, out.size() * 8 - size);
+
+    const uint32_t version = SaveGame::VERSION;
+    const uint64_t saveBytes = EncodedBytes(save);
+    const uint64_t baseTag = baseTagOf(base.data());
+    const uint64_t payload = payloadBytes;
+    const uint64_t payloadChecksum = checksum(bytes + DELTA_HEADER_BYTES, out.size() * 8 - DELTA_HEADER_BYTES);
+    std::memcpy(bytes, DELTA_MAGIC, sizeof(DELTA_MAGIC));
+    storeLanes(bytes + 4, &version, 4, 4);
+    storeLanes(bytes + 8, &saveBytes, 8, 8);
+    storeLanes(bytes + 16, &baseTag, 8, 8);
+    storeLanes(bytes + 24, &payload, 8, 8);
+    storeLanes(bytes + 32, &payloadChecksum, 8, 8);
+    return out.size() * 8;
+}
+
+bool SaveGame::ApplyDelta(std::span<const uint64_t> base, const void* delta, size_t size, std::vector<uint64_t>& out) {
+    PROFILE_ZONE("SaveGame::ApplyDelta");
+    const auto* bytes = static_cast<const unsigned char*>(delta);
+    if (size < DELTA_HEADER_BYTES || size % 8 || std::memcmp(bytes, DELTA_MAGIC, sizeof(DELTA_MAGIC)) != 0) return fail("not a save delta");
+
+    uint32_t version = 0;
+    uint64_t saveBytes = 0, baseTag = 0, payloadBytes = 0, payloadChecksum = 0;
+    storeLanes(&version, bytes + 4, 4, 4);
+    storeLanes(&saveBytes, bytes + 8, 8, 8);
+    storeLanes(&baseTag, bytes + 16, 8, 8);
+    storeLanes(&payloadBytes, bytes + 24, 8, 8);
+    storeLanes(&payloadChecksum, bytes + 32, 8, 8);
+    if (version != SaveGame::VERSION) return fail("unsupported delta version");
+    if (saveBytes < HEADER_BYTES || payloadBytes > size - DELTA_HEADER_BYTES) return fail("bad delta size");
+    if (base.size() * 8 < HEADER_BYTES || baseTag != baseTagOf(base.data())) return fail("delta made against a different save");
+    if (checksum(bytes + DELTA_HEADER_BYTES, size - DELTA_HEADER_BYTES) != payloadChecksum) return fail("delta checksum mismatch");
+
+    const size_t words = (saveBytes + 7) / 8;
+    out.assign(words, 0);
+    std::copy_n(base.begin(), std::min(words, base.size()), out.begin());
+
+    const unsigned char* p = bytes + DELTA_HEADER_BYTES;
+    const unsigned char* end = p + payloadBytes;
+    bool ok = true;
+    auto varint = [&]() {
+        uint64_t v = 0;
+        for (int shift = 0; ok; shift += 7) {
+            if (p == end || shift > 63) { ok = false; break; }
+            const unsigned char b = *p++;
+            v |= uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        return v;
+    };
+
+    size_t at = 0;
+    while (ok && p < end) {
+        const uint64_t zeros = varint();
+        const uint64_t literals = varint();
+        if (!ok || zeros > words - at || literals > words - at - zeros) return fail("delta out of bounds");
+        at += zeros;
+        for (uint64_t k = 0; k < literals; ++k, ++at) {
+            if (p == end) return fail("delta out of bounds");
+            const unsigned char mask = *p++;
+            unsigned char word[8] = {};
+            for (int b = 0; b < 8; ++b) {
+                if (mask & (1u << b)) {
+                    if (p == end) return fail("delta out of bounds");
+                    word[b] = *p++;
+                }
+            }
+            uint64_t x;
+            std::memcpy(&x, word, 8);
+            out[at] ^= x;
+        }
+    }
+    if (!ok) return fail("delta out of bounds");
+    return true;
+}
+
+bool SaveGame::Decode(const void* data, size_t size, Simulation& sim, std::span<Model* const> propModels) {
+    PROFILE_ZONE("SaveGame::Decode");
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    Parsed parsed;
+    if (!parse(bytes, size, parsed)) return false;
+
+    const BlockEntry* blocks[REQUIRED_BLOCKS] = {
+        parsed.find(TAG_META), parsed.find(TAG_PROPS), parsed.find(TAG_POKEMON), parsed.find(TAG_BALLS),
+        parsed.find(TAG_CAPTURES), parsed.find(TAG_INVENTORY), parsed.find(TAG_OUT)
+    };
+    for (const BlockEntry* b : blocks) {
+        if (!b) return fail("missing block");
+    }
+    auto reader = [&](const BlockEntry* b) { return Reader(bytes + b->offset, b->bytes); };
+
+    Registry& reg = sim.registry_;
+    PokemonController& pc = *sim.pokemonController_;
+    const std::vector<PokemonSpecies>& species = sim.species_;
+
+    // Scalars
+    Reader meta = reader(blocks[0]);
+    std::string scene;
+    uint64_t seed = 0;
+    meta.get(scene);
+    meta.get(seed);
+    sim.setSeed(seed);
+    meta.get(sim.rng_.state_);
+    meta.get(sim.rng_.inc_);
+    meta.get(sim.physicsAccumulator_);
+    PlayerState& player = sim.player_;
+    uint8_t grounded = 0;
+    meta.get(player.position);
+    meta.get(player.verticalVelocity);
+    meta.get(grounded);
+    player.grounded = grounded != 0;
+    meta.get(player.eyeHeight);
+    meta.get(player.radius);
+    meta.get(player.moveSpeed);
+    int32_t nextId = 1;
+    uint32_t frame = 0;
+    meta.get(pc.seed_);
+    meta.get(pc.rng_.state_);
+    meta.get(pc.rng_.inc_);
+    meta.get(nextId);
+    meta.get(frame);
+    pc.nextPokemonId_ = nextId;
+    pc.frame_ = frame;
+    if (!meta.ok()) return fail("truncated META block");
+
+    // Props, with their collision boxes
+    size_t n = blocks[1]->rows;
+    {
+        std::vector<Transform> transforms(n);
+        std::vector<Renderable> renderables(n);
+        std::vector<Prop> props(n);
+        Reader in = reader(blocks[1]);
+        in.column<glm::vec3>(n, [&](size_t i, const glm::vec3& v) { transforms[i].position = v; });
+        in.column<glm::vec3>(n, [&](size_t i, const glm::vec3& v) { transforms[i].scale = v; });
+        in.column<glm::vec3>(n, [&](size_t i, const glm::vec3& v) { renderables[i].color = v; });
+        in.column<glm::vec3>(n, [&](size_t i, const glm::vec3& v) { props[i].boxMin = v; });
+        in.column<glm::vec3>(n, [&](size_t i, const glm::vec3& v) { props[i].boxMax = v; });
+        in.column<uint32_t>(n, [&](size_t i, uint32_t v) { props[i].set = v; });
+        if (!in.ok()) return fail("truncated PROP block");
+
+        reg.reserve<Transform, Renderable, Prop>(n);
+        for (size_t i = 0; i < n; ++i) {
+            const Transform& t = transforms[i];
+            renderables[i].model = props[i].set < propModels.size() ? propModels[props[i].set] : nullptr;
+            sim.collision_->addBox(t.position + t.scale * props[i].boxMin, t.position + t.scale * props[i].boxMax);
+            reg.create(t, renderables[i], props[i]);
+        }
+    }
+    sim.ballCollisionVersion_ = sim.collision_->version();
+
+    // Pokemon: each is constructed from its identity columns, the rest of its state filled
+    // in, and created in one pass over the rows
+    n = blocks[2]->rows;
+    std::vector<Entity> pokemonEntities(n);
+    {
+        Reader in = reader(blocks[2]);
+        const unsigned char* id = in.column<int32_t>(n);
+        const unsigned char* slot = in.column<int32_t>(n);
+        const unsigned char* speciesRow = in.column<uint32_t>(n);
+        const unsigned char* position = in.column<glm::vec3>(n);
+        const unsigned char* velocity = in.column<glm::vec3>(n);
+        const unsigned char* wanderDir = in.column<glm::vec3>(n);
+        const unsigned char* speed = in.column<float>(n);
+        const unsigned char* radius = in.column<float>(n);
+        const unsigned char* directionTime = in.column<float>(n);
+        const unsigned char* captureTimer = in.column<float>(n);
+        const unsigned char* captureDuration = in.column<float>(n);
+        const unsigned char* yRotation = in.column<float>(n);
+        const unsigned char* pendingDt = in.column<float>(n);
+        const unsigned char* state = in.column<uint8_t>(n);
+        const unsigned char* simTier = in.column<uint8_t>(n);
+        const unsigned char* visible = in.column<uint8_t>(n);
+        const unsigned char* rngState = in.column<uint64_t>(n);
+        const unsigned char* rngInc = in.column<uint64_t>(n);
+        if (!in.ok()) return fail("truncated PKMN block");
+
+        reg.reserve<Pokemon>(n);
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t s = Reader::load<uint32_t>(speciesRow, i);
+            Pokemon p(s < species.size() ? &species[s] : nullptr, glm::vec3(0.0f), 2.0f, 0.5f,
+                Reader::load<int32_t>(id, i), pc.seed_);
+            p.inventorySlot_ = Reader::load<int32_t>(slot, i);
+            p.position_ = Reader::load<glm::vec3>(position, i);
+            p.velocity_ = Reader::load<glm::vec3>(velocity, i);
+            p.wanderDir_ = Reader::load<glm::vec3>(wanderDir, i);
+            p.speed_ = Reader::load<float>(speed, i);
+            p.radius_ = Reader::load<float>(radius, i);
+            p.timeUntilDirectionChange_ = Reader::load<float>(directionTime, i);
+            p.captureTimer_ = Reader::load<float>(captureTimer, i);
+            p.captureDuration = Reader::load<float>(captureDuration, i);
+            p.yRotation_ = Reader::load<float>(yRotation, i);
+            p.pendingDt_ = Reader::load<float>(pendingDt, i);
+            p.state_ = static_cast<PokemonState>(std::min<uint8_t>(Reader::load<uint8_t>(state, i), uint8_t(PokemonState::CaptureFailed)));
+            p.simTier_ = static_cast<SimTier>(std::min<uint8_t>(Reader::load<uint8_t>(simTier, i), uint8_t(SimTier::Far)));
+            p.visible_ = Reader::load<uint8_t>(visible, i) != 0;
+            p.rng_.state_ = Reader::load<uint64_t>(rngState, i);
+            p.rng_.inc_ = Reader::load<uint64_t>(rngInc, i);
+            pokemonEntities[i] = reg.create(std::move(p));
+        }
+    }
+    auto pokemonAt = [&](uint32_t row) { return row < pokemonEntities.size() ? pokemonEntities[row] : Entity{}; };
+
+    // Pokeballs. Capture sessions are linked once they exist.
+    n = blocks[3]->rows;
+    std::vector<Entity> ballEntities(n);
+    std::vector<uint32_t> ballSessions(n);
+    {
+        std::vector<Transform> transforms(n);
+        std::vector<Pokeball> balls(n);
+        std::vector<uint8_t> flags(n);
+        Reader in = reader(blocks[3]);
+        in.column<glm::vec3>(n, [&](size_t i, const glm::vec3& v) { transforms[i].position = v; });
+        in.column<glm::vec3>(n, [&](size_t i, const glm::vec3& v) { transforms[i].scale = v; });
+        in.column<glm::vec3>(n, [&](size_t i, const glm::vec3& v) { balls[i].velocity = v; });
+        in.column<glm::vec3>(n, [&](size_t i, const glm::vec3& v) { balls[i].captureBasePos = v; });
+        in.column<float>(n, [&](size_t i, float v) { balls[i].radius = v; });
+        in.column<float>(n, [&](size_t i, float v) { balls[i].life = v; });
+        in.column<float>(n, [&](size_t i, float v) { balls[i].lockTimer = v; });
+        in.column<float>(n, [&](size_t i, float v) { balls[i].shakePhase = v; });
+        in.column<int32_t>(n, [&](size_t i, int32_t v) { balls[i].restSteps = v; });
+        in.column<int32_t>(n, [&](size_t i, int32_t v) { balls[i].shakeCount = v; });
+        in.column<uint32_t>(n, [&](size_t i, uint32_t v) { ballSessions[i] = v; });
+        in.column<uint32_t>(n, [&](size_t i, uint32_t v) { balls[i].targetPokemon = pokemonAt(v); });
+        in.column<uint8_t>(n, [&](size_t i, uint8_t v) { flags[i] = v; });
+        if (!in.ok()) return fail("truncated BALL block");
+
+        for (size_t i = 0; i < n; ++i) {
+            Pokeball& b = balls[i];
+            b.active = flags[i] & BALL_ACTIVE;
+            b.grounded = flags[i] & BALL_GROUNDED;
+            b.locked = flags[i] & BALL_LOCKED;
+            b.captureSuccess = flags[i] & BALL_SUCCESS;
+            ballEntities[i] = (flags[i] & BALL_SLEEPING) ? reg.create(transforms[i], b, Sleeping{}) : reg.create(transforms[i], b);
+        }
+        sim.ballPool_.highWater = std::max(sim.ballPool_.highWater, n);
+
+        // Throw order. Without it, every ball started with the same life, so the ones with
+        // the least left are the oldest.
+        std::vector<Entity> order;
+        if (const BlockEntry* b = parsed.find(TAG_BALL_ORDER)) {
+            order.reserve(n);
+            Reader orderIn = reader(b);
+            orderIn.column<uint32_t>(b->rows, [&](size_t, uint32_t v) { if (v < n) order.push_back(ballEntities[v]); });
+            if (!orderIn.ok()) return fail("truncated BORD block");
+        } else {
+            std::vector<uint32_t> rows(n);
+            std::iota(rows.begin(), rows.end(), 0u);
+            std::stable_sort(rows.begin(), rows.end(), [&](uint32_t a, uint32_t c) { return balls[a].life < balls[c].life; });
+            for (uint32_t row : rows) order.push_back(ballEntities[row]);
+        }
+        sim.resetBallOrder(order);
+    }
+
+    // Capture sessions, in their saved order
+    n = blocks[4]->rows;
+    {
+        std::vector<CaptureSession> sessions(n);
+        Reader in = reader(blocks[4]);
+        in.column<uint32_t>(n, [&](size_t i, uint32_t v) { sessions[i].ball = v < ballEntities.size() ? ballEntities[v] : Entity{}; });
+        in.column<uint32_t>(n, [&](size_t i, uint32_t v) { sessions[i].pokemon = pokemonAt(v); });
+        in.column<float>(n, [&](size_t i, float v) { sessions[i].roll = v; });
+        in.column<float>(n, [&](size_t i, float v) { sessions[i].timer = v; });
+        in.column<uint8_t>(n, [&](size_t i, uint8_t v) { sessions[i].success = v != 0; });
+        if (!in.ok()) return fail("truncated CAPT block");
+
+        std::vector<Handle> handles(n);
+        for (size_t i = 0; i < n; ++i) handles[i] = pc.captures_.insert(sessions[i]);
+        for (size_t i = 0; i < ballEntities.size(); ++i) {
+            if (ballSessions[i] < n) reg.get<Pokeball>(ballEntities[i])->captureSession = handles[ballSessions[i]];
+        }
+    }
+
+    // Inventory and the Pokemon sent out from it
+    n = blocks[5]->rows;
+    {
+        std::vector<InventoryEntry> inventory(n);
+        Reader in = reader(blocks[5]);
+        in.column<int32_t>(n, [&](size_t i, int32_t v) { inventory[i].id = v; });
+        in.column<uint16_t>(n, [&](size_t i, uint16_t v) { inventory[i].species = v; });
+        in.column<float>(n, [&](size_t i, float v) { inventory[i].speed = v; });
+        in.column<float>(n, [&](size_t i, float v) { inventory[i].radius = v; });
+        if (!in.ok()) return fail("truncated INVE block");
+        pc.inventory_ = std::move(inventory);
+    }
+
+    n = blocks[6]->rows;
+    {
+        std::vector<PokemonController::OutPokemon> out(n);
+        Reader in = reader(blocks[6]);
+        in.column<uint32_t>(n, [&](size_t i, uint32_t v) { out[i].slot = v; });
+        in.column<uint32_t>(n, [&](size_t i, uint32_t v) { out[i].entity = pokemonAt(v); });
+        if (!in.ok()) return fail("truncated OUTP block");
+        pc.out_ = std::move(out);
+    }
+    return true;
+}
+
+size_t SaveGame::EncodedBytes(std::span<const uint64_t> save) {
+    return save.size() * sizeof(uint64_t) >= HEADER_BYTES ? static_cast<size_t>(encodedBytes(save.data())) : 0;
+}
+
+bool SaveGame::WriteFile(const std::string& path, std::span<const uint64_t> data, size_t bytes) {
+    PROFILE_ZONE("SaveGame::WriteFile");
+    // Write next to the target, flush that to the disk and rename it over the target, so
+    // `path` holds either the old file or the new one, even after a crash
+    const std::string temp = path + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    if (!file) return false;
+    const size_t size = std::min(bytes, data.size_bytes());
+    bool ok = std::fwrite(data.data(), 1, size, file) == size && std::fflush(file) == 0 && syncFile(file);
+    ok = std::fclose(file) == 0 && ok;
+    ok = ok && replaceFile(temp, path);
+    if (!ok) std::remove(temp.c_str());
+    return ok;
+}
+
+bool SaveGame::Save(const Simulation& sim, const std::string& scene, const std::string& path) {
+    std::vector<uint64_t> data;
+    Encode(sim, scene, data);
+    return WriteFile(path, data, EncodedBytes(data));
+}
+
+bool SaveGame::Load(const std::string& path, Simulation& sim, std::span<Model* const> propModels) {
+    std::vector<uint64_t> buffer;
+    size_t size = 0;
+    if (!readFile(path, buffer, size)) return false;
+
+    // A newer state saved as a delta against this file
+    const std::string deltaPath = path + ".delta";
+    std::vector<uint64_t> delta;
+    size_t deltaSize = 0;
+    if (std::ifstream(deltaPath).good() && readFile(deltaPath, delta, deltaSize)) {
+        std::vector<uint64_t> applied;
+        if (size >= HEADER_BYTES && ApplyDelta(buffer, delta.data(), deltaSize, applied)) {
+            size = encodedBytes(applied.data());
+            buffer.swap(applied);
+        } else {
+            std::cerr << "Ignoring " << deltaPath << std::endl;
+        }
+    }
+    return Decode(buffer.data(), size, sim, propModels);
+}
+
+bool SaveGame::ReadInfo(const std::string& path, SaveInfo& out) {
+    std::vector<uint64_t> buffer;
+    size_t size = 0;
+    if (!readFile(path, buffer, size)) return false;
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(buffer.data());
+    Parsed parsed;
+    if (!parse(bytes, size, parsed)) return false;
+    const BlockEntry* meta = parsed.find(TAG_META);
+    if (!meta) return fail("missing block");
+
+    Reader in(bytes + meta->offset, meta->bytes);
+    out = SaveInfo();
+    out.version = VERSION;
+    in.get(out.scene);
+    in.get(out.seed);
+    if (!in.ok()) return fail("truncated META block");
+
+    auto rows = [&](uint32_t tag) { const BlockEntry* b = parsed.find(tag); return b ? size_t(b->rows) : size_t(0); };
+    out.props = rows(TAG_PROPS);
+    out.pokemon = rows(TAG_POKEMON);
+    out.pokeballs = rows(TAG_BALLS);
+    out.inventory = rows(TAG_INVENTORY);
+    return true;
+}
+
+} // namespace pokepp
@@ -0,0 +1,430 @@
+#include "pokeapp/Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+/*
+	Implementation of Scene loading and saving. See Scene.h for the text format.
+
+	The text parser streams the file in fixed-size chunks and tokenizes each line in place,
+	so even large scene files load without building an intermediate tree.
+
+	Binary layout ("PPSC", version byte, then the fields of Scene in declaration order).
+	Strings are a uint16 length and bytes, lists a uint32 count; numbers are stored in host
+	(little endian) order.
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr char BINARY_MAGIC[4] = { 'P', 'P', 'S', 'C' };
+    constexpr uint8_t BINARY_VERSION = 1;
+    constexpr size_t READ_CHUNK = 64 * 1024;
+    constexpr float SQUARE_METERS_PER_HECTARE = 10000.0f;
+
+    // --- Text form ---
+
+    bool parseFloat(std::string_view s, float& out) {
+        char buf[64];
+        if (s.empty() || s.size() >= sizeof(buf)) return false;
+        std::memcpy(buf, s.data(), s.size());
+        buf[s.size()] = '\0';
+        char* end = nullptr;
+        out = std::strtof(buf, &end);
+        return end == buf + s.size();
+    }
+
+    bool parseInt(std::string_view s, int& out) {
+        char buf[32];
+        if (s.empty() || s.size() >= sizeof(buf)) return false;
+        std::memcpy(buf, s.data(), s.size());
+        buf[s.size()] = '\0';
+        char* end = nullptr;
+        long v = std::strtol(buf, &end, 10);
+        out = static_cast<int>(v);
+        return end == buf + s.size() && v >= 0;
+    }
+
+    // Exactly n comma separated floats
+    bool parseFloats(std::string_view s, float* out, int n) {
+        for (int i = 0; i < n; ++i) {
+            size_t comma = (i + 1 < n) ? s.find(',') : std::string_view::npos;
+            if ((i + 1 < n) && comma == std::string_view::npos) return false;
+            if (!parseFloat(s.substr(0, comma), out[i])) return false;
+            if (comma != std::string_view::npos) s.remove_prefix(comma + 1);
+        }
+        return true;
+    }
+
+    bool parseVec2(std::string_view s, glm::vec2& v) { return parseFloats(s, &v.x, 2); }
+    bool parseVec3(std::string_view s, glm::vec3& v) { return parseFloats(s, &v.x, 3); }
+
+    struct KeyValue {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    // Outcome of applying one key to a directive
+    enum class KeyResult { Ok, BadValue, UnknownKey };
+
+    KeyResult check(bool ok) { return ok ? KeyResult::Ok : KeyResult::BadValue; }
+
+    KeyResult applyWorld(SceneWorld& w, const KeyValue& kv) {
+        if (kv.key == "heightmap") { w.heightmap = kv.value; return KeyResult::Ok; }
+        if (kv.key == "cell") return check(parseFloat(kv.value, w.cellSize));
+        if (kv.key == "height") return check(parseFloat(kv.value, w.heightScale));
+        return KeyResult::UnknownKey;
+    }
+
+    KeyResult applySpecies(SceneSpecies& s, const KeyValue& kv) {
+        if (kv.key == "name") { s.name = kv.value; return KeyResult::Ok; }
+        if (kv.key == "model") { s.model = kv.value; return KeyResult::Ok; }
+        if (kv.key == "color") return check(parseVec3(kv.value, s.color));
+        if (kv.key == "scale") return check(parseFloat(kv.value, s.displayScale));
+        if (kv.key == "catch") return check(parseFloat(kv.value, s.catchRate));
+        return KeyResult::UnknownKey;
+    }
+
+    KeyResult applyProps(ScenePropSet& p, const KeyValue& kv) {
+        if (kv.key == "kind") { p.kind = kv.value; return KeyResult::Ok; }
+        if (kv.key == "model") { p.model = kv.value; return KeyResult::Ok; }
+        if (kv.key == "count") return check(parseInt(kv.value, p.count));
+        if (kv.key == "density") return check(parseFloat(kv.value, p.density));
+        if (kv.key == "range") return check(parseFloat(kv.value, p.range));
+        if (kv.key == "margin") return check(parseFloat(kv.value, p.margin));
+        if (kv.key == "flat") return check(parseFloat(kv.value, p.minNormalY));
+        if (kv.key == "scale_xz") return check(parseVec2(kv.value, p.scaleXZ));
+        if (kv.key == "scale_y") return check(parseVec2(kv.value, p.scaleY));
+        if (kv.key == "box_min") return check(parseVec3(kv.value, p.boxMin));
+        if (kv.key == "box_max") return check(parseVec3(kv.value, p.boxMax));
+        if (kv.key == "color") return check(parseVec3(kv.value, p.color));
+        return KeyResult::UnknownKey;
+    }
+
+    KeyResult applyPokemon(ScenePokemonSpawn& s, const KeyValue& kv) {
+        if (kv.key == "count") return check(parseInt(kv.value, s.count));
+        if (kv.key == "density") return check(parseFloat(kv.value, s.density));
+        if (kv.key == "range") return check(parseFloat(kv.value, s.range));
+        if (kv.key == "margin") return check(parseFloat(kv.value, s.margin));
+        if (kv.key == "flat") return check(parseFloat(kv.value, s.minNormalY));
+        if (kv.key == "speed") return check(parseVec2(kv.value, s.speed));
+        if (kv.key == "radius") return check(parseVec2(kv.value, s.radius));
+        return KeyResult::UnknownKey;
+    }
+
+    KeyResult applyBalls(Scene& scene, const KeyValue& kv) {
+        if (kv.key == "count") return check(parseInt(kv.value, scene.balls));
+        return KeyResult::UnknownKey;
+    }
+
+    bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    class TextParser {
+    public:
+        TextParser(const std::string& path, Scene& scene) : path_(path), scene_(scene) {}
+
+        bool parseLine(std::string_view line) {
+            lineNo_++;
+
+            size_t hash = line.find('#');
+            if (hash != std::string_view::npos) line = line.substr(0, hash);
+
+            // Split into the directive and its key=value pairs
+            std::string_view directive;
+            pairs_.clear();
+            while (!line.empty()) {
+                while (!line.empty() && isSpace(line.front())) line.remove_prefix(1);
+                size_t len = 0;
+                while (len < line.size() && !isSpace(line[len])) len++;
+                if (len == 0) break;
+
+                std::string_view token = line.substr(0, len);
+                line.remove_prefix(len);
+
+                if (directive.empty()) {
+                    directive = token;
+                    continue;
+                }
+                size_t eq = token.find('=');
+                if (eq == std::string_view::npos || eq == 0) return fail("expected key=value, got", token);
+                pairs_.push_back({ token.substr(0, eq), token.substr(eq + 1) });
+            }
+            if (directive.empty()) return true;
+
+            if (directive == "world") return applyAll(directive, [&](const KeyValue& kv) { return applyWorld(scene_.world, kv); });
+            if (directive == "species") {
+                scene_.species.emplace_back();
+                if (!applyAll(directive, [&](const KeyValue& kv) { return applySpecies(scene_.species.back(), kv); })) return false;
+                if (scene_.species.back().name.empty()) return fail("species needs a", "name");
+                return true;
+            }
+            if (directive == "props") {
+                scene_.props.emplace_back();
+                return applyAll(directive, [&](const KeyValue& kv) { return applyProps(scene_.props.back(), kv); });
+            }
+            if (directive == "pokemon") {
+                scene_.pokemon.emplace_back();
+                return applyAll(directive, [&](const KeyValue& kv) { return applyPokemon(scene_.pokemon.back(), kv); });
+            }
+            if (directive == "balls") return applyAll(directive, [&](const KeyValue& kv) { return applyBalls(scene_, kv); });
+
+            return fail("unknown directive", directive);
+        }
+
+    private:
+        template <typename Apply>
+        bool applyAll(std::string_view directive, Apply&& apply) {
+            for (const KeyValue& kv : pairs_) {
+                switch (apply(kv)) {
+                case KeyResult::Ok: break;
+                case KeyResult::BadValue: return fail("bad value for", kv.key);
+                case KeyResult::UnknownKey: return fail(std::string(directive).append(" has no key").c_str(), kv.key);
+                }
+            }
+            return true;
+        }
+
+        bool fail(const char* message, std::string_view what) {
+            std::cerr << path_ << ":" << lineNo_ << ": " << message << " '" << what << "'" << std::endl;
+            return false;
+        }
+
+        const std::string& path_;
+        Scene& scene_;
+        int lineNo_ = 0;
+        std::vector<KeyValue> pairs_;
+    };
+
+    // Feed the file through the parser chunk by chunk; a line split across chunks is
+    // carried over in `partial`
+    bool loadText(std::ifstream& file, const std::string& path, Scene& out) {
+        TextParser parser(path, out);
+        std::vector<char> chunk(READ_CHUNK);
+        std::string partial;
+
+        while (file) {
+            file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            size_t n = static_cast<size_t>(file.gcount());
+            if (n == 0) break;
+
+            size_t start = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (chunk[i] != '\n') continue;
+
+                std::string_view line(chunk.data() + start, i - start);
+                if (!partial.empty()) {
+                    partial.append(line);
+                    line = partial;
+                }
+                if (!parser.parseLine(line)) return false;
+                partial.clear();
+                start = i + 1;
+            }
+            partial.append(chunk.data() + start, n - start);
+        }
+        return partial.empty() || parser.parseLine(partial);
+    }
+
+    // --- Binary form ---
+
+    class Writer {
+    public:
+        template <typename T>
+        void put(const T& v) {
+            const char* p = reinterpret_cast<const char*>(&v);
+            data_.insert(data_.end(), p, p + sizeof(T));
+        }
+        void put(const std::string& s) {
+            put(static_cast<uint16_t>(s.size()));
+            data_.insert(data_.end(), s.begin(), s.end());
+        }
+        const std::vector<char>& data() const { return data_; }
+
+    private:
+        std::vector<char> data_;
+    };
+
+    class Reader {
+    public:
+        Reader(const char* p, const char* end) : p_(p), end_(end) {}
+
+        template <typename T>
+        void get(T& v) {
+            if (static_cast<size_t>(end_ - p_) < sizeof(T)) { ok_ = false; v = T(); return; }
+            std::memcpy(&v, p_, sizeof(T));
+            p_ += sizeof(T);
+        }
+        void get(std::string& s) {
+            uint16_t len = 0;
+            get(len);
+            if (static_cast<size_t>(end_ - p_) < len) { ok_ = false; return; }
+            s.assign(p_, len);
+            p_ += len;
+        }
+        // Element count of a list, rejecting counts the remaining bytes cannot hold
+        uint32_t count(size_t minElementSize) {
+            uint32_t n = 0;
+            get(n);
+            if (n > static_cast<size_t>(end_ - p_) / minElementSize) { ok_ = false; return 0; }
+            return n;
+        }
+        bool ok() const { return ok_; }
+
+    private:
+        const char* p_;
+        const char* end_;
+        bool ok_ = true;
+    };
+
+    bool loadBinary(const std::vector<char>& data, const std::string& path, Scene& out) {
+        Reader in(data.data() + sizeof(BINARY_MAGIC), data.data() + data.size());
+
+        uint8_t version = 0;
+        in.get(version);
+        if (version != BINARY_VERSION) {
+            std::cerr << path << ": unsupported scene version " << int(version) << std::endl;
+            return false;
+        }
+
+        in.get(out.world.heightmap);
+        in.get(out.world.cellSize);
+        in.get(out.world.heightScale);
+
+        out.species.resize(in.count(4));
+        for (SceneSpecies& s : out.species) {
+            in.get(s.name);
+            in.get(s.model);
+            in.get(s.color);
+            in.get(s.displayScale);
+            in.get(s.catchRate);
+        }
+
+        out.props.resize(in.count(4));
+        for (ScenePropSet& p : out.props) {
+            in.get(p.kind);
+            in.get(p.model);
+            in.get(p.count);
+            in.get(p.density);
+            in.get(p.range);
+            in.get(p.margin);
+            in.get(p.minNormalY);
+            in.get(p.scaleXZ);
+            in.get(p.scaleY);
+            in.get(p.boxMin);
+            in.get(p.boxMax);
+            in.get(p.color);
+        }
+
+        out.pokemon.resize(in.count(4));
+        for (ScenePokemonSpawn& s : out.pokemon) {
+            in.get(s.count);
+            in.get(s.density);
+            in.get(s.range);
+            in.get(s.margin);
+            in.get(s.minNormalY);
+            in.get(s.speed);
+            in.get(s.radius);
+        }
+
+        in.get(out.balls);
+
+        if (!in.ok()) {
+            std::cerr << path << ": truncated scene file" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+bool Scene::Load(const std::string& path, Scene& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open scene " << path << std::endl;
+        return false;
+    }
+
+    out = Scene();
+
+    char magic[sizeof(BINARY_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    bool binary = file.gcount() == sizeof(magic) && std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+
+    if (binary) {
+        file.seekg(0, std::ios::end);
+        std::vector<char> data(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(data.data(), static_cast<std::streamsize>(data.size()));
+        return loadBinary(data, path, out);
+    }
+
+    file.clear();
+    file.seekg(0);
+    return loadText(file, path, out);
+}
+
+bool Scene::saveBinary(const std::string& path) const {
+    Writer w;
+    for (char c : BINARY_MAGIC) w.put(c);
+    w.put(BINARY_VERSION);
+
+    w.put(world.heightmap);
+    w.put(world.cellSize);
+    w.put(world.heightScale);
+
+    w.put(static_cast<uint32_t>(species.size()));
+    for (const SceneSpecies& s : species) {
+        w.put(s.name);
+        w.put(s.model);
+        w.put(s.color);
+        w.put(s.displayScale);
+        w.put(s.catchRate);
+    }
+
+    w.put(static_cast<uint32_t>(props.size()));
+    for (const ScenePropSet& p : props) {
+        w.put(p.kind);
+        w.put(p.model);
+        w.put(p.count);
+        w.put(p.density);
+        w.put(p.range);
+        w.put(p.margin);
+        w.put(p.minNormalY);
+        w.put(p.scaleXZ);
+        w.put(p.scaleY);
+        w.put(p.boxMin);
+        w.put(p.boxMax);
+        w.put(p.color);
+    }
+
+    w.put(static_cast<uint32_t>(pokemon.size()));
+    for (const ScenePokemonSpawn& s : pokemon) {
+        w.put(s.count);
+        w.put(s.density);
+        w.put(s.range);
+        w.put(s.margin);
+        w.put(s.minNormalY);
+        w.put(s.speed);
+        w.put(s.radius);
+    }
+
+    w.put(balls);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file.write(w.data().data(), static_cast<std::streamsize>(w.data().size()));
+    return static_cast<bool>(file);
+}
+
+int spawnCount(int count, float density, float range, float margin) {
+    if (density <= 0.0f) return count;
+    float side = 2.0f * std::max(0.0f, range - margin);
+    return static_cast<int>(std::lround(density * side * side / SQUARE_METERS_PER_HECTARE));
+}
+
+} // namespace pokepp
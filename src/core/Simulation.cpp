@@ -0,0 +1,643 @@
+#include "pokeapp/Simulation.h"
+#include "pokeapp/Constants.h"
+#include "pokeapp/World.h"
+#include "pokeapp/CollisionWorld.h"
+#include "pokeapp/PokemonController.h"
+#include "pokeapp/Navigation.h"
+#include "pokeapp/ThreadPool.h"
+#include "pokeapp/Profiler.h"
+#include "pokeapp/Memory.h"
+#include "pokeapp/FrameArena.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+
+/*
+	Implementation of the Simulation class. Contains the gameplay logic that used to live in
+	App: pokeball physics and captures, Pokemon updates and player movement.
+*/
+
+using namespace pokepp::constants;
+
+namespace pokepp {
+
+Simulation::Simulation()
+	: collision_(std::make_unique<CollisionWorld>()),
+	  pokemonController_(std::make_unique<PokemonController>(registry_)) {
+	setPokeballPool(POKEBALL_POOL_CAPACITY, PokeballOverflow::RecycleOldest);
+}
+
+Simulation::~Simulation() = default;
+
+namespace {
+	// 64-bit FNV-1a over the raw bytes of the state
+	struct StateHasher {
+		uint64_t h = 14695981039346656037ull;
+
+		void bytes(const void* data, size_t size) {
+			const unsigned char* p = static_cast<const unsigned char*>(data);
+			for (size_t i = 0; i < size; ++i) {
+				h = (h ^ p[i]) * 1099511628211ull;
+			}
+		}
+		template <typename T>
+		void add(const T& value) { bytes(&value, sizeof(T)); }
+		void add(const glm::vec3& v) { add(v.x); add(v.y); add(v.z); }
+		void add(bool b) { add(static_cast<unsigned char>(b)); }
+	};
+}
+
+void Simulation::setSeed(uint64_t seed) {
+	seed_ = seed;
+	rng_.reseed(seed);
+	pokemonController_->setSeed(seed);
+	herdEpoch_ = ~0u;
+}
+
+uint64_t Simulation::stateHash() const {
+	StateHasher hash;
+
+	hash.add(player_.position);
+	hash.add(player_.verticalVelocity);
+	hash.add(player_.grounded);
+
+	registry_.each<Pokemon>([&](const Pokemon& p) {
+		hash.add(p.getId());
+		hash.add(static_cast<int>(p.getState()));
+		hash.add(p.getPosition());
+		hash.add(p.getVelocity());
+		hash.add(p.isVisible());
+	});
+	for (const InventoryEntry& entry : pokemonController_->getInventory()) {
+		hash.add(entry.id);
+	}
+
+	registry_.each<Transform, Pokeball>([&](Entity e, const Transform& t, const Pokeball& b) {
+		hash.add(t.position);
+		hash.add(b.velocity);
+		hash.add(b.life);
+		hash.add(b.active);
+		hash.add(b.locked);
+		hash.add(registry_.has<Sleeping>(e));
+	});
+	return hash.h;
+}
+
+void Simulation::reportMemory(MemoryReport& out) const {
+	if (world_) out.add(MemoryCategory::CpuTerrain, "heightfield", world_->heightsMemory());
+	out.add(MemoryCategory::CpuCollision, "collision boxes", collision_->memoryBytes());
+	if (flowFields_) {
+		out.add(MemoryCategory::CpuNavigation, "navigation grid", flowFields_->gridMemory());
+		out.add(MemoryCategory::CpuNavigation, "flow fields", flowFields_->fieldMemory());
+	}
+	out.add(MemoryCategory::CpuEntities, "registry chunks", registry_.chunkMemory());
+	out.add(MemoryCategory::CpuEntities, "registry bookkeeping", registry_.bookkeepingMemory());
+	out.addVector(MemoryCategory::CpuEntities, "species", species_);
+	out.addVector(MemoryCategory::CpuEntities, "pokeball throw order", ballOrder_);
+	pokemonController_->reportMemory(out);
+}
+
+// Load the terrain from a height map. Headless runs skip the mesh and textures.
+bool Simulation::loadWorld(const char* heightmapPath, float cellSize, float heightScale, bool withMesh) {
+	world_ = World::FromHeightMap(heightmapPath, cellSize, heightScale, withMesh);
+	return world_ && world_->halfExtents().x > 0.0f;
+}
+
+// Find a random spot within range (minus margin) of the origin whose terrain normal is at
+// least minNormalY upright. Gives up after a bounded number of tries.
+bool Simulation::findFlatSpot(float range, float margin, float minNormalY, glm::vec2& out) {
+	if (!world_) return false;
+
+	constexpr int MAX_TRIES = 1000;
+	for (int i = 0; i < MAX_TRIES; ++i) {
+		float x = rng_.range(-range + margin, range - margin);
+		float z = rng_.range(-range + margin, range - margin);
+		if (glm::dot(world_->normalAt(x, z), glm::vec3(0, 1, 0)) >= minNormalY) {
+			out = { x, z };
+			return true;
+		}
+	}
+	return false;
+}
+
+// Spawn a Pokemon at the specified coordinates. It queries the world height at that
+// position to place it on the terrain. 
+void Simulation::spawnPokemonAt(float x, float z, float speed, float radius) {
+	if (!world_ || species_.empty()) return;
+
+	float y = world_->heightAt(x, z);
+
+	// Pick a random species
+	uint32_t speciesIdx = rng_.index(static_cast<uint32_t>(species_.size()));
+	pokemonController_->spawnPokemon(&species_[speciesIdx], glm::vec3(x, y, z), speed, radius);
+}
+
+// Scatter props randomly across the terrain, ensuring they are placed on relatively
+// flat ground. Each prop's box is scaled with it and anchored at its base.
+size_t Simulation::scatterProps(const ScenePropSet& set, Model* model, uint32_t setIndex) {
+	if (!world_) return 0;
+
+	int count = spawnCount(set.count, set.density, set.range, set.margin);
+	int i = 0;
+	for (; i < count; i++) {
+		glm::vec2 spot;
+		if (!findFlatSpot(set.range, set.margin, set.minNormalY, spot)) break; // no flat ground left
+
+		float sXZ = rng_.range(set.scaleXZ.x, set.scaleXZ.y);
+		float sY = rng_.range(set.scaleY.x, set.scaleY.y);
+
+		Transform t;
+		t.position = glm::vec3(spot.x, world_->heightAt(spot.x, spot.y), spot.y);
+		t.scale = glm::vec3(sXZ, sY, sXZ);
+		collision_->addBox(t.position + t.scale * set.boxMin, t.position + t.scale * set.boxMax);
+
+		registry_.create(t, Renderable{ model, set.color }, Prop{ set.boxMin, set.boxMax, setIndex });
+	}
+	return static_cast<size_t>(i);
+}
+
+// Scatter multiple Pokemon randomly across the terrain, ensuring they are placed
+// on relatively flat ground.
+void Simulation::scatterPokemon(const ScenePokemonSpawn& spawn) {
+	if (!world_ || species_.empty()) return;
+
+	int count = spawnCount(spawn.count, spawn.density, spawn.range, spawn.margin);
+	for (int i = 0; i < count; i++) {
+		glm::vec2 spot;
+		if (!findFlatSpot(spawn.range, spawn.margin, spawn.minNormalY, spot)) break;
+
+		float speed = rng_.range(spawn.speed.x, spawn.speed.y);
+		float radius = rng_.range(spawn.radius.x, spawn.radius.y);
+		spawnPokemonAt(spot.x, spot.y, speed, radius);
+	}
+}
+
+// Build the navigation grid from the terrain and props, and register the flee-from-player
+// flow field and a herd field per species. Must run after the props are placed. Solves go
+// to the background pool, so a long one never holds up the frame's parallel work.
+void Simulation::buildNavigation() {
+	if (!world_) return;
+
+	auto grid = NavGrid::Build(*world_, collision_.get(), NAV_CELL_SIZE, NAV_AGENT_RADIUS, NAV_MAX_SLOPE_DEGREES);
+	flowFields_ = std::make_unique<FlowFieldService>(ThreadPool::background());
+	flowFields_->setSynchronous(deterministic_);
+	flowFields_->setGrid(std::move(grid));
+	fleeGoal_ = flowFields_->addGoal(FlowMode::Flee, FLEE_FIELD_RANGE);
+	herdGoals_.clear();
+	for (size_t s = 0; s < species_.size(); ++s) {
+		herdGoals_.push_back(flowFields_->addGoal(FlowMode::Seek, HERD_FIELD_RANGE));
+	}
+	herdEpoch_ = ~0u;
+	pokemonController_->setNavigation(flowFields_.get(), fleeGoal_, herdGoals_);
+}
+
+// Move the herd targets every HERD_RETARGET_FRAMES frames. A target is a function of the
+// seed, the species and the frame count only (both saved), so a loaded game puts the herds
+// back where they were without storing them.
+void Simulation::updateHerds() {
+	unsigned epoch = pokemonController_->getFrame() / static_cast<unsigned>(HERD_RETARGET_FRAMES);
+	if (epoch == herdEpoch_) return;
+	herdEpoch_ = epoch;
+	for (size_t s = 0; s < herdGoals_.size(); ++s) {
+		flowFields_->setGoal(herdGoals_[s], herdTarget(s, epoch));
+	}
+}
+
+// A walkable spot near the species' home (itself a walkable spot picked from the seed),
+// different for each epoch. Falls back to the home, then to the world's center.
+glm::vec3 Simulation::herdTarget(size_t species, unsigned epoch) const {
+	constexpr uint64_t HERD_STREAM = 0x4845524400000000ull;  // "HERD"
+	constexpr int MAX_TRIES = 32;
+	const NavGrid* grid = flowFields_->grid();
+	glm::vec2 half = world_->halfExtents();
+
+	glm::vec3 home(0.0f);
+	Random homeRng(seed_, HERD_STREAM + species);
+	for (int i = 0; i < MAX_TRIES; ++i) {
+		glm::vec3 p(homeRng.range(-half.x, half.x), 0.0f, homeRng.range(-half.y, half.y));
+		if (grid->walkable(p)) {
+			home = p;
+			break;
+		}
+	}
+
+	Random roamRng(seed_ + (static_cast<uint64_t>(epoch) + 1) * 0x9E3779B97F4A7C15ull, HERD_STREAM + species);
+	for (int i = 0; i < MAX_TRIES; ++i) {
+		glm::vec3 p = home + glm::vec3(roamRng.range(-HERD_ROAM_RADIUS, HERD_ROAM_RADIUS), 0.0f,
+			roamRng.range(-HERD_ROAM_RADIUS, HERD_ROAM_RADIUS));
+		if (grid->walkable(p)) return p;
+	}
+	return home;
+}
+
+// Reserve room for `capacity` balls, flying or asleep, and for the step's expiry list
+void Simulation::setPokeballPool(size_t capacity, PokeballOverflow policy) {
+	ballPool_.capacity = capacity;
+	ballPool_.policy = policy;
+	registry_.reserve<Transform, Pokeball>(capacity);
+	registry_.reserve<Transform, Pokeball, Sleeping>(capacity);
+	compactBallOrder(2 * capacity);
+}
+
+// The controller's inventory entries refer to species by index into this table
+void Simulation::setSpecies(std::vector<PokemonSpecies> species) {
+	species_ = std::move(species);
+	pokemonController_->setSpecies(species_);
+}
+
+// Throw a pokeball from origin along front with the given speed, plus a small upward kick
+bool Simulation::throwPokeball(const glm::vec3& origin, const glm::vec3& front, float speed) {
+	size_t count = pokeballCount();
+	if (count >= ballPool_.capacity) {
+		ballPool_.overflows++;
+		if (ballPool_.policy == PokeballOverflow::Reject) return false;
+		if (ballPool_.policy == PokeballOverflow::RecycleOldest) {
+			Entity oldest = takeOldestBall();
+			if (!oldest.valid()) return false;
+			registry_.destroy(oldest);
+			count--;
+		}
+	}
+
+	Pokeball ball;
+	ball.velocity = glm::normalize(front) * speed + glm::vec3(0.0f, PROJECTILE_UPWARD_VELOCITY, 0.0f);
+	ball.radius = PROJECTILE_RADIUS;
+	ball.life = PROJECTILE_LIFETIME;
+
+	recordThrow(registry_.create(Transform{ origin }, ball));
+	ballPool_.highWater = std::max(ballPool_.highWater, count + 1);
+	return true;
+}
+
+// The throw order is a ring twice the pool capacity. Balls that expire stay in it until they
+// reach the head or the ring fills up; compacting then frees at least half of it, so
+// throwing stays O(1) amortized and only allocates when Grow overfills the pool.
+void Simulation::recordThrow(Entity ball) {
+	if (ballOrderCount_ == ballOrder_.size()) compactBallOrder(0);
+	ballOrder_[(ballOrderHead_ + ballOrderCount_) % ballOrder_.size()] = ball;
+	ballOrderCount_++;
+}
+
+// Take the oldest ball that is not in a capture out of the throw order, or return an invalid
+// entity if every ball is capturing. Removed balls at the head are dropped on the way;
+// capturing ones keep their place.
+Entity Simulation::takeOldestBall() {
+	const size_t size = ballOrder_.size();
+	while (ballOrderCount_ > 0 && !registry_.alive(ballOrder_[ballOrderHead_])) {
+		ballOrderHead_ = (ballOrderHead_ + 1) % size;
+		ballOrderCount_--;
+	}
+	for (size_t i = 0; i < ballOrderCount_; ++i) {
+		Entity& slot = ballOrder_[(ballOrderHead_ + i) % size];
+		const Pokeball* b = registry_.get<Pokeball>(slot);
+		if (!b || b->locked) continue;
+		Entity oldest = slot;
+		slot = Entity{};
+		return oldest;
+	}
+	return Entity{};
+}
+
+// Drop removed balls and move the order to the start of the ring, which is grown to at
+// least minSize entries and doubled if the balls still fill it
+void Simulation::compactBallOrder(size_t minSize) {
+	std::rotate(ballOrder_.begin(), ballOrder_.begin() + ballOrderHead_, ballOrder_.end());
+	auto end = std::remove_if(ballOrder_.begin(), ballOrder_.begin() + ballOrderCount_,
+		[this](Entity e) { return !registry_.alive(e); });
+	ballOrderCount_ = static_cast<size_t>(end - ballOrder_.begin());
+	ballOrderHead_ = 0;
+
+	size_t size = std::max({ minSize, ballOrder_.size(), size_t(2) });
+	if (ballOrderCount_ == size) size *= 2;
+	ballOrder_.resize(size);
+}
+
+// Replace the throw order, oldest first (used when loading a save)
+void Simulation::resetBallOrder(std::span<const Entity> order) {
+	ballOrder_.assign(order.begin(), order.end());
+	ballOrderHead_ = 0;
+	ballOrderCount_ = ballOrder_.size();
+	compactBallOrder(2 * ballPool_.capacity);
+}
+
+void Simulation::jump() {
+	if (player_.grounded) {
+		player_.verticalVelocity = JUMP_VELOCITY;
+		player_.grounded = false;
+	}
+}
+
+void Simulation::tick(float dt, const PlayerInput& input) {
+	PROFILE_ZONE("Simulation::tick");
+	stepPokeballs(dt);
+	updatePokemon(dt);
+	updatePlayer(dt, input);
+}
+
+// Run the pokeball physics in fixed PHYSICS_TIMESTEP steps, carrying the remainder over
+void Simulation::stepPokeballs(float dt) {
+	PROFILE_ZONE("Simulation::stepPokeballs");
+	const float h = PHYSICS_TIMESTEP;
+	physicsAccumulator_ += dt;
+	while (physicsAccumulator_ >= h) {
+		updatePokeballs(h);
+		physicsAccumulator_ -= h;
+	}
+}
+
+// Update all Pokemon with world and obstacle info
+void Simulation::updatePokemon(float dt) {
+	PROFILE_ZONE("Simulation::updatePokemon");
+
+	// Keep the flee field centered on the player and the herd fields on their targets
+	// (solved on a worker when a goal changes cell)
+	if (flowFields_) {
+		flowFields_->setGoal(fleeGoal_, player_.position);
+		updateHerds();
+		flowFields_->update();
+	}
+
+	// Build obstacle list from props, on the frame arena. Only needed without a navigation
+	// grid, which already has the props baked in.
+	FrameVector<glm::vec3> obstacles(&frameArena());
+	if (!flowFields_ || !flowFields_->grid()) {
+		obstacles.reserve(collision_->boxes().size());
+		for (const auto& box : collision_->boxes()) {
+			obstacles.push_back(glm::vec3(0.5f * (box.min.x + box.max.x), box.min.y, 0.5f * (box.min.z + box.max.z)));
+		}
+	}
+
+	pokemonController_->updateAll(dt, world_.get(), obstacles, player_.position);
+
+	// Move captured Pokemon to inventory automatically
+	pokemonController_->updateInventory();
+}
+
+uint64_t Simulation::allocationEpoch() const {
+	return registry_.structureVersion();
+}
+
+// Update the player position based on input, collisions, and gravity
+void Simulation::updatePlayer(float dt, const PlayerInput& input) {
+	PROFILE_ZONE("Simulation::updatePlayer");
+	PlayerState& pl = player_;
+
+	// Helper lambda to push a point out of an AABB in the XZ plane. That is, it pushes the player
+	// out of obstacles. Uses AABB (Axis-Aligned Bounding Box) collision detection.
+	// Find the closest point on the obstacle to the player, and if the player is inside it then
+	// calculate which edge is nearest and push them to that edge. Prevents things like walking through rocks.
+	auto pushOutFromAABB_XZ = [&](glm::vec3& p, const glm::vec3& aabbWorldMin, const glm::vec3& aabbWorldMax) {
+		glm::vec2 pos2(p.x, p.z);
+		glm::vec2 bmin(aabbWorldMin.x - pl.radius, aabbWorldMin.z - pl.radius);
+		glm::vec2 bmax(aabbWorldMax.x + pl.radius, aabbWorldMax.z + pl.radius);
+		
+		glm::vec2 clampPt;
+		clampPt.x = glm::clamp(pos2.x, bmin.x, bmax.x);
+		clampPt.y = glm::clamp(pos2.y, bmin.y, bmax.y);
+		glm::vec2 delta = pos2 - clampPt;
+
+		if (delta.x == 0.0f && delta.y == 0.0f) {
+			float left = pos2.x - bmin.x;
+			float right = bmax.x - pos2.x;
+			float down = pos2.y - bmin.y;
+			float up = bmax.y - pos2.y;
+			float m = std::min(std::min(left, right), std::min(down, up));
+
+			if (m == left) p.x = bmin.x;
+			else if (m == right) p.x = bmax.x;
+			else if (m == down) p.z = bmin.y;
+			else p.z = bmax.y;
+		}
+	};
+
+	// Calculate intended movement vector from the WASD intent.
+	float velocity = pl.moveSpeed * dt;
+
+	if (input.sprint) velocity *= SPRINT_MULTIPLIER;
+
+	glm::vec3 right = glm::normalize(glm::cross(input.front, glm::vec3(0.0f, 1.0f, 0.0f)));
+	glm::vec3 fwd = glm::normalize(glm::vec3(input.front.x, 0.0f, input.front.z));
+
+	// Apply WASD movement. 
+	glm::vec3 next = pl.position;
+	if (input.forward) next += fwd * velocity;
+	if (input.back) next -= fwd * velocity;
+	if (input.left) next -= right * velocity;
+	if (input.right) next += right * velocity;
+
+	// Check collisions with props, and call our lambda to push the player out of obstacles.
+	for (const auto& box : collision_->boxes()) {
+		pushOutFromAABB_XZ(next, box.min, box.max);
+	}
+
+	// Handle gravity and ground collision. Physics!
+	if (world_) {
+		// Apply gravity to vertical velocity
+		pl.verticalVelocity -= GRAVITY * dt;
+
+		// Update Y position based on vertical velocity
+		next.y = pl.position.y + pl.verticalVelocity * dt;
+
+		// Get terrain info at new position. Use dot product to find slope angle.
+		float groundY = world_->heightAt(next.x, next.z);
+		glm::vec3 normal = world_->normalAt(next.x, next.z);
+		float slopeAngle = glm::degrees(acosf(glm::clamp(glm::dot(normal, glm::vec3(0, 1, 0)), -1.0f, 1.0f)));
+
+		constexpr float MAX_CLIMBABLE_SLOPE = 45.0f;
+		constexpr float SLIDE_THRESHOLD = 35.0f;
+
+		// ONLY block horizontal movement if grounded AND slope too steep.
+		// This prevents things like walking up cliffs, instead making the player slide down. 
+		if (pl.grounded && slopeAngle > MAX_CLIMBABLE_SLOPE) {
+			// Too steep - reject horizontal movement
+			next.x = pl.position.x;
+			next.z = pl.position.z;
+			groundY = world_? world_->heightAt(next.x, next.z) : 0.0f;
+		}
+
+		// Check ground collision
+		float targetY = groundY + pl.eyeHeight;
+		if (next.y <= targetY) {
+			next.y = targetY;
+			pl.verticalVelocity = 0.0f;
+			pl.grounded = true;
+
+			// Apply sliding on steep slopes (only when grounded)
+			if (slopeAngle > SLIDE_THRESHOLD) {
+				glm::vec3 gravity(0, -1, 0);
+				glm::vec3 slideDir = gravity - glm::dot(gravity, normal) * normal;
+				if (glm::length(slideDir) > 0.001f) {
+					slideDir = glm::normalize(slideDir);
+
+					float slideSpeed = (slopeAngle - SLIDE_THRESHOLD) * 0.1f;
+					next.x += slideDir.x * slideSpeed * dt;
+					next.z += slideDir.z * slideSpeed * dt;
+
+					// Recalculate ground height after sliding
+					groundY = world_->heightAt(next.x, next.z);
+					next.y = groundY + pl.eyeHeight;
+				}
+			}
+		}
+		else {
+			pl.grounded = false;
+		}
+	}
+	else {
+		next.y = pl.eyeHeight;
+	}
+
+	pl.position = next;
+}
+
+// Update all active pokeballs, applying physics, collisions, and capture logic. This is, in a sense, the 
+// physics and game logic engine for all active pokeballs. Handles projectile motion, collisions, captures,
+// and cleanup. 
+void Simulation::updatePokeballs(float dt) {
+	constexpr float SHAKE_DURATION = 0.6f;
+	constexpr int MAX_SHAKES = 3;
+	constexpr int MAX_BOUNCES_PER_STEP = 3;
+	constexpr float CONTACT_SKIN = 1e-3f; // Gap left after a contact, so the next sweep starts free
+
+	// Contacts and bounces go through the same helpers as the throw preview
+	auto bounce = [this](glm::vec3& velocity, const glm::vec3& normal) {
+		velocity = CollisionWorld::BounceBall(velocity, normal, bounceRestitution_, BOUNCE_FRICTION);
+	};
+	auto sweep = [this](const glm::vec3& from, const glm::vec3& to, float radius, float& toi, glm::vec3& normal) {
+		return CollisionWorld::SweepBall(world_.get(), collision_.get(), from, to, radius, GROUND_Y, toi, normal);
+	};
+
+	// Balls changing sleep state or expiring this step, applied after each query
+	FrameVector<Entity> changed(&frameArena());
+
+	// If the props changed (e.g. a rock was spawned), sleeping balls may no longer be
+	// supported, so wake them all
+	if (collision_->version() != ballCollisionVersion_) {
+		ballCollisionVersion_ = collision_->version();
+		registry_.each<Pokeball, Sleeping>([&](Entity e, Pokeball& b, Sleeping&) {
+			b.restSteps = 0;
+			changed.push_back(e);
+		});
+		for (Entity e : changed) registry_.remove<Sleeping>(e);
+	}
+	ballStats_ = {};
+
+	// Resting balls only age
+	registry_.each<Pokeball, Sleeping>([&](Pokeball& b, Sleeping&) {
+		b.life -= dt;
+		ballStats_.sleeping++;
+	});
+
+	// Main update loop, iterates through all the awake pokeballs. Balls that come to rest
+	// are tagged Sleeping after the loop.
+	changed.clear();
+	registry_.each<Transform, Pokeball>(Without<Sleeping>{}, [&](Entity e, Transform& t, Pokeball& b) {
+		glm::vec3& position = t.position;
+
+		// If locked, do horizontal shake animation!
+		if (b.locked) {
+			b.lockTimer += dt;
+			
+			// Initialize base position on first frame of lock
+			if (b.lockTimer <= dt) {
+				b.captureBasePos = position;
+			}
+			
+			b.shakePhase += dt / SHAKE_DURATION;
+
+			if (b.shakePhase >= 1.0f) {
+				b.shakePhase = 0.0f;
+				b.shakeCount++;
+				
+				// After 3rd shake, finalize capture result through the ball's capture session
+				if (b.shakeCount >= MAX_SHAKES) {
+					pokemonController_->resolveCapture(b.captureSession);
+				}
+			}
+
+			// Only shake during first 3 shakes
+			if (b.shakeCount < MAX_SHAKES) {
+				float t = b.shakePhase;
+				float shakeOffset = 0.12f * std::sin(t * 6.28318f);
+				
+				position.x = b.captureBasePos.x + shakeOffset;
+				position.y = b.captureBasePos.y;
+				position.z = b.captureBasePos.z;
+			}
+			return;
+		}
+
+		if (!b.active) return; // Skip inactive balls
+
+		ballStats_.active++;
+		b.grounded = false;
+
+		// Here, the ball is active - it is flying through the air!
+
+		// Apply gravity, then move along the step with continuous collision: sweep to the first
+		// contact, bounce there and continue with the remaining time. Thin props can no longer be
+		// skipped between steps, so the fixed step can stay coarse.
+		b.velocity.y -= gravity_ * dt;
+
+		float remaining = dt;
+		for (int i = 0; i < MAX_BOUNCES_PER_STEP && remaining > 0.0f; ++i) {
+			glm::vec3 target = position + b.velocity * remaining;
+			float toi;
+			glm::vec3 normal;
+			if (!sweep(position, target, b.radius, toi, normal)) {
+				position = target;
+				break;
+			}
+
+			position = glm::mix(position, target, toi) + normal * CONTACT_SKIN;
+			bounce(b.velocity, normal);
+			if (normal.y >= BALL_GROUND_NORMAL_Y) b.grounded = true;
+			remaining *= (1.0f - toi);
+		}
+
+		// Safety net for resting contact: never leave the ball inside the terrain
+		float terrainHeight = GROUND_Y;
+		glm::vec3 terrainNormal = glm::vec3(0.0f, 1.0f, 0.0f);
+
+		if (world_) {
+			terrainHeight = world_->heightAt(position.x, position.z);
+			terrainNormal = world_->normalAt(position.x, position.z);
+		}
+
+		glm::vec3 terrainPoint(position.x, terrainHeight, position.z);
+		float distToTerrain = glm::dot(position - terrainPoint, terrainNormal);
+		if (distToTerrain < b.radius) {
+			position += terrainNormal * (b.radius - distToTerrain);
+			bounce(b.velocity, terrainNormal);
+			if (terrainNormal.y >= BALL_GROUND_NORMAL_Y) b.grounded = true;
+		}
+
+		// Rest detection: slow and on the ground for long enough -> sleep
+		if (b.grounded && glm::dot(b.velocity, b.velocity) < BALL_SLEEP_SPEED * BALL_SLEEP_SPEED) {
+			if (++b.restSteps >= BALL_SLEEP_STEPS) {
+				b.velocity = glm::vec3(0.0f);
+				changed.push_back(e);
+			}
+		} else {
+			b.restSteps = 0;
+		}
+
+		b.life -= dt;
+	});
+	for (Entity e : changed) registry_.add<Sleeping>(e);
+
+	// Capture logic
+	pokemonController_->handlePokeballCapture(dt);
+
+	// Remove expired pokeballs
+	changed.clear();
+	registry_.each<Pokeball>([&](Entity e, const Pokeball& p) {
+		if (p.life <= 0.0f || (p.locked && p.lockTimer > 2.8f)) {
+			changed.push_back(e);
+		}
+	});
+	for (Entity e : changed) registry_.destroy(e);
+}
+
+} // namespace pokepp
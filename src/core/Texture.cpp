@@ -14,6 +14,22 @@
     It acts as the bridge between image files and the rendered Pokemon textures.
 */
 
+namespace {
+    // Bytes of a texture with its full mip chain. RGB counts as 4 bytes per texel, which is
+    // how drivers usually store it.
+    size_t mipChainBytes(int width, int height, int channels) {
+        const size_t bytesPerTexel = (channels == 3) ? 4 : channels;
+        size_t total = 0;
+        for (;;) {
+            total += static_cast<size_t>(width) * height * bytesPerTexel;
+            if (width == 1 && height == 1) break;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return total;
+    }
+}
+
 Texture::Texture(const std::string& path, Kind kind) : path_(path) {
     int width, height, channels;
     
@@ -82,6 +98,8 @@ Texture::Texture(const std::string& path, Kind kind) : path_(path) {
     // Cleanup
     stbi_image_free(data);
     glBindTexture(GL_TEXTURE_2D, 0);
+
+    memory_ = pokepp::TrackedMemory(pokepp::MemoryCategory::GpuTextures, path_, mipChainBytes(width, height, channels));
 }
 
 Texture::~Texture() {
@@ -0,0 +1,153 @@
+#include "pokeapp/ThreadPool.h"
+#include "pokeapp/Profiler.h"
+
+#include <algorithm>
+
+/*
+	Implementation of the ThreadPool class. Workers sleep on a condition variable
+	and pull jobs from a shared FIFO queue.
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr size_t INITIAL_QUEUE_CAPACITY = 64;
+
+    // One parallelFor call, on the caller's stack. The counter is only touched under
+    // doneMutex, so the caller cannot return (and destroy it) while a worker is still
+    // signalling.
+    struct ParallelLoop {
+        void* fn = nullptr;
+        void (*invoke)(void*, size_t, size_t) = nullptr;
+        size_t count = 0;
+        size_t chunk = 0;
+        size_t remaining = 0;
+        std::mutex doneMutex;
+        std::condition_variable done;
+    };
+}
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        threadCount = hw > 1 ? hw - 1 : 1;
+    }
+
+    jobs_.resize(INITIAL_QUEUE_CAPACITY);
+    workers_.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    jobAvailable_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool& ThreadPool::background() {
+    static ThreadPool pool(1);
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (jobCount_ == jobs_.size()) {
+            // Full: unroll the ring into a buffer twice the size
+            std::vector<std::function<void()>> grown(jobs_.size() * 2);
+            for (size_t i = 0; i < jobCount_; ++i) {
+                grown[i] = std::move(jobs_[(jobHead_ + i) % jobs_.size()]);
+            }
+            jobs_.swap(grown);
+            jobHead_ = 0;
+        }
+        jobs_[(jobHead_ + jobCount_) % jobs_.size()] = std::move(job);
+        jobCount_++;
+    }
+    jobAvailable_.notify_one();
+}
+
+// Split [0, count) into roughly one chunk per thread (including the caller), hand all but
+// the first chunk to the workers and run the first chunk on the calling thread. Each job
+// captures only the loop and its chunk index, which std::function stores without allocating.
+void ThreadPool::parallelForImpl(size_t count, size_t minChunk, void* fn, RangeFn invoke) {
+    if (count == 0) return;
+
+    size_t threads = workers_.size() + 1;
+    size_t chunk = std::max(minChunk, (count + threads - 1) / threads);
+    size_t chunks = (count + chunk - 1) / chunk;
+    if (chunks <= 1) {
+        invoke(fn, 0, count);
+        return;
+    }
+
+    ParallelLoop loop;
+    loop.fn = fn;
+    loop.invoke = invoke;
+    loop.count = count;
+    loop.chunk = chunk;
+    loop.remaining = chunks - 1;
+    ParallelLoop* shared = &loop;
+
+    for (size_t c = 1; c < chunks; ++c) {
+        submit([shared, c] {
+            size_t begin = c * shared->chunk;
+            shared->invoke(shared->fn, begin, std::min(shared->count, begin + shared->chunk));
+            std::lock_guard<std::mutex> lock(shared->doneMutex);
+            if (--shared->remaining == 0) shared->done.notify_one();
+        });
+    }
+
+    invoke(fn, 0, std::min(count, chunk));
+
+    std::unique_lock<std::mutex> lock(loop.doneMutex);
+    loop.done.wait(lock, [&] { return loop.remaining == 0; });
+}
+
+void ThreadPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return jobCount_ == 0 && running_ == 0; });
+}
+
+void ThreadPool::workerLoop() {
+    Profiler::setThreadName("pool worker");
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobAvailable_.wait(lock, [this] { return stopping_ || jobCount_ > 0; });
+            if (stopping_ && jobCount_ == 0) return;
+
+            job = std::move(jobs_[jobHead_]);
+            jobs_[jobHead_] = nullptr;
+            jobHead_ = (jobHead_ + 1) % jobs_.size();
+            jobCount_--;
+            running_++;
+        }
+
+        {
+            PROFILE_ZONE("ThreadPool job");
+            job();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_--;
+            if (jobCount_ == 0 && running_ == 0) idle_.notify_all();
+        }
+    }
+}
+
+} // namespace pokepp
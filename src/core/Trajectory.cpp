@@ -0,0 +1,111 @@
+#include "pokeapp/Trajectory.h"
+#include "pokeapp/CollisionWorld.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+	Implementation of the TrajectoryPredictor. See Trajectory.h for an overview.
+*/
+
+namespace pokepp {
+
+namespace {
+    constexpr int MAX_PREVIEW_BOUNCES = 2;  // The path ends at the contact after this many bounces
+    constexpr float CONTACT_SKIN = 1e-3f;
+
+    bool differs(const glm::vec3& a, const glm::vec3& b, float eps) {
+        glm::vec3 d = a - b;
+        return glm::dot(d, d) > eps * eps;
+    }
+}
+
+TrajectoryPredictor::TrajectoryPredictor(int maxPoints, float sampleStep)
+    : maxPoints_(std::max(2, maxPoints)), sampleStep_(sampleStep) {
+    points_.reserve(maxPoints_);
+}
+
+bool TrajectoryPredictor::update(const ThrowParams& params, const World* world, const CollisionWorld* collision) {
+    uint32_t collisionVersion = collision ? collision->version() : 0;
+
+    bool stale = !valid_
+        || world != world_
+        || collision != collision_
+        || collisionVersion != collisionVersion_
+        || differs(params.origin, cached_.origin, positionEps_)
+        || differs(params.velocity, cached_.velocity, velocityEps_)
+        || params.radius != cached_.radius
+        || params.gravity != cached_.gravity
+        || params.restitution != cached_.restitution
+        || params.friction != cached_.friction
+        || params.groundY != cached_.groundY;
+    if (!stale) return false;
+
+    cached_ = params;
+    world_ = world;
+    collision_ = collision;
+    collisionVersion_ = collisionVersion;
+    valid_ = true;
+
+    solve(params, world, collision);
+    revision_++;
+    return true;
+}
+
+// Sample the flight at fixed times. Each arc is the exact parabola p0 + v0*s + g*s^2/2 from
+// its launch point; between two samples the chord is swept against the world, and a contact
+// starts a new arc from the contact point with the bounced velocity. The rest of that sample
+// step is swept again from the contact, like the pokeball physics does within a step.
+void TrajectoryPredictor::solve(const ThrowParams& params, const World* world, const CollisionWorld* collision) {
+    points_.clear();
+
+    const glm::vec3 g(0.0f, -params.gravity, 0.0f);
+    glm::vec3 p0 = params.origin;
+    glm::vec3 v0 = params.velocity;
+    float t0 = 0.0f; // launch time of the current arc
+
+    auto arc = [&](float t) {
+        float s = t - t0;
+        return p0 + v0 * s + 0.5f * g * s * s;
+    };
+
+    glm::vec3 prev = p0;
+    float tPrev = 0.0f;
+    int bounces = 0;
+    points_.push_back(prev);
+
+    for (int i = 1; i < maxPoints_; ++i) {
+        float t = i * sampleStep_;
+        glm::vec3 next = arc(t);
+
+        glm::vec3 from = prev;
+        float tFrom = tPrev;
+        float toi;
+        glm::vec3 normal;
+        bool ended = false;
+        while (CollisionWorld::SweepBall(world, collision, from, next, params.radius, params.groundY, toi, normal)) {
+            float tc = tFrom + toi * (t - tFrom);
+            glm::vec3 contact = glm::mix(from, next, toi) + normal * CONTACT_SKIN;
+            if (bounces == MAX_PREVIEW_BOUNCES) {
+                points_.push_back(contact);
+                ended = true;
+                break;
+            }
+
+            v0 = CollisionWorld::BounceBall(v0 + g * (tc - t0), normal, params.restitution, params.friction);
+            p0 = contact;
+            t0 = tc;
+            bounces++;
+            from = contact;
+            tFrom = tc;
+            next = arc(t);
+        }
+        if (ended) break;
+
+        points_.push_back(next);
+        prev = next;
+        tPrev = t;
+    }
+}
+
+} // namespace pokepp
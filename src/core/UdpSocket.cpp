@@ -0,0 +1,200 @@
+#include "pokeapp/UdpSocket.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <cstdlib>
+#include <iostream>
+
+/*
+	Implementation of the UdpSocket class. The platform differences (socket handle type,
+	non-blocking mode, closing, Winsock start-up) stay in the helpers at the top.
+*/
+
+namespace pokepp {
+
+namespace {
+#ifdef _WIN32
+    using SocketHandle = SOCKET;
+    using SockLen = int;
+
+    // Winsock needs starting once per process; it is left running until exit
+    bool startNetworking() {
+        static const bool started = [] {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        return started;
+    }
+
+    bool setNonBlocking(SocketHandle s) {
+        u_long on = 1;
+        return ioctlsocket(s, FIONBIO, &on) == 0;
+    }
+
+    void closeSocket(SocketHandle s) { closesocket(s); }
+#else
+    using SocketHandle = int;
+    using SockLen = socklen_t;
+
+    bool startNetworking() { return true; }
+
+    bool setNonBlocking(SocketHandle s) {
+        int flags = fcntl(s, F_GETFL, 0);
+        return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    void closeSocket(SocketHandle s) { ::close(s); }
+#endif
+
+    sockaddr_in toSockaddr(const NetAddress& address) {
+        sockaddr_in sa{};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(address.ip);
+        sa.sin_port = htons(address.port);
+        return sa;
+    }
+}
+
+std::string NetAddress::toString() const {
+    return std::to_string((ip >> 24) & 0xFF) + "." + std::to_string((ip >> 16) & 0xFF) + "."
+        + std::to_string((ip >> 8) & 0xFF) + "." + std::to_string(ip & 0xFF) + ":" + std::to_string(port);
+}
+
+NetAddress NetAddress::Loopback(uint16_t port) {
+    return { 0x7F000001u, port };
+}
+
+bool NetAddress::Parse(const std::string& text, NetAddress& out) {
+    size_t colon = text.rfind(':');
+    std::string host = colon == std::string::npos ? "127.0.0.1" : text.substr(0, colon);
+    std::string portText = colon == std::string::npos ? text : text.substr(colon + 1);
+
+    char* end = nullptr;
+    unsigned long port = std::strtoul(portText.c_str(), &end, 10);
+    if (portText.empty() || *end != '\0' || port == 0 || port > 65535) {
+        std::cerr << "Invalid port in address " << text << std::endl;
+        return false;
+    }
+    if (!startNetworking()) {
+        std::cerr << "Failed to start networking" << std::endl;
+        return false;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+        std::cerr << "Failed to resolve " << host << std::endl;
+        return false;
+    }
+    out.ip = ntohl(reinterpret_cast<const sockaddr_in*>(result->ai_addr)->sin_addr.s_addr);
+    out.port = static_cast<uint16_t>(port);
+    freeaddrinfo(result);
+    return true;
+}
+
+UdpSocket::~UdpSocket() {
+    close();
+}
+
+bool UdpSocket::open(uint16_t port, bool loopbackOnly) {
+    close();
+    if (!startNetworking()) {
+        std::cerr << "Failed to start networking" << std::endl;
+        return false;
+    }
+
+    SocketHandle s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (static_cast<intptr_t>(s) == INVALID) {
+        std::cerr << "Failed to create a UDP socket" << std::endl;
+        return false;
+    }
+
+    // Room for a burst of snapshot fragments (or of many clients' inputs) between polls
+    int bufferBytes = 1 << 20;
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bufferBytes), sizeof(bufferBytes));
+    setsockopt(s, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&bufferBytes), sizeof(bufferBytes));
+
+    sockaddr_in sa = toSockaddr({ loopbackOnly ? NetAddress::Loopback(port).ip : 0u, port });
+    if (bind(s, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa)) != 0 || !setNonBlocking(s)) {
+        std::cerr << "Failed to bind UDP port " << port << std::endl;
+        closeSocket(s);
+        return false;
+    }
+
+    SockLen length = sizeof(sa);
+    getsockname(s, reinterpret_cast<sockaddr*>(&sa), &length);
+    handle_ = static_cast<intptr_t>(s);
+    port_ = ntohs(sa.sin_port);
+    return true;
+}
+
+void UdpSocket::close() {
+    if (!isOpen()) return;
+    closeSocket(static_cast<SocketHandle>(handle_));
+    handle_ = INVALID;
+    port_ = 0;
+}
+
+bool UdpSocket::send(const NetAddress& to, const void* data, size_t size) {
+    if (!isOpen()) return false;
+    sockaddr_in sa = toSockaddr(to);
+    auto sent = sendto(static_cast<SocketHandle>(handle_), static_cast<const char*>(data), static_cast<int>(size), 0,
+        reinterpret_cast<const sockaddr*>(&sa), sizeof(sa));
+    return sent == static_cast<decltype(sent)>(size);
+}
+
+size_t UdpSocket::receive(NetAddress& from, void* buf, size_t capacity) {
+    if (!isOpen()) return 0;
+    // A datagram that does not fit fails (Windows) or is truncated (elsewhere); both are
+    // dropped, and so are errors such as ICMP port unreachable reported on Windows
+    while (true) {
+        sockaddr_in sa{};
+        SockLen length = sizeof(sa);
+        auto got = recvfrom(static_cast<SocketHandle>(handle_), static_cast<char*>(buf), static_cast<int>(capacity), 0,
+            reinterpret_cast<sockaddr*>(&sa), &length);
+        if (got < 0) {
+#ifdef _WIN32
+            int error = WSAGetLastError();
+            if (error == WSAECONNRESET || error == WSAEMSGSIZE) continue;
+            return 0;
+#else
+            return 0;
+#endif
+        }
+        if (static_cast<size_t>(got) >= capacity) continue;
+        from.ip = ntohl(sa.sin_addr.s_addr);
+        from.port = ntohs(sa.sin_port);
+        return static_cast<size_t>(got);
+    }
+}
+
+bool UdpSocket::wait(int ms) {
+    if (!isOpen()) return false;
+    SocketHandle s = static_cast<SocketHandle>(handle_);
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(s, &readable);
+    timeval timeout{ ms / 1000, (ms % 1000) * 1000 };
+    return select(static_cast<int>(s) + 1, &readable, nullptr, nullptr, &timeout) > 0;
+}
+
+} // namespace pokepp
@@ -14,7 +14,8 @@
 
 namespace pokepp {
 
-World::World() {
+World::World(bool withMesh) {
+	if (!withMesh) return;
 	auto mesh = makeGround(64, 1.0f);
 	ground_ = std::make_unique<Model>(std::move(mesh));
 }
@@ -23,8 +24,8 @@ World::~World() = default;
 
 // Static method to create a World from a height map image.
 // A 3D terrain mesh is generated based on the grayscale values of the image.
-std::unique_ptr<World> World::FromHeightMap(const char* path, float cellSize, float heightScale) {
-    auto w = std::make_unique<World>();
+std::unique_ptr<World> World::FromHeightMap(const char* path, float cellSize, float heightScale, bool withMesh) {
+    auto w = std::make_unique<World>(withMesh);
 
     // Load the heightmap. 
     int wpx, hpx, nch;
@@ -51,6 +52,8 @@ std::unique_ptr<World> World::FromHeightMap(const char* path, float cellSize, fl
     }
     stbi_image_free(data);
 
+    if (!withMesh) return w;
+
 	// Build mesh from heights (create vertices with normals and uvs)
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
@@ -95,7 +98,7 @@ std::unique_ptr<World> World::FromHeightMap(const char* path, float cellSize, fl
     }
 
     // Create the model and load the textuers 
-    auto mesh = std::make_unique<Mesh>(vertices, indices);
+    auto mesh = std::make_unique<Mesh>(vertices, indices, std::string("terrain ") + path);
     w->ground_ = std::make_unique<Model>(std::move(mesh));
 	w->grassTex_ = std::make_unique<Texture>("assets/textures/grass.png", Texture::Kind::Diffuse);
 	w->rockTex_ = std::make_unique<Texture>("assets/textures/rock.png", Texture::Kind::Diffuse);
@@ -152,7 +155,7 @@ std::unique_ptr<Mesh> World::makeGround(int n, float size) {
 		}
 	}
 
-	return std::make_unique<Mesh>(vertices, indices);
+	return std::make_unique<Mesh>(vertices, indices, "flat ground");
 }
 
 // Query the height of the terrain at world coordinates (x,z) using bilinear interpolation
@@ -209,6 +212,56 @@ glm::vec3 World::normalAt(float x, float z) const {
     return n;
 }
 
+// Sweep a sphere against the heightfield. The clearance of the sphere above the terrain
+// (measured along the terrain normal, like the ball collision response) is sampled along the
+// segment at half a cell spacing, so no bump of the bilinear surface is skipped, and the first
+// sign change is refined by bisection. toi is taken on the free side of the contact.
+bool World::sweepSphere(const glm::vec3& from, const glm::vec3& to, float radius,
+                        float& toi, glm::vec3& normal) const {
+    constexpr int MAX_SAMPLES = 64;
+    constexpr int BISECT_STEPS = 10;
+
+    auto clearance = [&](const glm::vec3& p, glm::vec3& n) {
+        n = normalAt(p.x, p.z);
+        return glm::dot(p - glm::vec3(p.x, heightAt(p.x, p.z), p.z), n) - radius;
+    };
+
+    const glm::vec3 d = to - from;
+    glm::vec3 n;
+    float f = clearance(from, n);
+    if (f <= 0.0f) {
+        // Starting in contact: only a hit when moving further into the ground
+        toi = 0.0f;
+        normal = n;
+        return glm::dot(d, n) < 0.0f;
+    }
+
+    float horizontal = std::sqrt(d.x * d.x + d.z * d.z);
+    int samples = std::clamp(int(std::ceil(horizontal / (0.5f * cellSize_))), 1, MAX_SAMPLES);
+
+    float tFree = 0.0f;
+    for (int s = 1; s <= samples; ++s) {
+        float t = float(s) / samples;
+        if (clearance(from + d * t, n) > 0.0f) {
+            tFree = t;
+            continue;
+        }
+
+        // Contact between tFree and t
+        float tHit = t;
+        for (int i = 0; i < BISECT_STEPS; ++i) {
+            float mid = 0.5f * (tFree + tHit);
+            if (clearance(from + d * mid, n) > 0.0f) tFree = mid;
+            else tHit = mid;
+        }
+        glm::vec3 p = from + d * tFree;
+        toi = tFree;
+        normal = normalAt(p.x, p.z);
+        return true;
+    }
+    return false;
+}
+
 // Render the terrain using the provided shader and camera matrices.
 void World::draw(const Shader& shader, const glm::mat4& view, const glm::mat4& proj) const {
 	if (!ground_) return;
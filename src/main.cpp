@@ -2,14 +2,93 @@
 #include <SDL.h>
 #include "../include/pokeapp/App.h"
 
-int main() {
-	App app;
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+/*
+	Entry point. Options:
+		--record <log>   record this session's input for replay
+		--replay <log>   replay a recorded session instead of playing (one tick per frame)
+		--headless       no window or rendering, with --replay
+		--timing <csv>   write per-frame timings and state hashes
+		--seed <n>       world seed for a new session
+		--scene <file>   scene to populate a new session from (default assets/scenes/default.scene)
+		--load <save>    continue a saved session (F5 saves quicksave.ppsave)
+		--autosave <save> save in the background every 30 s of play (deltas in <save>.delta)
+		--connect <host:port> join a pokepp_server instead of simulating locally
+		--trace <json>   profile the first frames into a Chrome trace (F9 captures one later)
+		--memory <json>  write a GPU/CPU memory report at exit (F10 writes one any time)
+		--alloc-check    exit with 3 if a steady-state frame allocates from the heap
+*/
+
+namespace {
+	bool parseArgs(int argc, char** argv, AppOptions& options) {
+		for (int i = 1; i < argc; ++i) {
+			const char* arg = argv[i];
+			if (!std::strcmp(arg, "--headless")) {
+				options.headless = true;
+				continue;
+			}
+			if (!std::strcmp(arg, "--alloc-check")) {
+				options.allocCheck = true;
+				continue;
+			}
+
+			const char* value = (i + 1 < argc) ? argv[++i] : nullptr;
+			if (!value) {
+				std::cerr << "Missing value for " << arg << std::endl;
+				return false;
+			}
+
+			if (!std::strcmp(arg, "--record")) options.recordPath = value;
+			else if (!std::strcmp(arg, "--replay")) options.replayPath = value;
+			else if (!std::strcmp(arg, "--timing")) options.timingPath = value;
+			else if (!std::strcmp(arg, "--seed")) options.seed = std::strtoull(value, nullptr, 10);
+			else if (!std::strcmp(arg, "--scene")) options.scenePath = value;
+			else if (!std::strcmp(arg, "--trace")) options.tracePath = value;
+			else if (!std::strcmp(arg, "--memory")) options.memoryPath = value;
+			else if (!std::strcmp(arg, "--load")) options.loadPath = value;
+			else if (!std::strcmp(arg, "--autosave")) options.autosavePath = value;
+			else if (!std::strcmp(arg, "--connect")) options.connectAddress = value;
+			else {
+				std::cerr << "Unknown option " << arg << std::endl;
+				return false;
+			}
+		}
+
+		if (options.headless && options.replayPath.empty()) {
+			std::cerr << "--headless needs --replay <log>" << std::endl;
+			return false;
+		}
+		if (!options.loadPath.empty() && (!options.recordPath.empty() || !options.replayPath.empty())) {
+			std::cerr << "--load cannot be combined with --record or --replay" << std::endl;
+			return false;
+		}
+		if (!options.connectAddress.empty() && (!options.recordPath.empty() || !options.replayPath.empty()
+			|| !options.loadPath.empty() || !options.autosavePath.empty())) {
+			std::cerr << "--connect cannot be combined with --record, --replay, --load or --autosave" << std::endl;
+			return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	AppOptions options;
+	if (!parseArgs(argc, argv, options)) {
+		return 1;
+	}
+
+	App app(options);
 	if (!app.init()) {
 		return 1;
 	}
 	while (app.running()) {
 		app.tick();
-		SDL_Delay(16); // Roughly 60 FPS
+		if (!app.replaying()) {
+			SDL_Delay(16); // Roughly 60 FPS. Replays run as fast as they can.
+		}
 	}
-	return 0;
-}
\ No newline at end of file
+	return app.exitCode();
+}
@@ -0,0 +1,705 @@
+#define SDL_MAIN_HANDLED
+#include "pokeapp/Simulation.h"
+#include "pokeapp/Scene.h"
+#include "pokeapp/PokemonController.h"
+#include "pokeapp/Pokeball.h"
+#include "pokeapp/Components.h"
+#include "pokeapp/World.h"
+#include "pokeapp/Model.h"
+#include "pokeapp/Constants.h"
+#include "pokeapp/Random.h"
+#include "pokeapp/GlCounters.h"
+#include "pokeapp/HeapCounter.h"
+#include "pokeapp/tiny_obj_loader.h"
+#include "pokeapp/stb_image.h"
+
+#include <glad/glad.h>
+#include <SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+	pokepp_bench: microbenchmarks of the engine's hot paths.
+
+	Each case is warmed up while its batch size is calibrated (operations per sample, doubled
+	until a sample takes at least --min-sample-ms), then timed for --reps samples. Reported
+	per operation: median, median absolute deviation, min and mean. Cases that do a fixed
+	amount of work per operation (e.g. 4096 height queries) also report time per item.
+
+	Cases:
+		world.heightAt/normalAt   random and coherent (walking) queries on the arena terrain
+		world.fromHeightMap       heightfield build, and with its mesh when there is GL
+		obj.parse/<file>          tinyobj parse of each model
+		model.load/<file>         Model construction (parse, meshes, textures), GL only
+		image.decode/<file>       stbi decode of each texture, from memory
+		pokemon.updateAll/N       PokemonController::updateAll with N Pokemon
+		pokemon.capture/N         handlePokeballCapture, N Pokemon and 64 balls out of reach
+		pokeball.substep/N        one physics step with N balls in flight
+
+	N runs over 100, 1000, 10000 and 100000 (up to --max-entities). GL cases run in a hidden
+	window and are skipped without a GL 3.3 context (or with --no-gl). When built with
+	POKEPP_GL_COUNTERS, the GL calls each operation makes are reported and written too.
+	Heap allocations and bytes per operation are counted over the timed operations (not
+	prepare) of every case.
+
+	--alloc-check fails the run (exit code 3, or 2 if a case also regressed) when a
+	steady-state case, one whose operation should reuse what earlier operations allocated
+	(terrain queries, Pokemon updates, capture checks, ball steps), allocates at all.
+
+	Regression gate: --baseline compares the samples of each case against a JSON file from an
+	earlier run (--current compares two files without running anything). A case regresses
+	when it is slower with Mann-Whitney p below --alpha (two-sided, default 0.01) and the
+	bootstrap 95% interval of the median ratio lies entirely above 1 + --threshold (default
+	5%), so noise and shifts too small to matter both pass. Exits with 2 on any regression.
+	Both runs need at least 6 samples per case for any p-value to get below 0.01.
+
+	Usage: pokepp_bench [--filter text] [--reps N] [--warmup-ms T] [--min-sample-ms T]
+	                    [--max-entities N] [--json file] [--no-gl] [--list] [--alloc-check]
+	                    [--baseline file [--current file]] [--alpha p] [--threshold pct]
+*/
+
+namespace {
+
+	struct Options {
+		std::string filter;
+		int reps = 15;
+		double warmupMs = 200.0;
+		double minSampleMs = 10.0;
+		int maxEntities = 100000;
+		std::string jsonPath;
+		bool gl = true;
+		bool list = false;
+		bool allocCheck = false;
+		std::string baselinePath;
+		std::string currentPath;  // Compare this file instead of running
+		double alpha = 0.01;
+		double threshold = 0.05;
+	};
+
+	// One benchmark. init runs once before warmup, prepare before every sample, and only op
+	// is timed. Every member has a default, so cases name only the ones they set.
+	struct Case {
+		std::string name = {};
+		size_t itemsPerOp = 1;
+		size_t maxBatch = 0;  // 0 = unlimited
+		bool steady = false;  // Operations must not allocate once warmed up (--alloc-check)
+		std::function<void()> init = {};
+		std::function<void()> prepare = {};
+		std::function<void()> op = {};
+	};
+
+	struct Result {
+		std::string name;
+		size_t itemsPerOp = 1;
+		size_t batch = 1;
+		bool steady = false;
+		std::vector<double> samples;  // Nanoseconds per operation
+		pokepp::GlCallCounts gl;      // GL calls over all timed operations
+		size_t ops = 0;               // Timed operations
+		uint64_t allocs = 0;          // Heap allocations and bytes over all timed operations
+		uint64_t allocBytes = 0;
+		double median = 0.0, mad = 0.0, min = 0.0, max = 0.0, mean = 0.0, stddev = 0.0;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	// Keeps results alive so the compiler cannot drop the work that produced them
+	volatile float g_sink = 0.0f;
+
+	bool parseArgs(int argc, char** argv, Options& opt) {
+		for (int i = 1; i < argc; ++i) {
+			const char* arg = argv[i];
+			if (!std::strcmp(arg, "--no-gl")) { opt.gl = false; continue; }
+			if (!std::strcmp(arg, "--list")) { opt.list = true; continue; }
+			if (!std::strcmp(arg, "--alloc-check")) { opt.allocCheck = true; continue; }
+
+			const char* value = (i + 1 < argc) ? argv[++i] : nullptr;
+			if (!value) {
+				std::fprintf(stderr, "Missing value for %s\n", arg);
+				return false;
+			}
+
+			if (!std::strcmp(arg, "--filter")) opt.filter = value;
+			else if (!std::strcmp(arg, "--reps")) opt.reps = std::max(1, std::atoi(value));
+			else if (!std::strcmp(arg, "--warmup-ms")) opt.warmupMs = std::atof(value);
+			else if (!std::strcmp(arg, "--min-sample-ms")) opt.minSampleMs = std::atof(value);
+			else if (!std::strcmp(arg, "--max-entities")) opt.maxEntities = std::atoi(value);
+			else if (!std::strcmp(arg, "--json")) opt.jsonPath = value;
+			else if (!std::strcmp(arg, "--baseline")) opt.baselinePath = value;
+			else if (!std::strcmp(arg, "--current")) opt.currentPath = value;
+			else if (!std::strcmp(arg, "--alpha")) opt.alpha = std::atof(value);
+			else if (!std::strcmp(arg, "--threshold")) opt.threshold = std::atof(value) / 100.0;
+			else {
+				std::fprintf(stderr, "Unknown option %s\n", arg);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	double median(std::vector<double> v) {
+		if (v.empty()) return 0.0;
+		std::sort(v.begin(), v.end());
+		size_t n = v.size();
+		return (n % 2) ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+	}
+
+	void summarize(Result& r) {
+		const std::vector<double>& s = r.samples;
+		r.median = median(s);
+		std::vector<double> dev;
+		dev.reserve(s.size());
+		for (double x : s) dev.push_back(std::abs(x - r.median));
+		r.mad = median(dev);
+		r.min = *std::min_element(s.begin(), s.end());
+		r.max = *std::max_element(s.begin(), s.end());
+
+		double sum = 0.0;
+		for (double x : s) sum += x;
+		r.mean = sum / s.size();
+		double var = 0.0;
+		for (double x : s) var += (x - r.mean) * (x - r.mean);
+		r.stddev = s.size() > 1 ? std::sqrt(var / (s.size() - 1)) : 0.0;
+	}
+
+	// Time one sample of `batch` operations, in nanoseconds per operation. The heap allocations
+	// the operations made are added to r, when given.
+	double sample(const Case& c, size_t batch, Result* r = nullptr) {
+		if (c.prepare) c.prepare();
+		const uint64_t allocsBefore = pokepp::HeapCounter::allocations();
+		const uint64_t bytesBefore = pokepp::HeapCounter::bytes();
+		auto start = Clock::now();
+		for (size_t i = 0; i < batch; ++i) c.op();
+		auto end = Clock::now();
+		if (r) {
+			r->allocs += pokepp::HeapCounter::allocations() - allocsBefore;
+			r->allocBytes += pokepp::HeapCounter::bytes() - bytesBefore;
+		}
+		return std::chrono::duration<double, std::nano>(end - start).count() / batch;
+	}
+
+	Result run(const Case& c, const Options& opt) {
+		if (c.init) c.init();
+
+		// Warm up, doubling the batch until a sample is long enough to time reliably
+		Result r;
+		r.name = c.name;
+		r.itemsPerOp = c.itemsPerOp;
+		r.steady = c.steady;
+		const double minSampleNs = opt.minSampleMs * 1e6;
+		auto warmupStart = Clock::now();
+		do {
+			double ns = sample(c, r.batch);
+			bool canGrow = !c.maxBatch || r.batch * 2 <= c.maxBatch;
+			if (ns * r.batch < minSampleNs && canGrow) r.batch *= 2;
+		} while (std::chrono::duration<double, std::milli>(Clock::now() - warmupStart).count() < opt.warmupMs);
+
+		r.samples.reserve(opt.reps);
+		const pokepp::GlCallCounts glBefore = pokepp::GlCounters::total();
+		for (int i = 0; i < opt.reps; ++i) r.samples.push_back(sample(c, r.batch, &r));
+		r.gl = pokepp::GlCounters::total().minus(glBefore);
+		r.ops = r.batch * opt.reps;
+		summarize(r);
+		return r;
+	}
+
+	// Files under dir (recursively) with one of the extensions, sorted
+	std::vector<std::string> findFiles(const std::string& dir, std::initializer_list<const char*> extensions) {
+		std::vector<std::string> out;
+		std::error_code ec;
+		for (auto it = std::filesystem::recursive_directory_iterator(dir, ec);
+			!ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+			if (!it->is_regular_file()) continue;
+			std::string ext = it->path().extension().string();
+			std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char ch) { return std::tolower(ch); });
+			for (const char* e : extensions) {
+				if (ext == e) out.push_back(it->path().generic_string());
+			}
+		}
+		std::sort(out.begin(), out.end());
+		return out;
+	}
+
+	std::string fileName(const std::string& path) {
+		return std::filesystem::path(path).filename().string();
+	}
+
+	// The game's species without models, so no GL is needed
+	std::vector<pokepp::PokemonSpecies> benchSpecies() {
+		return {
+			{ .name = "Pikachu", .model = nullptr, .displayColor = glm::vec3(1.0f, 0.9f, 0.2f), .catchRate = 0.7f },
+			{ .name = "Charmander", .model = nullptr, .displayColor = glm::vec3(1.0f, 0.5f, 0.1f), .catchRate = 0.3f },
+			{ .name = "Squirtle", .model = nullptr, .displayColor = glm::vec3(0.3f, 0.6f, 1.0f), .catchRate = 0.5f },
+			{ .name = "Bulbasaur", .model = nullptr, .displayColor = glm::vec3(0.3f, 0.8f, 0.4f), .catchRate = 0.5f },
+		};
+	}
+
+	// A headless simulation on the default world with 200 rocks and `pokemon` Pokemon
+	std::unique_ptr<pokepp::Simulation> makeSimulation(int pokemon) {
+		pokepp::SceneWorld world;
+		auto sim = std::make_unique<pokepp::Simulation>();
+		sim->setSeed(1);
+		sim->setDeterministic(true);
+		if (!sim->loadWorld(world.heightmap.c_str(), world.cellSize, world.heightScale, false)) {
+			std::fprintf(stderr, "Failed to load heightmap %s\n", world.heightmap.c_str());
+			std::exit(1);
+		}
+		sim->setSpecies(benchSpecies());
+		pokepp::ScenePropSet rocks;
+		rocks.count = 200;
+		sim->scatterProps(rocks);
+		if (pokemon > 0) sim->scatterPokemon({ .count = pokemon });
+		sim->buildNavigation();
+
+		glm::vec3& player = sim->player().position;
+		player = glm::vec3(0.0f, sim->world()->heightAt(0.0f, 0.0f) + sim->player().eyeHeight, 0.0f);
+		return sim;
+	}
+
+	void destroyPokeballs(pokepp::Simulation& sim) {
+		std::vector<pokepp::Entity> balls;
+		sim.entities().each<pokepp::Pokeball>([&](pokepp::Entity e, pokepp::Pokeball&) { balls.push_back(e); });
+		for (pokepp::Entity e : balls) sim.entities().destroy(e);
+	}
+
+	// Throw `count` balls from random points over the arena, at `height` above the terrain
+	void throwPokeballs(pokepp::Simulation& sim, int count, float height, float speed) {
+		pokepp::Random& random = sim.random();
+		glm::vec2 half = sim.world()->halfExtents() * 0.9f;
+		for (int i = 0; i < count; ++i) {
+			float x = random.range(-half.x, half.x), z = random.range(-half.y, half.y);
+			glm::vec3 origin(x, sim.world()->heightAt(x, z) + height, z);
+			glm::vec3 dir(random.range(-1.0f, 1.0f), random.range(0.1f, 0.4f), random.range(-1.0f, 1.0f));
+			sim.throwPokeball(origin, dir, speed);
+		}
+	}
+
+	void addWorldCases(std::vector<Case>& cases, bool gl) {
+		constexpr size_t QUERIES = 4096;
+		struct State {
+			std::unique_ptr<pokepp::World> world;
+			std::vector<glm::vec2> random, coherent;
+		};
+		auto state = std::make_shared<State>();
+		auto init = [state] {
+			if (state->world) return;
+			pokepp::SceneWorld w;
+			state->world = pokepp::World::FromHeightMap(w.heightmap.c_str(), w.cellSize, w.heightScale, false);
+			if (!state->world) {
+				std::fprintf(stderr, "Failed to load heightmap %s\n", w.heightmap.c_str());
+				std::exit(1);
+			}
+
+			// Random points over the terrain, and a walk in small steps (neighbouring cells)
+			glm::vec2 half = state->world->halfExtents();
+			pokepp::Random random(7);
+			glm::vec2 p(0.0f);
+			for (size_t i = 0; i < QUERIES; ++i) {
+				state->random.emplace_back(random.range(-half.x, half.x), random.range(-half.y, half.y));
+				p += glm::vec2(random.range(-0.3f, 0.5f), random.range(-0.3f, 0.5f));
+				p = glm::clamp(p, -half, half);
+				state->coherent.push_back(p);
+			}
+		};
+
+		for (bool coherent : { false, true }) {
+			const char* access = coherent ? "coherent" : "random";
+			cases.push_back({ .name = std::string("world.heightAt/") + access, .itemsPerOp = QUERIES, .steady = true, .init = init,
+				.op = [state, coherent] {
+					float sum = 0.0f;
+					for (const glm::vec2& q : coherent ? state->coherent : state->random) sum += state->world->heightAt(q.x, q.y);
+					g_sink = sum;
+				} });
+			cases.push_back({ .name = std::string("world.normalAt/") + access, .itemsPerOp = QUERIES, .steady = true, .init = init,
+				.op = [state, coherent] {
+					float sum = 0.0f;
+					for (const glm::vec2& q : coherent ? state->coherent : state->random) sum += state->world->normalAt(q.x, q.y).y;
+					g_sink = sum;
+				} });
+		}
+
+		for (bool withMesh : { false, true }) {
+			if (withMesh && !gl) continue;
+			cases.push_back({ .name = withMesh ? "world.fromHeightMap/mesh" : "world.fromHeightMap/heights",
+				.op = [withMesh] {
+					pokepp::SceneWorld w;
+					auto world = pokepp::World::FromHeightMap(w.heightmap.c_str(), w.cellSize, w.heightScale, withMesh);
+					g_sink = world ? world->heightAt(0.0f, 0.0f) : 0.0f;
+				} });
+		}
+	}
+
+	void addAssetCases(std::vector<Case>& cases, bool gl) {
+		for (const std::string& path : findFiles("assets/models", { ".obj" })) {
+			cases.push_back({ .name = "obj.parse/" + fileName(path),
+				.op = [path] {
+					tinyobj::attrib_t attrib;
+					std::vector<tinyobj::shape_t> shapes;
+					std::vector<tinyobj::material_t> materials;
+					std::string warn, err;
+					std::string dir = std::filesystem::path(path).parent_path().generic_string();
+					tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str(), dir.c_str(), true);
+					g_sink = static_cast<float>(attrib.vertices.size());
+				} });
+			if (gl) {
+				cases.push_back({ .name = "model.load/" + fileName(path),
+					.op = [path] {
+						pokepp::Model model(path);
+						g_sink = static_cast<float>(model.materials().size());
+					} });
+			}
+		}
+
+		for (const std::string& path : findFiles("assets", { ".png", ".jpg" })) {
+			auto bytes = std::make_shared<std::vector<unsigned char>>();
+			cases.push_back({ .name = "image.decode/" + fileName(path),
+				.init = [path, bytes] {
+					std::ifstream in(path, std::ios::binary);
+					bytes->assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+					stbi_set_flip_vertically_on_load(1);  // As Texture does
+				},
+				.op = [bytes] {
+					int w = 0, h = 0, channels = 0;
+					stbi_uc* data = stbi_load_from_memory(bytes->data(), static_cast<int>(bytes->size()), &w, &h, &channels, 0);
+					g_sink = data ? float(data[0]) : 0.0f;
+					stbi_image_free(data);
+				} });
+		}
+	}
+
+	void addSimulationCases(std::vector<Case>& cases, int maxEntities) {
+		const float dt = 1.0f / 60.0f;
+		for (int n = 100; n <= maxEntities; n *= 10) {
+			const std::string suffix = "/" + std::to_string(n);
+
+			// Pokemon wander, flee and separate; no balls
+			auto updateSim = std::make_shared<std::unique_ptr<pokepp::Simulation>>();
+			cases.push_back({ .name = "pokemon.updateAll" + suffix, .itemsPerOp = size_t(n), .steady = true,
+				.init = [updateSim, n] { if (!*updateSim) *updateSim = makeSimulation(n); },
+				.op = [updateSim, dt] {
+					static const std::vector<glm::vec3> noObstacles;  // The navigation grid has the props
+					pokepp::Simulation& sim = **updateSim;
+					sim.pokemon().updateAll(dt, sim.world(), noObstacles, sim.player().position);
+				} });
+
+			// Balls hang out of reach, so every pass tests every pair and nothing changes
+			auto captureSim = std::make_shared<std::unique_ptr<pokepp::Simulation>>();
+			cases.push_back({ .name = "pokemon.capture" + suffix, .itemsPerOp = size_t(n), .steady = true,
+				.init = [captureSim, n] {
+					if (*captureSim) return;
+					*captureSim = makeSimulation(n);
+					throwPokeballs(**captureSim, 64, 50.0f, 0.0f);
+				},
+				.op = [captureSim, dt] { (*captureSim)->pokemon().handlePokeballCapture(dt); } });
+
+			// Fresh balls for each sample, so a sample is flight and bounces rather than rest
+			auto ballSim = std::make_shared<std::unique_ptr<pokepp::Simulation>>();
+			cases.push_back({ .name = "pokeball.substep" + suffix, .itemsPerOp = size_t(n), .maxBatch = 64, .steady = true,
+				.init = [ballSim, n] {
+					if (*ballSim) return;
+					*ballSim = makeSimulation(0);
+					(*ballSim)->setPokeballPool(size_t(n), pokepp::PokeballOverflow::Reject);
+				},
+				.prepare = [ballSim, n] {
+					destroyPokeballs(**ballSim);
+					throwPokeballs(**ballSim, n, 2.0f, 10.0f);
+				},
+				.op = [ballSim] { (*ballSim)->stepPokeballs(pokepp::constants::PHYSICS_TIMESTEP); } });
+		}
+	}
+
+	// A hidden window with a GL 3.3 core context for the cases that upload to the GPU
+	bool createGLContext(SDL_Window*& window, SDL_GLContext& context) {
+		if (SDL_Init(SDL_INIT_VIDEO) != 0) return false;
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		window = SDL_CreateWindow("pokepp_bench", 0, 0, 64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+		if (!window) return false;
+		context = SDL_GL_CreateContext(window);
+		if (!context) return false;
+		SDL_GL_MakeCurrent(window, context);
+		if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) return false;
+		pokepp::GlCounters::install();
+		return true;
+	}
+
+	void printResult(const Result& r) {
+		std::printf("%-34s %8zu %12.1f %8.1f%% %12.1f %12.1f", r.name.c_str(), r.batch, r.median,
+			r.median > 0.0 ? 100.0 * r.mad / r.median : 0.0, r.min, r.mean);
+		if (r.itemsPerOp > 1) std::printf(" %12.2f", r.median / r.itemsPerOp);
+		std::printf("\n");
+		if (r.allocs > 0) {
+			std::printf("%-34s heap allocs/op %.2f, bytes/op %.0f%s\n", "", double(r.allocs) / r.ops,
+				double(r.allocBytes) / r.ops, r.steady ? " (steady-state case)" : "");
+		}
+		if (r.gl.total() > 0) {
+			std::printf("%-34s gl calls/op %.1f, draws %.1f, binds %.1f\n", "", double(r.gl.total()) / r.ops,
+				double(r.gl.draws()) / r.ops,
+				double(r.gl[pokepp::GlCall::UseProgram] + r.gl[pokepp::GlCall::BindVertexArray] + r.gl[pokepp::GlCall::BindTexture]) / r.ops);
+		}
+		std::fflush(stdout);
+	}
+
+	bool writeJson(const std::string& path, const Options& opt, const std::vector<Result>& results) {
+		std::FILE* f = std::fopen(path.c_str(), "wb");
+		if (!f) return false;
+
+		std::fprintf(f, "{\n  \"suite\": \"pokepp_bench\",\n  \"version\": 1,\n");
+		std::fprintf(f, "  \"config\": {\"reps\": %d, \"warmupMs\": %g, \"minSampleMs\": %g, \"maxEntities\": %d},\n",
+			opt.reps, opt.warmupMs, opt.minSampleMs, opt.maxEntities);
+		std::fprintf(f, "  \"results\": [\n");
+		for (size_t i = 0; i < results.size(); ++i) {
+			const Result& r = results[i];
+			std::fprintf(f, "    {\"name\": \"%s\", \"unit\": \"ns\", \"itemsPerOp\": %zu, \"batch\": %zu, "
+				"\"median\": %.3f, \"mad\": %.3f, \"min\": %.3f, \"max\": %.3f, \"mean\": %.3f, \"stddev\": %.3f, \"samples\": [",
+				r.name.c_str(), r.itemsPerOp, r.batch, r.median, r.mad, r.min, r.max, r.mean, r.stddev);
+			for (size_t s = 0; s < r.samples.size(); ++s) {
+				std::fprintf(f, "%s%.3f", s ? ", " : "", r.samples[s]);
+			}
+			std::fprintf(f, "], \"allocsPerOp\": %.3f, \"allocBytesPerOp\": %.1f",
+				r.ops ? double(r.allocs) / r.ops : 0.0, r.ops ? double(r.allocBytes) / r.ops : 0.0);
+
+			// GL calls per operation, by entry point, with the redundant binds
+			if (r.gl.total() > 0) {
+				std::fprintf(f, ", \"glPerOp\": {");
+				for (size_t k = 0; k < pokepp::GlCallCounts::KINDS; ++k) {
+					std::fprintf(f, "%s\"%s\": %.3f", k ? ", " : "", pokepp::glCallName(static_cast<pokepp::GlCall>(k)),
+						double(r.gl.calls[k]) / r.ops);
+				}
+				std::fprintf(f, "}, \"glRedundantBindsPerOp\": %.3f",
+					double(r.gl.redundantOf(pokepp::GlCall::UseProgram) + r.gl.redundantOf(pokepp::GlCall::BindVertexArray)
+						+ r.gl.redundantOf(pokepp::GlCall::BindTexture)) / r.ops);
+			}
+			std::fprintf(f, "}%s\n", i + 1 < results.size() ? "," : "");
+		}
+		std::fprintf(f, "  ]\n}\n");
+		return std::fclose(f) == 0;
+	}
+
+	// Read the names and samples of a file written by writeJson
+	bool readJson(const std::string& path, std::vector<Result>& out) {
+		std::ifstream in(path, std::ios::binary);
+		if (!in) return false;
+		const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+		const std::string nameKey = "\"name\": \"", itemsKey = "\"itemsPerOp\": ", samplesKey = "\"samples\": [";
+		for (size_t pos = text.find(nameKey); pos != std::string::npos; pos = text.find(nameKey, pos)) {
+			Result r;
+			size_t begin = pos + nameKey.size(), end = text.find('"', begin);
+			size_t items = text.find(itemsKey, end), samples = text.find(samplesKey, end);
+			if (end == std::string::npos || samples == std::string::npos) return false;
+			r.name = text.substr(begin, end - begin);
+			if (items != std::string::npos && items < samples) r.itemsPerOp = std::strtoull(text.c_str() + items + itemsKey.size(), nullptr, 10);
+
+			const char* p = text.c_str() + samples + samplesKey.size();
+			while (*p && *p != ']') {
+				char* next = nullptr;
+				double v = std::strtod(p, &next);
+				if (next == p) { ++p; continue; }  // Separator
+				r.samples.push_back(v);
+				p = next;
+			}
+			if (r.samples.empty()) return false;
+			summarize(r);
+			out.push_back(std::move(r));
+			pos = static_cast<size_t>(p - text.c_str());
+		}
+		return true;
+	}
+
+	// One-sided p-values of the Mann-Whitney U test that a tends to be greater (or less)
+	// than b, by the normal approximation with tie and continuity corrections
+	void mannWhitney(const std::vector<double>& a, const std::vector<double>& b, double& pGreater, double& pLess) {
+		struct Value { double v; bool fromA; };
+		std::vector<Value> all;
+		for (double v : a) all.push_back({ v, true });
+		for (double v : b) all.push_back({ v, false });
+		std::sort(all.begin(), all.end(), [](const Value& x, const Value& y) { return x.v < y.v; });
+
+		// Rank sum of a, averaging the ranks of ties
+		const double n1 = double(a.size()), n2 = double(b.size()), n = n1 + n2;
+		double rankSum = 0.0, tieTerm = 0.0;
+		for (size_t i = 0; i < all.size(); ) {
+			size_t j = i;
+			while (j < all.size() && all[j].v == all[i].v) ++j;
+			double rank = 0.5 * (i + 1 + j);  // Ranks i+1 .. j
+			for (size_t k = i; k < j; ++k) {
+				if (all[k].fromA) rankSum += rank;
+			}
+			double t = double(j - i);
+			tieTerm += t * t * t - t;
+			i = j;
+		}
+
+		const double u = rankSum - n1 * (n1 + 1.0) / 2.0;
+		const double mean = n1 * n2 / 2.0;
+		const double var = n1 * n2 / 12.0 * ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+		if (var <= 0.0) {
+			pGreater = pLess = 1.0;
+			return;
+		}
+		const double sd = std::sqrt(var);
+		pGreater = 0.5 * std::erfc((u - mean - 0.5) / sd / std::sqrt(2.0));
+		pLess = 0.5 * std::erfc((mean - u - 0.5) / sd / std::sqrt(2.0));
+	}
+
+	// Bootstrap 95% percentile interval of median(current) / median(baseline)
+	void bootstrapRatio(const std::vector<double>& current, const std::vector<double>& baseline, double& lo, double& hi) {
+		constexpr int RESAMPLES = 2000;
+		pokepp::Random random(12345);
+		std::vector<double> ratios, a(current.size()), b(baseline.size());
+		ratios.reserve(RESAMPLES);
+		for (int i = 0; i < RESAMPLES; ++i) {
+			for (double& v : a) v = current[random.index(uint32_t(current.size()))];
+			for (double& v : b) v = baseline[random.index(uint32_t(baseline.size()))];
+			double mb = median(b);
+			if (mb > 0.0) ratios.push_back(median(a) / mb);
+		}
+		if (ratios.empty()) {
+			lo = hi = 1.0;
+			return;
+		}
+		std::sort(ratios.begin(), ratios.end());
+		lo = ratios[size_t(0.025 * (ratios.size() - 1))];
+		hi = ratios[size_t(0.975 * (ratios.size() - 1))];
+	}
+
+	// Print a diff table of current against baseline; returns the number of regressions
+	int compare(const std::vector<Result>& baseline, const std::vector<Result>& current, const Options& opt) {
+		std::printf("\ncomparison against %s (alpha %.3g, threshold %.1f%%)\n", opt.baselinePath.c_str(), opt.alpha, 100.0 * opt.threshold);
+		std::printf("%-34s %12s %12s %8s %17s %9s  %s\n", "case", "base ns", "current ns", "change", "95% ci", "p", "verdict");
+
+		int regressions = 0, improvements = 0;
+		for (const Result& cur : current) {
+			auto it = std::find_if(baseline.begin(), baseline.end(), [&](const Result& r) { return r.name == cur.name; });
+			if (it == baseline.end()) {
+				std::printf("%-34s %12s %12.1f %8s %17s %9s  new\n", cur.name.c_str(), "-", cur.median, "", "", "");
+				continue;
+			}
+
+			const Result& base = *it;
+			double pGreater, pLess, lo, hi;
+			mannWhitney(cur.samples, base.samples, pGreater, pLess);
+			bootstrapRatio(cur.samples, base.samples, lo, hi);
+			double p = std::min(1.0, 2.0 * std::min(pGreater, pLess));
+			double ratio = base.median > 0.0 ? cur.median / base.median : 1.0;
+
+			const char* verdict = "~";
+			if (p < opt.alpha && lo > 1.0 + opt.threshold) {
+				verdict = "REGRESSION";
+				++regressions;
+			} else if (p < opt.alpha && hi < 1.0 - opt.threshold) {
+				verdict = "improved";
+				++improvements;
+			} else if (p < opt.alpha) {
+				verdict = "~ (within threshold)";
+			}
+
+			char ci[32];
+			std::snprintf(ci, sizeof(ci), "[%+.1f%%, %+.1f%%]", 100.0 * (lo - 1.0), 100.0 * (hi - 1.0));
+			std::printf("%-34s %12.1f %12.1f %+7.1f%% %17s %9.2g  %s\n", cur.name.c_str(), base.median, cur.median,
+				100.0 * (ratio - 1.0), ci, p, verdict);
+		}
+		for (const Result& base : baseline) {
+			auto it = std::find_if(current.begin(), current.end(), [&](const Result& r) { return r.name == base.name; });
+			if (it == current.end() && (opt.filter.empty() || base.name.find(opt.filter) != std::string::npos)) {
+				std::printf("%-34s %12.1f %12s %8s %17s %9s  not run\n", base.name.c_str(), base.median, "-", "", "", "");
+			}
+		}
+
+		std::printf("%zu compared: %d regressions, %d improvements\n", current.size(), regressions, improvements);
+		return regressions;
+	}
+}
+
+int main(int argc, char** argv) {
+	Options opt;
+	if (!parseArgs(argc, argv, opt)) return 1;
+
+	std::vector<Result> baseline;
+	if (!opt.baselinePath.empty() && !readJson(opt.baselinePath, baseline)) {
+		std::fprintf(stderr, "Failed to read baseline %s\n", opt.baselinePath.c_str());
+		return 1;
+	}
+
+	// Compare two result files without running anything
+	if (!opt.currentPath.empty()) {
+		std::vector<Result> current;
+		if (!readJson(opt.currentPath, current)) {
+			std::fprintf(stderr, "Failed to read %s\n", opt.currentPath.c_str());
+			return 1;
+		}
+		if (baseline.empty()) {
+			std::fprintf(stderr, "--current needs a --baseline to compare against\n");
+			return 1;
+		}
+		return compare(baseline, current, opt) > 0 ? 2 : 0;
+	}
+
+	SDL_Window* window = nullptr;
+	SDL_GLContext context = nullptr;
+	bool gl = opt.gl && !opt.list && createGLContext(window, context);
+	if (opt.gl && !opt.list && !gl) std::printf("No GL 3.3 context: skipping GL cases\n");
+
+	std::vector<Case> cases;
+	addWorldCases(cases, gl || opt.list);
+	addAssetCases(cases, gl || opt.list);
+	addSimulationCases(cases, opt.maxEntities);
+
+	if (opt.list) {
+		for (const Case& c : cases) std::printf("%s\n", c.name.c_str());
+		return 0;
+	}
+
+	std::printf("pokepp_bench: %d reps, %.0f ms warmup, %.0f ms min sample\n", opt.reps, opt.warmupMs, opt.minSampleMs);
+	std::printf("%-34s %8s %12s %9s %12s %12s %12s\n", "case", "batch", "median ns", "mad", "min ns", "mean ns", "ns/item");
+
+	std::vector<Result> results;
+	for (const Case& c : cases) {
+		if (!opt.filter.empty() && c.name.find(opt.filter) == std::string::npos) continue;
+		results.push_back(run(c, opt));
+		printResult(results.back());
+	}
+
+	int status = 0;
+	if (!opt.jsonPath.empty()) {
+		if (writeJson(opt.jsonPath, opt, results)) {
+			std::printf("results written to %s\n", opt.jsonPath.c_str());
+		} else {
+			std::fprintf(stderr, "Failed to write %s\n", opt.jsonPath.c_str());
+			status = 1;
+		}
+	}
+
+	if (!baseline.empty() && compare(baseline, results, opt) > 0) status = 2;
+
+	if (opt.allocCheck) {
+		int allocating = 0;
+		for (const Result& r : results) {
+			if (!r.steady || r.allocs == 0) continue;
+			std::fprintf(stderr, "heap check: %s made %.2f allocations per operation\n", r.name.c_str(), double(r.allocs) / r.ops);
+			allocating++;
+		}
+		std::printf("heap check: %d steady-state cases allocated\n", allocating);
+		if (allocating > 0 && status == 0) status = 3;
+	}
+
+	// Drop the cases (and the models they own) before the context they were uploaded to
+	cases.clear();
+	if (context) SDL_GL_DeleteContext(context);
+	if (window) SDL_DestroyWindow(window);
+	if (opt.gl && !opt.list) SDL_Quit();
+	return status;
+}
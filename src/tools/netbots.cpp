@@ -0,0 +1,298 @@
+#define SDL_MAIN_HANDLED
+#include "pokeapp/Simulation.h"
+#include "pokeapp/Scene.h"
+#include "pokeapp/PokemonController.h"
+#include "pokeapp/World.h"
+#include "pokeapp/Constants.h"
+#include "pokeapp/NetClient.h"
+#include "pokeapp/NetServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	pokepp_netbots: load generator for the network server.
+
+	Connects bot clients that walk, sprint, jump and throw pokeballs on a script, adding
+	--step of them every --stage seconds up to --clients. For each stage it reports what the
+	server and one client see:
+		tick ms     server tick time (simulation and networking), mean and max, as reported
+		            in the snapshots it sends
+		us/client   the server's networking time (reading inputs, building and sending
+		            snapshots) per connected client and snapshot
+		B/tick      snapshot bytes received per client per server tick
+		delivery    snapshots decoded, of those the server should have sent
+		entities    per snapshot, per client
+	A stage passes if the mean tick time fits --budget-ms and at least 90% of snapshots
+	arrived; the largest passing client count is reported as the maximum. The ramp stops at
+	the first failing stage.
+
+	Without --server it runs a server in-process on a free loopback port, populated from
+	--scene (--pokemon overrides its first Pokemon group's count). On a machine with few
+	cores the bots compete with it for CPU, which counts against the maximum. At the end it
+	checks that the server's frame arena never overflowed to the heap (exit code 2 if it did).
+
+	Usage: pokepp_netbots [--server host:port] [--scene file] [--pokemon N] [--seed S]
+	                      [--clients N] [--step K] [--stage S] [--budget-ms B]
+*/
+
+namespace {
+
+	struct Options {
+		std::string server;  // Empty: run one in-process
+		std::string scene = "assets/scenes/default.scene";
+		int pokemon = -1;
+		unsigned seed = 1;
+		int clients = 64;
+		int step = 8;
+		float stageSeconds = 3.0f;
+		float budgetMs = 1000.0f * pokepp::constants::PHYSICS_TIMESTEP;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	bool parseArgs(int argc, char** argv, Options& opt) {
+		for (int i = 1; i < argc; ++i) {
+			const char* arg = argv[i];
+			const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+			if (!value) {
+				std::fprintf(stderr, "Missing value for %s\n", arg);
+				return false;
+			}
+
+			if (!std::strcmp(arg, "--server")) opt.server = value;
+			else if (!std::strcmp(arg, "--scene")) opt.scene = value;
+			else if (!std::strcmp(arg, "--pokemon")) opt.pokemon = std::atoi(value);
+			else if (!std::strcmp(arg, "--seed")) opt.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+			else if (!std::strcmp(arg, "--clients")) opt.clients = std::max(1, std::atoi(value));
+			else if (!std::strcmp(arg, "--step")) opt.step = std::max(1, std::atoi(value));
+			else if (!std::strcmp(arg, "--stage")) opt.stageSeconds = std::max(1.0f, static_cast<float>(std::atof(value)));
+			else if (!std::strcmp(arg, "--budget-ms")) opt.budgetMs = static_cast<float>(std::atof(value));
+			else {
+				std::fprintf(stderr, "Unknown option %s\n", arg);
+				return false;
+			}
+			++i;
+		}
+		return true;
+	}
+
+	// The in-process server: the simulation populated as pokepp_server does, ticked on its
+	// own thread at the fixed rate until stopped
+	class LocalServer {
+	public:
+		bool start(const Options& opt) {
+			pokepp::Scene scene;
+			if (!pokepp::Scene::Load(opt.scene, scene)) return false;
+			if (opt.pokemon >= 0) {
+				if (scene.pokemon.empty()) scene.pokemon.emplace_back();
+				scene.pokemon[0].count = opt.pokemon;
+				scene.pokemon[0].density = 0.0f;
+			}
+
+			sim_.setSeed(opt.seed);
+			if (!sim_.loadWorld(scene.world.heightmap.c_str(), scene.world.cellSize, scene.world.heightScale, false)) {
+				std::fprintf(stderr, "Failed to load heightmap %s\n", scene.world.heightmap.c_str());
+				return false;
+			}
+			std::vector<pokepp::PokemonSpecies> species;
+			for (const pokepp::SceneSpecies& s : scene.species) {
+				species.push_back({ .name = s.name, .model = nullptr, .displayColor = s.color,
+					.displayScale = s.displayScale, .catchRate = s.catchRate });
+			}
+			sim_.setSpecies(std::move(species));
+			for (size_t i = 0; i < scene.props.size(); ++i) sim_.scatterProps(scene.props[i], nullptr, static_cast<uint32_t>(i));
+			for (const pokepp::ScenePokemonSpawn& spawn : scene.pokemon) sim_.scatterPokemon(spawn);
+			sim_.buildNavigation();
+
+			server_ = std::make_unique<pokepp::NetServer>(sim_, opt.scene, std::max(opt.clients, 1));
+			if (!server_->start(0)) return false;
+			std::printf("in-process server: %s, %zu Pokemon, port %u\n", opt.scene.c_str(),
+				sim_.pokemon().getPokemonCount(), server_->port());
+
+			thread_ = std::thread([this] {
+				const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(pokepp::constants::PHYSICS_TIMESTEP));
+				auto next = Clock::now();
+				while (!stop_.load(std::memory_order_relaxed)) {
+					server_->tick();
+					next += step;
+					auto now = Clock::now();
+					if (now - next > std::chrono::seconds(1)) next = now;
+					std::this_thread::sleep_until(next);
+				}
+			});
+			return true;
+		}
+
+		~LocalServer() { stop(); }
+
+		void stop() {
+			stop_ = true;
+			if (thread_.joinable()) thread_.join();
+		}
+
+		uint16_t port() const { return server_->port(); }
+		const pokepp::NetServerStats& stats() const { return server_->stats(); }  // Once stopped
+
+	private:
+		pokepp::Simulation sim_;
+		std::unique_ptr<pokepp::NetServer> server_;
+		std::thread thread_;
+		std::atomic<bool> stop_{ false };
+	};
+
+	// Bot b's input at time t: circle at its own pace, sprint half of the time, jump every
+	// few seconds and throw about every five
+	pokepp::NetInput botInput(int b, float t) {
+		float yaw = 0.3f * t + b * 2.39996f;
+		pokepp::PlayerInput movement;
+		movement.forward = true;
+		movement.sprint = (static_cast<int>(t / 4.0f + b) % 2) == 1;
+		movement.front = glm::normalize(glm::vec3(std::cos(yaw), -0.1f, std::sin(yaw)));
+
+		pokepp::NetInput input;
+		input.setMovement(movement);
+		input.jumps = static_cast<uint8_t>((t + b * 0.37f) / 3.0f);
+		input.throws = static_cast<uint8_t>((t + b * 0.61f) / 5.0f);
+		input.throwSpeed = static_cast<uint8_t>(8 * (8 + b % 10));
+		return input;
+	}
+
+	struct StageResult {
+		int clients = 0;
+		double tickMsMean = 0.0;
+		double tickMsMax = 0.0;
+		double netMicrosPerClient = 0.0;
+		double bytesPerTick = 0.0;  // Per client
+		double delivery = 0.0;
+		double entities = 0.0;
+		bool pass = false;
+	};
+}
+
+int main(int argc, char** argv) {
+	Options opt;
+	if (!parseArgs(argc, argv, opt)) return 1;
+
+	std::unique_ptr<LocalServer> local;
+	pokepp::NetAddress address;
+	if (opt.server.empty()) {
+		local = std::make_unique<LocalServer>();
+		if (!local->start(opt)) return 1;
+		address = pokepp::NetAddress::Loopback(local->port());
+	} else if (!pokepp::NetAddress::Parse(opt.server, address)) {
+		return 1;
+	}
+
+	std::printf("%8s %16s %10s %10s %10s %9s %9s\n", "clients", "tick ms (max)", "us/client", "B/tick", "KiB/s", "delivery", "entities");
+	std::vector<std::unique_ptr<pokepp::NetClient>> bots;
+	std::vector<uint64_t> bytesBefore, snapshotsBefore;
+	std::vector<StageResult> results;
+	const float frame = 1.0f / 60.0f;
+	const auto frameStep = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(frame));
+	float t = 0.0f;
+
+	while (static_cast<int>(bots.size()) < opt.clients) {
+		int target = std::min(opt.clients, static_cast<int>(bots.size()) + opt.step);
+		while (static_cast<int>(bots.size()) < target) {
+			auto bot = std::make_unique<pokepp::NetClient>();
+			if (!bot->connect(address)) return 1;
+			bots.push_back(std::move(bot));
+		}
+		const pokepp::NetAccept& session = bots.front()->session();
+		const double snapshotsPerSecond = static_cast<double>(session.tickRate) / session.snapshotInterval;
+
+		// Let the new bots settle, then measure the rest of the stage
+		const int frames = static_cast<int>(opt.stageSeconds / frame);
+		const int settle = frames / 4;
+		double tickSum = 0.0, tickMax = 0.0, netSum = 0.0, entitySum = 0.0;
+		int samples = 0;
+		uint32_t tickStart = 0, tickEnd = 0;
+		auto measureStart = Clock::now();
+		auto next = Clock::now();
+		for (int f = 0; f < frames; ++f) {
+			for (size_t b = 0; b < bots.size(); ++b) bots[b]->update(frame, botInput(static_cast<int>(b), t));
+			t += frame;
+
+			if (f == settle) {
+				bytesBefore.assign(bots.size(), 0);
+				snapshotsBefore.assign(bots.size(), 0);
+				for (size_t b = 0; b < bots.size(); ++b) {
+					bytesBefore[b] = bots[b]->stats().bytesReceived;
+					snapshotsBefore[b] = bots[b]->stats().snapshots;
+				}
+				tickStart = bots.front()->stats().serverTick;
+				measureStart = Clock::now();
+			} else if (f > settle) {
+				// Server figures from the newest snapshot header, once per frame
+				const pokepp::NetClientStats& s = bots.front()->stats();
+				tickSum += s.serverTickMicros / 1000.0;
+				tickMax = std::max(tickMax, s.serverTickMicros / 1000.0);
+				netSum += s.serverNetMicros / std::max<double>(s.serverClients, 1);
+				entitySum += s.entities;
+				samples++;
+			}
+
+			next += frameStep;
+			auto now = Clock::now();
+			if (now - next > std::chrono::seconds(1)) next = now;
+			std::this_thread::sleep_until(next);
+		}
+		tickEnd = bots.front()->stats().serverTick;
+		double seconds = std::chrono::duration<double>(Clock::now() - measureStart).count();
+
+		uint64_t bytes = 0, snapshots = 0;
+		for (size_t b = 0; b < bots.size(); ++b) {
+			bytes += bots[b]->stats().bytesReceived - bytesBefore[b];
+			snapshots += bots[b]->stats().snapshots - snapshotsBefore[b];
+		}
+		StageResult r;
+		r.clients = static_cast<int>(bots.size());
+		samples = std::max(samples, 1);
+		r.tickMsMean = tickSum / samples;
+		r.tickMsMax = tickMax;
+		r.netMicrosPerClient = netSum / samples;
+		double ticks = std::max<double>(tickEnd - tickStart, 1.0);
+		r.bytesPerTick = static_cast<double>(bytes) / bots.size() / ticks;
+		r.delivery = snapshots / (seconds * snapshotsPerSecond * bots.size());
+		r.entities = entitySum / samples;
+		r.pass = r.tickMsMean <= opt.budgetMs && r.delivery >= 0.9;
+		results.push_back(r);
+
+		std::printf("%8d %7.3f (%6.3f) %10.1f %10.1f %10.1f %8.1f%% %9.0f%s\n", r.clients, r.tickMsMean, r.tickMsMax,
+			r.netMicrosPerClient, r.bytesPerTick, bytes / 1024.0 / bots.size() / seconds, 100.0 * r.delivery, r.entities,
+			r.pass ? "" : "  over budget");
+		std::fflush(stdout);
+		if (!r.pass) break;
+	}
+
+	int best = 0;
+	for (const StageResult& r : results) {
+		if (r.pass) best = std::max(best, r.clients);
+	}
+	const pokepp::NetClientStats& s = bots.front()->stats();
+	std::printf("bot 0: %llu snapshots (%llu full), %llu incomplete, %llu undecodable\n",
+		static_cast<unsigned long long>(s.snapshots), static_cast<unsigned long long>(s.fullSnapshots),
+		static_cast<unsigned long long>(s.incomplete), static_cast<unsigned long long>(s.undecodable));
+	std::printf("max clients within %.2f ms per tick: %d%s\n", opt.budgetMs, best,
+		best == opt.clients ? " (all; raise --clients to find the limit)" : "");
+
+	bots.clear();  // Disconnect before the local server stops
+	if (local) {
+		// The server resets its frame arena every tick, so the arena's block must cover a tick
+		local->stop();
+		size_t overflows = local->stats().arenaOverflows;
+		std::printf("server frame arena: %zu overflows\n", overflows);
+		if (overflows > 0) return 2;
+	}
+	return 0;
+}
@@ -0,0 +1,48 @@
+#define SDL_MAIN_HANDLED
+#include "pokeapp/Scene.h"
+
+#include <chrono>
+#include <cstdio>
+
+/*
+	pokepp_scenec: compiles a text scene into the binary .pscene form, which loads without
+	any text parsing. Prints how long each form takes to load.
+
+	Usage: pokepp_scenec <in.scene> <out.pscene>
+*/
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	double msSince(Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		std::fprintf(stderr, "Usage: pokepp_scenec <in.scene> <out.pscene>\n");
+		return 1;
+	}
+
+	auto start = Clock::now();
+	pokepp::Scene scene;
+	if (!pokepp::Scene::Load(argv[1], scene)) return 1;
+	double textMs = msSince(start);
+
+	if (!scene.saveBinary(argv[2])) {
+		std::fprintf(stderr, "Failed to write %s\n", argv[2]);
+		return 1;
+	}
+
+	// Load it back, both to check it and to compare load times
+	start = Clock::now();
+	pokepp::Scene check;
+	if (!pokepp::Scene::Load(argv[2], check)) return 1;
+	double binaryMs = msSince(start);
+
+	std::printf("%s: %zu species, %zu prop sets, %zu Pokemon groups, %d balls\n", argv[1],
+		scene.species.size(), scene.props.size(), scene.pokemon.size(), scene.balls);
+	std::printf("loaded in %.3f ms as text, %.3f ms as %s\n", textMs, binaryMs, argv[2]);
+	return 0;
+}
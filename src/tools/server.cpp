@@ -0,0 +1,164 @@
+#define SDL_MAIN_HANDLED
+#include "pokeapp/Simulation.h"
+#include "pokeapp/Scene.h"
+#include "pokeapp/PokemonController.h"
+#include "pokeapp/CollisionWorld.h"
+#include "pokeapp/World.h"
+#include "pokeapp/Constants.h"
+#include "pokeapp/NetServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	pokepp_server: headless authoritative game server.
+
+	Populates a scene (its heightmap without a mesh, props and Pokemon; no GL context) and
+	runs the simulation at a fixed PHYSICS_TIMESTEP tick, serving clients over UDP (see
+	NetServer). Clients connect with `pokepp --connect host:port` or pokepp_netbots. Once a
+	second it prints the client count, the tick time (simulation and networking), the
+	networking share per client and the bytes sent.
+
+	It listens on the loopback interface unless --public is given. --pokemon overrides the
+	count of the scene's first Pokemon group. --seconds stops it after that long (0 runs
+	until killed).
+
+	Usage: pokepp_server [--scene file] [--port P] [--seed S] [--pokemon N] [--max-clients N]
+	                     [--seconds T] [--public]
+*/
+
+namespace {
+
+	struct Options {
+		std::string scene = "assets/scenes/default.scene";
+		int port = pokepp::constants::NET_DEFAULT_PORT;
+		unsigned seed = 1;
+		int pokemon = -1;  // -1 keeps the scene's count
+		int maxClients = pokepp::constants::NET_MAX_CLIENTS;
+		float seconds = 0.0f;
+		bool loopbackOnly = true;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	bool parseArgs(int argc, char** argv, Options& opt) {
+		for (int i = 1; i < argc; ++i) {
+			const char* arg = argv[i];
+			if (!std::strcmp(arg, "--public")) {
+				opt.loopbackOnly = false;
+				continue;
+			}
+
+			const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+			if (!value) {
+				std::fprintf(stderr, "Missing value for %s\n", arg);
+				return false;
+			}
+
+			if (!std::strcmp(arg, "--scene")) opt.scene = value;
+			else if (!std::strcmp(arg, "--port")) opt.port = std::atoi(value);
+			else if (!std::strcmp(arg, "--seed")) opt.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+			else if (!std::strcmp(arg, "--pokemon")) opt.pokemon = std::atoi(value);
+			else if (!std::strcmp(arg, "--max-clients")) opt.maxClients = std::max(1, std::atoi(value));
+			else if (!std::strcmp(arg, "--seconds")) opt.seconds = static_cast<float>(std::atof(value));
+			else {
+				std::fprintf(stderr, "Unknown option %s\n", arg);
+				return false;
+			}
+			++i;
+		}
+		if (opt.port < 0 || opt.port > 65535) {
+			std::fprintf(stderr, "Invalid port %d\n", opt.port);
+			return false;
+		}
+		return true;
+	}
+
+	// Populate the simulation as the game does for a scene, without models. Clients repeat
+	// the prop scatter with the same seed, so it must come first.
+	bool populate(pokepp::Simulation& sim, pokepp::Scene& scene, const Options& opt) {
+		if (opt.pokemon >= 0) {
+			if (scene.pokemon.empty()) scene.pokemon.emplace_back();
+			scene.pokemon[0].count = opt.pokemon;
+			scene.pokemon[0].density = 0.0f;
+		}
+
+		sim.setSeed(opt.seed);
+		if (!sim.loadWorld(scene.world.heightmap.c_str(), scene.world.cellSize, scene.world.heightScale, false)) {
+			std::fprintf(stderr, "Failed to load heightmap %s\n", scene.world.heightmap.c_str());
+			return false;
+		}
+		std::vector<pokepp::PokemonSpecies> species;
+		for (const pokepp::SceneSpecies& s : scene.species) {
+			species.push_back({ .name = s.name, .model = nullptr, .displayColor = s.color,
+				.displayScale = s.displayScale, .catchRate = s.catchRate });
+		}
+		sim.setSpecies(std::move(species));
+		for (size_t i = 0; i < scene.props.size(); ++i) sim.scatterProps(scene.props[i], nullptr, static_cast<uint32_t>(i));
+		for (const pokepp::ScenePokemonSpawn& spawn : scene.pokemon) sim.scatterPokemon(spawn);
+		sim.buildNavigation();
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	Options opt;
+	if (!parseArgs(argc, argv, opt)) return 1;
+
+	pokepp::Scene scene;
+	if (!pokepp::Scene::Load(opt.scene, scene)) return 1;
+	pokepp::Simulation sim;
+	if (!populate(sim, scene, opt)) return 1;
+
+	pokepp::NetServer server(sim, opt.scene, opt.maxClients);
+	if (!server.start(static_cast<uint16_t>(opt.port), opt.loopbackOnly)) return 1;
+	std::printf("pokepp_server: %s, %zu Pokemon, %zu props (seed %u), listening on %s port %u\n",
+		opt.scene.c_str(), sim.pokemon().getPokemonCount(), sim.collision().boxes().size(), opt.seed,
+		opt.loopbackOnly ? "loopback" : "all interfaces", server.port());
+	std::fflush(stdout);
+
+	const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(pokepp::constants::PHYSICS_TIMESTEP));
+	const int ticksPerSecond = std::max(1, static_cast<int>(std::lround(1.0f / pokepp::constants::PHYSICS_TIMESTEP)));
+	const long long totalTicks = opt.seconds > 0.0f ? std::llround(opt.seconds * ticksPerSecond) : -1;
+
+	double tickMsSum = 0.0, tickMsMax = 0.0, netMsSum = 0.0;
+	uint64_t bytesBefore = 0;
+	auto next = Clock::now();
+	for (long long t = 0; totalTicks < 0 || t < totalTicks; ++t) {
+		server.tick();
+		const pokepp::NetServerStats& stats = server.stats();
+		tickMsSum += stats.tickMs;
+		tickMsMax = std::max(tickMsMax, stats.tickMs);
+		netMsSum += stats.netMs;
+
+		if ((t + 1) % ticksPerSecond == 0) {
+			size_t clients = std::max<size_t>(stats.clients, 1);
+			std::printf("tick %u: %zu clients, tick %.3f ms avg (%.3f max), net %.3f ms (%.1f us/client), sent %.1f KiB/s\n",
+				stats.tick, stats.clients, tickMsSum / ticksPerSecond, tickMsMax, netMsSum / ticksPerSecond,
+				1000.0 * netMsSum / ticksPerSecond / clients, (stats.bytesSent - bytesBefore) / 1024.0);
+			std::fflush(stdout);
+			tickMsSum = tickMsMax = netMsSum = 0.0;
+			bytesBefore = stats.bytesSent;
+		}
+
+		// Fixed rate; a server that falls more than a second behind drops the backlog
+		next += step;
+		auto now = Clock::now();
+		if (now - next > std::chrono::seconds(1)) next = now;
+		std::this_thread::sleep_until(next);
+	}
+
+	const pokepp::NetServerStats& stats = server.stats();
+	std::printf("done: %u ticks, %llu clients accepted, %llu rejected, %llu dropped, %llu snapshots (%llu full)\n",
+		stats.tick, static_cast<unsigned long long>(stats.accepted), static_cast<unsigned long long>(stats.rejected),
+		static_cast<unsigned long long>(stats.dropped), static_cast<unsigned long long>(stats.snapshotsSent),
+		static_cast<unsigned long long>(stats.fullSnapshots));
+	return 0;
+}
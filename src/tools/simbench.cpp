@@ -0,0 +1,530 @@
+#define SDL_MAIN_HANDLED
+#include "pokeapp/Simulation.h"
+#include "pokeapp/Scene.h"
+#include "pokeapp/PokemonController.h"
+#include "pokeapp/CollisionWorld.h"
+#include "pokeapp/World.h"
+#include "pokeapp/Constants.h"
+#include "pokeapp/FrameArena.h"
+#include "pokeapp/HeapCounter.h"
+#include "pokeapp/SaveGame.h"
+#include "pokeapp/AutoSave.h"
+#include "pokeapp/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+	pokepp_simbench: headless throughput benchmark for the gameplay simulation.
+
+	Populates a scene (its heightmap without a mesh, props, Pokemon and pokeballs), then runs
+	T fixed ticks with scripted player input (walking in a slow circle, sprinting, jumping and
+	keeping the scene's ball count in the air). Reports ticks per second, and time and heap
+	allocations per tick for each simulation stage. No window or GL context is created.
+
+	Without --scene it uses 2000 Pokemon, 200 rocks and 50 balls on the arena heightmap.
+	--pokemon, --props and --balls override the counts of the scene's first Pokemon and
+	prop groups and its ball count; --heightmap overrides its world.
+
+	--alloc-check W checks every tick after the first W: a tick that spawned or removed no
+	entities must make no heap allocations on the main thread, autosaves and flow field
+	solves included. The first failures are reported (with call stacks in
+	POKEPP_ALLOC_TRACKING builds) and the benchmark exits with code 3. It also fails if fewer
+	than HEAP_CHECK_MIN_STEADY ticks were steady, so a run that spawns on every tick cannot
+	pass by checking nothing.
+
+	--save path saves the end state, loads it into a second simulation and checks that both
+	have the same state hash, re-encode to the same bytes and still agree after running on
+	for another second. Navigation fields are then solved inline (deterministic mode), since
+	a solve still running on a worker is not saved. Reports the save and load times; a
+	mismatch exits with code 4.
+
+	--save-fault KIND (with --save) then damages the save and checks that loading it fails:
+	block-checksum (a byte of a block flipped), table-checksum (a byte of the block table),
+	version, endian (the header's version or endian tag), truncated (the last word cut off).
+	stale-delta instead writes a .delta made against a later save next to it, which must be
+	ignored: the save loads as it was. A damaged save that loads exits with code 4.
+
+	--autosave path autosaves every simulated second (full saves and deltas, see AutoSave),
+	waiting for the previous write first so that no save is skipped and which ones are
+	deltas does not depend on the writer's speed. It reports the main thread snapshot cost
+	and the background write time, and checks that some saves were deltas, that the last
+	one was, and that loading it (the full save plus the delta) gives the state it was
+	taken from (code 4 otherwise). A snapshot taking longer than HUD_SPIKE_MS, a frame's
+	spike threshold in the game, exits with code 6.
+
+	--profiler-overhead B runs the ticks on two copies of the simulation in lockstep instead,
+	one of them with the profiler recording every frame (as the HUD's frame history does),
+	alternating which goes first. It reports the recording copy's median extra time per tick
+	(relative to the median tick) and exits with code 5 if that is more than B percent.
+
+	Usage: pokepp_simbench [--scene file] [--pokemon N] [--props M] [--balls K] [--ticks T]
+	                       [--dt S] [--seed S] [--heightmap path] [--alloc-check W] [--save path]
+	                       [--save-fault KIND] [--autosave path] [--profiler-overhead B]
+*/
+
+namespace {
+
+	struct Options {
+		std::string scene;
+		int pokemon = -1;  // -1 keeps the scene's count
+		int props = -1;
+		int balls = -1;
+		int ticks = 2000;
+		float dt = 1.0f / 60.0f;
+		unsigned seed = 1;
+		std::string heightmap;
+		int allocCheck = -1;  // Warmup ticks before the allocation check, -1 for none
+		std::string save;
+		std::string saveFault;
+		std::string autosave;
+		float profilerBudget = -1.0f;  // Percent, -1 for a normal run
+	};
+
+	// Accumulated cost of one simulation stage
+	struct StageStats {
+		const char* name;
+		double seconds = 0.0;
+		size_t allocs = 0;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	bool parseArgs(int argc, char** argv, Options& opt) {
+		for (int i = 1; i < argc; ++i) {
+			const char* arg = argv[i];
+			const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+			if (!value) {
+				std::fprintf(stderr, "Missing value for %s\n", arg);
+				return false;
+			}
+
+			if (!std::strcmp(arg, "--scene")) opt.scene = value;
+			else if (!std::strcmp(arg, "--pokemon")) opt.pokemon = std::atoi(value);
+			else if (!std::strcmp(arg, "--props")) opt.props = std::atoi(value);
+			else if (!std::strcmp(arg, "--balls")) opt.balls = std::atoi(value);
+			else if (!std::strcmp(arg, "--ticks")) opt.ticks = std::atoi(value);
+			else if (!std::strcmp(arg, "--dt")) opt.dt = static_cast<float>(std::atof(value));
+			else if (!std::strcmp(arg, "--seed")) opt.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+			else if (!std::strcmp(arg, "--heightmap")) opt.heightmap = value;
+			else if (!std::strcmp(arg, "--alloc-check")) opt.allocCheck = std::max(0, std::atoi(value));
+			else if (!std::strcmp(arg, "--save")) opt.save = value;
+			else if (!std::strcmp(arg, "--save-fault")) opt.saveFault = value;
+			else if (!std::strcmp(arg, "--autosave")) opt.autosave = value;
+			else if (!std::strcmp(arg, "--profiler-overhead")) opt.profilerBudget = std::max(0.0f, static_cast<float>(std::atof(value)));
+			else {
+				std::fprintf(stderr, "Unknown option %s\n", arg);
+				return false;
+			}
+			++i;
+		}
+		if (!opt.saveFault.empty() && opt.save.empty()) {
+			std::fprintf(stderr, "--save-fault needs --save\n");
+			return false;
+		}
+		return true;
+	}
+
+	// Damage an encoded save the way --save-fault KIND names (byte offsets from the file
+	// header: version at 4, endian tag at 8, block table from 32). False for an unknown kind.
+	bool damageSave(const std::string& kind, std::vector<uint64_t>& data, size_t& bytes) {
+		auto* b = reinterpret_cast<unsigned char*>(data.data());
+		if (kind == "block-checksum") b[bytes / 2 & ~size_t(7)] ^= 0xFF;
+		else if (kind == "table-checksum") b[36] ^= 0xFF;
+		else if (kind == "version") b[4] = static_cast<unsigned char>(pokepp::SaveGame::VERSION + 1);
+		else if (kind == "endian") std::reverse(b + 8, b + 12);
+		else if (kind == "truncated") bytes -= sizeof(uint64_t);
+		else return false;
+		return true;
+	}
+
+	// The scene used without --scene: the game's species (without models) and rocks
+	pokepp::Scene defaultScene() {
+		pokepp::Scene scene;
+		scene.species = {
+			{ .name = "Pikachu", .model = {}, .color = glm::vec3(1.0f, 0.9f, 0.2f), .catchRate = 0.7f },
+			{ .name = "Charmander", .model = {}, .color = glm::vec3(1.0f, 0.5f, 0.1f), .catchRate = 0.3f },
+			{ .name = "Squirtle", .model = {}, .color = glm::vec3(0.3f, 0.6f, 1.0f), .catchRate = 0.5f },
+			{ .name = "Bulbasaur", .model = {}, .color = glm::vec3(0.3f, 0.8f, 0.4f), .catchRate = 0.5f },
+		};
+		pokepp::ScenePropSet rocks;
+		rocks.count = 200;
+		scene.props.push_back(rocks);
+		scene.pokemon.push_back({ .count = 2000 });
+		scene.balls = 50;
+		return scene;
+	}
+
+	// Apply the count overrides from the command line
+	void overrideCounts(pokepp::Scene& scene, const Options& opt) {
+		if (opt.props >= 0) {
+			if (scene.props.empty()) scene.props.emplace_back();
+			scene.props[0].count = opt.props;
+			scene.props[0].density = 0.0f;
+		}
+		if (opt.pokemon >= 0) {
+			if (scene.pokemon.empty()) scene.pokemon.emplace_back();
+			scene.pokemon[0].count = opt.pokemon;
+			scene.pokemon[0].density = 0.0f;
+		}
+		if (opt.balls >= 0) scene.balls = opt.balls;
+		if (!opt.heightmap.empty()) scene.world.heightmap = opt.heightmap;
+	}
+
+	// Load the scene's world and species, leaving the simulation ready to populate or restore
+	bool loadScene(pokepp::Simulation& sim, const pokepp::Scene& scene) {
+		if (!sim.loadWorld(scene.world.heightmap.c_str(), scene.world.cellSize, scene.world.heightScale, false)) {
+			std::fprintf(stderr, "Failed to load heightmap %s\n", scene.world.heightmap.c_str());
+			return false;
+		}
+
+		std::vector<pokepp::PokemonSpecies> species;
+		for (const pokepp::SceneSpecies& s : scene.species) {
+			species.push_back({ .name = s.name, .model = nullptr, .displayColor = s.color,
+				.displayScale = s.displayScale, .catchRate = s.catchRate });
+		}
+		sim.setSpecies(std::move(species));
+		return true;
+	}
+
+	// Scripted input for tick i: walk a slow circle, sprint half of the time
+	pokepp::PlayerInput scriptedInput(int tick, float dt) {
+		float t = tick * dt;
+		float yaw = 0.25f * t;
+
+		pokepp::PlayerInput input;
+		input.forward = true;
+		input.sprint = (static_cast<int>(t / 5.0f) % 2) == 1;
+		input.front = glm::normalize(glm::vec3(std::cos(yaw), -0.1f, std::sin(yaw)));
+		return input;
+	}
+
+	// Keep `target` balls in flight, thrown in a fan around the look direction
+	void topUpBalls(pokepp::Simulation& sim, const pokepp::PlayerInput& input, int target) {
+		pokepp::Random& random = sim.random();
+		while (static_cast<int>(sim.pokeballCount()) < target) {
+			float angle = random.range(-0.75f, 0.75f);
+			float c = std::cos(angle), s = std::sin(angle);
+			glm::vec3 dir(input.front.x * c - input.front.z * s, random.range(0.1f, 0.4f), input.front.x * s + input.front.z * c);
+			float speed = random.range(5.0f, 20.0f);
+			sim.throwPokeball(sim.player().position + glm::normalize(dir), dir, speed);
+		}
+	}
+
+	// Populate the simulation from the scene, put the player at the center and throw the
+	// scene's balls
+	bool populate(pokepp::Simulation& sim, const pokepp::Scene& scene, const Options& opt) {
+		if (!loadScene(sim, scene)) return false;
+		for (size_t i = 0; i < scene.props.size(); ++i) sim.scatterProps(scene.props[i], nullptr, static_cast<uint32_t>(i));
+		for (const pokepp::ScenePokemonSpawn& spawn : scene.pokemon) sim.scatterPokemon(spawn);
+		sim.buildNavigation();
+
+		glm::vec3 start(0.0f, 0.0f, 0.0f);
+		start.y = sim.world()->heightAt(start.x, start.z) + sim.player().eyeHeight;
+		sim.player().position = start;
+		if (scene.balls > pokepp::constants::POKEBALL_POOL_CAPACITY) {
+			// Room for every ball the scene keeps up, so topping up never recycles one
+			sim.setPokeballPool(static_cast<size_t>(scene.balls), pokepp::PokeballOverflow::RecycleOldest);
+		}
+		topUpBalls(sim, scriptedInput(0, opt.dt), scene.balls);
+		return true;
+	}
+
+	// One scripted tick, all stages
+	void runTick(pokepp::Simulation& sim, int tick, const pokepp::PlayerInput& input, float dt, int balls) {
+		if (tick % 180 == 90) sim.jump();
+		topUpBalls(sim, input, balls);
+		sim.stepPokeballs(dt);
+		sim.updatePokemon(dt);
+		sim.updatePlayer(dt, input);
+	}
+
+	// --profiler-overhead: the same ticks on two identical (deterministic) simulations, the
+	// second one with every zone recorded. Either copy goes first on alternate ticks, so
+	// clock and cache drift cost both alike.
+	int profilerOverhead(const pokepp::Scene& scene, const Options& opt) {
+		pokepp::Simulation plain, recorded;
+		for (pokepp::Simulation* sim : { &plain, &recorded }) {
+			sim->setSeed(opt.seed);
+			sim->setDeterministic(true);
+			if (!populate(*sim, scene, opt)) return 1;
+		}
+		std::printf("pokepp_simbench: %s: %zu Pokemon, %d balls, profiler overhead over %d ticks\n",
+			opt.scene.empty() ? "default" : opt.scene.c_str(), plain.pokemon().getPokemonCount(),
+			scene.balls, opt.ticks);
+
+#ifdef POKEPP_PROFILER
+		// Per tick: plain time and the recording copy's extra time over it. Medians, so a tick
+		// preempted or stalled by the machine does not count as overhead.
+		std::vector<double> plainMs, extraMs;
+		plainMs.reserve(opt.ticks);
+		extraMs.reserve(opt.ticks);
+		for (int i = 0; i < opt.ticks; ++i) {
+			double ms[2] = {};  // Plain, recorded
+			pokepp::PlayerInput input = scriptedInput(i, opt.dt);
+			for (int k = 0; k < 2; ++k) {
+				const int which = (i + k) % 2;
+				pokepp::Profiler::setFrameHistory(which == 1);
+				pokepp::Profiler::frame();
+				pokepp::frameArena().reset();
+				auto start = Clock::now();
+				runTick(which ? recorded : plain, i, input, opt.dt, scene.balls);
+				ms[which] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			}
+			plainMs.push_back(ms[0]);
+			extraMs.push_back(ms[1] - ms[0]);
+		}
+		pokepp::Profiler::setFrameHistory(false);
+		pokepp::Profiler::frame();
+
+		const bool same = plain.stateHash() == recorded.stateHash();
+		auto median = [](std::vector<double>& v) {
+			if (v.empty()) return 0.0;
+			std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+			return v[v.size() / 2];
+		};
+		const double offMs = median(plainMs);
+		const double addedMs = median(extraMs);
+		const double overhead = 100.0 * addedMs / std::max(offMs, 1e-9);
+		const bool within = overhead <= opt.profilerBudget;
+		std::printf("profiler overhead: %+.2f%% (median tick %.3f ms off, %+.4f ms recording), budget %.1f%%: %s\n",
+			overhead, offMs, addedMs, opt.profilerBudget, within ? "ok" : "OVER BUDGET");
+		if (!same) {
+			std::fprintf(stderr, "profiler overhead: the two simulations diverged, the timings are not comparable\n");
+			return 4;
+		}
+		return within ? 0 : 5;
+#else
+		std::printf("profiler overhead: zones are compiled out (POKEPP_PROFILER is off)\n");
+		return 0;
+#endif
+	}
+
+	template <typename Fn>
+	void measure(StageStats& stage, Fn&& fn) {
+		uint64_t allocsBefore = pokepp::HeapCounter::allocations();
+		auto start = Clock::now();
+		fn();
+		stage.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+		stage.allocs += pokepp::HeapCounter::allocations() - allocsBefore;
+	}
+}
+
+int main(int argc, char** argv) {
+	Options opt;
+	if (!parseArgs(argc, argv, opt)) return 1;
+
+	// Setup
+	auto setupStart = Clock::now();
+	pokepp::Scene scene;
+	if (opt.scene.empty()) {
+		scene = defaultScene();
+	} else if (!pokepp::Scene::Load(opt.scene, scene)) {
+		return 1;
+	}
+	overrideCounts(scene, opt);
+	if (opt.profilerBudget >= 0.0f) return profilerOverhead(scene, opt);
+	double sceneMs = std::chrono::duration<double, std::milli>(Clock::now() - setupStart).count();
+
+	pokepp::Simulation sim;
+	sim.setSeed(opt.seed);
+	sim.setDeterministic(!opt.save.empty());
+	if (!populate(sim, scene, opt)) return 1;
+	const int balls = scene.balls;
+	double setupMs = std::chrono::duration<double, std::milli>(Clock::now() - setupStart).count();
+
+	std::printf("pokepp_simbench: %s: %zu Pokemon, %zu props, %d balls, %d ticks at dt %.4f s (seed %u)\n",
+		opt.scene.empty() ? "default" : opt.scene.c_str(), sim.pokemon().getPokemonCount(),
+		sim.collision().boxes().size(), balls, opt.ticks, opt.dt, opt.seed);
+	std::printf("setup: %.1f ms (scene %.2f ms)\n", setupMs, sceneMs);
+
+	// Autosaves, and the state hash of the last one taken
+	const std::string sceneName = opt.scene.empty() ? "default" : opt.scene;
+	std::unique_ptr<pokepp::AutoSave> autosave;
+	if (!opt.autosave.empty()) autosave = std::make_unique<pokepp::AutoSave>(opt.autosave, sceneName);
+	const int autosaveTicks = std::max(1, static_cast<int>(std::lround(1.0f / opt.dt)));
+	uint64_t autosaveHash = 0;
+	double snapshotMsTotal = 0.0;
+	size_t snapshots = 0;
+
+	// Run
+	StageStats stages[] = { { "pokeballs" }, { "pokemon" }, { "player" }, { "script" } };
+	uint64_t allocsBefore = pokepp::HeapCounter::allocations();
+	uint64_t bytesBefore = pokepp::HeapCounter::bytes();
+	size_t checkedTicks = 0;
+	size_t steadyTicks = 0;
+	size_t allocatingTicks = 0;
+	auto runStart = Clock::now();
+
+	for (int i = 0; i < opt.ticks; ++i) {
+		pokepp::frameArena().reset();
+		pokepp::PlayerInput input = scriptedInput(i, opt.dt);
+
+		const bool checkTick = opt.allocCheck >= 0 && i >= opt.allocCheck;
+		uint64_t tickAllocs = pokepp::HeapCounter::threadAllocations();
+		uint64_t tickBytes = pokepp::HeapCounter::threadBytes();
+		uint64_t tickEpoch = sim.allocationEpoch();
+		if (checkTick) pokepp::HeapCounter::captureStacks(pokepp::constants::ALLOC_STACK_CAPTURES);
+
+		measure(stages[3], [&] {
+			if (i % 180 == 90) sim.jump();
+			topUpBalls(sim, input, balls);
+		});
+		measure(stages[0], [&] { sim.stepPokeballs(opt.dt); });
+		measure(stages[1], [&] { sim.updatePokemon(opt.dt); });
+		measure(stages[2], [&] { sim.updatePlayer(opt.dt, input); });
+		if (autosave && i % autosaveTicks == autosaveTicks - 1) autosave->wait();
+		if (autosave && i % autosaveTicks == autosaveTicks - 1 && autosave->save(sim)) {
+			autosaveHash = sim.stateHash();
+			snapshotMsTotal += autosave->stats().lastSnapshotMs;
+			snapshots++;
+		}
+
+		// Spawns and removals allocate by design; any other tick must not
+		if (checkTick) checkedTicks++;
+		if (checkTick && sim.allocationEpoch() == tickEpoch) {
+			steadyTicks++;
+			uint64_t n = pokepp::HeapCounter::threadAllocations() - tickAllocs;
+			if (n > 0 && allocatingTicks++ < static_cast<size_t>(pokepp::constants::HEAP_CHECK_REPORTS)) {
+				std::fprintf(stderr, "heap check: tick %d made %llu allocations (%llu bytes)\n", i,
+					static_cast<unsigned long long>(n),
+					static_cast<unsigned long long>(pokepp::HeapCounter::threadBytes() - tickBytes));
+				pokepp::HeapCounter::printStacks(stderr);
+			}
+		}
+	}
+	pokepp::HeapCounter::stopStackCapture();
+
+	double runSeconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+	uint64_t allocs = pokepp::HeapCounter::allocations() - allocsBefore;
+	uint64_t bytes = pokepp::HeapCounter::bytes() - bytesBefore;
+
+	// Report
+	const double ticks = std::max(1, opt.ticks);
+	std::printf("total: %.1f ticks/s (%.3f ms/tick), %.1f allocs/tick, %.1f KiB/tick\n",
+		ticks / runSeconds, 1000.0 * runSeconds / ticks, allocs / ticks, bytes / ticks / 1024.0);
+	std::printf("%-10s %10s %12s\n", "stage", "ms/tick", "allocs/tick");
+	for (const auto& stage : stages) {
+		std::printf("%-10s %10.4f %12.1f\n", stage.name, 1000.0 * stage.seconds / ticks, stage.allocs / ticks);
+	}
+
+	const auto& lod = sim.pokemon().getLodStats();
+	std::printf("end state: %zu wild/out Pokemon (near %zu, mid %zu, far %zu), %zu captured, %zu balls (%zu active, %zu sleeping)\n",
+		sim.pokemon().getPokemonCount(), lod.nearCount, lod.midCount, lod.farCount,
+		sim.pokemon().getInventoryCount(), sim.pokeballCount(),
+		sim.pokeballStats().active, sim.pokeballStats().sleeping);
+	const pokepp::PokeballPool& pool = sim.pokeballPool();
+	std::printf("pokeball pool: capacity %zu, high water %zu, %zu overflows\n", pool.capacity, pool.highWater, pool.overflows);
+	std::printf("entities: %zu in %zu archetypes\n", sim.entities().size(), sim.entities().archetypeCount());
+	std::printf("state hash: %016llx\n", static_cast<unsigned long long>(sim.stateHash()));
+
+	if (autosave) {
+		autosave->wait();
+		const pokepp::AutoSaveStats stats = autosave->stats();
+		std::printf("autosave: %zu full, %zu deltas, %zu skipped, snapshot %.3f ms avg (%.3f ms max), last write %.2f ms, last file %zu KiB\n",
+			stats.fullSaves, stats.deltaSaves, stats.skipped, snapshots ? snapshotMsTotal / snapshots : 0.0,
+			stats.maxSnapshotMs, stats.lastWriteMs, stats.lastBytes / 1024);
+
+		// The last save is a delta, so only the full save with it applied has its state
+		if (stats.deltaSaves == 0 || !stats.lastDelta) {
+			std::fprintf(stderr, "autosave: the last save was not a delta, run for more ticks\n");
+			return 4;
+		}
+		pokepp::Simulation loaded;
+		if (!loadScene(loaded, scene) || !pokepp::SaveGame::Load(opt.autosave, loaded)) return 4;
+		bool match = loaded.stateHash() == autosaveHash;
+		std::printf("autosave restore: full save + delta %s\n", match ? "matches" : "MISMATCH");
+		if (!match) return 4;
+		if (stats.maxSnapshotMs > pokepp::constants::HUD_SPIKE_MS) {
+			std::fprintf(stderr, "autosave: a snapshot took %.2f ms, over the %.0f ms spike threshold\n",
+				stats.maxSnapshotMs, pokepp::constants::HUD_SPIKE_MS);
+			return 6;
+		}
+	}
+
+	if (!opt.save.empty()) {
+		// Round trip: save, restore into a fresh simulation, compare, then run both on
+		auto saveStart = Clock::now();
+		if (!pokepp::SaveGame::Save(sim, sceneName, opt.save)) {
+			std::fprintf(stderr, "Failed to write save %s\n", opt.save.c_str());
+			return 1;
+		}
+		double saveMs = std::chrono::duration<double, std::milli>(Clock::now() - saveStart).count();
+
+		pokepp::Simulation loaded;
+		loaded.setDeterministic(true);
+		if (!loadScene(loaded, scene)) return 1;
+		auto loadStart = Clock::now();
+		if (!pokepp::SaveGame::Load(opt.save, loaded)) return 4;
+		double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - loadStart).count();
+		loaded.buildNavigation();
+		if (balls > pokepp::constants::POKEBALL_POOL_CAPACITY) {
+			loaded.setPokeballPool(static_cast<size_t>(balls), pokepp::PokeballOverflow::RecycleOldest);
+		}
+
+		std::vector<uint64_t> saved, reloaded;
+		pokepp::SaveGame::Encode(sim, sceneName, saved);
+		pokepp::SaveGame::Encode(loaded, sceneName, reloaded);
+		const uint64_t savedHash = sim.stateHash();
+		bool match = savedHash == loaded.stateHash() && saved == reloaded;
+
+		const int extra = static_cast<int>(std::lround(1.0f / opt.dt));
+		for (int i = opt.ticks; match && i < opt.ticks + extra; ++i) {
+			pokepp::PlayerInput input = scriptedInput(i, opt.dt);
+			for (pokepp::Simulation* s : { &sim, &loaded }) {
+				pokepp::frameArena().reset();
+				runTick(*s, i, input, opt.dt, balls);
+			}
+			match = sim.stateHash() == loaded.stateHash();
+		}
+
+		std::printf("save: %zu KiB, saved in %.2f ms, loaded in %.2f ms, round trip %s\n",
+			saved.size() * sizeof(uint64_t) / 1024, saveMs, loadMs, match ? "matches" : "MISMATCH");
+		if (!match) return 4;
+
+		if (!opt.saveFault.empty()) {
+			// The save as encoded above (before running on), then damaged
+			size_t bytes = pokepp::SaveGame::EncodedBytes(saved);
+			const std::string deltaPath = opt.save + ".delta";
+			bool stale = opt.saveFault == "stale-delta";
+			if (stale) {
+				// A delta from the state a second later to itself: its base is not this save
+				std::vector<uint64_t> later, delta;
+				pokepp::SaveGame::Encode(sim, sceneName, later);
+				size_t deltaBytes = pokepp::SaveGame::EncodeDelta(later, later, delta);
+				if (!pokepp::SaveGame::WriteFile(deltaPath, delta, deltaBytes)) return 1;
+			} else if (!damageSave(opt.saveFault, saved, bytes)) {
+				std::fprintf(stderr, "Unknown save fault %s\n", opt.saveFault.c_str());
+				return 1;
+			}
+			if (!pokepp::SaveGame::WriteFile(opt.save, saved, bytes)) return 1;
+
+			pokepp::Simulation damaged;
+			if (!loadScene(damaged, scene)) return 1;
+			bool loads = pokepp::SaveGame::Load(opt.save, damaged);
+			bool ok = stale ? loads && damaged.stateHash() == savedHash : !loads;
+			std::remove(deltaPath.c_str());
+			std::printf("save fault %s: %s\n", opt.saveFault.c_str(),
+				!ok ? "NOT DETECTED" : stale ? "delta ignored, save loaded" : "load rejected");
+			if (!ok) return 4;
+		}
+	}
+
+	if (opt.allocCheck >= 0) {
+		std::printf("heap check: %zu of %zu ticks steady, %zu allocated\n", steadyTicks, checkedTicks, allocatingTicks);
+		if (allocatingTicks > 0) return 3;
+		if (steadyTicks < static_cast<size_t>(pokepp::constants::HEAP_CHECK_MIN_STEADY)) {
+			std::fprintf(stderr, "heap check: too few steady ticks (at least %d needed)\n",
+				pokepp::constants::HEAP_CHECK_MIN_STEADY);
+			return 3;
+		}
+	}
+	return 0;
+}